@@ -0,0 +1,52 @@
+/**
+ * Compares exporting every entity attribute one entity at a time, the way getAllEntityAttributes used to work,
+ * against the cursor-backed bulk scan. Run against a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "benchmark.h"
+
+using knowledge_rep::EntityAttribute;
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+
+int main(int argc, char** argv)
+{
+  size_t num_entities = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+
+  for (size_t i = 0; i < num_entities; i++)
+  {
+    auto entity = ltmc.addEntity();
+    entity.addAttribute("count", static_cast<int>(i));
+    entity.addAttribute("height", 0.5);
+    entity.addAttribute("name", "entity " + std::to_string(i));
+  }
+
+  double per_entity = timePerCall(iterations, [&]() {
+    std::vector<EntityAttribute> attrs;
+    for (const auto& entity : ltmc.getAllEntities())
+    {
+      auto entity_attrs = entity.getAttributes();
+      attrs.insert(attrs.end(), entity_attrs.begin(), entity_attrs.end());
+    }
+  });
+  double scan = timePerCall(iterations, [&]() { ltmc.getAllEntityAttributes(); });
+  report("getAllEntityAttributes (" + std::to_string(num_entities) + " entities)", per_entity, scan);
+
+  scan = timePerCall(iterations, [&]() {
+    size_t count = 0;
+    ltmc.forEachEntityAttributeBatch([&count](std::vector<EntityAttribute>& batch) { count += batch.size(); });
+  });
+  report("forEachEntityAttributeBatch", per_entity, scan);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
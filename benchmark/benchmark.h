@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace knowledge_rep
+{
+namespace benchmark
+{
+/**
+ * @brief Times repeated calls to a function
+ * @param iterations how many times to call the function
+ * @param f the function under test
+ * @return the mean wall-clock time per call, in microseconds
+ */
+template <typename F>
+double timePerCall(size_t iterations, F f)
+{
+  // One untimed call so connection setup and first-use costs don't skew the mean
+  f();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; i++)
+  {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+inline void report(const std::string& name, double microseconds_per_call)
+{
+  std::printf("%-50s %12.2f us/call\n", name.c_str(), microseconds_per_call);
+}
+
+inline void report(const std::string& name, double baseline_microseconds, double microseconds)
+{
+  std::printf("%-50s %12.2f -> %10.2f us/call (%.2fx)\n", name.c_str(), baseline_microseconds, microseconds,
+              baseline_microseconds / microseconds);
+}
+}  // namespace benchmark
+}  // namespace knowledge_rep
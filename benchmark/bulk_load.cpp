@@ -0,0 +1,60 @@
+/**
+ * Compares loading name-keyed knowledge one operation at a time, the way the knowledge loader does, against a single
+ * bulkLoad. Run against a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCConcept.h>
+#include <knowledge_representation/LTMCInstance.h>
+#include <cstdlib>
+#include <string>
+#include "benchmark.h"
+
+using knowledge_rep::BulkEntityRef;
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+
+int main(int argc, char** argv)
+{
+  size_t num_instances = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+
+  // Spread the instances over a few concepts, and give each a couple of attributes
+  knowledge_rep::BulkKnowledge knowledge;
+  for (size_t i = 0; i < num_instances; i++)
+  {
+    auto instance = BulkEntityRef::instanceNamed("object " + std::to_string(i), "kind " + std::to_string(i % 20));
+    knowledge.instances.push_back(instance);
+    knowledge.attributes.push_back({ instance, "count", static_cast<int>(i), {} });
+    knowledge.attributes.push_back({ instance, "is_in", {}, BulkEntityRef::instanceNamed("room", "room") });
+  }
+
+  double one_at_a_time = timePerCall(1, [&]() {
+    ltmc.deleteAllEntities();
+    auto room = ltmc.getConcept("room");
+    auto room_instance = room.getInstanceNamed("room");
+    if (!room_instance)
+    {
+      room_instance = room.createInstance("room");
+    }
+    for (size_t i = 0; i < num_instances; i++)
+    {
+      auto concept = ltmc.getConcept(knowledge.instances[i].concept_name);
+      auto instance = concept.createInstance(knowledge.instances[i].name);
+      instance->addAttribute("count", static_cast<int>(i));
+      instance->addAttribute("is_in", *room_instance);
+    }
+  });
+  double bulk = timePerCall(1, [&]() {
+    ltmc.deleteAllEntities();
+    knowledge_rep::BulkLoadResult result;
+    ltmc.bulkLoad(knowledge, result);
+  });
+  report("load " + std::to_string(num_instances) + " instances (us per load)", one_at_a_time, bulk);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * Measures read throughput as more threads share one LTMC. Each thread repeatedly looks up an entity's attributes
+ * and checks that it exists, on a connection of its own from the LTMC's pool. Run against a scratch knowledge base;
+ * the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCConcept.h>
+#include <knowledge_representation/LTMCInstance.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+  size_t reads_per_thread = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  size_t max_threads = 16;
+  std::string db_name = "knowledge_base";
+  if (const char* env_db_name = std::getenv("KNOWLEDGE_REP_DB_NAME"))
+  {
+    db_name = env_db_name;
+  }
+  knowledge_rep::LongTermMemoryConduit ltmc(db_name, "localhost", max_threads);
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+
+  auto apple = *ltmc.getConcept("apple").createInstance("fuji");
+  apple.addAttribute("height", 0.1);
+
+  double single_thread_rate = 0;
+  for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+  {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < num_threads; i++)
+    {
+      threads.emplace_back([&]() {
+        for (size_t j = 0; j < reads_per_thread; j++)
+        {
+          apple.getAttributes();
+          ltmc.entityExists(apple.entity_id);
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = 2.0 * reads_per_thread * num_threads / seconds;
+    if (num_threads == 1)
+    {
+      single_thread_rate = rate;
+    }
+    std::printf("%2zu threads %12.0f reads/s (%.2fx)\n", num_threads, rate, rate / single_thread_rate);
+  }
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
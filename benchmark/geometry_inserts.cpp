@@ -0,0 +1,48 @@
+/**
+ * Compares adding a point the way the conduit used to (an entity, the map's has attribute, the geometry and
+ * instance_of rows, and the name, each committed separately) against the single-statement addPoint. Run against a
+ * scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCPoint.h>
+#include <pqxx/pqxx>
+#include <cstdlib>
+#include <string>
+#include "benchmark.h"
+
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+
+int main(int argc, char** argv)
+{
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+  auto map = ltmc.getMap("benchmark map");
+
+  size_t count = 0;
+  double separate = timePerCall(iterations, [&]() {
+    auto name = "old " + std::to_string(count++);
+    auto point = ltmc.addEntity();
+    map.addAttribute("has", point);
+    {
+      auto connection = ltmc.borrowConnection();
+      pqxx::work txn{ *connection };
+      txn.exec("INSERT INTO points VALUES (" + txn.quote(point.entity_id) + ", " +
+               txn.quote(name) + ", " + txn.quote(map.getId()) + ", point(1, 2))");
+      txn.exec("INSERT INTO instance_of SELECT " + txn.quote(point.entity_id) +
+               ", entity_id FROM concepts WHERE concept_name = 'point'");
+      txn.commit();
+    }
+    point.addAttribute("name", name);
+  });
+  double combined = timePerCall(iterations, [&]() { map.addPoint("new " + std::to_string(count++), 1, 2); });
+  report("addPoint", separate, combined);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
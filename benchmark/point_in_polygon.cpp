@@ -0,0 +1,75 @@
+/**
+ * Times checking a 1,000-point footprint against a region: one query per point, as isPointContained used to make,
+ * against testing each point locally, against the prepared batch test. Run against a scratch knowledge base; the
+ * benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCRegion.h>
+#include <pqxx/pqxx>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "benchmark.h"
+
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+using std::to_string;
+
+int main(int argc, char** argv)
+{
+  size_t num_points = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+  size_t num_vertices = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 32;
+  size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+  auto map = ltmc.getMap("benchmark map");
+
+  // A star-shaped room, so that many of the points in its bounding box fall outside it
+  std::vector<knowledge_rep::Region::Point2D> vertices;
+  for (size_t i = 0; i < num_vertices; i++)
+  {
+    double angle = 2 * M_PI * i / num_vertices;
+    double radius = i % 2 ? 4 : 5;
+    vertices.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+  }
+  auto region = map.addRegion("footprint region", vertices);
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> coordinate(-5, 5);
+  std::vector<knowledge_rep::Region::Point2D> footprint(num_points);
+  for (auto& point : footprint)
+  {
+    point = { coordinate(generator), coordinate(generator) };
+  }
+
+  auto connection = ltmc.borrowConnection();
+  double round_trips = timePerCall(iterations, [&]() {
+    for (const auto& point : footprint)
+    {
+      pqxx::work txn{ *connection };
+      txn.exec("SELECT region @> point(" + to_string(point.first) + ", " + to_string(point.second) +
+               ") FROM regions WHERE entity_id = " + to_string(region.entity_id));
+      txn.commit();
+    }
+  });
+  double one_by_one = timePerCall(iterations, [&]() {
+    for (const auto& point : footprint)
+    {
+      region.isPointContained(point);
+    }
+  });
+  double batch = timePerCall(iterations, [&]() { region.isPointContained(footprint); });
+
+  std::string sizes = " (" + to_string(num_points) + " points, " + to_string(num_vertices) + " vertices)";
+  report("footprint, query per point -> local" + sizes, round_trips, one_by_one);
+  report("footprint, local -> batch" + sizes, one_by_one, batch);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * Compares the latency of the conduit's prepared statements against sending the same SQL as plain text, the way the
+ * conduit used to issue every query. Run against a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCConcept.h>
+#include <knowledge_representation/LTMCInstance.h>
+#include <pqxx/pqxx>
+#include <cstdlib>
+#include <string>
+#include "benchmark.h"
+
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+
+int main(int argc, char** argv)
+{
+  size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+
+  auto apple = *ltmc.getConcept("apple").createInstance("fuji");
+  apple.addAttribute("height", 0.1);
+  apple.addAttribute("is_open", false);
+  auto connection = ltmc.borrowConnection();
+  auto& conn = *connection;
+  const auto entity_id = apple.entity_id;
+
+  double text = timePerCall(iterations, [&]() {
+    pqxx::work txn{ conn };
+    txn.exec("SELECT count(*) FROM entities WHERE entity_id = " + txn.quote(entity_id));
+    txn.commit();
+  });
+  double prepared = timePerCall(iterations, [&]() { ltmc.entityExists(entity_id); });
+  report("entityExists", text, prepared);
+
+  text = timePerCall(iterations, [&]() {
+    for (const auto& table : knowledge_rep::TABLE_NAMES)
+    {
+      pqxx::work txn{ conn };
+      txn.exec("SELECT * FROM " + std::string(table) + " WHERE entity_id = " + txn.quote(entity_id));
+      txn.commit();
+    }
+  });
+  prepared = timePerCall(iterations, [&]() { apple.getAttributes(); });
+  report("getAttributes", text, prepared);
+
+  text = timePerCall(iterations, [&]() {
+    pqxx::work txn{ conn };
+    txn.exec("SELECT entity_id FROM entity_attributes_str WHERE attribute_value = " + txn.quote("fuji") +
+             " AND attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = " + txn.quote("name") +
+             ")");
+    txn.commit();
+  });
+  prepared = timePerCall(iterations, [&]() { ltmc.getEntitiesWithAttributeOfValue("name", "fuji"); });
+  report("getEntitiesWithAttributeOfValue", text, prepared);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
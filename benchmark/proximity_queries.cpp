@@ -0,0 +1,105 @@
+/**
+ * Times proximity queries on a large map: fetching every pose and scanning the list on the client, as callers had to,
+ * against the LTMC's nearest-neighbour and radius queries, which answer from its in-memory spatial index. Run against
+ * a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCPose.h>
+#include <pqxx/pqxx>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "benchmark.h"
+
+using knowledge_rep::Pose;
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+using std::string;
+using std::to_string;
+
+int main(int argc, char** argv)
+{
+  size_t num_poses = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+  size_t k = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+  double radius = argc > 3 ? std::strtod(argv[3], nullptr) : 2;
+  size_t iterations = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 20;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+  auto map = ltmc.getMap("benchmark map");
+
+  // Poses scattered over a square about a pose per square metre. Only the geometry rows are written, as they're all
+  // that proximity queries read.
+  auto side = to_string(std::ceil(std::sqrt(num_poses)));
+  {
+    auto connection = ltmc.borrowConnection();
+    pqxx::work txn{ *connection };
+    txn.exec("WITH ids AS (INSERT INTO entities SELECT nextval('entities_entity_id_seq') FROM generate_series(1, " +
+             to_string(num_poses) + ") RETURNING entity_id), " +
+             "placed AS (SELECT entity_id, point(random() * " + side + ", random() * " + side +
+             ") AS p, random() * 6.28 AS theta FROM ids) " +
+             "INSERT INTO poses SELECT entity_id, 'pose ' || entity_id, " + to_string(map.getId()) +
+             ", lseg(p, p + point(cos(theta), sin(theta))) FROM placed");
+    txn.commit();
+  }
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> coordinate(0, std::stod(side));
+  std::vector<std::pair<double, double>> probes(iterations + 1);
+  for (auto& probe : probes)
+  {
+    probe = { coordinate(generator), coordinate(generator) };
+  }
+  auto distanceFrom = [](const std::pair<double, double>& probe) {
+    return [probe](const Pose& a, const Pose& b) {
+      return std::hypot(a.x - probe.first, a.y - probe.second) < std::hypot(b.x - probe.first, b.y - probe.second);
+    };
+  };
+
+  size_t i = 0;
+  double nearest_scan = timePerCall(iterations, [&]() {
+    const auto& probe = probes[i++ % probes.size()];
+    auto poses = map.getAllPoses();
+    std::partial_sort(poses.begin(), poses.begin() + std::min(k, poses.size()), poses.end(), distanceFrom(probe));
+  });
+  double radius_scan = timePerCall(iterations, [&]() {
+    const auto& probe = probes[i++ % probes.size()];
+    auto poses = map.getAllPoses();
+    poses.erase(std::remove_if(poses.begin(), poses.end(),
+                               [&](const Pose& pose) {
+                                 return std::hypot(pose.x - probe.first, pose.y - probe.second) > radius;
+                               }),
+                poses.end());
+    std::sort(poses.begin(), poses.end(), distanceFrom(probe));
+  });
+
+  // The LTMC reads the map into its spatial index on the first query, and answers every later one from memory
+  auto start = std::chrono::steady_clock::now();
+  map.getNearestPoses(probes[0].first, probes[0].second, k);
+  auto end = std::chrono::steady_clock::now();
+  report("spatial index load", std::chrono::duration<double, std::micro>(end - start).count());
+
+  double nearest_indexed = timePerCall(iterations, [&]() {
+    const auto& probe = probes[i++ % probes.size()];
+    map.getNearestPoses(probe.first, probe.second, k);
+  });
+  double radius_indexed = timePerCall(iterations, [&]() {
+    const auto& probe = probes[i++ % probes.size()];
+    map.getPosesWithinRadius(probe.first, probe.second, radius);
+  });
+
+  string sizes = " (" + to_string(num_poses) + " poses)";
+  report("nearest " + to_string(k) + " poses, scan -> index" + sizes, nearest_scan, nearest_indexed);
+  report("poses within " + to_string(radius) + ", scan -> index" + sizes, radius_scan, radius_indexed);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
@@ -0,0 +1,96 @@
+/**
+ * Times reading every region of a map whose regions have many vertices: fetching the rows and decoding each polygon
+ * the way the conduit used to, with a regex and a string per coordinate, against getAllRegions, which parses the text
+ * in place. Run against a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCRegion.h>
+#include <pqxx/pqxx>
+#include <cstdlib>
+#include <iterator>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "benchmark.h"
+
+using knowledge_rep::Region;
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+using std::string;
+using std::to_string;
+
+/// The conduit's old polygon decoding, kept as the baseline
+std::vector<Region::Point2D> regexStrToPoints(const string& s)
+{
+  std::vector<Region::Point2D> points;
+  std::regex paren_regex("\\(|\\)");
+  std::string result;
+  std::regex_replace(back_inserter(result), s.begin(), s.end(), paren_regex, "");
+  std::vector<string> components;
+  std::istringstream iss(result);
+  std::string item;
+  while (std::getline(iss, item, ','))
+  {
+    components.push_back(item);
+  }
+  auto i = components.begin();
+  while (i < components.end())
+  {
+    auto f = *i++;
+    auto s = *i++;
+    points.emplace_back(std::stod(f), std::stod(s));
+  }
+  return points;
+}
+
+int main(int argc, char** argv)
+{
+  size_t num_regions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+  size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+
+  for (size_t vertices : { 16, 256, 4096 })
+  {
+    // Circles approximated by polygons, one map per vertex count. Only the geometry rows are written, as they're all
+    // that getAllRegions reads.
+    auto map = ltmc.getMap("benchmark map " + to_string(vertices));
+    auto map_id = to_string(map.getId());
+    auto connection = ltmc.borrowConnection();
+    {
+      pqxx::work txn{ *connection };
+      txn.exec("WITH ids AS (INSERT INTO entities SELECT nextval('entities_entity_id_seq') FROM generate_series(1, " +
+               to_string(num_regions) + ") RETURNING entity_id), " +
+               "numbered AS (SELECT entity_id, row_number() OVER (ORDER BY entity_id) - 1 AS n FROM ids) " +
+               "INSERT INTO regions SELECT entity_id, 'region ' || n, " + map_id + ", polygon(" + to_string(vertices) +
+               ", circle(point(n * 3, 0), 1)) FROM numbered");
+      txn.commit();
+    }
+
+    double regex = timePerCall(iterations, [&]() {
+      pqxx::work txn{ *connection };
+      auto rows = txn.exec("SELECT entity_id, region, region_name FROM regions WHERE parent_map_id = " + map_id);
+      txn.commit();
+      std::vector<Region> regions;
+      for (const auto& row : rows)
+      {
+        regions.emplace_back(row["entity_id"].as<uint>(), row["region_name"].as<string>(),
+                             regexStrToPoints(row["region"].as<string>()), map, ltmc);
+      }
+    });
+    double parsed = timePerCall(iterations, [&]() { map.getAllRegions(); });
+
+    report("getAllRegions, regex -> parser (" + to_string(num_regions) + " regions, " + to_string(vertices) +
+               " vertices)",
+           regex, parsed);
+  }
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * Times containment queries on a large map: in SQL without the geometry indexes, as the schema used to be, in SQL
+ * through the GiST-indexed, bounding-box prefiltered functions, and through the LTMC, which answers from its in-memory
+ * spatial index. Run against a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCPoint.h>
+#include <knowledge_representation/LTMCRegion.h>
+#include <pqxx/pqxx>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "benchmark.h"
+
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+using std::string;
+using std::to_string;
+
+/// The indexes that containment relies on, as schema_postgresql.sql creates them
+const std::pair<const char*, const char*> GEOMETRY_INDEXES[] = {
+  { "points_parent_map_id", "ON points (parent_map_id)" },
+  { "regions_parent_map_id", "ON regions (parent_map_id)" },
+  { "regions_region", "ON regions USING gist (region)" },
+  { "points_point", "ON points USING gist (point)" },
+};
+
+/**
+ * @brief Inserts geometry rows for new entities, numbered from 0
+ * @param make_row SQL for the row, in terms of entity_id and n
+ */
+void insertGeometry(pqxx::work& txn, const string& table, size_t count, const string& make_row)
+{
+  txn.exec("WITH ids AS (INSERT INTO entities SELECT nextval('entities_entity_id_seq') FROM generate_series(1, " +
+           to_string(count) + ") RETURNING entity_id), " +
+           "numbered AS (SELECT entity_id, row_number() OVER (ORDER BY entity_id) - 1 AS n FROM ids) " +
+           "INSERT INTO " + table + " SELECT " + make_row + " FROM numbered");
+}
+
+int main(int argc, char** argv)
+{
+  size_t num_regions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  size_t num_points = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+  size_t iterations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+  auto map = ltmc.getMap("benchmark map");
+  auto map_id = to_string(map.getId());
+
+  // Overlapping squares on a grid, with points scattered over the same area. Only the geometry rows are written,
+  // as they're all that containment reads.
+  size_t side = static_cast<size_t>(std::ceil(std::sqrt(num_regions)));
+  {
+    auto connection = ltmc.borrowConnection();
+    pqxx::work txn{ *connection };
+    insertGeometry(txn, "regions", num_regions,
+                   "entity_id, 'region ' || n, " + map_id + ", polygon(box(point(n % " + to_string(side) + ", n / " +
+                       to_string(side) + "), point(n % " + to_string(side) + " + 1.5, n / " + to_string(side) +
+                       " + 1.5)))");
+    insertGeometry(txn, "points", num_points,
+                   "entity_id, 'point ' || n, " + map_id + ", point(random() * " + to_string(side) + ", random() * " +
+                       to_string(side) + ")");
+    for (const auto& index : GEOMETRY_INDEXES)
+    {
+      txn.exec("DROP INDEX IF EXISTS " + string(index.first));
+    }
+    txn.exec("ANALYZE regions");
+    txn.exec("ANALYZE points");
+    txn.commit();
+  }
+
+  std::mt19937 generator(0);
+  std::uniform_real_distribution<double> coordinate(0, side);
+  std::vector<std::pair<double, double>> probes(iterations + 1);
+  for (auto& probe : probes)
+  {
+    probe = { coordinate(generator), coordinate(generator) };
+  }
+  auto regions = map.getAllRegions();
+  std::uniform_int_distribution<size_t> region_index(0, regions.size() - 1);
+  std::vector<uint> probe_regions(probes.size());
+  for (auto& region : probe_regions)
+  {
+    region = regions[region_index(generator)].entity_id;
+  }
+
+  auto connection = ltmc.borrowConnection();
+  auto timeSql = [&](const std::function<string(size_t)>& make_query) {
+    size_t i = 0;
+    return timePerCall(iterations, [&]() {
+      pqxx::work txn{ *connection };
+      txn.exec(make_query(i++ % probes.size()));
+      txn.commit();
+    });
+  };
+  auto containingUnindexed = [&](size_t i) {
+    return "SELECT count(*) FROM regions WHERE parent_map_id = " + map_id + " AND region @> point(" +
+           to_string(probes[i].first) + ", " + to_string(probes[i].second) + ")";
+  };
+  auto containingIndexed = [&](size_t i) {
+    return "SELECT count(*) FROM get_containing_regions(" + map_id + ", " + to_string(probes[i].first) + ", " +
+           to_string(probes[i].second) + ")";
+  };
+  auto containedUnindexed = [&](size_t i) {
+    return "SELECT count(*) FROM points WHERE parent_map_id = " + map_id +
+           " AND (SELECT region FROM regions WHERE entity_id = " + to_string(probe_regions[i]) + ") @> point";
+  };
+  auto containedIndexed = [&](size_t i) {
+    return "SELECT count(*) FROM get_contained_points(" + to_string(probe_regions[i]) + ")";
+  };
+
+  double containing_unindexed = timeSql(containingUnindexed);
+  double contained_unindexed = timeSql(containedUnindexed);
+  {
+    pqxx::work txn{ *connection };
+    for (const auto& index : GEOMETRY_INDEXES)
+    {
+      txn.exec("CREATE INDEX " + string(index.first) + " " + index.second);
+    }
+    txn.exec("ANALYZE regions");
+    txn.exec("ANALYZE points");
+    txn.commit();
+  }
+  double containing_indexed = timeSql(containingIndexed);
+  double contained_indexed = timeSql(containedIndexed);
+
+  string sizes = " (" + to_string(num_regions) + " regions, " + to_string(num_points) + " points)";
+  report("containing regions, SQL, GiST" + sizes, containing_unindexed, containing_indexed);
+  report("contained points, SQL, GiST" + sizes, contained_unindexed, contained_indexed);
+
+  // The LTMC reads the map into its spatial index on the first query, and answers every later one from memory
+  auto start = std::chrono::steady_clock::now();
+  knowledge_rep::Point(0, "probe", probes[0].first, probes[0].second, map, ltmc).getContainingRegions();
+  auto end = std::chrono::steady_clock::now();
+  report("spatial index load", std::chrono::duration<double, std::micro>(end - start).count());
+
+  size_t i = 0;
+  double containing_in_memory = timePerCall(iterations, [&]() {
+    const auto& probe = probes[i++ % probes.size()];
+    knowledge_rep::Point(0, "probe", probe.first, probe.second, map, ltmc).getContainingRegions();
+  });
+  report("containing regions, in-memory index", containing_indexed, containing_in_memory);
+  double contained_in_memory =
+      timePerCall(iterations, [&]() { regions[region_index(generator)].getContainedPoints(); });
+  report("contained points, in-memory index", contained_indexed, contained_in_memory);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
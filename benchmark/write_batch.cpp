@@ -0,0 +1,45 @@
+/**
+ * Compares writing the facts from one perception cycle with a commit per operation against writing them in a single
+ * WriteBatch. Run against a scratch knowledge base; the benchmark clears it.
+ */
+#include <knowledge_representation/LongTermMemoryConduit.h>
+#include <knowledge_representation/convenience.h>
+#include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCWriteBatch.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "benchmark.h"
+
+using knowledge_rep::benchmark::report;
+using knowledge_rep::benchmark::timePerCall;
+
+int main(int argc, char** argv)
+{
+  size_t facts_per_cycle = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50;
+  size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100;
+  auto ltmc = knowledge_rep::getDefaultLTMC();
+  ltmc.deleteAllAttributes();
+  ltmc.deleteAllEntities();
+
+  // Each fact is a new entity with one attribute, so a cycle is twice as many writes as facts
+  auto write_cycle = [&]() {
+    for (size_t i = 0; i < facts_per_cycle; i++)
+    {
+      ltmc.addEntity().addAttribute("count", static_cast<int>(i));
+    }
+  };
+
+  double unbatched = timePerCall(iterations, write_cycle);
+  ltmc.deleteAllEntities();
+  double batched = timePerCall(iterations, [&]() {
+    knowledge_rep::WriteBatch batch{ ltmc };
+    write_cycle();
+  });
+  report("write cycle (" + std::to_string(facts_per_cycle) + " facts)", unbatched, batched);
+  std::printf("%-50s %12.0f -> %10.0f writes/s\n", "throughput", 2e6 * facts_per_cycle / unbatched,
+              2e6 * facts_per_cycle / batched);
+
+  ltmc.deleteAllEntities();
+  return 0;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <knowledge_representation/EntityAttribute.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * @brief Entity attributes stored column by column
+ *
+ * Entity IDs, attribute names and type tags each get an array with one entry per row. Names are stored once each and
+ * rows hold an index into them. Values go in one array per type, and each row holds the index of its value in its
+ * type's array. String values are packed end to end in a single arena. Scanning one column, say to count an attribute
+ * or sum its values, reads contiguous memory and touches nothing else, and filling a batch allocates only when a
+ * column grows.
+ *
+ * Rows keep the order they were added in. Reading a row back as an EntityAttribute reassembles it from the columns.
+ */
+class AttributeBatch
+{
+public:
+  size_t size() const
+  {
+    return entity_ids.size();
+  }
+
+  bool empty() const
+  {
+    return entity_ids.empty();
+  }
+
+  /// Forgets every row, keeping the columns' memory for reuse
+  void clear();
+
+  /// Makes room for some number of rows. Value columns grow as values of their type arrive.
+  void reserve(size_t rows);
+
+  void emplace_back(uint entity_id, const AttributeString& attribute_name, const AttributeValue& value);
+
+  void push_back(const EntityAttribute& attribute)
+  {
+    emplace_back(attribute.entity_id, attribute.attribute_name, attribute.value);
+  }
+
+  /// Adds every row of another batch after this one's
+  void append(const AttributeBatch& other);
+
+  /// Reassembles a row
+  EntityAttribute operator[](size_t row) const
+  {
+    return { static_cast<int>(entity_ids[row]), names[name_indexes[row]], value(row) };
+  }
+
+  uint entityId(size_t row) const
+  {
+    return entity_ids[row];
+  }
+
+  const AttributeString& attributeName(size_t row) const
+  {
+    return names[name_indexes[row]];
+  }
+
+  AttributeValueType type(size_t row) const
+  {
+    return static_cast<AttributeValueType>(types[row]);
+  }
+
+  AttributeValue value(size_t row) const;
+
+  /// The entity ID of each row
+  const std::vector<uint>& entityIdColumn() const
+  {
+    return entity_ids;
+  }
+
+  /// The index in attributeNames() of each row's attribute name
+  const std::vector<uint32_t>& nameIndexColumn() const
+  {
+    return name_indexes;
+  }
+
+  /// The distinct attribute names of the batch, in the order they were first added
+  const std::vector<AttributeString>& attributeNames() const
+  {
+    return names;
+  }
+
+  /// The AttributeValueType of each row
+  const std::vector<uint8_t>& typeColumn() const
+  {
+    return types;
+  }
+
+  /// The index of each row's value in the value column of its type
+  const std::vector<uint32_t>& valueIndexColumn() const
+  {
+    return value_indexes;
+  }
+
+  const std::vector<uint>& idValues() const
+  {
+    return id_values;
+  }
+
+  /// Bools, one byte each
+  const std::vector<uint8_t>& boolValues() const
+  {
+    return bool_values;
+  }
+
+  const std::vector<int>& intValues() const
+  {
+    return int_values;
+  }
+
+  const std::vector<double>& floatValues() const
+  {
+    return float_values;
+  }
+
+  size_t stringCount() const
+  {
+    return string_offsets.size() - 1;
+  }
+
+  /**
+   * @brief Gets a string value from the arena
+   * @param index the value's index in the string column, as valueIndexColumn() gives it
+   * @param size set to the string's length
+   * @return the string's first character. Strings in the arena aren't NUL terminated.
+   */
+  const char* stringValue(size_t index, size_t& size) const
+  {
+    size = string_offsets[index + 1] - string_offsets[index];
+    return string_arena.data() + string_offsets[index];
+  }
+
+private:
+  /// The index of a name in names, adding it if the batch hasn't seen it
+  uint32_t nameIndex(const AttributeString& name);
+
+  std::vector<uint> entity_ids;
+  std::vector<uint32_t> name_indexes;
+  std::vector<uint8_t> types;
+  std::vector<uint32_t> value_indexes;
+
+  std::vector<AttributeString> names;
+  std::map<AttributeString, uint32_t> name_lookup;
+
+  std::vector<uint> id_values;
+  std::vector<uint8_t> bool_values;
+  std::vector<int> int_values;
+  std::vector<double> float_values;
+  std::string string_arena;
+  /// Where each string starts in the arena, followed by the arena's end
+  std::vector<uint32_t> string_offsets = { 0 };
+};
+}  // namespace knowledge_rep
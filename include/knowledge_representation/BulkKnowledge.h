@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <boost/optional.hpp>
+#include "EntityAttribute.h"
+
+namespace knowledge_rep
+{
+/**
+ * @brief Identifies a concept or an instance by name in a bulk load
+ *
+ * Concepts are identified by their name alone. Instances are identified by their name together with the concept they
+ * are an instance of, the same way the knowledge loader identifies them.
+ */
+struct BulkEntityRef
+{
+  std::string name;
+  /// The concept the instance belongs to. Empty when referring to a concept.
+  std::string concept_name;
+
+  static BulkEntityRef conceptNamed(std::string name)
+  {
+    return { std::move(name), "" };
+  }
+
+  static BulkEntityRef instanceNamed(std::string name, std::string concept_name)
+  {
+    return { std::move(name), std::move(concept_name) };
+  }
+
+  bool isConcept() const
+  {
+    return concept_name.empty();
+  }
+};
+
+/**
+ * @brief An attribute to set on a concept or instance in a bulk load
+ */
+struct BulkAttribute
+{
+  BulkEntityRef entity;
+  std::string attribute_name;
+  /// The value, unless the attribute points at another entity named in the load
+  AttributeValue value;
+  /// The entity the attribute points at. Takes the place of value when set.
+  boost::optional<BulkEntityRef> value_entity;
+};
+
+/**
+ * @brief Name-keyed knowledge to be written in one bulk load
+ *
+ * Every concept and instance named anywhere in the load is created if it doesn't exist yet, so attributes may point
+ * at entities that appear nowhere else. Anything that already exists is reused, and attributes that are already set
+ * are left alone.
+ */
+struct BulkKnowledge
+{
+  std::vector<std::string> concepts;
+  /// Instances, each of which is made an instance of the concept it is identified by
+  std::vector<BulkEntityRef> instances;
+  /// Additional concepts that instances are instances of
+  std::vector<std::pair<BulkEntityRef, std::string>> instance_of;
+  std::vector<BulkAttribute> attributes;
+};
+
+/**
+ * @brief The entity IDs a bulk load resolved, parallel to the concepts and instances of its BulkKnowledge
+ */
+struct BulkLoadResult
+{
+  std::vector<uint> concept_ids;
+  std::vector<uint> instance_ids;
+};
+}  // namespace knowledge_rep
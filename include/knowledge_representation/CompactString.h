@@ -0,0 +1,177 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace knowledge_rep
+{
+/**
+ * @brief Keeps a copy of a string for the life of the process
+ *
+ * Equal strings share one copy, so each distinct string is only ever stored once.
+ * @return the copy, which is never freed
+ */
+const std::string* internString(const char* str, size_t size);
+
+/**
+ * @brief A string stored in place when it's at most Capacity bytes, and interned when it's longer
+ *
+ * Making a short one never allocates, and any is trivially copyable, so structs holding one can be copied and stored in
+ * bulk as cheaply as plain numbers. Longer strings are kept by internString, so they should be rare and drawn from a
+ * small set. It converts to std::string wherever one is expected.
+ * @tparam Capacity the most bytes stored in place. It must be less than 255 and leave room for a pointer.
+ */
+template <size_t Capacity>
+class CompactString
+{
+  static_assert(Capacity < 255, "CompactString stores its size in a byte");
+  static_assert(Capacity + 1 >= sizeof(const std::string*), "CompactString stores interned strings in place of chars");
+
+public:
+  static const size_t capacity = Capacity;
+
+  CompactString() : length(0)
+  {
+    chars[0] = '\0';
+  }
+
+  CompactString(const char* str, size_t size)
+  {
+    if (size > Capacity)
+    {
+      const std::string* interned = internString(str, size);
+      std::memcpy(chars, &interned, sizeof(interned));
+      length = INTERNED;
+      return;
+    }
+    if (size > 0)
+    {
+      std::memcpy(chars, str, size);
+    }
+    chars[size] = '\0';
+    length = static_cast<unsigned char>(size);
+  }
+
+  CompactString(const char* str) : CompactString(str, std::strlen(str))  // NOLINT(runtime/explicit)
+  {
+  }
+
+  CompactString(const std::string& str) : CompactString(str.data(), str.size())  // NOLINT(runtime/explicit)
+  {
+  }
+
+  size_t size() const
+  {
+    return length == INTERNED ? interned()->size() : length;
+  }
+
+  bool empty() const
+  {
+    return length == 0;
+  }
+
+  /// The characters, NUL terminated
+  const char* c_str() const
+  {
+    return length == INTERNED ? interned()->c_str() : chars;
+  }
+
+  std::string str() const
+  {
+    return length == INTERNED ? *interned() : std::string(chars, length);
+  }
+
+  operator std::string() const
+  {
+    return str();
+  }
+
+  bool operator==(const CompactString& other) const
+  {
+    // Interned strings are never stored in place, and equal ones share a copy
+    if (length == INTERNED || other.length == INTERNED)
+    {
+      return length == other.length && interned() == other.interned();
+    }
+    return length == other.length && std::memcmp(chars, other.chars, length) == 0;
+  }
+
+  bool operator!=(const CompactString& other) const
+  {
+    return !(*this == other);
+  }
+
+  bool operator<(const CompactString& other) const
+  {
+    size_t size = this->size();
+    size_t other_size = other.size();
+    int order = std::memcmp(c_str(), other.c_str(), std::min(size, other_size));
+    return order < 0 || (order == 0 && size < other_size);
+  }
+
+  friend bool operator==(const CompactString& a, const std::string& b)
+  {
+    return a.size() == b.size() && std::memcmp(a.c_str(), b.data(), b.size()) == 0;
+  }
+
+  friend bool operator==(const std::string& a, const CompactString& b)
+  {
+    return b == a;
+  }
+
+  friend bool operator!=(const CompactString& a, const std::string& b)
+  {
+    return !(a == b);
+  }
+
+  friend bool operator!=(const std::string& a, const CompactString& b)
+  {
+    return !(b == a);
+  }
+
+  friend bool operator==(const CompactString& a, const char* b)
+  {
+    size_t size = a.size();
+    return std::strlen(b) == size && std::memcmp(a.c_str(), b, size) == 0;
+  }
+
+  friend bool operator==(const char* a, const CompactString& b)
+  {
+    return b == a;
+  }
+
+  friend bool operator!=(const CompactString& a, const char* b)
+  {
+    return !(a == b);
+  }
+
+  friend bool operator!=(const char* a, const CompactString& b)
+  {
+    return !(b == a);
+  }
+
+  friend std::ostream& operator<<(std::ostream& strm, const CompactString& str)
+  {
+    return strm.write(str.c_str(), str.size());
+  }
+
+private:
+  /// The length that marks an interned string, whose copy's address is held in place of the chars
+  static const unsigned char INTERNED = 255;
+
+  const std::string* interned() const
+  {
+    const std::string* interned;
+    std::memcpy(&interned, chars, sizeof(interned));
+    return interned;
+  }
+
+  char chars[Capacity + 1];
+  unsigned char length;
+};
+
+template <size_t Capacity>
+const size_t CompactString<Capacity>::capacity;
+}  // namespace knowledge_rep
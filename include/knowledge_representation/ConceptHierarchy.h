@@ -0,0 +1,81 @@
+#pragma once
+
+#include <boost/dynamic_bitset.hpp>
+#include <sys/types.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * @brief The transitive closure of is_a, kept in memory so that subsumption checks don't touch the database
+ *
+ * Every entity that takes part in an is_a relation gets a bitset of the entities it descends from, itself included,
+ * so asking whether one concept is a kind of another is two hash lookups and a bit test. Adding a relation ORs the
+ * parent's bitset into those of the child's descendants. Removing one marks the closure stale, and it's recomputed by
+ * the next check, so a run of removals only costs one recomputation.
+ *
+ * Conduits also keep here the concepts that instances are directly an instance of, filled in as instances are asked
+ * about. The hierarchy doesn't lock. Conduits guard it with locks of their own.
+ */
+class ConceptHierarchy
+{
+public:
+  /// Forgets every relation and instance
+  void clear();
+
+  /**
+   * @brief Replaces the relations with the given ones, and forgets every instance
+   * @param is_a (child, parent) pairs
+   */
+  void reset(const std::vector<std::pair<uint, uint>>& is_a);
+
+  /// Records that child is_a parent
+  void addIsA(uint child, uint parent);
+
+  /// Forgets that child is_a parent
+  void removeIsA(uint child, uint parent);
+
+  /// Forgets every is_a relation from child
+  void removeIsA(uint child);
+
+  /// Forgets every is_a relation from or to the entity
+  void removeEntity(uint entity_id);
+
+  /// @return whether descendant is ancestor, or is transitively a kind of it
+  bool isA(uint descendant, uint ancestor) const;
+
+  /// @return whether the concepts of the instance have been recorded
+  bool knowsInstance(uint instance_id) const;
+
+  /// Records the concepts that an instance is directly an instance of
+  void setConcepts(uint instance_id, std::vector<uint> concept_ids);
+
+  /// Records another concept of an instance. Instances whose concepts haven't been recorded are left unknown.
+  void addConcept(uint instance_id, uint concept_id);
+
+  void forgetInstances();
+
+  /// @return whether one of the instance's recorded concepts is the concept, or is transitively a kind of it
+  bool instanceOf(uint instance_id, uint concept_id) const;
+
+private:
+  /// The index of an entity's node, adding one if it has none
+  uint node(uint entity_id);
+
+  void recompute() const;
+
+  /// Node indexes by entity ID
+  std::unordered_map<uint, uint> nodes;
+  /// The direct parents of each node
+  std::vector<std::vector<uint>> parents;
+  /// Each node's ancestors, itself included. Sized in doubling steps so that adding a node rarely resizes them all.
+  mutable std::vector<boost::dynamic_bitset<>> ancestors;
+  size_t capacity = 0;
+  /// Set when relations have been removed since the ancestors were last computed
+  mutable bool stale = false;
+  /// Concept IDs by instance
+  std::unordered_map<uint, std::vector<uint>> instance_concepts;
+};
+}  // namespace knowledge_rep
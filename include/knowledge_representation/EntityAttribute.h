@@ -1,7 +1,17 @@
 #pragma once
+#include <knowledge_representation/CompactString.h>
 #include <string>
-#include <boost/variant.hpp>
+#include <boost/optional.hpp>
+#include <boost/variant/get.hpp>
 #include <boost/unordered_map.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cmath>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <typeinfo>
 #include <utility>
 #include <map>
 
@@ -25,38 +35,308 @@ static std::map<std::string, AttributeValueType> string_to_attribute_value_type
 static std::map<AttributeValueType, std::string> attribute_value_type_to_string = {
   { Id, "id" }, { Bool, "bool" }, { Int, "int" }, { Float, "float" }, { Str, "str" },
 };
-typedef boost::variant<uint, bool, int, double, std::string> AttributeValue;
 
-static std::string toString(const AttributeValue& attribute_value)
+/// The most characters an attribute name or string value may have. The schemas store both as varchar(24).
+static const size_t MAX_ATTRIBUTE_STRING_LENGTH = 24;
+
+/**
+ * @brief An attribute name or string value
+ *
+ * 30 bytes in place keeps AttributeValue and EntityAttribute the size they were when values held std::strings. Every
+ * ASCII name or value the schemas take is held in place, so only ones of mostly multibyte characters are interned.
+ */
+typedef CompactString<30> AttributeString;
+
+/**
+ * @brief Checks that a string can be an attribute name or string value
+ *
+ * Characters are counted as varchar(24) counts them, so every backend takes the same strings.
+ * @param str UTF-8 text
+ * @return whether the string has at most MAX_ATTRIBUTE_STRING_LENGTH characters
+ */
+inline bool fitsAttributeString(const std::string& str)
+{
+  // Every character has exactly one byte that doesn't continue another
+  auto length =
+      std::count_if(str.begin(), str.end(), [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; });
+  return length <= static_cast<std::ptrdiff_t>(MAX_ATTRIBUTE_STRING_LENGTH);
+}
+
+/**
+ * @brief An ID, bool, int, float or string, tagged with which one it is
+ *
+ * Strings are held as AttributeStrings, so values can be copied like plain numbers. The LTMCs check strings with
+ * fitsAttributeString before storing values of them.
+ */
+class AttributeValue
+{
+public:
+  AttributeValue() : tag(Id), id_value(0)
+  {
+  }
+
+  AttributeValue(uint value) : tag(Id), id_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  AttributeValue(bool value) : tag(Bool), bool_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  AttributeValue(int value) : tag(Int), int_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  AttributeValue(double value) : tag(Float), float_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  AttributeValue(const AttributeString& value) : tag(Str), str_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  AttributeValue(const std::string& value) : tag(Str), str_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  AttributeValue(const char* value) : tag(Str), str_value(value)  // NOLINT(runtime/explicit)
+  {
+  }
+
+  /// @return the value's type, as an AttributeValueType
+  int which() const
+  {
+    return tag;
+  }
+
+  /// @return the type the value is held as, as boost::variant's type() gives it
+  const std::type_info& type() const
+  {
+    switch (tag)
+    {
+      case Id:
+        return typeid(uint);
+      case Bool:
+        return typeid(bool);
+      case Int:
+        return typeid(int);
+      case Float:
+        return typeid(double);
+      default:
+        return typeid(std::string);
+    }
+  }
+
+  /**
+   * @brief Reads the value as one of uint, bool, int, double, std::string or AttributeString
+   * @throws boost::bad_get if the value is of another type, as boost::get does
+   */
+  template <typename T>
+  T get() const;
+
+  bool operator==(const AttributeValue& other) const
+  {
+    if (tag != other.tag)
+    {
+      return false;
+    }
+    switch (tag)
+    {
+      case Id:
+        return id_value == other.id_value;
+      case Bool:
+        return bool_value == other.bool_value;
+      case Int:
+        return int_value == other.int_value;
+      case Float:
+        return float_value == other.float_value;
+      default:
+        return str_value == other.str_value;
+    }
+  }
+
+  bool operator!=(const AttributeValue& other) const
+  {
+    return !(*this == other);
+  }
+
+private:
+  /// Throws unless the value is of the given type
+  void expect(AttributeValueType expected) const
+  {
+    if (tag != expected)
+    {
+      throw boost::bad_get();
+    }
+  }
+
+  AttributeValueType tag;
+  union
+  {
+    uint id_value;
+    bool bool_value;
+    int int_value;
+    double float_value;
+    AttributeString str_value;
+  };
+};
+
+template <>
+inline uint AttributeValue::get<uint>() const
+{
+  expect(Id);
+  return id_value;
+}
+
+template <>
+inline bool AttributeValue::get<bool>() const
+{
+  expect(Bool);
+  return bool_value;
+}
+
+template <>
+inline int AttributeValue::get<int>() const
+{
+  expect(Int);
+  return int_value;
+}
+
+template <>
+inline double AttributeValue::get<double>() const
+{
+  expect(Float);
+  return float_value;
+}
+
+template <>
+inline AttributeString AttributeValue::get<AttributeString>() const
+{
+  expect(Str);
+  return str_value;
+}
+
+template <>
+inline std::string AttributeValue::get<std::string>() const
+{
+  expect(Str);
+  return str_value.str();
+}
+
+inline std::ostream& operator<<(std::ostream& strm, const AttributeValue& value)
+{
+  switch (value.which())
+  {
+    case Id:
+      return strm << value.get<uint>();
+    case Bool:
+      return strm << value.get<bool>();
+    case Int:
+      return strm << value.get<int>();
+    case Float:
+      return strm << value.get<double>();
+    default:
+      return strm << value.get<AttributeString>();
+  }
+}
+
+inline std::string toString(const AttributeValue& attribute_value)
 {
   switch (attribute_value.which())
   {
-    case 0:
-      return std::to_string(boost::get<uint>(attribute_value));
-    case 1:
-      return std::to_string(boost::get<bool>(attribute_value));
-    case 2:
-      return std::to_string(boost::get<int>(attribute_value));
-    case 3:
-      return std::to_string(boost::get<double>(attribute_value));
-    case 4:
-      return boost::get<std::string>(attribute_value);
+    case Id:
+      return std::to_string(attribute_value.get<uint>());
+    case Bool:
+      return std::to_string(attribute_value.get<bool>());
+    case Int:
+      return std::to_string(attribute_value.get<int>());
+    case Float:
+      return std::to_string(attribute_value.get<double>());
+    case Str:
+      return attribute_value.get<std::string>();
     default:
       assert(false);
+      return {};
   }
 }
 
+/**
+ * @brief Converts a value to an attribute type, as long as no information is lost
+ *
+ * Numbers convert between the numeric types when the new type holds them exactly, and 0 and 1 convert to bools. This
+ * lets callers pass whichever numeric type they have on hand; the Python bindings, for one, hand every number over as
+ * a double.
+ * @return the value as the given type, or none if it can't be stored as that type
+ */
+inline boost::optional<AttributeValue> convertAttributeValue(const AttributeValue& value, AttributeValueType type)
+{
+  if (value.which() == type)
+  {
+    return value;
+  }
+  if (value.which() == Str || type == Str)
+  {
+    return {};
+  }
+  // Everything else is a number, and a double holds any of them exactly
+  double number;
+  switch (value.which())
+  {
+    case Id:
+      number = value.get<uint>();
+      break;
+    case Bool:
+      number = value.get<bool>() ? 1 : 0;
+      break;
+    case Int:
+      number = value.get<int>();
+      break;
+    default:
+      number = value.get<double>();
+      break;
+  }
+  switch (type)
+  {
+    case Id:
+      if (number == std::floor(number) && number >= 0 && number <= std::numeric_limits<uint>::max())
+      {
+        return AttributeValue(static_cast<uint>(number));
+      }
+      break;
+    case Bool:
+      if (number == 0 || number == 1)
+      {
+        return AttributeValue(number == 1);
+      }
+      break;
+    case Int:
+      if (number == std::floor(number) && number >= std::numeric_limits<int>::min() &&
+          number <= std::numeric_limits<int>::max())
+      {
+        return AttributeValue(static_cast<int>(number));
+      }
+      break;
+    case Float:
+      return AttributeValue(number);
+    default:
+      break;
+  }
+  return {};
+}
+
 /**
  * @brief A tuple of an entity id, an attribute name, and a value.
+ *
+ * Trivially copyable, so reading attributes in bulk doesn't allocate for each one.
  */
 struct EntityAttribute
 {
   uint entity_id;
-  std::string attribute_name;
+  AttributeString attribute_name;
   AttributeValue value;
 
-  EntityAttribute(int entity_id, std::string attribute_name, AttributeValue value)
-    : entity_id(entity_id), attribute_name(std::move(attribute_name)), value(std::move(value))
+  EntityAttribute(int entity_id, const AttributeString& attribute_name, const AttributeValue& value)
+    : entity_id(entity_id), attribute_name(attribute_name), value(value)
   {
   }
 
@@ -79,7 +359,7 @@ struct EntityAttribute
 */
   uint getIdValue() const
   {
-    return boost::get<uint>(value);
+    return value.get<uint>();
   }
 
   /**
@@ -90,7 +370,7 @@ struct EntityAttribute
  */
   bool getBoolValue() const
   {
-    return boost::get<bool>(value);
+    return value.get<bool>();
   }
 
   /**
@@ -101,7 +381,7 @@ struct EntityAttribute
    */
   int getIntValue() const
   {
-    return boost::get<int>(value);
+    return value.get<int>();
   }
 
   /**
@@ -112,7 +392,7 @@ struct EntityAttribute
    */
   double getFloatValue() const
   {
-    return boost::get<double>(value);
+    return value.get<double>();
   }
 
   /**
@@ -123,13 +403,17 @@ struct EntityAttribute
    */
   std::string getStringValue() const
   {
-    return boost::get<std::string>(value);
+    return value.get<std::string>();
   }
 
-  bool operator==(const EntityAttribute& other)
+  bool operator==(const EntityAttribute& other) const
   {
     return (this->entity_id == other.entity_id) && (this->attribute_name == other.attribute_name) &&
            (this->value == other.value);
   }
 };
+
+static_assert(std::is_trivially_copyable<EntityAttribute>::value, "EntityAttributes should copy without allocating");
+static_assert(sizeof(AttributeValue) <= 40 && sizeof(EntityAttribute) <= 80,
+              "EntityAttributes should be no bigger than they were when values held std::strings");
 }  // namespace knowledge_rep
@@ -8,6 +8,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <memory>
 
 namespace knowledge_rep
 {
@@ -19,8 +20,8 @@ class LTMCDoor : public LTMCInstance<LTMCImpl>
   using MapImpl = LTMCMap<LTMCImpl>;
 
 public:
-  /// The map that owns this door
-  MapImpl parent_map;
+  /// The map that owns this door. Geometry read together shares one copy of it.
+  std::shared_ptr<const MapImpl> parent_map;
 
   /// The x component of the first point of the door line
   double x_0;
@@ -31,9 +32,20 @@ public:
   /// The y component of the second point of the door line
   double y_1;
 
-  LTMCDoor(uint entity_id, std::string name, double x_0, double y_0, double x_1, double y_1, MapImpl parent_map,
-           LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
-    : parent_map(parent_map), x_0(x_0), y_0(y_0), x_1(x_1), y_1(y_1), InstanceImpl(entity_id, name, ltmc)
+  LTMCDoor(uint entity_id, std::string name, double x_0, double y_0, double x_1, double y_1,
+           std::shared_ptr<const MapImpl> parent_map, LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
+    : parent_map(std::move(parent_map))
+    , x_0(x_0)
+    , y_0(y_0)
+    , x_1(x_1)
+    , y_1(y_1)
+    , InstanceImpl(entity_id, std::move(name), ltmc)
+  {
+  }
+
+  LTMCDoor(uint entity_id, std::string name, double x_0, double y_0, double x_1, double y_1,
+           const MapImpl& parent_map, LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
+    : LTMCDoor(entity_id, std::move(name), x_0, y_0, x_1, y_1, std::make_shared<const MapImpl>(parent_map), ltmc)
   {
   }
 
@@ -58,7 +70,7 @@ public:
 template <typename LTMCImpl>
 std::ostream& operator<<(std::ostream& strm, const LTMCDoor<LTMCImpl>& p)
 {
-  return strm << "Door(" << p.entity_id << " \"" << p.getName() << "\" " << p.parent_map << " (" << p.x_0 << ", "
+  return strm << "Door(" << p.entity_id << " \"" << p.getName() << "\" " << *p.parent_map << " (" << p.x_0 << ", "
               << p.y_0 << ") (" << p.x_1 << ", " << p.y_1 << "))";
 }
 
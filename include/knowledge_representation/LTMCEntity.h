@@ -143,7 +143,7 @@ public:
     auto name_attrs = getAttributes("name");
     if (!name_attrs.empty())
     {
-      return boost::get<std::string>(name_attrs[0].value);
+      return name_attrs[0].getStringValue();
     }
     else
     {
@@ -54,7 +54,7 @@ public:
     auto name_attrs = this->ltmc.get().getAttributes(*this, "name");
     if (!name_attrs.empty())
     {
-      name = boost::get<std::string>(name_attrs[0].value);
+      name = name_attrs[0].getStringValue();
       return name;
     }
     return {};
@@ -106,12 +106,14 @@ public:
   }
   /**
    * @brief whether instance descends from the concept recursively
+   *
+   * Answered from the LTMC's in-memory index of is_a, so repeated checks don't go to the database. The index follows
+   * changes made through the LTMC, but not changes that other processes make to the database.
    * @return
    */
   bool hasConceptRecursively(const LTMCConcept<LTMCImpl>& concept) const
   {
-    auto concepts = this->getConceptsRecursive();
-    return std::find(concepts.begin(), concepts.end(), concept) != concepts.end();
+    return this->ltmc.get().hasConceptRecursively(*this, concept);
   }
 };
 
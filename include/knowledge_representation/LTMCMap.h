@@ -199,6 +199,121 @@ public:
     return this->ltmc.get().getAllDoors(*this);
   }
 
+  /**
+   * @brief Get the points of this map closest to a location
+   *
+   * Answered from an in-memory index of the map's geometry, so it's cheap enough to call on every replan
+   * @param k how many points to return. Fewer come back if the map doesn't have that many
+   * @return the points, nearest first
+   */
+  std::vector<PointImpl> getNearestPoints(double x, double y, size_t k)
+  {
+    return this->ltmc.get().getNearestPoints(*this, x, y, k);
+  }
+
+  /**
+   * @brief Get the poses of this map closest to a location
+   * @param k how many poses to return. Fewer come back if the map doesn't have that many
+   * @return the poses, nearest first
+   */
+  std::vector<PoseImpl> getNearestPoses(double x, double y, size_t k)
+  {
+    return this->ltmc.get().getNearestPoses(*this, x, y, k);
+  }
+
+  /**
+   * @brief Get the doors of this map closest to a location, measured to the closest point of each door
+   * @param k how many doors to return. Fewer come back if the map doesn't have that many
+   * @return the doors, nearest first
+   */
+  std::vector<DoorImpl> getNearestDoors(double x, double y, size_t k)
+  {
+    return this->ltmc.get().getNearestDoors(*this, x, y, k);
+  }
+
+  /**
+   * @brief Get the points of this map within some distance of a location, boundary included
+   * @return the points, nearest first
+   */
+  std::vector<PointImpl> getPointsWithinRadius(double x, double y, double radius)
+  {
+    return this->ltmc.get().getPointsWithinRadius(*this, x, y, radius);
+  }
+
+  /**
+   * @brief Get the poses of this map within some distance of a location, boundary included
+   * @return the poses, nearest first
+   */
+  std::vector<PoseImpl> getPosesWithinRadius(double x, double y, double radius)
+  {
+    return this->ltmc.get().getPosesWithinRadius(*this, x, y, radius);
+  }
+
+  /**
+   * @brief Get the doors of this map that come within some distance of a location, boundary included
+   * @return the doors, nearest first
+   */
+  std::vector<DoorImpl> getDoorsWithinRadius(double x, double y, double radius)
+  {
+    return this->ltmc.get().getDoorsWithinRadius(*this, x, y, radius);
+  }
+
+  /**
+   * @brief Get the regions that share a door with a region
+   *
+   * A door joins the regions that its line touches. The map's region graph is built on first use and kept until the
+   * map's regions or doors change, so topology queries are cheap enough to make for every plan.
+   * @return the adjacent regions
+   */
+  std::vector<RegionImpl> getAdjacentRegions(const RegionImpl& region)
+  {
+    return this->ltmc.get().getAdjacentRegions(*this, region);
+  }
+
+  /**
+   * @brief Get the regions that can be reached from a region by passing through doors
+   * @return the reachable regions, including the region itself, or none if the region isn't on this map
+   */
+  std::vector<RegionImpl> getReachableRegions(const RegionImpl& region)
+  {
+    return this->ltmc.get().getReachableRegions(*this, region);
+  }
+
+  /**
+   * @brief Checks whether a path through doors leads from one region to another
+   * @return whether the region is reachable. A region on this map is always reachable from itself.
+   */
+  bool isRegionReachable(const RegionImpl& from, const RegionImpl& to)
+  {
+    return this->ltmc.get().isRegionReachable(*this, from, to);
+  }
+
+  /**
+   * @brief Get the regions along the path between two regions that passes through the fewest doors
+   * @return the regions in the order they are passed through, both ends included, or none if there's no path
+   */
+  std::vector<RegionImpl> getRegionPath(const RegionImpl& from, const RegionImpl& to)
+  {
+    std::vector<RegionImpl> regions;
+    std::vector<DoorImpl> doors;
+    this->ltmc.get().getShortestPath(*this, from, to, regions, doors);
+    return regions;
+  }
+
+  /**
+   * @brief Get the doors along the path between two regions that passes through the fewest doors
+   *
+   * The doors are those between consecutive regions of getRegionPath
+   * @return the doors in the order they are passed through, or none if the regions are the same or there's no path
+   */
+  std::vector<DoorImpl> getDoorPath(const RegionImpl& from, const RegionImpl& to)
+  {
+    std::vector<RegionImpl> regions;
+    std::vector<DoorImpl> doors;
+    this->ltmc.get().getShortestPath(*this, from, to, regions, doors);
+    return doors;
+  }
+
   /**
    * @brief Creates a copy of all of the map's owned geometry
    * @param with_name the name to use for the new map
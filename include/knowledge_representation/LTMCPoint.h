@@ -8,6 +8,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <memory>
 
 namespace knowledge_rep
 {
@@ -24,16 +25,22 @@ class LTMCPoint : public LTMCInstance<LTMCImpl>
   using RegionImpl = LTMCRegion<LTMCImpl>;
 
 public:
-  /// The map that owns this point
-  MapImpl parent_map;
+  /// The map that owns this point. Geometry read together shares one copy of it.
+  std::shared_ptr<const MapImpl> parent_map;
   /// The x component of the coordinate
   double x;
   /// The y component of the coordinate
   double y;
 
-  LTMCPoint(uint entity_id, std::string name, double x, double y, MapImpl parent_map,
+  LTMCPoint(uint entity_id, std::string name, double x, double y, std::shared_ptr<const MapImpl> parent_map,
             LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
-    : parent_map(parent_map), x(x), y(y), InstanceImpl(entity_id, name, ltmc)
+    : parent_map(std::move(parent_map)), x(x), y(y), InstanceImpl(entity_id, std::move(name), ltmc)
+  {
+  }
+
+  LTMCPoint(uint entity_id, std::string name, double x, double y, const MapImpl& parent_map,
+            LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
+    : LTMCPoint(entity_id, std::move(name), x, y, std::make_shared<const MapImpl>(parent_map), ltmc)
   {
   }
 
@@ -48,7 +55,8 @@ public:
    */
   std::vector<RegionImpl> getContainingRegions()
   {
-    return this->ltmc.get().getContainingRegions(parent_map, x, y);
+    MapImpl map = *parent_map;
+    return this->ltmc.get().getContainingRegions(map, x, y);
   }
 
   bool operator==(const LTMCPoint& other) const
@@ -65,7 +73,7 @@ public:
 template <typename LTMCImpl>
 std::ostream& operator<<(std::ostream& strm, const LTMCPoint<LTMCImpl>& p)
 {
-  return strm << "Point(" << p.entity_id << " \"" << p.getName() << "\" " << p.parent_map << " (" << p.x << ", " << p.y
+  return strm << "Point(" << p.entity_id << " \"" << p.getName() << "\" " << *p.parent_map << " (" << p.x << ", " << p.y
               << "))";
 }
 
@@ -7,6 +7,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <memory>
 
 namespace knowledge_rep
 {
@@ -24,17 +25,23 @@ class LTMCPose : public LTMCInstance<LTMCImpl>
   using RegionImpl = LTMCRegion<LTMCImpl>;
 
 public:
-  /// The map that owns this pose
-  MapImpl parent_map;
+  /// The map that owns this pose. Geometry read together shares one copy of it.
+  std::shared_ptr<const MapImpl> parent_map;
   /// The x component of the pose
   double x;
   /// The y component of the pose
   double y;
   /// The theta (in radians) component of the pose
   double theta;
-  LTMCPose(uint entity_id, std::string name, double x, double y, double theta, MapImpl parent_map,
+  LTMCPose(uint entity_id, std::string name, double x, double y, double theta,
+           std::shared_ptr<const MapImpl> parent_map, LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
+    : parent_map(std::move(parent_map)), x(x), y(y), theta(theta), InstanceImpl(entity_id, std::move(name), ltmc)
+  {
+  }
+
+  LTMCPose(uint entity_id, std::string name, double x, double y, double theta, const MapImpl& parent_map,
            LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
-    : parent_map(parent_map), x(x), y(y), theta(theta), InstanceImpl(entity_id, name, ltmc)
+    : LTMCPose(entity_id, std::move(name), x, y, theta, std::make_shared<const MapImpl>(parent_map), ltmc)
   {
   }
 
@@ -49,18 +56,19 @@ public:
    */
   std::vector<RegionImpl> getContainingRegions()
   {
-    return this->ltmc.get().getContainingRegions(parent_map, x, y);
+    MapImpl map = *parent_map;
+    return this->ltmc.get().getContainingRegions(map, x, y);
   }
 
   bool operator==(const LTMCPose& other) const
   {
-    return this->entity_id == other.entity_id && this->name == other.name && this->parent_map == other.parent_map &&
+    return this->entity_id == other.entity_id && this->name == other.name && *this->parent_map == *other.parent_map &&
            this->x == other.x && this->y == other.y && this->theta == other.theta;
   }
 
   bool operator!=(const LTMCPose& other) const
   {
-    return this->entity_id != other.entity_id || this->name != other.name || this->parent_map != other.parent_map ||
+    return this->entity_id != other.entity_id || this->name != other.name || *this->parent_map != *other.parent_map ||
            this->x != other.x || this->y != other.y || this->theta != other.theta;
   }
 };
@@ -68,7 +76,7 @@ public:
 template <typename LTMCImpl>
 std::ostream& operator<<(std::ostream& strm, const LTMCPose<LTMCImpl>& p)
 {
-  return strm << "Pose(" << p.entity_id << " \"" << p.getName() << "\" " << p.parent_map << " (" << p.x << ", " << p.y
+  return strm << "Pose(" << p.entity_id << " \"" << p.getName() << "\" " << *p.parent_map << " (" << p.x << ", " << p.y
               << ", " << p.theta << "))";
 }
 
@@ -0,0 +1,188 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * \brief The entities of some kind, read from the LTMC a page at a time as they're iterated over.
+ *
+ * Pages follow each other by entity ID, so only one page is ever held in memory and the first entities are available
+ * as soon as their page is read. No connection is held between pages, so the loop body may use the LTMC. As with
+ * forEachEntityBatch, pages aren't read from a single snapshot, so entities added or deleted during iteration may or
+ * may not be visited.
+ *
+ * Each call to begin() starts a new pass over the entities. Iterators are single pass: copies share their position.
+ * @tparam T an entity type, such as EntityImpl or ConceptImpl
+ */
+template <typename T>
+class LTMCRange
+{
+  struct Pass;
+
+public:
+  /// Reads at most limit entities with IDs after the given one, in order of ID, into page. Returns whether it could.
+  typedef std::function<bool(uint after_id, size_t limit, std::vector<T>& page)> PageReader;
+
+  class iterator
+  {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T* pointer;
+    typedef const T& reference;
+
+    /// The end of any range
+    iterator() = default;
+
+    reference operator*() const
+    {
+      return pass->page[pass->position];
+    }
+
+    pointer operator->() const
+    {
+      return &pass->page[pass->position];
+    }
+
+    iterator& operator++()
+    {
+      assert(pass);
+      if (++pass->position == pass->page.size())
+      {
+        pass->readNextPage();
+      }
+      if (pass->finished)
+      {
+        pass.reset();
+      }
+      return *this;
+    }
+
+    /// Only comparing with the end is meaningful, as all other iterators over a pass are at the same position
+    bool operator==(const iterator& other) const
+    {
+      return pass == other.pass;
+    }
+
+    bool operator!=(const iterator& other) const
+    {
+      return !(*this == other);
+    }
+
+  private:
+    friend class LTMCRange;
+
+    explicit iterator(std::shared_ptr<Pass> pass) : pass(pass->finished ? nullptr : std::move(pass))
+    {
+    }
+
+    std::shared_ptr<Pass> pass;
+  };
+
+  LTMCRange(PageReader read_page, size_t page_size) : read_page(std::move(read_page)), page_size(page_size)
+  {
+    assert(page_size > 0);
+  }
+
+  /// Reads the first page
+  iterator begin()
+  {
+    last_pass = std::make_shared<Pass>(read_page, page_size);
+    last_pass->readNextPage();
+    return iterator(last_pass);
+  }
+
+  iterator end() const
+  {
+    return {};
+  }
+
+  /**
+   * @brief Whether the most recent pass stopped early because a page couldn't be read
+   *
+   * Iteration just ends when a page can't be read, so check this afterwards to tell a failure from the last entity.
+   */
+  bool failed() const
+  {
+    return last_pass && last_pass->failed;
+  }
+
+private:
+  /// One pass over the entities, shared by every iterator begin() hands out for it
+  struct Pass
+  {
+    Pass(const PageReader& read_page, size_t page_size) : read_page(read_page), page_size(page_size)
+    {
+    }
+
+    /// Replaces the page with the one that follows it, or marks the pass finished if there isn't one
+    void readNextPage()
+    {
+      // A short page was the last, so there's no need to ask for another
+      if (started && page.size() < page_size)
+      {
+        finished = true;
+        return;
+      }
+      uint after_id = page.empty() ? 0 : page.back().entity_id;
+      started = true;
+      position = 0;
+      failed = !read_page(after_id, page_size, page);
+      finished = failed || page.empty();
+    }
+
+    PageReader read_page;
+    size_t page_size;
+    std::vector<T> page;
+    size_t position = 0;
+    bool started = false;
+    bool finished = false;
+    bool failed = false;
+  };
+
+  PageReader read_page;
+  size_t page_size;
+  std::shared_ptr<Pass> last_pass;
+};
+
+/**
+ * @brief Hands each page in turn to a callback, as the forEach*Batch scans do
+ *
+ * The callback may move entities out of the page, but shouldn't keep a reference to it, as it's reused.
+ * @return whether every page could be read
+ */
+template <typename T>
+bool forEachPage(const typename LTMCRange<T>::PageReader& read_page, size_t page_size,
+                 const std::function<void(std::vector<T>&)>& callback)
+{
+  assert(page_size > 0);
+  std::vector<T> page;
+  uint after_id = 0;
+  while (true)
+  {
+    if (!read_page(after_id, page_size, page))
+    {
+      return false;
+    }
+    const size_t num_read = page.size();
+    if (num_read == 0)
+    {
+      return true;
+    }
+    after_id = page.back().entity_id;
+    callback(page);
+    if (num_read < page_size)
+    {
+      return true;
+    }
+  }
+}
+
+}  // namespace knowledge_rep
@@ -2,11 +2,13 @@
 
 #include <knowledge_representation/LTMCInstance.h>
 #include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/PreparedPolygon.h>
 #include <utility>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <map>
+#include <memory>
 
 namespace knowledge_rep
 {
@@ -26,13 +28,19 @@ class LTMCRegion : public LTMCInstance<LTMCImpl>
 public:
   /// Shorthand for specifying 2D coordinates
   using Point2D = std::pair<double, double>;
-  /// The map that owns this region
-  MapImpl parent_map;
+  /// The map that owns this region. Geometry read together shares one copy of it.
+  std::shared_ptr<const MapImpl> parent_map;
   /// The points that define the closed boundary of the region
   std::vector<Point2D> points;
-  LTMCRegion(uint entity_id, std::string name, std::vector<Point2D> points, MapImpl parent_map,
+  LTMCRegion(uint entity_id, std::string name, std::vector<Point2D> points, std::shared_ptr<const MapImpl> parent_map,
              LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
-    : parent_map(parent_map), points(std::move(points)), InstanceImpl(entity_id, name, ltmc)
+    : parent_map(std::move(parent_map)), points(std::move(points)), InstanceImpl(entity_id, std::move(name), ltmc)
+  {
+  }
+
+  LTMCRegion(uint entity_id, std::string name, std::vector<Point2D> points, const MapImpl& parent_map,
+             LongTermMemoryConduitInterface<LTMCImpl>& ltmc)
+    : LTMCRegion(entity_id, std::move(name), std::move(points), std::make_shared<const MapImpl>(parent_map), ltmc)
   {
   }
 
@@ -61,49 +69,63 @@ public:
 
   /**
    * @brief Checks whether a point is in or on the bounds of the region
+   *
+   * The test runs against the region's own points, without a trip to the knowledge base
    * @return whether the point is contained in the region
    */
-  bool isPointContained(double x, double y)
+  bool isPointContained(double x, double y) const
   {
-    return this->ltmc.get().isPointContained(*this, x, y);
+    return polygonContains(points, x, y);
   }
 
   /**
    * @brief Checks whether a point is in or on the bounds of the region
    * @return whether the point is contained in the region
    */
-  bool isPointContained(const Point2D& point)
+  bool isPointContained(const Point2D& point) const
   {
-    return this->ltmc.get().isPointContained(*this, point.first, point.second);
+    return polygonContains(points, point.first, point.second);
   }
 
   /**
    * @brief Checks whether a point is in or on the bounds of the region
    * @return whether the point is contained in the region
    */
-  bool isPointContained(const PointImpl& point)
+  bool isPointContained(const PointImpl& point) const
+  {
+    return polygonContains(points, point.x, point.y);
+  }
+
+  /**
+   * @brief Checks whether many points are in or on the bounds of the region
+   *
+   * The region's edges are prepared once and the points tested against them several at a time, which is much faster
+   * than checking them one by one
+   * @return whether each point is contained in the region, in the order the points were given
+   */
+  std::vector<bool> isPointContained(const std::vector<Point2D>& query_points) const
   {
-    return this->ltmc.get().isPointContained(*this, point.x, point.y);
+    return PreparedPolygon(points).contains(query_points);
   }
 
   /**
    * @brief Checks whether a pose is in or on the bounds of the region
    * @return whether the pose is contained in the region
    */
-  bool isPoseContained(const PoseImpl& pose)
+  bool isPoseContained(const PoseImpl& pose) const
   {
-    return this->ltmc.get().isPointContained(*this, pose.x, pose.y);
+    return polygonContains(points, pose.x, pose.y);
   }
 
   bool operator==(const LTMCRegion& other) const
   {
-    return this->entity_id == other.entity_id && this->name == other.name && this->parent_map == other.parent_map &&
+    return this->entity_id == other.entity_id && this->name == other.name && *this->parent_map == *other.parent_map &&
            this->points == other.points;
   }
 
   bool operator!=(const LTMCRegion& other) const
   {
-    return this->entity_id != other.entity_id || this->name != other.name || this->parent_map != other.parent_map ||
+    return this->entity_id != other.entity_id || this->name != other.name || *this->parent_map != *other.parent_map ||
            this->points != other.points;
   }
 };
@@ -111,7 +133,7 @@ public:
 template <typename LTMCImpl>
 std::ostream& operator<<(std::ostream& strm, const LTMCRegion<LTMCImpl>& r)
 {
-  strm << "Region(" << r.entity_id << " \"" << r.getName() << "\" " << r.parent_map << " (";
+  strm << "Region(" << r.entity_id << " \"" << r.getName() << "\" " << *r.parent_map << " (";
   for (const auto& p : r.points)
   {
     strm << p.first << "," << p.second << " ";
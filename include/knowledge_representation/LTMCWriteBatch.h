@@ -0,0 +1,93 @@
+#pragma once
+#include <exception>
+#include <functional>
+#include <knowledge_representation/LongTermMemoryConduitInterface.h>
+
+namespace knowledge_rep
+{
+/**
+ * \brief Groups many knowledgebase operations into a single transaction.
+ *
+ * Every operation made through the LTMC, or through any entity belonging to it, while a batch is alive becomes part
+ * of the batch. The batch's changes are kept all together or not at all. They're committed when the batch goes out of
+ * scope, unless an exception is unwinding the stack, in which case they're discarded. A single operation that fails
+ * inside a batch (for instance, adding an attribute twice) only rolls back its own changes and reports failure as
+ * usual.
+ *
+ * Batches may be nested. A nested batch that aborts discards only its own changes, and a nested batch that commits
+ * still depends on the outer batch committing.
+ *
+ * Batches belong to the LTMC they were opened on and must be closed in the reverse of the order they were opened.
+ */
+template <typename LTMCImpl>
+class LTMCWriteBatch
+{
+public:
+  explicit LTMCWriteBatch(LongTermMemoryConduitInterface<LTMCImpl>& ltmc) : ltmc(ltmc), open(ltmc.beginWriteBatch())
+  {
+  }
+
+  LTMCWriteBatch(const LTMCWriteBatch&) = delete;
+
+  LTMCWriteBatch& operator=(const LTMCWriteBatch&) = delete;
+
+  ~LTMCWriteBatch()
+  {
+    if (!open)
+    {
+      return;
+    }
+    if (std::uncaught_exception())
+    {
+      abort();
+    }
+    else
+    {
+      commit();
+    }
+  }
+
+  /**
+   * @brief Makes the batch's changes permanent (or, for a nested batch, hands them to the enclosing batch)
+   *
+   * No further operations are part of this batch after it has been committed.
+   * @return whether the commit succeeded. If it fails, none of the batch's changes are kept
+   */
+  bool commit()
+  {
+    if (!open)
+    {
+      return false;
+    }
+    open = false;
+    return ltmc.get().commitWriteBatch();
+  }
+
+  /**
+   * @brief Discards every change made as part of this batch
+   */
+  void abort()
+  {
+    if (!open)
+    {
+      return;
+    }
+    open = false;
+    ltmc.get().abortWriteBatch();
+  }
+
+  /**
+   * @brief Whether the batch is still accepting operations
+   * @return false once the batch has been committed or aborted, or if it couldn't be started
+   */
+  bool isOpen() const
+  {
+    return open;
+  }
+
+private:
+  std::reference_wrapper<LongTermMemoryConduitInterface<LTMCImpl>> ltmc;
+  bool open;
+};
+
+}  // namespace knowledge_rep
@@ -0,0 +1,395 @@
+#pragma once
+
+#include <knowledge_representation/LongTermMemoryConduitInterface.h>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <memory>
+
+namespace knowledge_rep
+{
+/**
+ * @brief A concrete implementation of the LongTermMemoryConduitInterface that keeps the knowledgebase in process memory
+ *
+ * Entities, attributes, concepts and map geometry live in hash maps, with adjacency lists for the relations the
+ * interface walks (instances of a concept, entities pointing at an entity). Nothing leaves the process, so every
+ * lookup avoids a database round trip. This suits tests, simulation and robots that load their knowledge at startup.
+ *
+ * Conduits constructed with the same database name in the same process share one knowledgebase, which lasts until
+ * the last of them is destroyed. Raw SQL queries aren't supported.
+ */
+class LongTermMemoryConduitInMemory : public LongTermMemoryConduitInterface<LongTermMemoryConduitInMemory>
+{
+  using EntityImpl = LTMCEntity<LongTermMemoryConduitInMemory>;
+  using InstanceImpl = LTMCInstance<LongTermMemoryConduitInMemory>;
+  using ConceptImpl = LTMCConcept<LongTermMemoryConduitInMemory>;
+  using MapImpl = LTMCMap<LongTermMemoryConduitInMemory>;
+  using PointImpl = LTMCPoint<LongTermMemoryConduitInMemory>;
+  using PoseImpl = LTMCPose<LongTermMemoryConduitInMemory>;
+  using RegionImpl = LTMCRegion<LongTermMemoryConduitInMemory>;
+  using DoorImpl = LTMCDoor<LongTermMemoryConduitInMemory>;
+  using WriteBatchImpl = LTMCWriteBatch<LongTermMemoryConduitInMemory>;
+
+  // Give wrapper classes access to our protected members. Knowledgebase access
+  // is isolated into this class, so any wrapper methods that need to talk to the knowledgebase
+  // are implemented as protected members here.
+  friend EntityImpl;
+  friend InstanceImpl;
+  friend ConceptImpl;
+  friend MapImpl;
+  friend PointImpl;
+  friend PoseImpl;
+  friend RegionImpl;
+  friend DoorImpl;
+  friend WriteBatchImpl;
+
+  // Allow the interface to forward calls to our protected members
+  friend class LongTermMemoryConduitInterface;
+
+public:
+  /**
+   * @param db_name names the knowledgebase. Conduits with the same name share it.
+   * @param hostname unused. Accepted so that the backends are constructed the same way
+   * @param max_connections unused. Accepted so that the backends are constructed the same way
+   */
+  explicit LongTermMemoryConduitInMemory(const std::string& db_name, const std::string& hostname = "localhost",
+                                         size_t max_connections = 8);
+
+  // Move constructor
+  LongTermMemoryConduitInMemory(LongTermMemoryConduitInMemory&& that) noexcept;
+
+  ~LongTermMemoryConduitInMemory();
+
+  // Move assignment
+  LongTermMemoryConduitInMemory& operator=(LongTermMemoryConduitInMemory&& that) noexcept;
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name,
+                                                          const uint other_entity_id);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const bool bool_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const int int_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const double float_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const char* string_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name,
+                                                          const std::string& string_val);
+
+  bool entityExists(uint id) const;
+
+  bool addEntity(uint id);
+
+  boost::optional<EntityImpl> getEntity(uint entity_id);
+
+  boost::optional<InstanceImpl> getInstanceNamed(const ConceptImpl& concept, const std::string& name);
+
+  boost::optional<InstanceImpl> getInstance(uint entity_id);
+
+  boost::optional<ConceptImpl> getConcept(uint entity_id);
+
+  boost::optional<MapImpl> getMap(uint entity_id);
+
+  boost::optional<PointImpl> getPoint(uint entity_id);
+
+  boost::optional<PoseImpl> getPose(uint entity_id);
+
+  boost::optional<RegionImpl> getRegion(uint entity_id);
+
+  boost::optional<DoorImpl> getDoor(uint entity_id);
+
+  // ATTRIBUTES
+
+  bool addNewAttribute(const std::string& name, const AttributeValueType type);
+
+  bool deleteAttribute(const std::string& name);
+
+  bool attributeExists(const std::string& name) const;
+
+  // BULK OPERATIONS
+
+  std::vector<EntityImpl> getAllEntities();
+
+  std::vector<ConceptImpl> getAllConcepts();
+
+  std::vector<InstanceImpl> getAllInstances();
+
+  std::vector<MapImpl> getAllMaps();
+
+  std::vector<std::pair<std::string, AttributeValueType>> getAllAttributes() const;
+
+  std::vector<EntityAttribute> getAllEntityAttributes();
+
+  bool getAllEntityAttributes(AttributeBatch& attributes) const;
+
+  bool forEachEntityAttributeBatch(const std::function<void(std::vector<EntityAttribute>&)>& callback,
+                                   size_t batch_size = 10000) const;
+
+  bool forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                   size_t batch_size = 10000) const;
+
+  bool forEachEntityBatch(const std::function<void(std::vector<EntityImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool forEachConceptBatch(const std::function<void(std::vector<ConceptImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool forEachInstanceBatch(const std::function<void(std::vector<InstanceImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool getEntityPage(uint after_id, size_t limit, std::vector<EntityImpl>& page);
+
+  bool getConceptPage(uint after_id, size_t limit, std::vector<ConceptImpl>& page);
+
+  bool getInstancePage(uint after_id, size_t limit, std::vector<InstanceImpl>& page);
+
+  bool bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result);
+
+  std::vector<std::vector<ConceptImpl>> getConceptsRecursive(const std::vector<InstanceImpl>& instances);
+
+  bool getAttributes(const std::vector<EntityImpl>& entities, AttributeBatch& attributes) const;
+
+  std::vector<InstanceImpl> filterInstancesOf(const std::vector<InstanceImpl>& instances, const ConceptImpl& concept);
+
+  uint deleteAllEntities();
+
+  uint deleteAllAttributes();
+
+  // RAW QUERIES
+
+  bool selectQueryId(const std::string& sql_query, std::vector<EntityAttribute>&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryId(const std::string& sql_query, AttributeBatch&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryBool(const std::string& sql_query, std::vector<EntityAttribute>&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryBool(const std::string& sql_query, AttributeBatch&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryInt(const std::string& sql_query, std::vector<EntityAttribute>&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryInt(const std::string& sql_query, AttributeBatch&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryFloat(const std::string& sql_query, std::vector<EntityAttribute>&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryFloat(const std::string& sql_query, AttributeBatch&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryString(const std::string& sql_query, std::vector<EntityAttribute>&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  bool selectQueryString(const std::string& sql_query, AttributeBatch&) const
+  {
+    return selectQuery(sql_query);
+  }
+
+  // CONVENIENCE
+  ConceptImpl getConcept(const std::string& name);
+
+  MapImpl getMap(const std::string& name);
+
+  InstanceImpl getRobot();
+
+  EntityImpl addEntity();
+
+  // PROMOTERS
+
+  bool makeConcept(uint id, std::string name);
+
+protected:
+  // ENTITY BACKERS
+  bool deleteEntity(EntityImpl& entity);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const uint other_entity_id);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const bool bool_val);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const int int_val);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const double float_val);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const std::string& string_val);
+
+  int removeAttribute(EntityImpl& entity, const std::string& attribute_name);
+
+  int removeAttributeOfValue(EntityImpl& entity, const std::string& attribute_name, const EntityImpl& other_entity);
+
+  std::vector<EntityAttribute> getAttributes(const EntityImpl& entity) const;
+
+  std::vector<EntityAttribute> getAttributes(const EntityImpl& entity, const std::string& attribute_name) const;
+
+  bool isValid(const EntityImpl& entity) const;
+
+  // INSTANCE BACKERS
+  std::vector<ConceptImpl> getConcepts(const InstanceImpl& instance);
+
+  std::vector<ConceptImpl> getConceptsRecursive(const InstanceImpl& instance);
+
+  bool makeInstanceOf(InstanceImpl& instance, const ConceptImpl& concept);
+
+  bool hasConceptRecursively(const InstanceImpl& instance, const ConceptImpl& concept);
+
+  // CONCEPT BACKERS
+
+  std::vector<ConceptImpl> getChildren(const ConceptImpl& concept);
+
+  std::vector<ConceptImpl> getChildrenRecursive(const ConceptImpl& concept);
+
+  std::vector<InstanceImpl> getInstances(const ConceptImpl& concept);
+
+  int removeInstances(const ConceptImpl& concept);
+
+  int removeInstancesRecursive(const ConceptImpl& concept);
+
+  // MAP BACKERS
+  PointImpl addPoint(MapImpl& map, const std::string& name, double x, double y);
+
+  PoseImpl addPose(MapImpl& map, const std::string& name, double x, double y, double theta);
+
+  RegionImpl addRegion(MapImpl& map, const std::string& name, const std::vector<std::pair<double, double>>& points);
+
+  DoorImpl addDoor(MapImpl& map, const std::string& name, double x_0, double y_0, double x_1, double y_1);
+
+  boost::optional<PointImpl> getPoint(MapImpl& map, const std::string& name);
+
+  boost::optional<PoseImpl> getPose(MapImpl& map, const std::string& name);
+
+  boost::optional<RegionImpl> getRegion(MapImpl& map, const std::string& name);
+
+  boost::optional<DoorImpl> getDoor(MapImpl& map, const std::string& name);
+
+  std::vector<PointImpl> getAllPoints(MapImpl& map);
+
+  std::vector<PoseImpl> getAllPoses(MapImpl& map);
+
+  std::vector<RegionImpl> getAllRegions(MapImpl& map);
+
+  std::vector<DoorImpl> getAllDoors(MapImpl& map);
+
+  std::vector<RegionImpl> getContainingRegions(MapImpl& map, double x, double y);
+
+  std::vector<PointImpl> getNearestPoints(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<PoseImpl> getNearestPoses(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<DoorImpl> getNearestDoors(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<PointImpl> getPointsWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<PoseImpl> getPosesWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<DoorImpl> getDoorsWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<RegionImpl> getAdjacentRegions(MapImpl& map, const RegionImpl& region);
+
+  std::vector<RegionImpl> getReachableRegions(MapImpl& map, const RegionImpl& region);
+
+  bool isRegionReachable(MapImpl& map, const RegionImpl& from, const RegionImpl& to);
+
+  bool getShortestPath(MapImpl& map, const RegionImpl& from, const RegionImpl& to, std::vector<RegionImpl>& regions,
+                       std::vector<DoorImpl>& doors);
+
+  bool renameMap(MapImpl& map, const std::string& new_name);
+
+  // REGION BACKERS
+
+  std::vector<PointImpl> getContainedPoints(RegionImpl& region);
+
+  std::vector<PoseImpl> getContainedPoses(RegionImpl& region);
+
+  // WRITE BATCH BACKERS
+
+  bool beginWriteBatch();
+
+  bool commitWriteBatch();
+
+  void abortWriteBatch();
+
+private:
+  /// The knowledgebase itself. Defined alongside the implementation.
+  struct State;
+
+  /// A knowledgebase shared by every conduit with the same name, along with the lock that guards it
+  struct Store;
+
+  /// What an open write batch needs to undo its changes. Defined alongside the implementation.
+  struct UndoLog;
+
+  std::shared_ptr<Store> store;
+
+  /// How many of the store's open write batches this conduit opened, so that they can be aborted if it's destroyed
+  size_t open_write_batches = 0;
+
+  /**
+   * @brief The knowledgebase. Write batches change it in place.
+   *
+   * The store's lock must be held for as long as the result is used.
+   */
+  State& current() const;
+
+  /// Stops recording changes into the innermost write batch and releases the lock it held
+  void closeWriteBatch();
+
+  bool selectQuery(const std::string& sql_query) const
+  {
+    std::cerr << "The in-memory LTMC can't run SQL queries: " << sql_query << std::endl;
+    return false;
+  }
+
+  /**
+   * @brief Retrieve a map by its internal map ID
+   *
+   * Map IDs are an implementation detail and should not be used
+   * by API consumers
+   * @param map_id
+   * @return the map with the given map ID, if it exists
+   */
+  boost::optional<MapImpl> getMapForMapId(uint map_id);
+
+  /// Finds entities with the given value, converted to its attribute's type
+  std::vector<EntityImpl> getEntitiesWithAttributeValue(const std::string& attribute_name,
+                                                        const AttributeValue& value);
+
+  /// Streams all entity attributes in batches of either kind, for the forEachEntityAttributeBatch overloads
+  template <typename Attributes>
+  bool scanEntityAttributes(const std::function<void(Attributes&)>& callback, size_t batch_size) const;
+};
+
+// These definitions are provided so that API consumers don't need to fill
+// their code with references to the specific implementation. Any implementation
+// of the LTMCInterface should provide these same typedefs to be compatible.
+typedef LTMCEntity<LongTermMemoryConduitInMemory> Entity;
+typedef LTMCConcept<LongTermMemoryConduitInMemory> Concept;
+typedef LTMCInstance<LongTermMemoryConduitInMemory> Instance;
+typedef LTMCPoint<LongTermMemoryConduitInMemory> Point;
+typedef LTMCPose<LongTermMemoryConduitInMemory> Pose;
+typedef LTMCRegion<LongTermMemoryConduitInMemory> Region;
+typedef LTMCDoor<LongTermMemoryConduitInMemory> Door;
+typedef LTMCMap<LongTermMemoryConduitInMemory> Map;
+typedef LTMCWriteBatch<LongTermMemoryConduitInMemory> WriteBatch;
+typedef LongTermMemoryConduitInMemory LongTermMemoryConduit;
+}  // namespace knowledge_rep
@@ -1,14 +1,17 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include <map>
-#include <boost/variant.hpp>
 #include <boost/optional.hpp>
 #include <utility>
 #include <typeindex>
 #include <vector>
+#include "AttributeBatch.h"
 #include "EntityAttribute.h"
+#include "BulkKnowledge.h"
+#include "LTMCRange.h"
 
 namespace knowledge_rep
 {
@@ -36,6 +39,9 @@ class LTMCRegion;
 template <typename DoorLTMCImpl>
 class LTMCDoor;
 
+template <typename WriteBatchLTMCImpl>
+class LTMCWriteBatch;
+
 class EntityAttribute;
 
 enum AttributeValueType;
@@ -66,6 +72,7 @@ public:
   using PoseImpl = LTMCPose<Impl>;
   using RegionImpl = LTMCRegion<Impl>;
   using DoorImpl = LTMCDoor<Impl>;
+  using WriteBatchImpl = LTMCWriteBatch<Impl>;
 
   friend EntityImpl;
   friend InstanceImpl;
@@ -75,6 +82,7 @@ public:
   friend PoseImpl;
   friend RegionImpl;
   friend DoorImpl;
+  friend WriteBatchImpl;
   friend Impl;
 
   LongTermMemoryConduitInterface(LongTermMemoryConduitInterface&& that) noexcept = default;
@@ -284,6 +292,112 @@ public:
     return static_cast<Impl*>(this)->getAllInstances();
   }
 
+  /**
+   * @brief Streams all entities in batches of bounded size
+   *
+   * Unlike getAllEntities, the whole result is never held in memory at once, and the callback sees the first batch as
+   * soon as it's read, so passes over a large knowledge base run in constant memory. The batch is reused between
+   * calls. No connection is held while the callback runs, so it may use the LTMC. Batches aren't read from a single
+   * snapshot, though, so entities added or deleted during the scan may or may not be delivered.
+   * @param callback called once per batch, in no particular order
+   * @param batch_size the most entities delivered in a single batch
+   * @return whether the scan completed
+   */
+  bool forEachEntityBatch(const std::function<void(std::vector<EntityImpl>&)>& callback, size_t batch_size = 10000)
+  {
+    return static_cast<Impl*>(this)->forEachEntityBatch(callback, batch_size);
+  }
+
+  /**
+   * @brief Streams all concepts in batches of bounded size, as forEachEntityBatch does for entities
+   */
+  bool forEachConceptBatch(const std::function<void(std::vector<ConceptImpl>&)>& callback, size_t batch_size = 10000)
+  {
+    return static_cast<Impl*>(this)->forEachConceptBatch(callback, batch_size);
+  }
+
+  /**
+   * @brief Streams all instances in batches of bounded size, as forEachEntityBatch does for entities
+   */
+  bool forEachInstanceBatch(const std::function<void(std::vector<InstanceImpl>&)>& callback,
+                            size_t batch_size = 10000)
+  {
+    return static_cast<Impl*>(this)->forEachInstanceBatch(callback, batch_size);
+  }
+
+  /**
+   * @brief Reads the entities that follow an ID, in order of ID
+   *
+   * Reading on from the last ID of each page visits every entity without holding a connection in between, which is
+   * how entities() and forEachEntityBatch page through them.
+   * @param after_id the ID the page starts after. 0 starts from the first entity.
+   * @param limit the most entities to read
+   * @param page filled with the entities read, in place of what it held
+   * @return whether the page could be read
+   */
+  bool getEntityPage(uint after_id, size_t limit, std::vector<EntityImpl>& page)
+  {
+    return static_cast<Impl*>(this)->getEntityPage(after_id, limit, page);
+  }
+
+  /**
+   * @brief Reads the concepts that follow an ID, as getEntityPage does for entities
+   */
+  bool getConceptPage(uint after_id, size_t limit, std::vector<ConceptImpl>& page)
+  {
+    return static_cast<Impl*>(this)->getConceptPage(after_id, limit, page);
+  }
+
+  /**
+   * @brief Reads the instances that follow an ID, as getEntityPage does for entities
+   */
+  bool getInstancePage(uint after_id, size_t limit, std::vector<InstanceImpl>& page)
+  {
+    return static_cast<Impl*>(this)->getInstancePage(after_id, limit, page);
+  }
+
+  /**
+   * @brief All entities, read a page at a time as they're iterated over
+   *
+   * Like forEachEntityBatch, but for use in a range-based for loop:
+   *
+   *     for (const auto& entity : ltmc.entities()) { ... }
+   *
+   * @param page_size the most entities held in memory at once
+   */
+  LTMCRange<EntityImpl> entities(size_t page_size = 10000)
+  {
+    Impl* impl = static_cast<Impl*>(this);
+    return { [impl](uint after_id, size_t limit, std::vector<EntityImpl>& page) {
+              return impl->getEntityPage(after_id, limit, page);
+            },
+             page_size };
+  }
+
+  /**
+   * @brief All concepts, read a page at a time as they're iterated over, as entities() reads entities
+   */
+  LTMCRange<ConceptImpl> concepts(size_t page_size = 10000)
+  {
+    Impl* impl = static_cast<Impl*>(this);
+    return { [impl](uint after_id, size_t limit, std::vector<ConceptImpl>& page) {
+              return impl->getConceptPage(after_id, limit, page);
+            },
+             page_size };
+  }
+
+  /**
+   * @brief All instances, read a page at a time as they're iterated over, as entities() reads entities
+   */
+  LTMCRange<InstanceImpl> instances(size_t page_size = 10000)
+  {
+    Impl* impl = static_cast<Impl*>(this);
+    return { [impl](uint after_id, size_t limit, std::vector<InstanceImpl>& page) {
+              return impl->getInstancePage(after_id, limit, page);
+            },
+             page_size };
+  }
+
   /**
    * @brief Queries for all entities that are identified as maps
    *
@@ -315,6 +429,95 @@ public:
     return static_cast<const Impl*>(this)->getAllEntityAttributes();
   }
 
+  /**
+   * @brief Streams all entity attributes in batches of bounded size
+   *
+   * Unlike getAllEntityAttributes, the whole result is never held in memory at once, which makes this the
+   * right choice for exporting large knowledge bases. The batch is reused between calls, so the callback may
+   * move elements out of it but shouldn't keep a reference to it. As with forEachEntityBatch, the callback may use
+   * the LTMC, and attributes changed during the scan may or may not be delivered.
+   * @param callback called once per batch, in no particular order
+   * @param batch_size the most attributes delivered in a single batch
+   * @return whether the scan completed
+   */
+  bool forEachEntityAttributeBatch(const std::function<void(std::vector<EntityAttribute>&)>& callback,
+                                   size_t batch_size = 10000) const
+  {
+    return static_cast<const Impl*>(this)->forEachEntityAttributeBatch(callback, batch_size);
+  }
+
+  /**
+   * @brief Streams all entity attributes in columnar batches of bounded size
+   *
+   * Like the overload that delivers vectors, but each batch is an AttributeBatch, which suits analyses that scan
+   * whole columns. The batch is reused between calls.
+   */
+  bool forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                   size_t batch_size = 10000) const
+  {
+    return static_cast<const Impl*>(this)->forEachEntityAttributeBatch(callback, batch_size);
+  }
+
+  /**
+   * @brief Retrieves all entity attributes into a single columnar batch
+   * @param attributes replaced with the attributes
+   * @return whether the scan completed
+   */
+  bool getAllEntityAttributes(AttributeBatch& attributes) const
+  {
+    return static_cast<const Impl*>(this)->getAllEntityAttributes(attributes);
+  }
+
+  /**
+   * @brief Retrieves the attributes of many entities in one go
+   * @param attributes filled with the attributes, appended to whatever it already holds
+   * @return whether the attributes could be read
+   */
+  bool getAttributes(const std::vector<EntityImpl>& entities, AttributeBatch& attributes) const
+  {
+    return static_cast<const Impl*>(this)->getAttributes(entities, attributes);
+  }
+
+  /**
+   * @brief Writes a large amount of name-keyed knowledge at once
+   *
+   * Much faster than making the same changes one at a time: names are resolved in a handful of queries and rows are
+   * streamed to the database in bulk. Concepts and instances that already exist are reused, and attributes that are
+   * already set are skipped. The load happens in a single transaction, so either all of it is written or none of it
+   * is.
+   * @param knowledge the concepts, instances and attributes to write
+   * @param result receives the IDs of the knowledge's concepts and instances
+   * @return whether the load succeeded
+   */
+  bool bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result)
+  {
+    return static_cast<Impl*>(this)->bulkLoad(knowledge, result);
+  }
+
+  /**
+   * @brief Gets the concepts that each of many instances is transitively an instance of
+   *
+   * Gives the same results as calling getConceptsRecursive on each instance, but in a single query rather than one
+   * per instance.
+   * @return the concepts of each instance, in the order the instances were given. Empty if the query fails.
+   */
+  std::vector<std::vector<ConceptImpl>> getConceptsRecursive(const std::vector<InstanceImpl>& instances)
+  {
+    return static_cast<Impl*>(this)->getConceptsRecursive(instances);
+  }
+
+  /**
+   * @brief Picks out the instances that are transitively instances of a concept
+   *
+   * Gives the same results as calling hasConceptRecursively on each instance, but in a single query rather than one
+   * per instance.
+   * @return the instances that descend from the concept, in the order they were given
+   */
+  std::vector<InstanceImpl> filterInstancesOf(const std::vector<InstanceImpl>& instances, const ConceptImpl& concept)
+  {
+    return static_cast<Impl*>(this)->filterInstancesOf(instances, concept);
+  }
+
   /**
    * @brief Remove all entities and all entity attributes except for the robot
    * @return The number of entities removed
@@ -339,26 +542,51 @@ public:
     return static_cast<const Impl*>(this)->selectQueryId(sql_query, result);
   }
 
+  bool selectQueryId(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return static_cast<const Impl*>(this)->selectQueryId(sql_query, result);
+  }
+
   bool selectQueryBool(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return static_cast<const Impl*>(this)->selectQueryBool(sql_query, result);
   }
 
+  bool selectQueryBool(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return static_cast<const Impl*>(this)->selectQueryBool(sql_query, result);
+  }
+
   bool selectQueryInt(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return static_cast<const Impl*>(this)->selectQueryInt(sql_query, result);
   }
 
+  bool selectQueryInt(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return static_cast<const Impl*>(this)->selectQueryInt(sql_query, result);
+  }
+
   bool selectQueryFloat(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return static_cast<const Impl*>(this)->selectQueryFloat(sql_query, result);
   }
 
+  bool selectQueryFloat(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return static_cast<const Impl*>(this)->selectQueryFloat(sql_query, result);
+  }
+
   bool selectQueryString(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return static_cast<const Impl*>(this)->selectQueryString(sql_query, result);
   }
 
+  bool selectQueryString(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return static_cast<const Impl*>(this)->selectQueryString(sql_query, result);
+  }
+
   // CONVENIENCE
   /**
    * @brief Retrieves a concept of the given name, or creates one with the name if no such concept exists
@@ -484,6 +712,11 @@ protected:
     return static_cast<Impl*>(this)->makeInstanceOf(instance, concept);
   }
 
+  bool hasConceptRecursively(const InstanceImpl& instance, const ConceptImpl& concept)
+  {
+    return static_cast<Impl*>(this)->hasConceptRecursively(instance, concept);
+  }
+
   // CONCEPT BACKERS
 
   std::vector<ConceptImpl> getChildren(const ConceptImpl& concept)
@@ -582,6 +815,57 @@ protected:
     return static_cast<Impl*>(this)->getContainingRegions(map, x, y);
   }
 
+  std::vector<PointImpl> getNearestPoints(MapImpl& map, double x, double y, size_t k)
+  {
+    return static_cast<Impl*>(this)->getNearestPoints(map, x, y, k);
+  }
+
+  std::vector<PoseImpl> getNearestPoses(MapImpl& map, double x, double y, size_t k)
+  {
+    return static_cast<Impl*>(this)->getNearestPoses(map, x, y, k);
+  }
+
+  std::vector<DoorImpl> getNearestDoors(MapImpl& map, double x, double y, size_t k)
+  {
+    return static_cast<Impl*>(this)->getNearestDoors(map, x, y, k);
+  }
+
+  std::vector<PointImpl> getPointsWithinRadius(MapImpl& map, double x, double y, double radius)
+  {
+    return static_cast<Impl*>(this)->getPointsWithinRadius(map, x, y, radius);
+  }
+
+  std::vector<PoseImpl> getPosesWithinRadius(MapImpl& map, double x, double y, double radius)
+  {
+    return static_cast<Impl*>(this)->getPosesWithinRadius(map, x, y, radius);
+  }
+
+  std::vector<DoorImpl> getDoorsWithinRadius(MapImpl& map, double x, double y, double radius)
+  {
+    return static_cast<Impl*>(this)->getDoorsWithinRadius(map, x, y, radius);
+  }
+
+  std::vector<RegionImpl> getAdjacentRegions(MapImpl& map, const RegionImpl& region)
+  {
+    return static_cast<Impl*>(this)->getAdjacentRegions(map, region);
+  }
+
+  std::vector<RegionImpl> getReachableRegions(MapImpl& map, const RegionImpl& region)
+  {
+    return static_cast<Impl*>(this)->getReachableRegions(map, region);
+  }
+
+  bool isRegionReachable(MapImpl& map, const RegionImpl& from, const RegionImpl& to)
+  {
+    return static_cast<Impl*>(this)->isRegionReachable(map, from, to);
+  }
+
+  bool getShortestPath(MapImpl& map, const RegionImpl& from, const RegionImpl& to, std::vector<RegionImpl>& regions,
+                       std::vector<DoorImpl>& doors)
+  {
+    return static_cast<Impl*>(this)->getShortestPath(map, from, to, regions, doors);
+  }
+
   bool renameMap(MapImpl& map, const std::string& new_name)
   {
     return static_cast<Impl*>(this)->renameMap(map, new_name);
@@ -599,9 +883,22 @@ protected:
     return static_cast<Impl*>(this)->getContainedPoses(region);
   }
 
-  bool isPointContained(const RegionImpl& region, double x, double y)
+  // WRITE BATCH BACKERS
+  // Batches are opened and closed through LTMCWriteBatch, which guarantees every batch is closed exactly once.
+
+  bool beginWriteBatch()
+  {
+    return static_cast<Impl*>(this)->beginWriteBatch();
+  }
+
+  bool commitWriteBatch()
+  {
+    return static_cast<Impl*>(this)->commitWriteBatch();
+  }
+
+  void abortWriteBatch()
   {
-    return static_cast<Impl*>(this)->isPointContained(region, x, y);
+    static_cast<Impl*>(this)->abortWriteBatch();
   }
 
 private:
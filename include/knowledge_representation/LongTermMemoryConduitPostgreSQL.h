@@ -1,8 +1,17 @@
 #pragma once
 
+#include <knowledge_representation/ConceptHierarchy.h>
 #include <knowledge_representation/LongTermMemoryConduitInterface.h>
+#include <knowledge_representation/MapSpatialIndex.h>
+#include <knowledge_representation/PostgreSQLConnectionPool.h>
 #include <pqxx/pqxx>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 #include <utility>
 #include <memory>
@@ -23,6 +32,7 @@ class LongTermMemoryConduitPostgreSQL : public LongTermMemoryConduitInterface<Lo
   using PoseImpl = LTMCPose<LongTermMemoryConduitPostgreSQL>;
   using RegionImpl = LTMCRegion<LongTermMemoryConduitPostgreSQL>;
   using DoorImpl = LTMCDoor<LongTermMemoryConduitPostgreSQL>;
+  using WriteBatchImpl = LTMCWriteBatch<LongTermMemoryConduitPostgreSQL>;
 
   // Give wrapper classes access to our protected members. Database access
   // is isolated into this class, so any wrapper methods that need to talk to the database
@@ -35,14 +45,20 @@ class LongTermMemoryConduitPostgreSQL : public LongTermMemoryConduitInterface<Lo
   friend PoseImpl;
   friend RegionImpl;
   friend DoorImpl;
+  friend WriteBatchImpl;
 
   // Allow the interface to forward calls to our protected members
   friend class LongTermMemoryConduitInterface;
 
 public:
-  std::unique_ptr<pqxx::connection> conn;
-
-  explicit LongTermMemoryConduitPostgreSQL(const std::string& db_name, const std::string& hostname = "localhost");
+  /**
+   * @param db_name
+   * @param hostname
+   * @param max_connections the most database connections to open at once. Calls from different threads each use a
+   * connection of their own, so this bounds how many threads can use the LTMC concurrently.
+   */
+  explicit LongTermMemoryConduitPostgreSQL(const std::string& db_name, const std::string& hostname = "localhost",
+                                           size_t max_connections = 8);
 
   // Move constructor
   LongTermMemoryConduitPostgreSQL(LongTermMemoryConduitPostgreSQL&& that) = default;
@@ -52,6 +68,13 @@ public:
   // Move assignment
   LongTermMemoryConduitPostgreSQL& operator=(LongTermMemoryConduitPostgreSQL&& that) noexcept = default;
 
+  /**
+   * @brief Borrows one of the LTMC's connections for running SQL directly
+   *
+   * The connection has all of the LTMC's prepared statements. It goes back to the pool when the lease is destroyed.
+   */
+  PostgreSQLConnectionPool::Lease borrowConnection();
+
   std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name,
                                                           const uint other_entity_id);
 
@@ -112,21 +135,80 @@ public:
 
   std::vector<EntityAttribute> getAllEntityAttributes();
 
+  bool getAllEntityAttributes(AttributeBatch& attributes) const;
+
+  bool forEachEntityAttributeBatch(const std::function<void(std::vector<EntityAttribute>&)>& callback,
+                                   size_t batch_size = 10000) const;
+
+  bool forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                   size_t batch_size = 10000) const;
+
+  bool forEachEntityBatch(const std::function<void(std::vector<EntityImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool forEachConceptBatch(const std::function<void(std::vector<ConceptImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool forEachInstanceBatch(const std::function<void(std::vector<InstanceImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool getEntityPage(uint after_id, size_t limit, std::vector<EntityImpl>& page);
+
+  bool getConceptPage(uint after_id, size_t limit, std::vector<ConceptImpl>& page);
+
+  bool getInstancePage(uint after_id, size_t limit, std::vector<InstanceImpl>& page);
+
+  bool bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result);
+
+  std::vector<std::vector<ConceptImpl>> getConceptsRecursive(const std::vector<InstanceImpl>& instances);
+
+  bool getAttributes(const std::vector<EntityImpl>& entities, AttributeBatch& attributes) const;
+
+  std::vector<InstanceImpl> filterInstancesOf(const std::vector<InstanceImpl>& instances, const ConceptImpl& concept);
+
   uint deleteAllEntities();
 
   uint deleteAllAttributes();
 
+  /// Reads a text field in place, without going through a std::string
+  static AttributeString readText(const pqxx::field& field)
+  {
+    return { field.c_str(), field.size() };
+  }
+
+  template <typename T>
+  static typename std::enable_if<!std::is_same<T, std::string>::value, AttributeValue>::type
+  readValue(const pqxx::field& field)
+  {
+    return field.as<T>();
+  }
+
   template <typename T>
-  bool selectQuery(const std::string& sql_query, std::vector<EntityAttribute>& result) const
+  static typename std::enable_if<std::is_same<T, std::string>::value, AttributeValue>::type
+  readValue(const pqxx::field& field)
+  {
+    return readText(field);
+  }
+
+  template <typename T, typename Attributes>
+  bool selectQuery(const std::string& sql_query, Attributes& result) const
   {
     try
     {
-      pqxx::work txn{ *conn };
-      auto query_result = txn.exec(sql_query);
+      // The connection goes back to the pool before any attribute is named, as that may load the schema
+      pqxx::result query_result;
+      {
+        auto txn = openTransaction();
+        query_result = txn->exec(sql_query);
+      }
+      // The attribute tables store IDs, but queries are free to join in the names themselves
+      bool named = false;
+      for (decltype(query_result.columns()) i = 0; i < query_result.columns(); i++)
+      {
+        named = named || std::string(query_result.column_name(i)) == "attribute_name";
+      }
       for (const auto& row : query_result)
       {
-        result.emplace_back(row["entity_id"].as<uint>(), row["attribute_name"].as<std::string>(),
-                            row["attribute_value"].as<T>());
+        result.emplace_back(row["entity_id"].as<uint>(),
+                            named ? readText(row["attribute_name"]) : attributeName(row["attribute_id"].as<int>()),
+                            readValue<T>(row["attribute_value"]));
       }
     }
     catch (const std::exception& e)
@@ -143,26 +225,51 @@ public:
     return selectQuery<uint>(sql_query, result);
   }
 
+  bool selectQueryId(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<uint>(sql_query, result);
+  }
+
   bool selectQueryBool(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return selectQuery<bool>(sql_query, result);
   }
 
+  bool selectQueryBool(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<bool>(sql_query, result);
+  }
+
   bool selectQueryInt(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return selectQuery<int>(sql_query, result);
   }
 
+  bool selectQueryInt(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<int>(sql_query, result);
+  }
+
   bool selectQueryFloat(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return selectQuery<double>(sql_query, result);
   }
 
+  bool selectQueryFloat(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<double>(sql_query, result);
+  }
+
   bool selectQueryString(const std::string& sql_query, std::vector<EntityAttribute>& result) const
   {
     return selectQuery<std::string>(sql_query, result);
   }
 
+  bool selectQueryString(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<std::string>(sql_query, result);
+  }
+
   // CONVENIENCE
   ConceptImpl getConcept(const std::string& name);
 
@@ -207,6 +314,8 @@ protected:
 
   bool makeInstanceOf(InstanceImpl& instance, const ConceptImpl& concept);
 
+  bool hasConceptRecursively(const InstanceImpl& instance, const ConceptImpl& concept);
+
   // CONCEPT BACKERS
 
   std::vector<ConceptImpl> getChildren(const ConceptImpl& concept);
@@ -246,6 +355,27 @@ protected:
 
   std::vector<RegionImpl> getContainingRegions(MapImpl& map, double x, double y);
 
+  std::vector<PointImpl> getNearestPoints(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<PoseImpl> getNearestPoses(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<DoorImpl> getNearestDoors(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<PointImpl> getPointsWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<PoseImpl> getPosesWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<DoorImpl> getDoorsWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<RegionImpl> getAdjacentRegions(MapImpl& map, const RegionImpl& region);
+
+  std::vector<RegionImpl> getReachableRegions(MapImpl& map, const RegionImpl& region);
+
+  bool isRegionReachable(MapImpl& map, const RegionImpl& from, const RegionImpl& to);
+
+  bool getShortestPath(MapImpl& map, const RegionImpl& from, const RegionImpl& to, std::vector<RegionImpl>& regions,
+                       std::vector<DoorImpl>& doors);
+
   bool renameMap(MapImpl& map, const std::string& new_name);
 
   // REGION BACKERS
@@ -254,18 +384,252 @@ protected:
 
   std::vector<PoseImpl> getContainedPoses(RegionImpl& region);
 
-  bool isPointContained(const RegionImpl& region, double x, double y);
+  // WRITE BATCH BACKERS
+
+  bool beginWriteBatch();
+
+  bool commitWriteBatch();
+
+  void abortWriteBatch();
 
 private:
   /**
-   * @brief Retrieve a map by its internal map ID
+   * @brief A transaction together with the pooled connection it runs on
+   *
+   * Only a thread's outermost transaction holds a connection. Subtransactions run on their parent's.
+   */
+  class Transaction
+  {
+  public:
+    Transaction(PostgreSQLConnectionPool::Lease connection, std::unique_ptr<pqxx::dbtransaction> txn)
+      : connection(std::move(connection)), txn(std::move(txn))
+    {
+    }
+
+    pqxx::dbtransaction* operator->() const
+    {
+      return txn.get();
+    }
+
+    pqxx::dbtransaction& operator*() const
+    {
+      return *txn;
+    }
+
+  private:
+    // Declared first so that the connection is only returned to the pool once the transaction is closed
+    PostgreSQLConnectionPool::Lease connection;
+    std::unique_ptr<pqxx::dbtransaction> txn;
+  };
+
+  std::unique_ptr<PostgreSQLConnectionPool> connections;
+
+  /**
+   * @brief The attributes table, loaded on first use and kept in step with the LTMC's own changes to it
+   *
+   * Attribute values are stored against small integer attribute IDs, so this is also the dictionary that turns names
+   * into the IDs statements are bound with and the IDs in their results back into names.
+   */
+  struct AttributeSchema
+  {
+    std::mutex mutex;
+    bool loaded = false;
+    /// The schema generation the cache was last read at. Names it's missing aren't looked up again until that moves on.
+    uint64_t loaded_generation = 0;
+    std::unordered_map<std::string, AttributeValueType> types;
+    std::unordered_map<std::string, int> ids;
+    std::unordered_map<int, AttributeString> names;
+  };
+
+  std::unique_ptr<AttributeSchema> attribute_schema;
+
+  /**
+   * @brief Looks up an attribute's type in the schema cache
+   *
+   * Names the cache doesn't know are looked up again in the database, in case another LTMC has added them since, but
+   * only once per schema generation. Asking after an attribute that doesn't exist is then as cheap as a cache hit.
+   * @return the attribute's type, or none if there is no such attribute
+   */
+  boost::optional<AttributeValueType> attributeType(const std::string& name) const;
+
+  /**
+   * @brief Looks up an attribute's ID and type in the schema cache, as attributeType does
+   * @return the (ID, type) pair, or none if there is no such attribute
+   */
+  boost::optional<std::pair<int, AttributeValueType>> attributeKey(const std::string& name) const;
+
+  /**
+   * @brief Names an attribute ID from a query result, looking it up again in the database if the cache doesn't know it
+   * @throws std::out_of_range if there is no such attribute, as when it was deleted after the query ran
+   */
+  AttributeString attributeName(int id) const;
+
+  /// Records an attribute in the schema cache. Expects the cache's lock to be held.
+  void cacheAttribute(const std::string& name, int id, AttributeValueType type) const;
+
+  /// Refills the schema cache from the attributes table
+  void loadAttributeSchema() const;
+
+  /**
+   * @brief The is_a hierarchy and instances' concepts, loaded on first use and kept in step with the LTMC's own changes
+   *
+   * Changes the index can't easily follow, like deletes that cascade, unload it to be read again on next use.
+   */
+  struct ConceptIndex
+  {
+    std::mutex mutex;
+    bool loaded = false;
+    /// Bumped by every change, so that a load can tell whether what it read is already out of date
+    uint64_t generation = 0;
+    ConceptHierarchy hierarchy;
+  };
+
+  std::unique_ptr<ConceptIndex> concept_index;
+
+  /// Applies a change to the concept index, if it's loaded. Inside a write batch, see changeConceptIndex.
+  void updateConceptIndex(const std::function<void(ConceptHierarchy&)>& update);
+
+  /// Unloads the concept index, so that it's read again on next use. Inside a write batch, see changeConceptIndex.
+  void unloadConceptIndex();
+
+  /**
+   * @brief Makes a change to the concept index
    *
-   * Map IDs are an implementation detail and should not be used
-   * by API consumers
-   * @param map_id
-   * @return the map with the given map ID, if it exists
+   * Outside of a write batch the change is made to the shared index. Inside one, it's made to the calling thread's own
+   * copy and held back from the shared index until the outermost batch commits.
+   */
+  void changeConceptIndex(const std::function<void(ConceptIndex&)>& change);
+
+  /// The concept index the calling thread reads: its own copy if its write batches have changed the index
+  ConceptIndex& conceptIndex() const;
+
+  /**
+   * @brief Spatial indexes of maps' regions, points and poses, each loaded by its map's first containment query and
+   * kept in step with the LTMC's own changes
+   *
+   * Changes the indexes can't easily follow, like deletes that cascade, unload them all to be read again on next use.
+   */
+  struct SpatialIndexes
+  {
+    std::mutex mutex;
+    /// Bumped by every change, so that a load can tell whether what it read is already out of date
+    uint64_t generation = 0;
+    /// Indexes by map ID, each with its map's entity ID so that deleting the map drops it
+    std::unordered_map<uint, std::pair<uint, MapSpatialIndex>> by_map_id;
+  };
+
+  std::unique_ptr<SpatialIndexes> spatial_indexes;
+
+  /**
+   * @brief Runs a query against a map's spatial index, loading the index first if need be
+   *
+   * The query runs with the indexes locked, so it should copy out what it needs and leave building results to the
+   * caller.
+   */
+  void querySpatialIndex(uint map_entity_id, uint map_id, const std::function<void(const MapSpatialIndex&)>& query);
+
+  /// Applies a change to a map's spatial index, if it's loaded. Inside a write batch, see changeSpatialIndexes.
+  void updateSpatialIndex(uint map_id, const std::function<void(MapSpatialIndex&)>& update);
+
+  /// Drops an entity from every loaded spatial index, along with the index of the map it may be
+  void removeFromSpatialIndexes(uint entity_id);
+
+  /// Unloads every spatial index, so that each is read again on next use
+  void unloadSpatialIndexes();
+
+  /// Makes a change to the spatial indexes, holding it back from other threads as changeConceptIndex does
+  void changeSpatialIndexes(const std::function<void(SpatialIndexes&)>& change);
+
+  /// The spatial indexes the calling thread reads: its own copies if its write batches have changed them
+  SpatialIndexes& spatialIndexes() const;
+
+  /**
+   * @brief A write batch, with the index changes it has made
+   *
+   * The shared indexes only take on a batch's changes once its outermost batch commits, so other threads never read
+   * changes that may yet be rolled back. A nested batch that commits hands its changes to the batch it belongs to.
+   */
+  struct OpenBatch
+  {
+    Transaction txn;
+    std::vector<std::function<void(ConceptIndex&)>> concept_changes;
+    std::vector<std::function<void(SpatialIndexes&)>> spatial_changes;
+  };
+
+  /**
+   * @brief A thread's open write batches, outermost first, with its own copies of the indexes they've changed
+   *
+   * The thread's operations run inside its innermost batch. Only it can see its batches' changes, so once they've
+   * changed an index it reads its own copy, loaded from inside the batch.
+   */
+  struct ThreadBatches
+  {
+    std::vector<OpenBatch> batches;
+    std::unique_ptr<ConceptIndex> concept_index;
+    std::unique_ptr<SpatialIndexes> spatial_indexes;
+  };
+
+  struct WriteBatches
+  {
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, ThreadBatches> by_thread;
+  };
+
+  std::unique_ptr<WriteBatches> write_batches;
+
+  /**
+   * @brief Takes the calling thread's innermost write batch off its stack
+   *
+   * A committed batch's index changes pass to the batch it belongs to, or to the shared indexes if it was the
+   * outermost. Otherwise they're dropped, and the thread's own copies of the indexes, which took them on, are unloaded.
+   * @param close commits or aborts the batch's transaction, returning whether it committed. It runs after the batch
+   * is off the stack, so the batch is gone even if closing it throws.
+   */
+  bool closeWriteBatch(const std::function<bool(Transaction&)>& close);
+
+  /**
+   * @brief Adds a value to the table for its attribute's type, converting it if it fits without loss
+   * @return whether the value was added. Unknown attributes and values of the wrong type are rejected up front.
+   */
+  bool addAttributeValue(EntityImpl& entity, const std::string& attribute_name, const AttributeValue& value);
+
+  /// Finds entities with a value in the table for its attribute's type, converting it as addAttributeValue does
+  std::vector<EntityImpl> getEntitiesWithAttributeValue(const std::string& attribute_name,
+                                                        const AttributeValue& value);
+
+  /**
+   * @brief Opens the transaction a single operation should run in
+   *
+   * Outside of a write batch this is a standalone transaction on a connection from the pool. Inside one, it's a
+   * subtransaction of the calling thread's innermost batch, so the operation's changes only become durable when the
+   * batch commits.
+   * @param name a name for the transaction, used in error messages
+   * @return a transaction that the caller must commit for its changes to be kept
+   */
+  Transaction openTransaction(const std::string& name = "") const;
+
+  /**
+   * @brief Reads the page of one of the scan_* statements that follows an entity ID
+   *
+   * The page is read in a transaction of its own, which is closed before it's returned, so the caller is free to use
+   * the conduit while it holds the page.
+   * @param make builds an element from a row
+   * @return whether the page could be read
+   */
+  template <typename T, typename Make>
+  bool readPage(const char* statement, uint after_id, size_t limit, std::vector<T>& page, Make make);
+
+  /// Streams all entity attributes in batches of either kind, for the forEachEntityAttributeBatch overloads
+  template <typename Attributes>
+  bool scanEntityAttributes(const std::function<void(Attributes&)>& callback, size_t batch_size) const;
+
+  /**
+   * @brief Pages through one attribute table by its primary key, as the entity scans page by entity ID
+   * @param value_column the column of the typed attribute union that holds the table's values
    */
-  boost::optional<MapImpl> getMapForMapId(uint map_id);
+  template <typename Attributes, typename Value>
+  void scanAttributeTable(const char* statement, const char* value_column, size_t batch_size,
+                          const std::function<void(Attributes&)>& callback, Attributes& batch) const;
 };
 
 // These definitions are provided so that API consumers don't need to fill
@@ -279,5 +643,6 @@ typedef LTMCPose<LongTermMemoryConduitPostgreSQL> Pose;
 typedef LTMCRegion<LongTermMemoryConduitPostgreSQL> Region;
 typedef LTMCDoor<LongTermMemoryConduitPostgreSQL> Door;
 typedef LTMCMap<LongTermMemoryConduitPostgreSQL> Map;
+typedef LTMCWriteBatch<LongTermMemoryConduitPostgreSQL> WriteBatch;
 typedef LongTermMemoryConduitPostgreSQL LongTermMemoryConduit;
 }  // namespace knowledge_rep
@@ -0,0 +1,665 @@
+#pragma once
+
+#include <knowledge_representation/ConceptHierarchy.h>
+#include <knowledge_representation/LongTermMemoryConduitInterface.h>
+#include <knowledge_representation/MapSpatialIndex.h>
+#include <knowledge_representation/SQLiteConnectionPool.h>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <utility>
+#include <memory>
+
+namespace knowledge_rep
+{
+/**
+ * @brief A concrete implementation of the LongTermMemoryConduitInterface that embeds the knowledgebase with SQLite
+ *
+ * The database is a file that every call reads and writes in process, so there is no server to run and no socket
+ * round trip. The file is created with the schema in sql/schema_sqlite.sql and the default knowledge the first time
+ * it's opened. It runs in WAL mode, so readers in other threads (or processes) don't wait on writers.
+ */
+class LongTermMemoryConduitSQLite : public LongTermMemoryConduitInterface<LongTermMemoryConduitSQLite>
+{
+  using EntityImpl = LTMCEntity<LongTermMemoryConduitSQLite>;
+  using InstanceImpl = LTMCInstance<LongTermMemoryConduitSQLite>;
+  using ConceptImpl = LTMCConcept<LongTermMemoryConduitSQLite>;
+  using MapImpl = LTMCMap<LongTermMemoryConduitSQLite>;
+  using PointImpl = LTMCPoint<LongTermMemoryConduitSQLite>;
+  using PoseImpl = LTMCPose<LongTermMemoryConduitSQLite>;
+  using RegionImpl = LTMCRegion<LongTermMemoryConduitSQLite>;
+  using DoorImpl = LTMCDoor<LongTermMemoryConduitSQLite>;
+  using WriteBatchImpl = LTMCWriteBatch<LongTermMemoryConduitSQLite>;
+
+  // Give wrapper classes access to our protected members. Database access
+  // is isolated into this class, so any wrapper methods that need to talk to the database
+  // are implemented as protected members here.
+  friend EntityImpl;
+  friend InstanceImpl;
+  friend ConceptImpl;
+  friend MapImpl;
+  friend PointImpl;
+  friend PoseImpl;
+  friend RegionImpl;
+  friend DoorImpl;
+  friend WriteBatchImpl;
+
+  // Allow the interface to forward calls to our protected members
+  friend class LongTermMemoryConduitInterface;
+
+public:
+  /**
+   * @param db_name the path of the database file
+   * @param hostname unused. Accepted so that the backends are constructed the same way
+   * @param max_connections the most database connections to open at once. Calls from different threads each use a
+   * connection of their own, so this bounds how many threads can use the LTMC concurrently.
+   */
+  explicit LongTermMemoryConduitSQLite(const std::string& db_name, const std::string& hostname = "localhost",
+                                       size_t max_connections = 8);
+
+  // Move constructor
+  LongTermMemoryConduitSQLite(LongTermMemoryConduitSQLite&& that) = default;
+
+  ~LongTermMemoryConduitSQLite();
+
+  // Move assignment
+  LongTermMemoryConduitSQLite& operator=(LongTermMemoryConduitSQLite&& that) noexcept = default;
+
+  /**
+   * @brief Borrows one of the LTMC's connections for running SQL directly
+   *
+   * The connection has all of the LTMC's prepared statements. It goes back to the pool when the lease is destroyed.
+   */
+  SQLiteConnectionPool::Lease borrowConnection();
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name,
+                                                          const uint other_entity_id);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const bool bool_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const int int_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const double float_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name, const char* string_val);
+
+  std::vector<EntityImpl> getEntitiesWithAttributeOfValue(const std::string& attribute_name,
+                                                          const std::string& string_val);
+
+  bool entityExists(uint id) const;
+
+  bool addEntity(uint id);
+
+  boost::optional<EntityImpl> getEntity(uint entity_id);
+
+  boost::optional<InstanceImpl> getInstanceNamed(const ConceptImpl& concept, const std::string& name);
+
+  boost::optional<InstanceImpl> getInstance(uint entity_id);
+
+  boost::optional<ConceptImpl> getConcept(uint entity_id);
+
+  boost::optional<MapImpl> getMap(uint entity_id);
+
+  boost::optional<PointImpl> getPoint(uint entity_id);
+
+  boost::optional<PoseImpl> getPose(uint entity_id);
+
+  boost::optional<RegionImpl> getRegion(uint entity_id);
+
+  boost::optional<DoorImpl> getDoor(uint entity_id);
+
+  // ATTRIBUTES
+
+  // TODO(nickswalker): Expose this in the interface once we know what run-time attribute
+  // operations are useful.
+  bool addNewAttribute(const std::string& name, const AttributeValueType type);
+
+  bool deleteAttribute(const std::string& name);
+
+  bool attributeExists(const std::string& name) const;
+
+  // BULK OPERATIONS
+
+  std::vector<EntityImpl> getAllEntities();
+
+  std::vector<ConceptImpl> getAllConcepts();
+
+  std::vector<InstanceImpl> getAllInstances();
+
+  std::vector<MapImpl> getAllMaps();
+
+  std::vector<std::pair<std::string, AttributeValueType>> getAllAttributes() const;
+
+  std::vector<EntityAttribute> getAllEntityAttributes();
+
+  bool getAllEntityAttributes(AttributeBatch& attributes) const;
+
+  bool forEachEntityAttributeBatch(const std::function<void(std::vector<EntityAttribute>&)>& callback,
+                                   size_t batch_size = 10000) const;
+
+  bool forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                   size_t batch_size = 10000) const;
+
+  bool forEachEntityBatch(const std::function<void(std::vector<EntityImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool forEachConceptBatch(const std::function<void(std::vector<ConceptImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool forEachInstanceBatch(const std::function<void(std::vector<InstanceImpl>&)>& callback, size_t batch_size = 10000);
+
+  bool getEntityPage(uint after_id, size_t limit, std::vector<EntityImpl>& page);
+
+  bool getConceptPage(uint after_id, size_t limit, std::vector<ConceptImpl>& page);
+
+  bool getInstancePage(uint after_id, size_t limit, std::vector<InstanceImpl>& page);
+
+  bool bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result);
+
+  std::vector<std::vector<ConceptImpl>> getConceptsRecursive(const std::vector<InstanceImpl>& instances);
+
+  bool getAttributes(const std::vector<EntityImpl>& entities, AttributeBatch& attributes) const;
+
+  std::vector<InstanceImpl> filterInstancesOf(const std::vector<InstanceImpl>& instances, const ConceptImpl& concept);
+
+  uint deleteAllEntities();
+
+  uint deleteAllAttributes();
+
+  /// Reads a text column in place, without going through a std::string
+  static AttributeString readText(const SQLiteStatement& row, int column)
+  {
+    size_t size;
+    auto text = row.text(column, size);
+    return { text, size };
+  }
+
+  template <typename T>
+  static typename std::enable_if<!std::is_same<T, std::string>::value, AttributeValue>::type
+  readValue(const SQLiteStatement& row, int column)
+  {
+    return row.get<T>(column);
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_same<T, std::string>::value, AttributeValue>::type
+  readValue(const SQLiteStatement& row, int column)
+  {
+    return readText(row, column);
+  }
+
+  template <typename T, typename Attributes>
+  bool selectQuery(const std::string& sql_query, Attributes& result) const
+  {
+    try
+    {
+      auto txn = openReadTransaction();
+      auto rows = txn->query(sql_query);
+      int entity_id = rows.columnIndex("entity_id");
+      int attribute_name = rows.columnIndex("attribute_name");
+      int attribute_value = rows.columnIndex("attribute_value");
+      if (entity_id < 0 || attribute_name < 0 || attribute_value < 0)
+      {
+        throw std::invalid_argument("Queries must select entity_id, attribute_name and attribute_value");
+      }
+      while (rows.step())
+      {
+        result.emplace_back(rows.get<uint>(entity_id), readText(rows, attribute_name),
+                            readValue<T>(rows, attribute_value));
+      }
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+    return true;
+  }
+  // RAW QUERIES
+
+  bool selectQueryId(const std::string& sql_query, std::vector<EntityAttribute>& result) const
+  {
+    return selectQuery<uint>(sql_query, result);
+  }
+
+  bool selectQueryId(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<uint>(sql_query, result);
+  }
+
+  bool selectQueryBool(const std::string& sql_query, std::vector<EntityAttribute>& result) const
+  {
+    return selectQuery<bool>(sql_query, result);
+  }
+
+  bool selectQueryBool(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<bool>(sql_query, result);
+  }
+
+  bool selectQueryInt(const std::string& sql_query, std::vector<EntityAttribute>& result) const
+  {
+    return selectQuery<int>(sql_query, result);
+  }
+
+  bool selectQueryInt(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<int>(sql_query, result);
+  }
+
+  bool selectQueryFloat(const std::string& sql_query, std::vector<EntityAttribute>& result) const
+  {
+    return selectQuery<double>(sql_query, result);
+  }
+
+  bool selectQueryFloat(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<double>(sql_query, result);
+  }
+
+  bool selectQueryString(const std::string& sql_query, std::vector<EntityAttribute>& result) const
+  {
+    return selectQuery<std::string>(sql_query, result);
+  }
+
+  bool selectQueryString(const std::string& sql_query, AttributeBatch& result) const
+  {
+    return selectQuery<std::string>(sql_query, result);
+  }
+
+  // CONVENIENCE
+  ConceptImpl getConcept(const std::string& name);
+
+  MapImpl getMap(const std::string& name);
+
+  InstanceImpl getRobot();
+
+  EntityImpl addEntity();
+
+  // PROMOTERS
+
+  bool makeConcept(uint id, std::string name);
+
+protected:
+  // ENTITY BACKERS
+  bool deleteEntity(EntityImpl& entity);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const uint other_entity_id);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const bool bool_val);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const int int_val);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const double float_val);
+
+  bool addAttribute(EntityImpl& entity, const std::string& attribute_name, const std::string& string_val);
+
+  int removeAttribute(EntityImpl& entity, const std::string& attribute_name);
+
+  int removeAttributeOfValue(EntityImpl& entity, const std::string& attribute_name, const EntityImpl& other_entity);
+
+  std::vector<EntityAttribute> getAttributes(const EntityImpl& entity) const;
+
+  std::vector<EntityAttribute> getAttributes(const EntityImpl& entity, const std::string& attribute_name) const;
+
+  bool isValid(const EntityImpl& entity) const;
+
+  // INSTANCE BACKERS
+  std::vector<ConceptImpl> getConcepts(const InstanceImpl& instance);
+
+  std::vector<ConceptImpl> getConceptsRecursive(const InstanceImpl& instance);
+
+  bool makeInstanceOf(InstanceImpl& instance, const ConceptImpl& concept);
+
+  bool hasConceptRecursively(const InstanceImpl& instance, const ConceptImpl& concept);
+
+  // CONCEPT BACKERS
+
+  std::vector<ConceptImpl> getChildren(const ConceptImpl& concept);
+
+  std::vector<ConceptImpl> getChildrenRecursive(const ConceptImpl& concept);
+
+  std::vector<InstanceImpl> getInstances(const ConceptImpl& concept);
+
+  int removeInstances(const ConceptImpl& concept);
+
+  int removeInstancesRecursive(const ConceptImpl& concept);
+
+  // MAP BACKERS
+  PointImpl addPoint(MapImpl& map, const std::string& name, double x, double y);
+
+  PoseImpl addPose(MapImpl& map, const std::string& name, double x, double y, double theta);
+
+  RegionImpl addRegion(MapImpl& map, const std::string& name, const std::vector<std::pair<double, double>>& points);
+
+  DoorImpl addDoor(MapImpl& map, const std::string& name, double x_0, double y_0, double x_1, double y_1);
+
+  boost::optional<PointImpl> getPoint(MapImpl& map, const std::string& name);
+
+  boost::optional<PoseImpl> getPose(MapImpl& map, const std::string& name);
+
+  boost::optional<RegionImpl> getRegion(MapImpl& map, const std::string& name);
+
+  boost::optional<DoorImpl> getDoor(MapImpl& map, const std::string& name);
+
+  std::vector<PointImpl> getAllPoints(MapImpl& map);
+
+  std::vector<PoseImpl> getAllPoses(MapImpl& map);
+
+  std::vector<RegionImpl> getAllRegions(MapImpl& map);
+
+  std::vector<DoorImpl> getAllDoors(MapImpl& map);
+
+  std::vector<RegionImpl> getContainingRegions(MapImpl& map, double x, double y);
+
+  std::vector<PointImpl> getNearestPoints(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<PoseImpl> getNearestPoses(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<DoorImpl> getNearestDoors(MapImpl& map, double x, double y, size_t k);
+
+  std::vector<PointImpl> getPointsWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<PoseImpl> getPosesWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<DoorImpl> getDoorsWithinRadius(MapImpl& map, double x, double y, double radius);
+
+  std::vector<RegionImpl> getAdjacentRegions(MapImpl& map, const RegionImpl& region);
+
+  std::vector<RegionImpl> getReachableRegions(MapImpl& map, const RegionImpl& region);
+
+  bool isRegionReachable(MapImpl& map, const RegionImpl& from, const RegionImpl& to);
+
+  bool getShortestPath(MapImpl& map, const RegionImpl& from, const RegionImpl& to, std::vector<RegionImpl>& regions,
+                       std::vector<DoorImpl>& doors);
+
+  bool renameMap(MapImpl& map, const std::string& new_name);
+
+  // REGION BACKERS
+
+  std::vector<PointImpl> getContainedPoints(RegionImpl& region);
+
+  std::vector<PoseImpl> getContainedPoses(RegionImpl& region);
+
+  // WRITE BATCH BACKERS
+
+  bool beginWriteBatch();
+
+  bool commitWriteBatch();
+
+  void abortWriteBatch();
+
+private:
+  /**
+   * @brief A transaction together with the pooled connection it runs on
+   *
+   * Only a thread's outermost transaction holds a connection. Transactions inside a write batch are savepoints on the
+   * batch's connection. A transaction that is destroyed before it's committed is rolled back.
+   */
+  class Transaction
+  {
+  public:
+    /**
+     * @param lease the connection, if the transaction owns one
+     * @param connection the connection the transaction's statements run on
+     * @param commit_sql ends the transaction, keeping its changes. Empty if there's no transaction to end.
+     * @param rollback_sql ends the transaction, discarding its changes
+     */
+    Transaction(SQLiteConnectionPool::Lease lease, SQLiteConnection& connection, std::string commit_sql,
+                std::string rollback_sql)
+      : lease(std::move(lease))
+      , connection(&connection)
+      , commit_sql(std::move(commit_sql))
+      , rollback_sql(std::move(rollback_sql))
+      , open(!this->commit_sql.empty())
+    {
+    }
+
+    Transaction(Transaction&& that) noexcept
+      : lease(std::move(that.lease))
+      , connection(that.connection)
+      , commit_sql(std::move(that.commit_sql))
+      , rollback_sql(std::move(that.rollback_sql))
+      , open(that.open)
+    {
+      that.open = false;
+    }
+
+    ~Transaction();
+
+    SQLiteConnection* operator->() const
+    {
+      return connection;
+    }
+
+    SQLiteConnection& operator*() const
+    {
+      return *connection;
+    }
+
+    void commit();
+
+    void abort();
+
+  private:
+    SQLiteConnectionPool::Lease lease;
+    SQLiteConnection* connection;
+    std::string commit_sql;
+    std::string rollback_sql;
+    bool open;
+  };
+
+  std::unique_ptr<SQLiteConnectionPool> connections;
+
+  /// The attributes table, loaded on first use and kept in step with the LTMC's own changes to it
+  struct AttributeSchema
+  {
+    std::mutex mutex;
+    bool loaded = false;
+    /// The schema generation the cache was last read at. Names it's missing aren't looked up again until that moves on.
+    uint64_t loaded_generation = 0;
+    std::unordered_map<std::string, AttributeValueType> types;
+  };
+
+  std::unique_ptr<AttributeSchema> attribute_schema;
+
+  /// @return the connection of the calling thread's open write batch, if it has one
+  SQLiteConnection* batchConnection() const;
+
+  /**
+   * @brief Opens the transaction a single operation that writes should run in
+   *
+   * Outside of a write batch this is a standalone transaction on a connection from the pool. It takes the database's
+   * write lock up front, so it never has to give up partway through because another connection wrote first. Inside a
+   * write batch, it's a savepoint in the calling thread's innermost batch, so a failed operation only rolls back its
+   * own changes and the rest only become durable when the batch commits.
+   * @return a transaction that the caller must commit for its changes to be kept
+   */
+  Transaction openTransaction() const;
+
+  /**
+   * @brief Opens the transaction a single operation that only reads should run in
+   *
+   * Outside of a write batch the statements run on a connection from the pool, each reading the latest committed
+   * data without taking any lock. Inside one, they run on the batch's connection so that they see its changes.
+   */
+  Transaction openReadTransaction() const;
+
+  /**
+   * @brief Looks up an attribute's type in the schema cache
+   *
+   * Names the cache doesn't know are looked up again in the database, in case another LTMC has added them since, but
+   * only once per schema generation. Asking after an attribute that doesn't exist is then as cheap as a cache hit.
+   * @return the attribute's type, or none if there is no such attribute
+   */
+  boost::optional<AttributeValueType> attributeType(const std::string& name) const;
+
+  /// Refills the schema cache from the attributes table
+  void loadAttributeSchema() const;
+
+  /**
+   * @brief The is_a hierarchy and instances' concepts, loaded on first use and kept in step with the LTMC's own changes
+   *
+   * Changes the index can't easily follow, like deletes that cascade, unload it to be read again on next use.
+   */
+  struct ConceptIndex
+  {
+    std::mutex mutex;
+    bool loaded = false;
+    /// Bumped by every change, so that a load can tell whether what it read is already out of date
+    uint64_t generation = 0;
+    ConceptHierarchy hierarchy;
+  };
+
+  std::unique_ptr<ConceptIndex> concept_index;
+
+  /// Applies a change to the concept index, if it's loaded. Inside a write batch, see changeConceptIndex.
+  void updateConceptIndex(const std::function<void(ConceptHierarchy&)>& update);
+
+  /// Unloads the concept index, so that it's read again on next use. Inside a write batch, see changeConceptIndex.
+  void unloadConceptIndex();
+
+  /**
+   * @brief Makes a change to the concept index
+   *
+   * Outside of a write batch the change is made to the shared index. Inside one, it's made to the calling thread's own
+   * copy and held back from the shared index until the outermost batch commits.
+   */
+  void changeConceptIndex(const std::function<void(ConceptIndex&)>& change);
+
+  /// The concept index the calling thread reads: its own copy if its write batches have changed the index
+  ConceptIndex& conceptIndex() const;
+
+  /**
+   * @brief Spatial indexes of maps' regions, points and poses, each loaded by its map's first containment query and
+   * kept in step with the LTMC's own changes
+   *
+   * Changes the indexes can't easily follow, like deletes that cascade, unload them all to be read again on next use.
+   */
+  struct SpatialIndexes
+  {
+    std::mutex mutex;
+    /// Bumped by every change, so that a load can tell whether what it read is already out of date
+    uint64_t generation = 0;
+    /// Indexes by map ID, each with its map's entity ID so that deleting the map drops it
+    std::unordered_map<uint, std::pair<uint, MapSpatialIndex>> by_map_id;
+  };
+
+  std::unique_ptr<SpatialIndexes> spatial_indexes;
+
+  /**
+   * @brief Runs a query against a map's spatial index, loading the index first if need be
+   *
+   * The query runs with the indexes locked, so it should copy out what it needs and leave building results to the
+   * caller.
+   */
+  void querySpatialIndex(uint map_entity_id, uint map_id, const std::function<void(const MapSpatialIndex&)>& query);
+
+  /// Applies a change to a map's spatial index, if it's loaded. Inside a write batch, see changeSpatialIndexes.
+  void updateSpatialIndex(uint map_id, const std::function<void(MapSpatialIndex&)>& update);
+
+  /// Drops an entity from every loaded spatial index, along with the index of the map it may be
+  void removeFromSpatialIndexes(uint entity_id);
+
+  /// Unloads every spatial index, so that each is read again on next use
+  void unloadSpatialIndexes();
+
+  /// Makes a change to the spatial indexes, holding it back from other threads as changeConceptIndex does
+  void changeSpatialIndexes(const std::function<void(SpatialIndexes&)>& change);
+
+  /// The spatial indexes the calling thread reads: its own copies if its write batches have changed them
+  SpatialIndexes& spatialIndexes() const;
+
+  /**
+   * @brief A write batch, with the index changes it has made
+   *
+   * The shared indexes only take on a batch's changes once its outermost batch commits, so other threads never read
+   * changes that may yet be rolled back. A nested batch that commits hands its changes to the batch it belongs to.
+   */
+  struct OpenBatch
+  {
+    Transaction txn;
+    std::vector<std::function<void(ConceptIndex&)>> concept_changes;
+    std::vector<std::function<void(SpatialIndexes&)>> spatial_changes;
+  };
+
+  /**
+   * @brief A thread's open write batches, outermost first, with its own copies of the indexes they've changed
+   *
+   * The thread's operations run inside its innermost batch. Only it can see its batches' changes, so once they've
+   * changed an index it reads its own copy, loaded from inside the batch.
+   */
+  struct ThreadBatches
+  {
+    std::vector<OpenBatch> batches;
+    std::unique_ptr<ConceptIndex> concept_index;
+    std::unique_ptr<SpatialIndexes> spatial_indexes;
+  };
+
+  struct WriteBatches
+  {
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, ThreadBatches> by_thread;
+  };
+
+  std::unique_ptr<WriteBatches> write_batches;
+
+  /**
+   * @brief Takes the calling thread's innermost write batch off its stack
+   *
+   * A committed batch's index changes pass to the batch it belongs to, or to the shared indexes if it was the
+   * outermost. Otherwise they're dropped, and the thread's own copies of the indexes, which took them on, are unloaded.
+   * @param close commits or aborts the batch's transaction, returning whether it committed. It runs after the batch
+   * is off the stack, so the batch is gone even if closing it throws.
+   */
+  bool closeWriteBatch(const std::function<bool(Transaction&)>& close);
+
+  /**
+   * @brief Adds a value to the table for its attribute's type, converting it if it fits without loss
+   * @return whether the value was added. Unknown attributes and values of the wrong type are rejected up front.
+   */
+  bool addAttributeValue(EntityImpl& entity, const std::string& attribute_name, const AttributeValue& value);
+
+  /// Finds entities with a value in the table for its attribute's type, converting it as addAttributeValue does
+  std::vector<EntityImpl> getEntitiesWithAttributeValue(const std::string& attribute_name,
+                                                        const AttributeValue& value);
+
+  /**
+   * @brief Reads the page of one of the scan_* statements that follows an entity ID
+   *
+   * The page is read on a connection of its own, which is given back before it's returned, so the caller is free to
+   * use the conduit while it holds the page.
+   * @param make builds an element from the current row
+   * @return whether the page could be read
+   */
+  template <typename T, typename Make>
+  bool readPage(const char* statement, uint after_id, size_t limit, std::vector<T>& page, Make make);
+
+  /**
+   * @brief Streams all entity attributes in batches of either kind, for the forEachEntityAttributeBatch overloads
+   *
+   * Each attribute table is paged through by rowid, as the entity scans page by entity ID.
+   */
+  template <typename Attributes>
+  bool scanEntityAttributes(const std::function<void(Attributes&)>& callback, size_t batch_size) const;
+};
+
+// These definitions are provided so that API consumers don't need to fill
+// their code with references to the specific implementation. Any implementation
+// of the LTMCInterface should provide these same typedefs to be compatible.
+typedef LTMCEntity<LongTermMemoryConduitSQLite> Entity;
+typedef LTMCConcept<LongTermMemoryConduitSQLite> Concept;
+typedef LTMCInstance<LongTermMemoryConduitSQLite> Instance;
+typedef LTMCPoint<LongTermMemoryConduitSQLite> Point;
+typedef LTMCPose<LongTermMemoryConduitSQLite> Pose;
+typedef LTMCRegion<LongTermMemoryConduitSQLite> Region;
+typedef LTMCDoor<LongTermMemoryConduitSQLite> Door;
+typedef LTMCMap<LongTermMemoryConduitSQLite> Map;
+typedef LTMCWriteBatch<LongTermMemoryConduitSQLite> WriteBatch;
+typedef LongTermMemoryConduitSQLite LongTermMemoryConduit;
+}  // namespace knowledge_rep
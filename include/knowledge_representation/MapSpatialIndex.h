@@ -0,0 +1,171 @@
+#pragma once
+
+#include <knowledge_representation/PreparedPolygon.h>
+#include <knowledge_representation/RegionGraph.h>
+#include <boost/geometry/geometries/box.hpp>
+#include <boost/geometry/geometries/point.hpp>
+#include <boost/geometry/geometries/segment.hpp>
+#include <boost/geometry/index/rtree.hpp>
+#include <sys/types.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * @brief A map's geometry, kept in memory so that containment, proximity and topology queries don't touch the database
+ *
+ * Regions are indexed by their bounding boxes, points and poses by their positions and doors by their segments, each
+ * in an R-tree. A query first finds the candidates whose boxes or positions could match, then tests only those against
+ * the polygon, so asking which of thousands of regions contain a point costs a tree descent and a handful of polygon
+ * tests. Nearest-neighbour and radius queries walk the same trees.
+ *
+ * Containment follows PostgreSQL's geometric operators, boundary and tolerance included, so answers match the
+ * queries the index stands in for. Containment results come back in entity ID order, proximity results nearest first.
+ *
+ * The index also keeps a RegionGraph of which regions connect through doors. A door connects the regions its line
+ * touches, so doors should be drawn across the boundary between the regions they join. The graph is rebuilt by the
+ * first topology query after a region or door changes, so loading a map's annotations costs one rebuild.
+ *
+ * The index doesn't lock, not even for the rebuild in const queries. Conduits guard it with locks of their own.
+ */
+class MapSpatialIndex
+{
+public:
+  using Point2D = std::pair<double, double>;
+
+  struct RegionEntry
+  {
+    uint entity_id;
+    std::string name;
+    std::vector<Point2D> points;
+  };
+
+  /// A point or a pose. Points have a theta of 0.
+  struct PointEntry
+  {
+    uint entity_id;
+    std::string name;
+    double x;
+    double y;
+    double theta;
+  };
+
+  struct DoorEntry
+  {
+    uint entity_id;
+    std::string name;
+    double x_0;
+    double y_0;
+    double x_1;
+    double y_1;
+  };
+
+  /// Forgets every region, point, pose and door
+  void clear();
+
+  /// Replaces the contents of the index, packing the trees in one pass rather than inserting one entry at a time
+  void reset(std::vector<RegionEntry> regions, std::vector<PointEntry> points, std::vector<PointEntry> poses,
+             std::vector<DoorEntry> doors);
+
+  void addRegion(RegionEntry region);
+
+  void addPoint(PointEntry point);
+
+  void addPose(PointEntry pose);
+
+  void addDoor(DoorEntry door);
+
+  /// Forgets the entity, if it's one of the map's regions, points, poses or doors
+  void removeEntity(uint entity_id);
+
+  /// @return the regions that contain (x, y)
+  std::vector<RegionEntry> containingRegions(double x, double y) const;
+
+  /// @return the points in the region, or none if the region isn't in the index
+  std::vector<PointEntry> containedPoints(uint region_id) const;
+
+  /// @return the poses in the region, or none if the region isn't in the index
+  std::vector<PointEntry> containedPoses(uint region_id) const;
+
+  /// @return the k points closest to (x, y), nearest first, or all of them if there are fewer than k
+  std::vector<PointEntry> nearestPoints(double x, double y, size_t k) const;
+
+  /// @return the k poses closest to (x, y), nearest first, or all of them if there are fewer than k
+  std::vector<PointEntry> nearestPoses(double x, double y, size_t k) const;
+
+  /// @return the k doors closest to (x, y), measured to the nearest point of each door, nearest first
+  std::vector<DoorEntry> nearestDoors(double x, double y, size_t k) const;
+
+  /// @return the points no further than radius from (x, y), nearest first
+  std::vector<PointEntry> pointsWithinRadius(double x, double y, double radius) const;
+
+  /// @return the poses no further than radius from (x, y), nearest first
+  std::vector<PointEntry> posesWithinRadius(double x, double y, double radius) const;
+
+  /// @return the doors with some part no further than radius from (x, y), nearest first
+  std::vector<DoorEntry> doorsWithinRadius(double x, double y, double radius) const;
+
+  /// @return the regions that share a door with the region, in entity ID order
+  std::vector<RegionEntry> adjacentRegions(uint region_id) const;
+
+  /// @return the regions reachable from the region through doors, itself included, in entity ID order
+  std::vector<RegionEntry> reachableRegions(uint region_id) const;
+
+  /// @return whether a path through doors leads from one region to the other
+  bool isReachable(uint from_region_id, uint to_region_id) const;
+
+  /**
+   * @brief Finds the path between two regions that passes through the fewest doors
+   * @param path_regions set to the regions along the path, both ends included
+   * @param path_doors set to the doors along the path, in order
+   * @return whether there is a path
+   */
+  bool shortestPath(uint from_region_id, uint to_region_id, std::vector<RegionEntry>& path_regions,
+                    std::vector<DoorEntry>& path_doors) const;
+
+private:
+  using IndexedPoint = boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian>;
+  using Box = boost::geometry::model::box<IndexedPoint>;
+  using Segment = boost::geometry::model::segment<IndexedPoint>;
+  using RegionTree = boost::geometry::index::rtree<std::pair<Box, uint>, boost::geometry::index::rstar<16>>;
+  using PointTree = boost::geometry::index::rtree<std::pair<IndexedPoint, uint>, boost::geometry::index::rstar<16>>;
+  using DoorTree = boost::geometry::index::rtree<std::pair<Segment, uint>, boost::geometry::index::rstar<16>>;
+
+  /// A region's bounding box, grown by the containment tolerance so that boundary points aren't filtered out
+  static Box bounds(const std::vector<Point2D>& points);
+
+  /// Whether the door's line touches the region, boundary and tolerance included
+  static bool touches(const RegionEntry& region, const DoorEntry& door);
+
+  /// The region graph, rebuilt first if regions or doors have changed since it was last built
+  const RegionGraph& regionGraph() const;
+
+  static std::vector<PointEntry> contained(const PointTree& tree, const std::unordered_map<uint, PointEntry>& entries,
+                                           const RegionEntry& region);
+
+  /// The k entries of the tree closest to (x, y), nearest first, with ties in entity ID order
+  template <typename Tree, typename Entry>
+  static std::vector<Entry> nearest(const Tree& tree, const std::unordered_map<uint, Entry>& entries, double x,
+                                    double y, size_t k);
+
+  /// The entries of the tree no further than radius from (x, y), nearest first, with ties in entity ID order
+  template <typename Tree, typename Entry>
+  static std::vector<Entry> withinRadius(const Tree& tree, const std::unordered_map<uint, Entry>& entries, double x,
+                                         double y, double radius);
+
+  std::unordered_map<uint, RegionEntry> regions;
+  std::unordered_map<uint, PointEntry> points;
+  std::unordered_map<uint, PointEntry> poses;
+  std::unordered_map<uint, DoorEntry> doors;
+  RegionTree region_tree;
+  PointTree point_tree;
+  PointTree pose_tree;
+  DoorTree door_tree;
+  mutable RegionGraph region_graph;
+  /// Set when regions or doors have changed since the graph was last built
+  mutable bool graph_stale = true;
+};
+}  // namespace knowledge_rep
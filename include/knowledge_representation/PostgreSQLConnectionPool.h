@@ -0,0 +1,96 @@
+#pragma once
+
+#include <pqxx/pqxx>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * @brief A fixed-size pool of PostgreSQL connections that can be shared between threads
+ *
+ * A pqxx connection may only be used by one thread at a time. The pool hands each caller a connection of its own for
+ * as long as it holds a Lease, opening new connections as needed up to a maximum and then making callers wait for a
+ * lease to be returned.
+ */
+class PostgreSQLConnectionPool
+{
+public:
+  /**
+   * @brief Exclusive use of one pooled connection. The connection goes back to the pool when the lease is destroyed.
+   */
+  class Lease
+  {
+  public:
+    Lease() = default;
+
+    Lease(Lease&& that) noexcept = default;
+
+    Lease& operator=(Lease&& that) noexcept;
+
+    ~Lease();
+
+    pqxx::connection& operator*() const
+    {
+      return *connection;
+    }
+
+    pqxx::connection* operator->() const
+    {
+      return connection.get();
+    }
+
+  private:
+    friend class PostgreSQLConnectionPool;
+
+    Lease(PostgreSQLConnectionPool& pool, std::unique_ptr<pqxx::connection> connection)
+      : pool(&pool), connection(std::move(connection))
+    {
+    }
+
+    void release();
+
+    PostgreSQLConnectionPool* pool = nullptr;
+    std::unique_ptr<pqxx::connection> connection;
+  };
+
+  /**
+   * @param connection_string the libpq connection string for every connection in the pool
+   * @param max_connections the most connections that will be open at once
+   * @param setup run on each connection when it's opened, before it's handed out
+   */
+  PostgreSQLConnectionPool(std::string connection_string, size_t max_connections,
+                           std::function<void(pqxx::connection&)> setup);
+
+  /**
+   * @brief Borrows a connection, waiting for one to be returned if all of them are in use
+   *
+   * A thread that already holds a lease shouldn't wait on a second one when the pool may be exhausted, as every
+   * holder could end up waiting on the others.
+   * @throws pqxx::broken_connection if a new connection can't be opened
+   */
+  Lease acquire();
+
+  size_t maxConnections() const
+  {
+    return max_connections;
+  }
+
+private:
+  void release(std::unique_ptr<pqxx::connection> connection);
+
+  const std::string connection_string;
+  const size_t max_connections;
+  const std::function<void(pqxx::connection&)> setup;
+
+  std::mutex mutex;
+  std::condition_variable returned;
+  std::vector<std::unique_ptr<pqxx::connection>> idle;
+  /// Connections that exist, whether idle or leased
+  size_t num_open = 0;
+};
+}  // namespace knowledge_rep
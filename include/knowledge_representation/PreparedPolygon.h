@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * @brief Whether a polygon contains (x, y), counting its boundary as inside like PostgreSQL's @> does
+ */
+bool polygonContains(const std::vector<std::pair<double, double>>& polygon, double x, double y);
+
+/**
+ * @brief A polygon with its edges preprocessed for testing many points against it
+ *
+ * Each edge's inverse slope, bounding box and boundary tolerance are worked out once, and kept as one array per
+ * quantity so that a batch test can run a crossing-number kernel over several points per instruction. The kernel uses
+ * AVX2 on CPUs that have it and SSE2 elsewhere on x86, with a scalar loop everywhere else. Every path gives the same
+ * answers as polygonContains.
+ */
+class PreparedPolygon
+{
+public:
+  using Point2D = std::pair<double, double>;
+
+  explicit PreparedPolygon(const std::vector<Point2D>& vertices);
+
+  /// @return whether the polygon contains (x, y), boundary included
+  bool contains(double x, double y) const;
+
+  /// @return whether the polygon contains each of the points, boundary included
+  std::vector<bool> contains(const std::vector<Point2D>& points) const;
+
+private:
+  /// Edge starts
+  std::vector<double> ax;
+  std::vector<double> ay;
+  /// Edge ends' y, for telling whether an edge straddles a point's y
+  std::vector<double> by;
+  /// Edge vectors
+  std::vector<double> ex;
+  std::vector<double> ey;
+  /// dx/dy of each edge, or 0 for horizontal edges, which never straddle
+  std::vector<double> inverse_slope;
+  /// How far from an edge's line a point may be and still count as on it
+  std::vector<double> tolerance;
+  /// Each edge's bounding box, grown by the tolerance PostgreSQL uses
+  std::vector<double> min_x;
+  std::vector<double> max_x;
+  std::vector<double> min_y;
+  std::vector<double> max_y;
+  /// The polygon's bounding box, grown the same way, for rejecting faraway points without looking at the edges
+  double bounds[4];
+};
+}  // namespace knowledge_rep
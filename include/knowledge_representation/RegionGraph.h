@@ -0,0 +1,60 @@
+#pragma once
+
+#include <sys/types.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace knowledge_rep
+{
+/**
+ * @brief Which of a map's regions connect to which through doors
+ *
+ * Regions are nodes and each door joins every pair of regions it touches. Regions are labelled with their connected
+ * component when the graph is built, so reachability checks are two hash lookups. Shortest paths are found
+ * breadth-first and pass through the fewest doors. Neighbours are visited in ID order, and of several doors between the
+ * same two regions only the lowest ID is used, so the same graph always gives the same path.
+ */
+class RegionGraph
+{
+public:
+  /// Forgets every region and door
+  void clear();
+
+  /**
+   * @brief Replaces the graph
+   * @param region_ids every region of the map, including ones without doors
+   * @param doors (door ID, IDs of the regions it touches) pairs
+   */
+  void reset(std::vector<uint> region_ids, const std::vector<std::pair<uint, std::vector<uint>>>& doors);
+
+  /// @return the regions that share a door with the region, in ID order
+  std::vector<uint> adjacent(uint region_id) const;
+
+  /// @return the regions reachable from the region, itself included, in ID order, or none if it isn't in the graph
+  std::vector<uint> reachable(uint region_id) const;
+
+  /// @return whether a path through doors leads from one region to the other
+  bool connected(uint from, uint to) const;
+
+  /**
+   * @brief Finds a path through the fewest doors
+   * @param regions set to the regions along the path, from and to included
+   * @param doors set to the doors along the path, one fewer than the regions
+   * @return whether there is a path. The outputs are left empty if not.
+   */
+  bool shortestPath(uint from, uint to, std::vector<uint>& regions, std::vector<uint>& doors) const;
+
+private:
+  /// Region IDs, in ascending order, by node index
+  std::vector<uint> region_ids;
+  /// Node indexes by region ID
+  std::unordered_map<uint, uint> nodes;
+  /// (neighbour node, door ID) pairs of each node, sorted, with one entry per neighbour for the lowest door ID
+  std::vector<std::vector<std::pair<uint, uint>>> edges;
+  /// The connected component of each node
+  std::vector<uint> components;
+  /// The nodes of each component, in ascending order
+  std::vector<std::vector<uint>> members;
+};
+}  // namespace knowledge_rep
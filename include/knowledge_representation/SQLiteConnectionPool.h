@@ -0,0 +1,278 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace knowledge_rep
+{
+/// An error reported by SQLite
+class SQLiteError : public std::runtime_error
+{
+public:
+  SQLiteError(int code, const std::string& what) : std::runtime_error(what), code(code)
+  {
+  }
+
+  /// The extended result code
+  const int code;
+};
+
+/**
+ * @brief A statement being run, with parameters bound in order and rows read one at a time
+ *
+ * Parameters are bound the way pqxx binds them to prepared statements: `connection.prepared("name")(a)(b)`. Statements
+ * that belong to a connection's cache are reset when the handle is destroyed, ready for the next use.
+ */
+class SQLiteStatement
+{
+public:
+  SQLiteStatement(sqlite3_stmt* stmt, bool owned) : stmt(stmt), owned(owned)
+  {
+  }
+
+  SQLiteStatement(SQLiteStatement&& that) noexcept
+    : stmt(that.stmt), owned(that.owned), next_parameter(that.next_parameter)
+  {
+    that.stmt = nullptr;
+  }
+
+  SQLiteStatement& operator=(SQLiteStatement&& that) = delete;
+
+  ~SQLiteStatement();
+
+  SQLiteStatement& operator()(int value) &;
+
+  SQLiteStatement& operator()(uint value) &;
+
+  SQLiteStatement& operator()(bool value) &;
+
+  SQLiteStatement& operator()(double value) &;
+
+  SQLiteStatement& operator()(const std::string& value) &;
+
+  SQLiteStatement& operator()(const char* value) &
+  {
+    return (*this)(std::string(value));
+  }
+
+  /// Binds a blob, which SQLite copies
+  SQLiteStatement& operator()(const void* data, size_t size) &;
+
+  /// Binds to a statement that was just started, so that `auto rows = connection.prepared("name")(a);` works
+  template <typename... Args>
+  SQLiteStatement&& operator()(Args&&... args) &&
+  {
+    return std::move(static_cast<SQLiteStatement&>(*this)(std::forward<Args>(args)...));
+  }
+
+  /**
+   * @brief Advances to the next row
+   * @return whether there is a row to read
+   * @throws SQLiteError if the statement fails
+   */
+  bool step();
+
+  /**
+   * @brief Runs the statement to completion
+   * @return the number of rows it inserted, updated or deleted
+   * @throws SQLiteError if the statement fails
+   */
+  int exec();
+
+  /// Reads a column of the current row
+  template <typename T>
+  T get(int column) const;
+
+  bool isNull(int column) const
+  {
+    return sqlite3_column_type(stmt, column) == SQLITE_NULL;
+  }
+
+  const void* blob(int column, size_t& size) const
+  {
+    auto data = sqlite3_column_blob(stmt, column);
+    size = sqlite3_column_bytes(stmt, column);
+    return data;
+  }
+
+  /// Reads a text column in place. The text is only valid until the statement moves on.
+  const char* text(int column, size_t& size) const
+  {
+    auto data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+    size = sqlite3_column_bytes(stmt, column);
+    return data;
+  }
+
+  /// @return the index of the result column with the given name, or -1 if there is none
+  int columnIndex(const std::string& name) const;
+
+private:
+  SQLiteStatement& bound(int result);
+
+  sqlite3_stmt* stmt;
+  /// Whether the statement is finalized with the handle rather than returned to a cache
+  bool owned;
+  int next_parameter = 1;
+};
+
+template <>
+int SQLiteStatement::get<int>(int column) const;
+template <>
+uint SQLiteStatement::get<uint>(int column) const;
+template <>
+bool SQLiteStatement::get<bool>(int column) const;
+template <>
+double SQLiteStatement::get<double>(int column) const;
+template <>
+std::string SQLiteStatement::get<std::string>(int column) const;
+
+/**
+ * @brief A connection to an SQLite database file, with a cache of prepared statements
+ *
+ * Like a pqxx connection, it may only be used by one thread at a time.
+ */
+class SQLiteConnection
+{
+public:
+  /**
+   * @param path the database file, which is created if it doesn't exist
+   * @throws SQLiteError if the file can't be opened
+   */
+  explicit SQLiteConnection(const std::string& path);
+
+  SQLiteConnection(const SQLiteConnection&) = delete;
+
+  SQLiteConnection& operator=(const SQLiteConnection&) = delete;
+
+  ~SQLiteConnection();
+
+  /**
+   * @brief Registers a statement under a name
+   *
+   * Registration is lazy. The statement is compiled the first time it's used, and every later use skips straight to
+   * binding and running it.
+   */
+  void prepare(const std::string& name, const std::string& sql);
+
+  /// Starts a statement registered with prepare
+  SQLiteStatement prepared(const std::string& name);
+
+  /// Starts a statement that is compiled for this use only
+  SQLiteStatement query(const std::string& sql);
+
+  /// Runs one or more statements that don't return rows
+  void exec(const std::string& sql);
+
+  int64_t lastInsertId() const
+  {
+    return sqlite3_last_insert_rowid(db);
+  }
+
+  sqlite3* handle() const
+  {
+    return db;
+  }
+
+private:
+  struct Prepared
+  {
+    std::string sql;
+    sqlite3_stmt* stmt;
+  };
+
+  sqlite3* db = nullptr;
+  std::unordered_map<std::string, Prepared> statements;
+};
+
+/**
+ * @brief A pool of connections to one SQLite database file that can be shared between threads
+ *
+ * The pool hands each caller a connection of its own for as long as it holds a Lease, opening new connections as
+ * needed up to a maximum and then making callers wait for a lease to be returned. In WAL mode, readers on separate
+ * connections run alongside each other and alongside a writer.
+ */
+class SQLiteConnectionPool
+{
+public:
+  /**
+   * @brief Exclusive use of one pooled connection. The connection goes back to the pool when the lease is destroyed.
+   */
+  class Lease
+  {
+  public:
+    Lease() = default;
+
+    Lease(Lease&& that) noexcept = default;
+
+    Lease& operator=(Lease&& that) noexcept;
+
+    ~Lease();
+
+    SQLiteConnection& operator*() const
+    {
+      return *connection;
+    }
+
+    SQLiteConnection* operator->() const
+    {
+      return connection.get();
+    }
+
+  private:
+    friend class SQLiteConnectionPool;
+
+    Lease(SQLiteConnectionPool& pool, std::unique_ptr<SQLiteConnection> connection)
+      : pool(&pool), connection(std::move(connection))
+    {
+    }
+
+    void release();
+
+    SQLiteConnectionPool* pool = nullptr;
+    std::unique_ptr<SQLiteConnection> connection;
+  };
+
+  /**
+   * @param path the database file for every connection in the pool
+   * @param max_connections the most connections that will be open at once
+   * @param setup run on each connection when it's opened, before it's handed out
+   */
+  SQLiteConnectionPool(std::string path, size_t max_connections, std::function<void(SQLiteConnection&)> setup);
+
+  /**
+   * @brief Borrows a connection, waiting for one to be returned if all of them are in use
+   *
+   * A thread that already holds a lease shouldn't wait on a second one when the pool may be exhausted, as every
+   * holder could end up waiting on the others.
+   * @throws SQLiteError if a new connection can't be opened
+   */
+  Lease acquire();
+
+  size_t maxConnections() const
+  {
+    return max_connections;
+  }
+
+private:
+  void release(std::unique_ptr<SQLiteConnection> connection);
+
+  const std::string path;
+  const size_t max_connections;
+  const std::function<void(SQLiteConnection&)> setup;
+
+  std::mutex mutex;
+  std::condition_variable returned;
+  std::vector<std::unique_ptr<SQLiteConnection>> idle;
+  /// Connections that exist, whether idle or leased
+  size_t num_open = 0;
+};
+}  // namespace knowledge_rep
@@ -11,18 +11,21 @@ CREATE TABLE entities
 
 CREATE TYPE attribute_type as ENUM ('id', 'bool', 'int', 'float', 'str');
 
+/* Names are stored once, here and in concepts. The large tables refer to attributes by attribute_id and to concepts by
+   their entity IDs, so their rows and index entries stay small and lookups compare integers rather than strings. */
 CREATE TABLE attributes
 (
-    attribute_name varchar(24)    NOT NULL,
+    attribute_id   smallserial    NOT NULL,
+    attribute_name varchar(24)    NOT NULL UNIQUE,
     type           attribute_type NOT NULL,
-    PRIMARY KEY (attribute_name)
+    PRIMARY KEY (attribute_id)
 );
 
 CREATE TABLE concepts
 (
     entity_id int NOT NULL,
     concept_name varchar(24) NOT NULL UNIQUE,
-    PRIMARY KEY (entity_id, concept_name),
+    PRIMARY KEY (entity_id),
         FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
@@ -32,14 +35,14 @@ CREATE TABLE concepts
 CREATE TABLE instance_of
 (
     entity_id int NOT NULL,
-    concept_name varchar(24) NOT NULL,
-    PRIMARY KEY (entity_id, concept_name),
+    concept_id int NOT NULL,
+    PRIMARY KEY (entity_id, concept_id),
     FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
-    FOREIGN KEY (concept_name)
-        REFERENCES concepts (concept_name)
+    FOREIGN KEY (concept_id)
+        REFERENCES concepts (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE
 );
@@ -49,15 +52,15 @@ CREATE TABLE instance_of
 CREATE TABLE entity_attributes_id
 (
     entity_id       int         NOT NULL,
-    attribute_name  varchar(24) NOT NULL,
+    attribute_id    smallint    NOT NULL,
     attribute_value int         NOT NULL,
-    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
     FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
-    FOREIGN KEY (attribute_name)
-        REFERENCES attributes (attribute_name)
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
     FOREIGN KEY (attribute_value)
@@ -69,15 +72,15 @@ CREATE TABLE entity_attributes_id
 CREATE TABLE entity_attributes_int
 (
     entity_id       int         NOT NULL,
-    attribute_name  varchar(24) NOT NULL,
+    attribute_id    smallint    NOT NULL,
     attribute_value int         NOT NULL,
-    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
     FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
-    FOREIGN KEY (attribute_name)
-        REFERENCES attributes (attribute_name)
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE
 );
@@ -85,15 +88,15 @@ CREATE TABLE entity_attributes_int
 CREATE TABLE entity_attributes_str
 (
     entity_id       int         NOT NULL,
-    attribute_name  varchar(24) NOT NULL,
+    attribute_id    smallint    NOT NULL,
     attribute_value varchar(24) NOT NULL,
-    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
     FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
-    FOREIGN KEY (attribute_name)
-        REFERENCES attributes (attribute_name)
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE
 );
@@ -101,15 +104,15 @@ CREATE TABLE entity_attributes_str
 CREATE TABLE entity_attributes_float
 (
     entity_id       int         NOT NULL,
-    attribute_name  varchar(24) NOT NULL,
+    attribute_id    smallint    NOT NULL,
     attribute_value double precision NOT NULL,
-    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
     FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
-    FOREIGN KEY (attribute_name)
-        REFERENCES attributes (attribute_name)
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE
 );
@@ -117,15 +120,15 @@ CREATE TABLE entity_attributes_float
 CREATE TABLE entity_attributes_bool
 (
     entity_id       int         NOT NULL,
-    attribute_name  varchar(24) NOT NULL,
+    attribute_id    smallint    NOT NULL,
     attribute_value bool,
-    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
     FOREIGN KEY (entity_id)
         REFERENCES entities (entity_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE,
-    FOREIGN KEY (attribute_name)
-        REFERENCES attributes (attribute_name)
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
         ON DELETE CASCADE
         ON UPDATE CASCADE
 );
@@ -298,9 +301,21 @@ CREATE VIEW doors_points AS
 SELECT entity_id, start[0] as x_0, start[1] as y_0, end_point[0] as x_1, end_point[1] as y_1, door_name, parent_map_id FROM (SELECT entity_id, line[0] as start, line[1] as end_point, door_name, parent_map_id FROM
     doors) AS dummy_sub_alias;
 
+/* Geometry is read a map at a time, and none of the keys above lead with parent_map_id */
+CREATE INDEX points_parent_map_id ON points (parent_map_id);
+CREATE INDEX poses_parent_map_id ON poses (parent_map_id);
+CREATE INDEX regions_parent_map_id ON regions (parent_map_id);
+CREATE INDEX doors_parent_map_id ON doors (parent_map_id);
+
+/* GiST indexes over the geometry's bounding boxes, so that spatial queries only test the rows whose boxes could match.
+   lseg has no GiST operator class, so doors are indexed by the box their ends span. */
+CREATE INDEX regions_region ON regions USING gist (region);
+CREATE INDEX points_point ON points USING gist (point);
+CREATE INDEX doors_line ON doors USING gist (box(line[0], line[1]));
+
 /******************* FUNCTIONS */
 
-CREATE FUNCTION remove_attribute(INT, varchar(24))
+CREATE FUNCTION remove_attribute(INT, smallint)
     RETURNS BIGINT
     LANGUAGE plpgsql
 AS
@@ -313,28 +328,28 @@ DECLARE
     n_str_del   bigint;
 BEGIN
 
-    WITH id_del AS (DELETE FROM entity_attributes_id WHERE entity_id = $1 AND attribute_name = $2 RETURNING entity_id)
+    WITH id_del AS (DELETE FROM entity_attributes_id WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
     SELECT count(*)
     FROM id_del
     INTO n_id_del;
 
     WITH bool_del
-             AS (DELETE FROM entity_attributes_bool WHERE entity_id = $1 AND attribute_name = $2 RETURNING entity_id)
+             AS (DELETE FROM entity_attributes_bool WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
     SELECT count(*)
     FROM bool_del
     INTO n_bool_del;
 
-    WITH int_del AS (DELETE FROM entity_attributes_int WHERE entity_id = $1 AND attribute_name = $2 RETURNING entity_id)
+    WITH int_del AS (DELETE FROM entity_attributes_int WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
     SELECT count(*)
     FROM int_del
     INTO n_int_del;
 
-    WITH float_del AS (DELETE FROM entity_attributes_float WHERE entity_id = $1 AND attribute_name = $2 RETURNING entity_id)
+    WITH float_del AS (DELETE FROM entity_attributes_float WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
     SELECT count(*)
     FROM float_del
     INTO n_float_del;
 
-    WITH str_del AS (DELETE FROM entity_attributes_str WHERE entity_id = $1 AND attribute_name = $2 RETURNING entity_id)
+    WITH str_del AS (DELETE FROM entity_attributes_str WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
     SELECT count(*)
     FROM str_del
     INTO n_str_del;
@@ -356,16 +371,16 @@ WITH RECURSIVE cteConcepts (ID)
    AS
    (
        /* Get whatever the argument is an instance of, and then every thing that that is a descended concept of*/
-       SELECT concepts.entity_id
-       FROM concepts
-       INNER JOIN instance_of ON (instance_of.entity_id = $1 AND instance_of.concept_name = concepts.concept_name)
+       SELECT concept_id
+       FROM instance_of
+       WHERE entity_id = $1
 
        UNION ALL
 
        SELECT a.attribute_value
        FROM entity_attributes_id a
                 INNER JOIN cteConcepts b
-                           ON a.attribute_name = 'is_a'
+                           ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
                                AND a.entity_id = b.ID
    )
 SELECT entity_id, concept_name
@@ -391,7 +406,7 @@ WITH RECURSIVE cteConcepts (id)
        SELECT a.attribute_value
        FROM entity_attributes_id a
                 INNER JOIN cteConcepts b
-                           ON a.attribute_name = 'is_a'
+                           ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
                                AND a.entity_id = b.ID
    )
 SELECT entity_id, concept_name
@@ -418,7 +433,7 @@ AS
    SELECT a.entity_id
    FROM entity_attributes_id a
             INNER JOIN cteConcepts b
-                       ON a.attribute_name = 'is_a'
+                       ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
                         AND a.attribute_value = b.ID
 )
 SELECT entity_id, concept_name
@@ -445,11 +460,52 @@ AS
    SELECT a.entity_id
    FROM entity_attributes_id a
             INNER JOIN cteConcepts b
-                       ON a.attribute_name = 'is_a'
+                       ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
                         AND a.attribute_value = b.ID
 )
-SELECT entity_id, concept_name
-FROM instance_of WHERE concept_name IN (SELECT concept_name FROM cteConcepts INNER JOIN concepts ON (concepts.entity_id = id));
+SELECT instance_of.entity_id, concept_name
+FROM instance_of INNER JOIN concepts ON (concepts.entity_id = concept_id)
+WHERE concept_id IN (SELECT id FROM cteConcepts);
+$$;
+
+/* A map's regions that contain a point. The && test against the point's box is answered by the GiST index, so only
+   regions whose bounding boxes cover the point are tested exactly. */
+CREATE FUNCTION get_containing_regions(INT, double precision, double precision)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                region_name varchar(24),
+                region polygon
+            )
+    STABLE
+    LANGUAGE SQL
+AS
+$$
+SELECT regions.entity_id, regions.region_name, regions.region
+FROM regions
+WHERE parent_map_id = $1
+  AND regions.region && polygon(box(point($2, $3), point($2, $3)))
+  AND regions.region @> point($2, $3);
+$$;
+
+/* The points in a region, prefiltered by the region's bounding box, which the GiST index on points can answer */
+CREATE FUNCTION get_contained_points(INT)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                point_name varchar(24),
+                x double precision,
+                y double precision
+            )
+    STABLE
+    LANGUAGE SQL
+AS
+$$
+SELECT points.entity_id, points.point_name, points.point[0], points.point[1]
+FROM points
+         INNER JOIN regions ON (regions.entity_id = $1 AND points.parent_map_id = regions.parent_map_id)
+WHERE points.point <@ box(regions.region)
+  AND regions.region @> points.point;
 $$;
 
 /***** DEFAULT VALUES */
@@ -460,24 +516,28 @@ AS
 $$
 
 INSERT INTO attributes
-VALUES ('answer_to', 'id'),
-('count', 'int'),
-('default_location', 'id'),
-('has', 'id'),
-('height', 'float'),
-('width', 'float'),
-('is_a', 'id'),
-('is_connected', 'id'),
-('is_delivered', 'id'),
-('is_facing', 'id'),
-('is_holding', 'id'),
-('is_in', 'id'),
-('is_near', 'id'),
-('is_open', 'bool'),
-('is_placed', 'id'),
-('name', 'str'),
-('part_of', 'id'),
-('approach_to', 'id');
+VALUES (1, 'answer_to', 'id'),
+(2, 'count', 'int'),
+(3, 'default_location', 'id'),
+(4, 'has', 'id'),
+(5, 'height', 'float'),
+(6, 'width', 'float'),
+(7, 'is_a', 'id'),
+(8, 'is_connected', 'id'),
+(9, 'is_delivered', 'id'),
+(10, 'is_facing', 'id'),
+(11, 'is_holding', 'id'),
+(12, 'is_in', 'id'),
+(13, 'is_near', 'id'),
+(14, 'is_open', 'bool'),
+(15, 'is_placed', 'id'),
+(16, 'name', 'str'),
+(17, 'part_of', 'id'),
+(18, 'approach_to', 'id');
+
+/* As with entities, so that IDs start over rather than running out after enough resets */
+SELECT setval('attributes_attribute_id_seq', max(attribute_id))
+FROM   attributes;
 $$;
 
 
@@ -492,7 +552,7 @@ VALUES (1), (2), (3), (4), (5), (6), (7);
 INSERT INTO concepts
 VALUES (2, 'robot'), (3, 'map'), (4, 'point'), (5, 'pose'), (6, 'region'), (7, 'door');
 INSERT INTO instance_of
-VALUES (1, 'robot');
+VALUES (1, 2);
 
 /* Manual inserts will mess up the SERIAL sequence, so we have to manually bump the number*/
 SELECT setval('entities_entity_id_seq', max(entity_id))
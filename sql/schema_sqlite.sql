@@ -0,0 +1,257 @@
+/* The SQLite counterpart of schema_postgresql.sql. LongTermMemoryConduitSQLite creates it, along with the default
+   attributes and entities, the first time it opens a database file, so there's no need to load it by hand.
+
+   SQLite doesn't enforce varchar lengths and has no geometric types or stored functions, so:
+   - geometry is kept in plain columns, and regions as a blob of packed (x, y) doubles in native byte order
+   - the conduit registers a polygon_contains(region, x, y) function on each connection, which counts points on the
+     boundary as contained, just like PostgreSQL's @> operator
+   - the recursive concept queries are written out as CTEs in the conduit's prepared statements */
+
+PRAGMA foreign_keys = ON;
+
+CREATE TABLE entities
+(
+    entity_id INTEGER PRIMARY KEY AUTOINCREMENT
+);
+
+CREATE TABLE attributes
+(
+    attribute_name varchar(24) NOT NULL,
+    type           varchar(5)  NOT NULL CHECK (type IN ('id', 'bool', 'int', 'float', 'str')),
+    PRIMARY KEY (attribute_name)
+);
+
+CREATE TABLE concepts
+(
+    entity_id int NOT NULL,
+    concept_name varchar(24) NOT NULL UNIQUE,
+    PRIMARY KEY (entity_id, concept_name),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE TABLE instance_of
+(
+    entity_id int NOT NULL,
+    concept_name varchar(24) NOT NULL,
+    PRIMARY KEY (entity_id, concept_name),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (concept_name)
+        REFERENCES concepts (concept_name)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+/* SQLite only indexes parent keys, so cascades and lookups by concept need their own */
+CREATE INDEX instance_of_concept_name ON instance_of (concept_name);
+
+/******************* ENTITY ATTRIBUTES */
+
+CREATE TABLE entity_attributes_id
+(
+    entity_id       int         NOT NULL,
+    attribute_name  varchar(24) NOT NULL,
+    attribute_value int         NOT NULL,
+    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_name)
+        REFERENCES attributes (attribute_name)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_value)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE INDEX entity_attributes_id_value ON entity_attributes_id (attribute_value, attribute_name);
+
+CREATE TABLE entity_attributes_int
+(
+    entity_id       int         NOT NULL,
+    attribute_name  varchar(24) NOT NULL,
+    attribute_value int         NOT NULL,
+    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_name)
+        REFERENCES attributes (attribute_name)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE TABLE entity_attributes_str
+(
+    entity_id       int         NOT NULL,
+    attribute_name  varchar(24) NOT NULL,
+    attribute_value varchar(24) NOT NULL,
+    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_name)
+        REFERENCES attributes (attribute_name)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE TABLE entity_attributes_float
+(
+    entity_id       int         NOT NULL,
+    attribute_name  varchar(24) NOT NULL,
+    attribute_value double precision NOT NULL,
+    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_name)
+        REFERENCES attributes (attribute_name)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE TABLE entity_attributes_bool
+(
+    entity_id       int         NOT NULL,
+    attribute_name  varchar(24) NOT NULL,
+    attribute_value bool CHECK (attribute_value IN (0, 1)),
+    PRIMARY KEY (entity_id, attribute_name, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_name)
+        REFERENCES attributes (attribute_name)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+/******************* MAPS */
+
+CREATE TABLE maps
+(
+    entity_id int UNIQUE NOT NULL,
+    map_id INTEGER PRIMARY KEY AUTOINCREMENT,
+    map_name varchar(24) NOT NULL UNIQUE,
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+/* Geometry is unique by name within its map. The unique constraints lead with the map so that they also serve every
+   per-map query, and the entity_id indexes serve lookups by ID and cascades from entities. */
+
+CREATE TABLE points
+(
+    entity_id int NOT NULL,
+    point_name varchar(24) NOT NULL,
+    parent_map_id int NOT NULL,
+    x double precision NOT NULL,
+    y double precision NOT NULL,
+    PRIMARY KEY (parent_map_id, point_name),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (parent_map_id)
+        REFERENCES maps (map_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE INDEX points_entity_id ON points (entity_id);
+
+CREATE TABLE regions
+(
+    entity_id     int         NOT NULL,
+    region_name   varchar(24) NOT NULL,
+    parent_map_id int         NOT NULL,
+    region        blob        NOT NULL,
+    PRIMARY KEY (entity_id, region_name, parent_map_id),
+    UNIQUE (parent_map_id, region_name),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (parent_map_id)
+        REFERENCES maps (map_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+/* Poses are stored with their angle normalized to [-pi, pi], as PostgreSQL's poses_point_angle view returns them */
+CREATE TABLE poses
+(
+    entity_id int NOT NULL,
+    pose_name varchar(24) NOT NULL,
+    parent_map_id int NOT NULL,
+    x double precision NOT NULL,
+    y double precision NOT NULL,
+    theta double precision NOT NULL,
+    PRIMARY KEY (entity_id, pose_name, parent_map_id),
+    UNIQUE (parent_map_id, pose_name),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (parent_map_id)
+        REFERENCES maps (map_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+CREATE TABLE doors
+(
+    entity_id int NOT NULL,
+    door_name varchar(24) NOT NULL,
+    parent_map_id int NOT NULL,
+    x_0 double precision NOT NULL,
+    y_0 double precision NOT NULL,
+    x_1 double precision NOT NULL,
+    y_1 double precision NOT NULL,
+    PRIMARY KEY (entity_id, door_name, parent_map_id),
+    UNIQUE (parent_map_id, door_name),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (parent_map_id)
+        REFERENCES maps (map_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+
+/* Deleting a map will delete owned entries in the geometry tables via cascade
+   on their parent_map_id references, but their deletion doesn't cascade to the entities table.
+   This trigger manually deletes entities associated with the map. */
+CREATE TRIGGER delete_map_owned_entities
+    BEFORE DELETE
+    ON maps
+    FOR EACH ROW
+BEGIN
+    DELETE
+    FROM entities
+    WHERE entity_id IN (SELECT entity_id FROM poses WHERE parent_map_id = OLD.map_id
+                        UNION
+                        SELECT entity_id FROM points WHERE parent_map_id = OLD.map_id
+                        UNION
+                        SELECT entity_id FROM regions WHERE parent_map_id = OLD.map_id
+                        UNION
+                        SELECT entity_id FROM doors WHERE parent_map_id = OLD.map_id);
+END;
+
+/* Bumped whenever the schema changes, so the conduit can tell which version a database file has */
+PRAGMA user_version = 1;
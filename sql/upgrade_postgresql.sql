@@ -0,0 +1,435 @@
+/* Brings a knowledge base created from an older schema_postgresql.sql up to date without touching its contents.
+   schema_postgresql.sql starts by dropping everything, so run this instead on databases worth keeping:
+
+       psql -d knowledge_base -f upgrade_postgresql.sql
+
+   Every statement checks for what it adds, so running it more than once, or on a current database, is harmless. */
+
+/* Geometry is read a map at a time, and none of the geometry tables' keys lead with parent_map_id */
+CREATE INDEX IF NOT EXISTS points_parent_map_id ON points (parent_map_id);
+CREATE INDEX IF NOT EXISTS poses_parent_map_id ON poses (parent_map_id);
+CREATE INDEX IF NOT EXISTS regions_parent_map_id ON regions (parent_map_id);
+CREATE INDEX IF NOT EXISTS doors_parent_map_id ON doors (parent_map_id);
+
+/* GiST indexes over the geometry's bounding boxes */
+CREATE INDEX IF NOT EXISTS regions_region ON regions USING gist (region);
+CREATE INDEX IF NOT EXISTS points_point ON points USING gist (point);
+CREATE INDEX IF NOT EXISTS doors_line ON doors USING gist (box(line[0], line[1]));
+
+CREATE OR REPLACE FUNCTION get_containing_regions(INT, double precision, double precision)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                region_name varchar(24),
+                region polygon
+            )
+    STABLE
+    LANGUAGE SQL
+AS
+$$
+SELECT regions.entity_id, regions.region_name, regions.region
+FROM regions
+WHERE parent_map_id = $1
+  AND regions.region && polygon(box(point($2, $3), point($2, $3)))
+  AND regions.region @> point($2, $3);
+$$;
+
+CREATE OR REPLACE FUNCTION get_contained_points(INT)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                point_name varchar(24),
+                x double precision,
+                y double precision
+            )
+    STABLE
+    LANGUAGE SQL
+AS
+$$
+SELECT points.entity_id, points.point_name, points.point[0], points.point[1]
+FROM points
+         INNER JOIN regions ON (regions.entity_id = $1 AND points.parent_map_id = regions.parent_map_id)
+WHERE points.point <@ box(regions.region)
+  AND regions.region @> points.point;
+$$;
+
+/* Attribute and concept names are stored once, in attributes and concepts, and the large tables refer to them by ID.
+   The tables that held names are set aside and rebuilt, which rewrites them no more than an UPDATE would and leaves
+   their columns in the same order as a new knowledge base's. */
+DO $upgrade$
+BEGIN
+IF EXISTS (SELECT 1
+           FROM information_schema.columns
+           WHERE table_name = 'attributes' AND column_name = 'attribute_id') THEN
+    RETURN;
+END IF;
+
+ALTER TABLE attributes RENAME TO attributes_by_name;
+ALTER INDEX attributes_pkey RENAME TO attributes_by_name_pkey;
+CREATE TABLE attributes
+(
+    attribute_id   smallserial    NOT NULL,
+    attribute_name varchar(24)    NOT NULL UNIQUE,
+    type           attribute_type NOT NULL,
+    PRIMARY KEY (attribute_id)
+);
+INSERT INTO attributes
+SELECT row_number() OVER (ORDER BY attribute_name), attribute_name, type
+FROM attributes_by_name;
+PERFORM setval('attributes_attribute_id_seq', max(attribute_id))
+FROM attributes;
+
+ALTER TABLE entity_attributes_id RENAME TO entity_attributes_id_by_name;
+ALTER INDEX entity_attributes_id_pkey RENAME TO entity_attributes_id_by_name_pkey;
+CREATE TABLE entity_attributes_id
+(
+    entity_id       int         NOT NULL,
+    attribute_id    smallint    NOT NULL,
+    attribute_value int         NOT NULL,
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_value)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+INSERT INTO entity_attributes_id
+SELECT entity_id, attribute_id, attribute_value
+FROM entity_attributes_id_by_name INNER JOIN attributes USING (attribute_name);
+DROP TABLE entity_attributes_id_by_name;
+
+ALTER TABLE entity_attributes_int RENAME TO entity_attributes_int_by_name;
+ALTER INDEX entity_attributes_int_pkey RENAME TO entity_attributes_int_by_name_pkey;
+CREATE TABLE entity_attributes_int
+(
+    entity_id       int         NOT NULL,
+    attribute_id    smallint    NOT NULL,
+    attribute_value int         NOT NULL,
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+INSERT INTO entity_attributes_int
+SELECT entity_id, attribute_id, attribute_value
+FROM entity_attributes_int_by_name INNER JOIN attributes USING (attribute_name);
+DROP TABLE entity_attributes_int_by_name;
+
+ALTER TABLE entity_attributes_str RENAME TO entity_attributes_str_by_name;
+ALTER INDEX entity_attributes_str_pkey RENAME TO entity_attributes_str_by_name_pkey;
+CREATE TABLE entity_attributes_str
+(
+    entity_id       int         NOT NULL,
+    attribute_id    smallint    NOT NULL,
+    attribute_value varchar(24) NOT NULL,
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+INSERT INTO entity_attributes_str
+SELECT entity_id, attribute_id, attribute_value
+FROM entity_attributes_str_by_name INNER JOIN attributes USING (attribute_name);
+DROP TABLE entity_attributes_str_by_name;
+
+ALTER TABLE entity_attributes_float RENAME TO entity_attributes_float_by_name;
+ALTER INDEX entity_attributes_float_pkey RENAME TO entity_attributes_float_by_name_pkey;
+CREATE TABLE entity_attributes_float
+(
+    entity_id       int         NOT NULL,
+    attribute_id    smallint    NOT NULL,
+    attribute_value double precision NOT NULL,
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+INSERT INTO entity_attributes_float
+SELECT entity_id, attribute_id, attribute_value
+FROM entity_attributes_float_by_name INNER JOIN attributes USING (attribute_name);
+DROP TABLE entity_attributes_float_by_name;
+
+ALTER TABLE entity_attributes_bool RENAME TO entity_attributes_bool_by_name;
+ALTER INDEX entity_attributes_bool_pkey RENAME TO entity_attributes_bool_by_name_pkey;
+CREATE TABLE entity_attributes_bool
+(
+    entity_id       int         NOT NULL,
+    attribute_id    smallint    NOT NULL,
+    attribute_value bool,
+    PRIMARY KEY (entity_id, attribute_id, attribute_value),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (attribute_id)
+        REFERENCES attributes (attribute_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+INSERT INTO entity_attributes_bool
+SELECT entity_id, attribute_id, attribute_value
+FROM entity_attributes_bool_by_name INNER JOIN attributes USING (attribute_name);
+DROP TABLE entity_attributes_bool_by_name;
+DROP TABLE attributes_by_name;
+
+ALTER TABLE instance_of RENAME TO instance_of_by_name;
+ALTER INDEX instance_of_pkey RENAME TO instance_of_by_name_pkey;
+ALTER TABLE concepts DROP CONSTRAINT concepts_pkey, ADD PRIMARY KEY (entity_id);
+CREATE TABLE instance_of
+(
+    entity_id int NOT NULL,
+    concept_id int NOT NULL,
+    PRIMARY KEY (entity_id, concept_id),
+    FOREIGN KEY (entity_id)
+        REFERENCES entities (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE,
+    FOREIGN KEY (concept_id)
+        REFERENCES concepts (entity_id)
+        ON DELETE CASCADE
+        ON UPDATE CASCADE
+);
+INSERT INTO instance_of
+SELECT instance_of_by_name.entity_id, concepts.entity_id
+FROM instance_of_by_name INNER JOIN concepts USING (concept_name);
+DROP TABLE instance_of_by_name;
+END $upgrade$;
+
+/* remove_attribute takes an attribute ID instead of a name */
+DROP FUNCTION IF EXISTS remove_attribute(INT, varchar(24));
+
+CREATE OR REPLACE FUNCTION remove_attribute(INT, smallint)
+    RETURNS BIGINT
+    LANGUAGE plpgsql
+AS
+$body$
+DECLARE
+    n_id_del    bigint;
+    n_bool_del  bigint;
+    n_int_del    bigint;
+    n_float_del bigint;
+    n_str_del   bigint;
+BEGIN
+
+    WITH id_del AS (DELETE FROM entity_attributes_id WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
+    SELECT count(*)
+    FROM id_del
+    INTO n_id_del;
+
+    WITH bool_del
+             AS (DELETE FROM entity_attributes_bool WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
+    SELECT count(*)
+    FROM bool_del
+    INTO n_bool_del;
+
+    WITH int_del AS (DELETE FROM entity_attributes_int WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
+    SELECT count(*)
+    FROM int_del
+    INTO n_int_del;
+
+    WITH float_del AS (DELETE FROM entity_attributes_float WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
+    SELECT count(*)
+    FROM float_del
+    INTO n_float_del;
+
+    WITH str_del AS (DELETE FROM entity_attributes_str WHERE entity_id = $1 AND attribute_id = $2 RETURNING entity_id)
+    SELECT count(*)
+    FROM str_del
+    INTO n_str_del;
+    RETURN n_id_del + n_bool_del + n_int_del + n_float_del + n_str_del;
+END
+$body$;
+
+CREATE OR REPLACE FUNCTION get_concepts_recursive(INT)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                concept_name varchar(24)
+            )
+    IMMUTABLE
+    LANGUAGE SQL
+AS
+$$
+WITH RECURSIVE cteConcepts (ID)
+   AS
+   (
+       /* Get whatever the argument is an instance of, and then every thing that that is a descended concept of*/
+       SELECT concept_id
+       FROM instance_of
+       WHERE entity_id = $1
+
+       UNION ALL
+
+       SELECT a.attribute_value
+       FROM entity_attributes_id a
+                INNER JOIN cteConcepts b
+                           ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
+                               AND a.entity_id = b.ID
+   )
+SELECT entity_id, concept_name
+FROM cteConcepts INNER JOIN concepts ON entity_id = ID;
+$$;
+
+CREATE OR REPLACE FUNCTION get_all_concept_ancestors(INT)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                concept_name varchar(24)
+            )
+    IMMUTABLE
+    LANGUAGE SQL
+AS
+$$
+WITH RECURSIVE cteConcepts (id)
+   AS
+   (
+       /* Make sure the argument is a concept */
+       SELECT entity_id FROM concepts WHERE (entity_id = $1)
+       UNION ALL
+       SELECT a.attribute_value
+       FROM entity_attributes_id a
+                INNER JOIN cteConcepts b
+                           ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
+                               AND a.entity_id = b.ID
+   )
+SELECT entity_id, concept_name
+FROM cteConcepts INNER JOIN concepts ON entity_id = ID;
+$$;
+
+CREATE OR REPLACE FUNCTION get_all_concept_descendants(INT)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                concept_name varchar(24)
+            )
+    IMMUTABLE
+    LANGUAGE SQL
+AS
+$$
+WITH RECURSIVE cteConcepts (id)
+AS
+(
+   /* Make sure the argument is a concept */
+   SELECT entity_id FROM concepts WHERE (entity_id = $1)
+   UNION ALL
+   SELECT a.entity_id
+   FROM entity_attributes_id a
+            INNER JOIN cteConcepts b
+                       ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
+                        AND a.attribute_value = b.ID
+)
+SELECT entity_id, concept_name
+FROM cteConcepts INNER JOIN concepts ON entity_id = ID;
+$$;
+
+CREATE OR REPLACE FUNCTION get_all_instances_of_concept_recursive(INT)
+    RETURNS TABLE
+            (
+                entity_id INT,
+                concept_name varchar(24)
+            )
+    IMMUTABLE
+    LANGUAGE SQL
+AS
+$$
+WITH RECURSIVE cteConcepts (id)
+AS
+(
+   /* Make sure the argument is a concept */
+   SELECT entity_id FROM concepts WHERE (entity_id = $1)
+   UNION ALL
+   SELECT a.entity_id
+   FROM entity_attributes_id a
+            INNER JOIN cteConcepts b
+                       ON a.attribute_id = (SELECT attribute_id FROM attributes WHERE attribute_name = 'is_a')
+                        AND a.attribute_value = b.ID
+)
+SELECT instance_of.entity_id, concept_name
+FROM instance_of INNER JOIN concepts ON (concepts.entity_id = concept_id)
+WHERE concept_id IN (SELECT id FROM cteConcepts);
+$$;
+
+CREATE OR REPLACE FUNCTION add_default_attributes()
+    RETURNS VOID
+    LANGUAGE SQL
+AS
+$$
+
+INSERT INTO attributes
+VALUES (1, 'answer_to', 'id'),
+(2, 'count', 'int'),
+(3, 'default_location', 'id'),
+(4, 'has', 'id'),
+(5, 'height', 'float'),
+(6, 'width', 'float'),
+(7, 'is_a', 'id'),
+(8, 'is_connected', 'id'),
+(9, 'is_delivered', 'id'),
+(10, 'is_facing', 'id'),
+(11, 'is_holding', 'id'),
+(12, 'is_in', 'id'),
+(13, 'is_near', 'id'),
+(14, 'is_open', 'bool'),
+(15, 'is_placed', 'id'),
+(16, 'name', 'str'),
+(17, 'part_of', 'id'),
+(18, 'approach_to', 'id');
+
+/* As with entities, so that IDs start over rather than running out after enough resets */
+SELECT setval('attributes_attribute_id_seq', max(attribute_id))
+FROM   attributes;
+$$;
+
+CREATE OR REPLACE FUNCTION add_default_entities()
+    RETURNS bigint
+    LANGUAGE SQL
+AS
+$$
+
+INSERT INTO entities
+VALUES (1), (2), (3), (4), (5), (6), (7);
+INSERT INTO concepts
+VALUES (2, 'robot'), (3, 'map'), (4, 'point'), (5, 'pose'), (6, 'region'), (7, 'door');
+INSERT INTO instance_of
+VALUES (1, 2);
+
+/* Manual inserts will mess up the SERIAL sequence, so we have to manually bump the number*/
+SELECT setval('entities_entity_id_seq', max(entity_id))
+FROM   entities;
+$$;
+
+/* New knowledge bases get fresh statistics as they fill, but indexes added to a full one are best planned with them */
+ANALYZE points;
+ANALYZE poses;
+ANALYZE regions;
+ANALYZE doors;
+ANALYZE attributes;
+ANALYZE concepts;
+ANALYZE instance_of;
+ANALYZE entity_attributes_id;
+ANALYZE entity_attributes_int;
+ANALYZE entity_attributes_str;
+ANALYZE entity_attributes_float;
+ANALYZE entity_attributes_bool;
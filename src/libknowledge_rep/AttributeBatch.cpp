@@ -0,0 +1,139 @@
+#include <knowledge_representation/AttributeBatch.h>
+#include <cassert>
+
+namespace knowledge_rep
+{
+void AttributeBatch::clear()
+{
+  entity_ids.clear();
+  name_indexes.clear();
+  types.clear();
+  value_indexes.clear();
+  names.clear();
+  name_lookup.clear();
+  id_values.clear();
+  bool_values.clear();
+  int_values.clear();
+  float_values.clear();
+  string_arena.clear();
+  string_offsets.resize(1);
+}
+
+void AttributeBatch::reserve(size_t rows)
+{
+  entity_ids.reserve(rows);
+  name_indexes.reserve(rows);
+  types.reserve(rows);
+  value_indexes.reserve(rows);
+}
+
+uint32_t AttributeBatch::nameIndex(const AttributeString& name)
+{
+  // Rows tend to arrive grouped by attribute, so the last row's name is usually the one wanted
+  if (!name_indexes.empty() && names[name_indexes.back()] == name)
+  {
+    return name_indexes.back();
+  }
+  auto found = name_lookup.find(name);
+  if (found != name_lookup.end())
+  {
+    return found->second;
+  }
+  uint32_t index = names.size();
+  names.push_back(name);
+  name_lookup.emplace(name, index);
+  return index;
+}
+
+void AttributeBatch::emplace_back(uint entity_id, const AttributeString& attribute_name, const AttributeValue& value)
+{
+  entity_ids.push_back(entity_id);
+  name_indexes.push_back(nameIndex(attribute_name));
+  types.push_back(value.which());
+  switch (value.which())
+  {
+    case Id:
+      value_indexes.push_back(id_values.size());
+      id_values.push_back(value.get<uint>());
+      break;
+    case Bool:
+      value_indexes.push_back(bool_values.size());
+      bool_values.push_back(value.get<bool>());
+      break;
+    case Int:
+      value_indexes.push_back(int_values.size());
+      int_values.push_back(value.get<int>());
+      break;
+    case Float:
+      value_indexes.push_back(float_values.size());
+      float_values.push_back(value.get<double>());
+      break;
+    default:
+    {
+      value_indexes.push_back(stringCount());
+      auto str = value.get<AttributeString>();
+      string_arena.append(str.c_str(), str.size());
+      string_offsets.push_back(string_arena.size());
+      break;
+    }
+  }
+}
+
+void AttributeBatch::append(const AttributeBatch& other)
+{
+  std::vector<uint32_t> renamed;
+  renamed.reserve(other.names.size());
+  for (const auto& name : other.names)
+  {
+    renamed.push_back(nameIndex(name));
+  }
+  // Each of the other batch's values lands after this batch's values of the same type
+  const uint32_t value_offsets[] = { static_cast<uint32_t>(id_values.size()),
+                                     static_cast<uint32_t>(bool_values.size()),
+                                     static_cast<uint32_t>(int_values.size()),
+                                     static_cast<uint32_t>(float_values.size()),
+                                     static_cast<uint32_t>(stringCount()) };
+  entity_ids.insert(entity_ids.end(), other.entity_ids.begin(), other.entity_ids.end());
+  types.insert(types.end(), other.types.begin(), other.types.end());
+  for (size_t row = 0; row < other.size(); row++)
+  {
+    name_indexes.push_back(renamed[other.name_indexes[row]]);
+    value_indexes.push_back(value_offsets[other.types[row]] + other.value_indexes[row]);
+  }
+  id_values.insert(id_values.end(), other.id_values.begin(), other.id_values.end());
+  bool_values.insert(bool_values.end(), other.bool_values.begin(), other.bool_values.end());
+  int_values.insert(int_values.end(), other.int_values.begin(), other.int_values.end());
+  float_values.insert(float_values.end(), other.float_values.begin(), other.float_values.end());
+  const uint32_t arena_offset = string_arena.size();
+  string_arena += other.string_arena;
+  for (auto offset = other.string_offsets.begin() + 1; offset != other.string_offsets.end(); ++offset)
+  {
+    string_offsets.push_back(arena_offset + *offset);
+  }
+}
+
+AttributeValue AttributeBatch::value(size_t row) const
+{
+  const uint32_t index = value_indexes[row];
+  switch (types[row])
+  {
+    case Id:
+      return id_values[index];
+    case Bool:
+      return bool_values[index] != 0;
+    case Int:
+      return int_values[index];
+    case Float:
+      return float_values[index];
+    case Str:
+    {
+      size_t size;
+      auto str = stringValue(index, size);
+      return AttributeString(str, size);
+    }
+    default:
+      assert(false);
+      return {};
+  }
+}
+}  // namespace knowledge_rep
@@ -0,0 +1,16 @@
+#include <knowledge_representation/CompactString.h>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace knowledge_rep
+{
+const std::string* internString(const char* str, size_t size)
+{
+  static std::mutex mutex;
+  static std::unordered_set<std::string> strings;
+  std::lock_guard<std::mutex> lock(mutex);
+  // Set elements never move, so the address stays good however many more are added
+  return &*strings.emplace(str, size).first;
+}
+}  // namespace knowledge_rep
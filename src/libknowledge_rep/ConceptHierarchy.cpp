@@ -0,0 +1,209 @@
+#include <knowledge_representation/ConceptHierarchy.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+namespace knowledge_rep
+{
+void ConceptHierarchy::clear()
+{
+  nodes.clear();
+  parents.clear();
+  ancestors.clear();
+  capacity = 0;
+  stale = false;
+  instance_concepts.clear();
+}
+
+void ConceptHierarchy::reset(const vector<std::pair<uint, uint>>& is_a)
+{
+  clear();
+  for (const auto& relation : is_a)
+  {
+    // Adding the parent's node may grow parents, so neither node can be looked up until both exist
+    auto child = node(relation.first);
+    auto parent = node(relation.second);
+    parents[child].push_back(parent);
+  }
+  // Computing the closure once is cheaper than keeping it up to date relation by relation
+  stale = true;
+}
+
+uint ConceptHierarchy::node(uint entity_id)
+{
+  auto inserted = nodes.emplace(entity_id, parents.size());
+  if (inserted.second)
+  {
+    parents.emplace_back();
+    if (parents.size() > capacity)
+    {
+      capacity = std::max<size_t>(64, capacity * 2);
+      for (auto& reached : ancestors)
+      {
+        reached.resize(capacity);
+      }
+    }
+    ancestors.emplace_back(capacity);
+    ancestors.back().set(inserted.first->second);
+  }
+  return inserted.first->second;
+}
+
+void ConceptHierarchy::addIsA(uint child, uint parent)
+{
+  uint child_node = node(child);
+  uint parent_node = node(parent);
+  auto& child_parents = parents[child_node];
+  if (std::find(child_parents.begin(), child_parents.end(), parent_node) != child_parents.end())
+  {
+    return;
+  }
+  child_parents.push_back(parent_node);
+  if (stale)
+  {
+    return;
+  }
+  // Everything that descends from the child, the child included, now descends from everything the parent does
+  const auto parent_ancestors = ancestors[parent_node];
+  for (auto& reached : ancestors)
+  {
+    if (reached.test(child_node))
+    {
+      reached |= parent_ancestors;
+    }
+  }
+}
+
+void ConceptHierarchy::removeIsA(uint child, uint parent)
+{
+  auto child_node = nodes.find(child);
+  auto parent_node = nodes.find(parent);
+  if (child_node == nodes.end() || parent_node == nodes.end())
+  {
+    return;
+  }
+  auto& child_parents = parents[child_node->second];
+  auto edge = std::find(child_parents.begin(), child_parents.end(), parent_node->second);
+  if (edge != child_parents.end())
+  {
+    child_parents.erase(edge);
+    stale = true;
+  }
+}
+
+void ConceptHierarchy::removeIsA(uint child)
+{
+  auto child_node = nodes.find(child);
+  if (child_node != nodes.end() && !parents[child_node->second].empty())
+  {
+    parents[child_node->second].clear();
+    stale = true;
+  }
+}
+
+void ConceptHierarchy::removeEntity(uint entity_id)
+{
+  auto entity_node = nodes.find(entity_id);
+  if (entity_node == nodes.end())
+  {
+    return;
+  }
+  // The node stays behind with no relations, as node indexes can't be reused without recomputing every bitset
+  uint removed = entity_node->second;
+  parents[removed].clear();
+  for (auto& node_parents : parents)
+  {
+    node_parents.erase(std::remove(node_parents.begin(), node_parents.end(), removed), node_parents.end());
+  }
+  stale = true;
+}
+
+void ConceptHierarchy::recompute() const
+{
+  vector<uint> frontier;
+  for (uint start = 0; start < parents.size(); start++)
+  {
+    auto& reached = ancestors[start];
+    reached.reset();
+    reached.set(start);
+    frontier.push_back(start);
+    while (!frontier.empty())
+    {
+      uint current = frontier.back();
+      frontier.pop_back();
+      for (uint parent : parents[current])
+      {
+        if (!reached.test(parent))
+        {
+          reached.set(parent);
+          frontier.push_back(parent);
+        }
+      }
+    }
+  }
+  stale = false;
+}
+
+bool ConceptHierarchy::isA(uint descendant, uint ancestor) const
+{
+  if (descendant == ancestor)
+  {
+    return true;
+  }
+  auto descendant_node = nodes.find(descendant);
+  auto ancestor_node = nodes.find(ancestor);
+  if (descendant_node == nodes.end() || ancestor_node == nodes.end())
+  {
+    return false;
+  }
+  if (stale)
+  {
+    recompute();
+  }
+  return ancestors[descendant_node->second].test(ancestor_node->second);
+}
+
+bool ConceptHierarchy::knowsInstance(uint instance_id) const
+{
+  return instance_concepts.count(instance_id) == 1;
+}
+
+void ConceptHierarchy::setConcepts(uint instance_id, vector<uint> concept_ids)
+{
+  instance_concepts[instance_id] = std::move(concept_ids);
+}
+
+void ConceptHierarchy::addConcept(uint instance_id, uint concept_id)
+{
+  auto concepts = instance_concepts.find(instance_id);
+  if (concepts != instance_concepts.end() &&
+      std::find(concepts->second.begin(), concepts->second.end(), concept_id) == concepts->second.end())
+  {
+    concepts->second.push_back(concept_id);
+  }
+}
+
+void ConceptHierarchy::forgetInstances()
+{
+  instance_concepts.clear();
+}
+
+bool ConceptHierarchy::instanceOf(uint instance_id, uint concept_id) const
+{
+  auto concepts = instance_concepts.find(instance_id);
+  if (concepts == instance_concepts.end())
+  {
+    return false;
+  }
+  for (uint direct : concepts->second)
+  {
+    if (isA(direct, concept_id))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace knowledge_rep
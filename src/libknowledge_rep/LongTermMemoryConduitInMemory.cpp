@@ -0,0 +1,2536 @@
+#include <knowledge_representation/LongTermMemoryConduitInMemory.h>
+#include <knowledge_representation/LongTermMemoryConduitInterface.h>
+#include <knowledge_representation/ConceptHierarchy.h>
+#include <knowledge_representation/MapSpatialIndex.h>
+#include <iostream>
+#include <string>
+#include <knowledge_representation/LTMCConcept.h>
+#include <knowledge_representation/LTMCInstance.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCPoint.h>
+#include <knowledge_representation/LTMCPose.h>
+#include <knowledge_representation/LTMCRegion.h>
+#include <knowledge_representation/LTMCDoor.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+using std::string;
+using std::vector;
+namespace knowledge_rep
+{
+typedef LTMCEntity<LongTermMemoryConduitInMemory> Entity;
+typedef LTMCConcept<LongTermMemoryConduitInMemory> Concept;
+typedef LTMCInstance<LongTermMemoryConduitInMemory> Instance;
+typedef LTMCPoint<LongTermMemoryConduitInMemory> Point;
+typedef LTMCPose<LongTermMemoryConduitInMemory> Pose;
+typedef LTMCRegion<LongTermMemoryConduitInMemory> Region;
+typedef LTMCMap<LongTermMemoryConduitInMemory> Map;
+
+namespace
+{
+// Mirror add_default_attributes() and add_default_entities() from the PostgreSQL schema
+const std::pair<const char*, AttributeValueType> DEFAULT_ATTRIBUTES[] = {
+  { "answer_to", Id },
+  { "count", Int },
+  { "default_location", Id },
+  { "has", Id },
+  { "height", Float },
+  { "width", Float },
+  { "is_a", Id },
+  { "is_connected", Id },
+  { "is_delivered", Id },
+  { "is_facing", Id },
+  { "is_holding", Id },
+  { "is_in", Id },
+  { "is_near", Id },
+  { "is_open", Bool },
+  { "is_placed", Id },
+  { "name", Str },
+  { "part_of", Id },
+  { "approach_to", Id },
+};
+
+const std::pair<uint, const char*> DEFAULT_CONCEPTS[] = {
+  { 2, "robot" }, { 3, "map" }, { 4, "point" }, { 5, "pose" }, { 6, "region" }, { 7, "door" },
+};
+
+enum GeometryKind
+{
+  PointGeometry,
+  PoseGeometry,
+  RegionGeometry,
+  DoorGeometry
+};
+
+const char* const GEOMETRY_CONCEPTS[] = { "point", "pose", "region", "door" };
+
+struct StoredAttribute
+{
+  string name;
+  /// IDs are held as uint so that they stay distinct from ints, the same way they live in separate tables
+  AttributeValue value;
+};
+
+struct EntityRecord
+{
+  vector<StoredAttribute> attributes;
+  /// Names of the concepts this entity is an instance of
+  vector<string> concepts;
+};
+
+/// An ID attribute, indexed under the entity it points at
+struct Reference
+{
+  uint entity_id;
+  string attribute_name;
+};
+
+struct GeometryRecord
+{
+  GeometryKind kind;
+  string name;
+  uint map_id;
+  /// One point for points and poses, the ends of a door, or the vertices of a region
+  vector<std::pair<double, double>> points;
+  double theta;
+};
+
+/// A map's geometry of one kind, in the order it was added
+struct GeometryIndex
+{
+  vector<uint> entity_ids;
+  std::unordered_map<string, uint> by_name;
+};
+
+struct MapRecord
+{
+  uint entity_id;
+  string name;
+  std::array<GeometryIndex, 4> geometry;
+  /// The map's geometry, for containment, proximity and topology queries
+  MapSpatialIndex spatial;
+};
+
+bool sameValue(const AttributeValue& a, const AttributeValue& b)
+{
+  return a.which() == b.which() && a == b;
+}
+
+/// Databases rarely have uint support, so IDs have always come back as ints
+AttributeValue exposedValue(const AttributeValue& value)
+{
+  if (value.which() == Id)
+  {
+    return static_cast<int>(value.get<uint>());
+  }
+  return value;
+}
+
+/**
+ * @brief Converts a value to an attribute's type when no information is lost, as bulk loads do
+ * @throws std::invalid_argument if the value can't be stored as the given type
+ */
+AttributeValue convertValue(const AttributeValue& value, AttributeValueType type)
+{
+  auto converted = convertAttributeValue(value, type);
+  if (!converted)
+  {
+    throw std::invalid_argument("Can't store " + toString(value) + " as an attribute of type " +
+                                attribute_value_type_to_string[type]);
+  }
+  return *converted;
+}
+
+string instanceKey(const string& name, const string& concept_name)
+{
+  // Names can't contain NUL, so this can't be ambiguous
+  return concept_name + '\0' + name;
+}
+
+/**
+ * @brief Entries of one of the knowledgebase's indexes as they were before a write batch first changed them
+ */
+template <typename Index>
+class BeforeImages
+{
+public:
+  /// Keeps a copy of the entry, or notes that there's none, unless it's already been saved
+  void save(const Index& index, const typename Index::key_type& key)
+  {
+    if (images.count(key) == 1)
+    {
+      return;
+    }
+    auto entry = index.find(key);
+    images.emplace(key, entry == index.end() ? nullptr : Image(new typename Index::mapped_type(entry->second)));
+  }
+
+  /// Puts the saved entries back
+  void restore(Index& index) const
+  {
+    for (const auto& image : images)
+    {
+      index.erase(image.first);
+      if (image.second)
+      {
+        index.emplace(image.first, *image.second);
+      }
+    }
+  }
+
+  /// Hands the images over to an enclosing batch, which keeps the older ones it already has
+  void mergeInto(BeforeImages& enclosing)
+  {
+    for (auto& image : images)
+    {
+      enclosing.images.emplace(image.first, std::move(image.second));
+    }
+    images.clear();
+  }
+
+private:
+  /// Null when the entry didn't exist
+  using Image = std::unique_ptr<typename Index::mapped_type>;
+  std::unordered_map<typename Index::key_type, Image> images;
+};
+}  // namespace
+
+/**
+ * @brief What a write batch needs to put the knowledgebase back the way it was when the batch opened
+ *
+ * Batches change the knowledgebase in place, saving each entry the first time they change it. Opening a batch costs
+ * nothing and aborting one costs as much as what it changed. Operations that clear the knowledgebase save all of it
+ * instead, after which nothing more needs saving.
+ */
+struct LongTermMemoryConduitInMemory::UndoLog
+{
+  explicit UndoLog(const State& state);
+
+  /// Undoes the batch's changes
+  void restore(State& state) const;
+
+  /// Makes the batch's changes part of the enclosing batch, for when it commits
+  void mergeInto(UndoLog& enclosing);
+
+  uint next_entity_id;
+  uint next_map_id;
+  BeforeImages<std::unordered_map<uint, EntityRecord>> entities;
+  BeforeImages<std::unordered_map<string, AttributeValueType>> attribute_types;
+  BeforeImages<std::unordered_map<string, uint>> concept_ids;
+  BeforeImages<std::unordered_map<uint, string>> concept_names;
+  BeforeImages<std::unordered_map<string, std::set<uint>>> instances;
+  BeforeImages<std::unordered_map<uint, vector<Reference>>> referrers;
+  BeforeImages<std::unordered_map<string, std::set<uint>>> named;
+  BeforeImages<std::unordered_map<uint, MapRecord>> maps;
+  BeforeImages<std::unordered_map<string, uint>> map_ids_by_name;
+  BeforeImages<std::unordered_map<uint, uint>> map_ids_by_entity;
+  BeforeImages<std::unordered_map<uint, GeometryRecord>> geometry;
+  /// Set when an is_a relation changes. The hierarchy is then rebuilt from the restored attributes.
+  bool hierarchy_changed = false;
+  /// The whole knowledgebase, saved before an operation cleared it
+  std::unique_ptr<State> snapshot;
+};
+
+/**
+ * @brief Everything in a knowledgebase
+ *
+ * Mutators keep the indexes consistent and enforce the same constraints as the PostgreSQL schema, cascading deletes
+ * included. They check everything before changing anything, so a failed operation leaves no trace. Inside a write
+ * batch they save what they're about to change to the batch's undo log.
+ */
+struct LongTermMemoryConduitInMemory::State
+{
+  uint next_entity_id = 1;
+  uint next_map_id = 1;
+
+  std::unordered_map<uint, EntityRecord> entities;
+  std::unordered_map<string, AttributeValueType> attribute_types;
+  std::unordered_map<string, uint> concept_ids;
+  std::unordered_map<uint, string> concept_names;
+  /// Instances of each concept, by concept name
+  std::unordered_map<string, std::set<uint>> instances;
+  /// ID attributes by the entity they point at
+  std::unordered_map<uint, vector<Reference>> referrers;
+  /// Entities by the value of their name attribute
+  std::unordered_map<string, std::set<uint>> named;
+  std::unordered_map<uint, MapRecord> maps;
+  std::unordered_map<string, uint> map_ids_by_name;
+  std::unordered_map<uint, uint> map_ids_by_entity;
+  /// Map geometry by entity ID
+  std::unordered_map<uint, GeometryRecord> geometry;
+  /// The transitive closure of is_a
+  ConceptHierarchy hierarchy;
+  /// The innermost open write batch's undo log, if a batch is open
+  UndoLog* undo = nullptr;
+
+  /// Saves an index entry to the open write batch's undo log before it's changed
+  template <typename Index>
+  void save(BeforeImages<Index> UndoLog::*images, const Index& index, const typename Index::key_type& key)
+  {
+    if (undo && !undo->snapshot)
+    {
+      (undo->*images).save(index, key);
+    }
+  }
+
+  /// Saves the whole knowledgebase to the open write batch's undo log before it's cleared
+  void saveAll()
+  {
+    if (undo && !undo->snapshot)
+    {
+      undo->snapshot.reset(new State(*this));
+    }
+  }
+
+  void isAChanged()
+  {
+    if (undo)
+    {
+      undo->hierarchy_changed = true;
+    }
+  }
+
+  bool entityExists(uint id) const
+  {
+    return entities.count(id) == 1;
+  }
+
+  uint addEntity()
+  {
+    while (entityExists(next_entity_id))
+    {
+      next_entity_id++;
+    }
+    uint id = next_entity_id++;
+    save(&UndoLog::entities, entities, id);
+    entities[id];
+    return id;
+  }
+
+  bool addEntity(uint id)
+  {
+    if (entityExists(id))
+    {
+      return false;
+    }
+    save(&UndoLog::entities, entities, id);
+    entities.emplace(id, EntityRecord{});
+    return true;
+  }
+
+  bool addAttribute(uint id, const string& name, AttributeValue value)
+  {
+    auto entity = entities.find(id);
+    auto type = attribute_types.find(name);
+    if (entity == entities.end() || type == attribute_types.end())
+    {
+      return false;
+    }
+    // Stored as the attribute's own type, as the database backends do
+    auto converted = convertAttributeValue(value, type->second);
+    if (!converted)
+    {
+      return false;
+    }
+    value = std::move(*converted);
+    if (value.which() == Id && !entityExists(value.get<uint>()))
+    {
+      return false;
+    }
+    for (const auto& attribute : entity->second.attributes)
+    {
+      if (attribute.name == name && sameValue(attribute.value, value))
+      {
+        return false;
+      }
+    }
+    if (value.which() == Id)
+    {
+      save(&UndoLog::referrers, referrers, value.get<uint>());
+      referrers[value.get<uint>()].push_back({ id, name });
+      if (name == "is_a")
+      {
+        isAChanged();
+        hierarchy.addIsA(id, value.get<uint>());
+      }
+    }
+    else if (value.which() == Str && name == "name")
+    {
+      save(&UndoLog::named, named, value.get<string>());
+      named[value.get<string>()].insert(id);
+    }
+    save(&UndoLog::entities, entities, id);
+    entity->second.attributes.push_back({ name, std::move(value) });
+    return true;
+  }
+
+  /**
+   * @brief Removes an entity's attributes that match a predicate
+   * @return how many were removed
+   */
+  template <typename Predicate>
+  int removeAttributes(uint id, Predicate matches)
+  {
+    auto entity = entities.find(id);
+    if (entity == entities.end())
+    {
+      return 0;
+    }
+    auto& attributes = entity->second.attributes;
+    if (std::none_of(attributes.begin(), attributes.end(), matches))
+    {
+      return 0;
+    }
+    save(&UndoLog::entities, entities, id);
+    auto removed = std::stable_partition(attributes.begin(), attributes.end(),
+                                         [&matches](const StoredAttribute& attribute) { return !matches(attribute); });
+    int count = std::distance(removed, attributes.end());
+    for (auto it = removed; it != attributes.end(); ++it)
+    {
+      unindexAttribute(id, *it);
+    }
+    attributes.erase(removed, attributes.end());
+    return count;
+  }
+
+  void unindexAttribute(uint id, const StoredAttribute& attribute)
+  {
+    if (attribute.value.which() == Id)
+    {
+      save(&UndoLog::referrers, referrers, attribute.value.get<uint>());
+      auto references = referrers.find(attribute.value.get<uint>());
+      if (references != referrers.end())
+      {
+        auto& list = references->second;
+        list.erase(std::find_if(list.begin(), list.end(),
+                                [&](const Reference& reference) {
+                                  return reference.entity_id == id && reference.attribute_name == attribute.name;
+                                }));
+        if (list.empty())
+        {
+          referrers.erase(references);
+        }
+      }
+      if (attribute.name == "is_a")
+      {
+        isAChanged();
+        hierarchy.removeIsA(id, attribute.value.get<uint>());
+      }
+    }
+    else if (attribute.value.which() == Str && attribute.name == "name")
+    {
+      save(&UndoLog::named, named, attribute.value.get<string>());
+      auto entities_named = named.find(attribute.value.get<string>());
+      if (entities_named != named.end())
+      {
+        entities_named->second.erase(id);
+        if (entities_named->second.empty())
+        {
+          named.erase(entities_named);
+        }
+      }
+    }
+  }
+
+  bool makeConcept(uint id, const string& name)
+  {
+    if (!entityExists(id) || concept_ids.count(name) == 1 || concept_names.count(id) == 1)
+    {
+      return false;
+    }
+    save(&UndoLog::concept_ids, concept_ids, name);
+    save(&UndoLog::concept_names, concept_names, id);
+    concept_ids.emplace(name, id);
+    concept_names.emplace(id, name);
+    return true;
+  }
+
+  bool makeInstanceOf(uint id, const string& concept_name)
+  {
+    auto entity = entities.find(id);
+    if (entity == entities.end() || concept_ids.count(concept_name) == 0)
+    {
+      return false;
+    }
+    auto members = instances.find(concept_name);
+    if (members != instances.end() && members->second.count(id) == 1)
+    {
+      return false;
+    }
+    save(&UndoLog::instances, instances, concept_name);
+    save(&UndoLog::entities, entities, id);
+    instances[concept_name].insert(id);
+    entity->second.concepts.push_back(concept_name);
+    return true;
+  }
+
+  /**
+   * @brief Deletes an entity and everything that refers to it
+   */
+  bool deleteEntity(uint id)
+  {
+    auto entity = entities.find(id);
+    if (entity == entities.end())
+    {
+      return false;
+    }
+    // A map owns its geometry
+    auto map_id = map_ids_by_entity.find(id);
+    if (map_id != map_ids_by_entity.end())
+    {
+      auto map = maps.find(map_id->second);
+      vector<uint> owned;
+      for (const auto& index : map->second.geometry)
+      {
+        owned.insert(owned.end(), index.entity_ids.begin(), index.entity_ids.end());
+      }
+      save(&UndoLog::map_ids_by_name, map_ids_by_name, map->second.name);
+      save(&UndoLog::maps, maps, map_id->second);
+      save(&UndoLog::map_ids_by_entity, map_ids_by_entity, id);
+      map_ids_by_name.erase(map->second.name);
+      maps.erase(map);
+      map_ids_by_entity.erase(map_id);
+      for (uint owned_id : owned)
+      {
+        deleteEntity(owned_id);
+      }
+      entity = entities.find(id);
+    }
+    auto geometry_record = geometry.find(id);
+    if (geometry_record != geometry.end())
+    {
+      save(&UndoLog::geometry, geometry, id);
+      auto map = maps.find(geometry_record->second.map_id);
+      if (map != maps.end())
+      {
+        save(&UndoLog::maps, maps, map->first);
+        auto& index = map->second.geometry[geometry_record->second.kind];
+        index.by_name.erase(geometry_record->second.name);
+        index.entity_ids.erase(std::find(index.entity_ids.begin(), index.entity_ids.end(), id));
+        map->second.spatial.removeEntity(id);
+      }
+      geometry.erase(geometry_record);
+    }
+    // Instances stop being instances of a deleted concept
+    auto concept_name = concept_names.find(id);
+    if (concept_name != concept_names.end())
+    {
+      save(&UndoLog::instances, instances, concept_name->second);
+      save(&UndoLog::concept_ids, concept_ids, concept_name->second);
+      save(&UndoLog::concept_names, concept_names, id);
+      auto members = instances.find(concept_name->second);
+      if (members != instances.end())
+      {
+        for (uint instance_id : members->second)
+        {
+          save(&UndoLog::entities, entities, instance_id);
+          auto& concepts = entities[instance_id].concepts;
+          concepts.erase(std::find(concepts.begin(), concepts.end(), concept_name->second));
+        }
+        instances.erase(members);
+      }
+      concept_ids.erase(concept_name->second);
+      concept_names.erase(concept_name);
+    }
+    for (const auto& name : entity->second.concepts)
+    {
+      save(&UndoLog::instances, instances, name);
+      instances[name].erase(id);
+    }
+    for (const auto& attribute : entity->second.attributes)
+    {
+      unindexAttribute(id, attribute);
+    }
+    auto references = referrers.find(id);
+    if (references != referrers.end())
+    {
+      save(&UndoLog::referrers, referrers, id);
+      auto to_remove = std::move(references->second);
+      referrers.erase(references);
+      for (const auto& reference : to_remove)
+      {
+        if (reference.attribute_name == "is_a")
+        {
+          isAChanged();
+        }
+        save(&UndoLog::entities, entities, reference.entity_id);
+        auto& attributes = entities[reference.entity_id].attributes;
+        attributes.erase(std::find_if(attributes.begin(), attributes.end(), [&](const StoredAttribute& attribute) {
+          return attribute.name == reference.attribute_name && attribute.value.which() == Id &&
+                 attribute.value.get<uint>() == id;
+        }));
+      }
+    }
+    hierarchy.removeEntity(id);
+    save(&UndoLog::entities, entities, id);
+    entities.erase(id);
+    return true;
+  }
+
+  void addDefaultEntities()
+  {
+    for (uint id = 1; id <= 7; id++)
+    {
+      save(&UndoLog::entities, entities, id);
+      entities[id];
+    }
+    for (const auto& concept : DEFAULT_CONCEPTS)
+    {
+      makeConcept(concept.first, concept.second);
+    }
+    makeInstanceOf(1, "robot");
+    next_entity_id = 8;
+  }
+
+  void addDefaultAttributes()
+  {
+    for (const auto& attribute : DEFAULT_ATTRIBUTES)
+    {
+      save(&UndoLog::attribute_types, attribute_types, attribute.first);
+      attribute_types.emplace(attribute.first, attribute.second);
+    }
+  }
+
+  uint deleteAllEntities()
+  {
+    saveAll();
+    uint num_deleted = entities.size();
+    entities.clear();
+    concept_ids.clear();
+    concept_names.clear();
+    instances.clear();
+    referrers.clear();
+    named.clear();
+    maps.clear();
+    map_ids_by_name.clear();
+    map_ids_by_entity.clear();
+    geometry.clear();
+    hierarchy.clear();
+    addDefaultEntities();
+    return num_deleted;
+  }
+
+  bool deleteAttribute(const string& name)
+  {
+    if (attribute_types.count(name) == 0)
+    {
+      return false;
+    }
+    save(&UndoLog::attribute_types, attribute_types, name);
+    attribute_types.erase(name);
+    for (auto& entity : entities)
+    {
+      removeAttributes(entity.first, [&name](const StoredAttribute& attribute) { return attribute.name == name; });
+    }
+    return true;
+  }
+
+  uint deleteAllAttributes()
+  {
+    saveAll();
+    uint num_deleted = attribute_types.size();
+    attribute_types.clear();
+    for (auto& entity : entities)
+    {
+      entity.second.attributes.clear();
+    }
+    referrers.clear();
+    named.clear();
+    hierarchy.clear();
+    addDefaultAttributes();
+    return num_deleted;
+  }
+
+  /**
+   * @brief Concepts reachable from the given ones by following is_a, including the given ones
+   */
+  vector<uint> ancestors(vector<uint> frontier) const
+  {
+    vector<uint> found;
+    std::unordered_set<uint> seen;
+    while (!frontier.empty())
+    {
+      uint id = frontier.back();
+      frontier.pop_back();
+      if (concept_names.count(id) == 0 || !seen.insert(id).second)
+      {
+        continue;
+      }
+      found.push_back(id);
+      for (const auto& attribute : entities.at(id).attributes)
+      {
+        if (attribute.name == "is_a" && attribute.value.which() == Id)
+        {
+          frontier.push_back(attribute.value.get<uint>());
+        }
+      }
+    }
+    return found;
+  }
+
+  /**
+   * @brief Concepts that an instance is transitively an instance of
+   */
+  vector<uint> conceptsRecursive(uint instance_id) const
+  {
+    auto record = entities.find(instance_id);
+    if (record == entities.end())
+    {
+      return {};
+    }
+    vector<uint> direct;
+    for (const auto& name : record->second.concepts)
+    {
+      direct.push_back(concept_ids.at(name));
+    }
+    return ancestors(direct);
+  }
+
+  /**
+   * @brief Whether an instance is an instance of the concept or of something that is transitively a kind of it
+   */
+  bool instanceOf(uint instance_id, uint concept_id) const
+  {
+    auto record = entities.find(instance_id);
+    if (record == entities.end())
+    {
+      return false;
+    }
+    for (const auto& name : record->second.concepts)
+    {
+      if (hierarchy.isA(concept_ids.at(name), concept_id))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Concepts that are directly a kind of the given concept
+   */
+  vector<uint> children(uint concept_id) const
+  {
+    vector<uint> found;
+    auto references = referrers.find(concept_id);
+    if (references != referrers.end())
+    {
+      for (const auto& reference : references->second)
+      {
+        if (reference.attribute_name == "is_a" && concept_names.count(reference.entity_id) == 1)
+        {
+          found.push_back(reference.entity_id);
+        }
+      }
+    }
+    return found;
+  }
+
+  /**
+   * @brief The concept and every concept that is transitively a kind of it
+   */
+  vector<uint> descendants(uint concept_id) const
+  {
+    vector<uint> found;
+    if (concept_names.count(concept_id) == 0)
+    {
+      return found;
+    }
+    std::unordered_set<uint> seen{ concept_id };
+    std::deque<uint> frontier{ concept_id };
+    while (!frontier.empty())
+    {
+      uint id = frontier.front();
+      frontier.pop_front();
+      found.push_back(id);
+      for (uint child : children(id))
+      {
+        if (seen.insert(child).second)
+        {
+          frontier.push_back(child);
+        }
+      }
+    }
+    return found;
+  }
+
+  uint addMap(uint entity_id, const string& name)
+  {
+    if (map_ids_by_name.count(name) == 1 || map_ids_by_entity.count(entity_id) == 1)
+    {
+      return 0;
+    }
+    uint map_id = next_map_id++;
+    save(&UndoLog::maps, maps, map_id);
+    save(&UndoLog::map_ids_by_name, map_ids_by_name, name);
+    save(&UndoLog::map_ids_by_entity, map_ids_by_entity, entity_id);
+    maps[map_id] = MapRecord{ entity_id, name, {}, {} };
+    map_ids_by_name.emplace(name, map_id);
+    map_ids_by_entity.emplace(entity_id, map_id);
+    return map_id;
+  }
+
+  /**
+   * @brief Adds a map-owned geometry entity: the entity, its geometry, the map's has attribute, the name attribute
+   * and the instance_of relation, all or nothing
+   * @throws std::invalid_argument if the map already has geometry of this kind with the name
+   */
+  uint addGeometry(uint map_id, GeometryKind kind, const string& name, vector<std::pair<double, double>> points,
+                   double theta = 0)
+  {
+    auto map = maps.find(map_id);
+    if (map == maps.end())
+    {
+      throw std::invalid_argument("No map with ID " + std::to_string(map_id));
+    }
+    auto& index = map->second.geometry[kind];
+    if (index.by_name.count(name) == 1)
+    {
+      throw std::invalid_argument("Map \"" + map->second.name + "\" already has a " + GEOMETRY_CONCEPTS[kind] +
+                                  " named \"" + name + "\"");
+    }
+    if (attribute_types.count("has") == 0 || attribute_types.count("name") == 0 ||
+        concept_ids.count(GEOMETRY_CONCEPTS[kind]) == 0)
+    {
+      throw std::invalid_argument("The knowledgebase is missing the defaults that map geometry relies on");
+    }
+    uint id = addEntity();
+    save(&UndoLog::maps, maps, map_id);
+    save(&UndoLog::geometry, geometry, id);
+    switch (kind)
+    {
+      case PointGeometry:
+        map->second.spatial.addPoint({ id, name, points[0].first, points[0].second, 0 });
+        break;
+      case PoseGeometry:
+        map->second.spatial.addPose({ id, name, points[0].first, points[0].second, theta });
+        break;
+      case RegionGeometry:
+        map->second.spatial.addRegion({ id, name, points });
+        break;
+      case DoorGeometry:
+        map->second.spatial.addDoor({ id, name, points[0].first, points[0].second, points[1].first, points[1].second });
+        break;
+    }
+    geometry[id] = GeometryRecord{ kind, name, map_id, std::move(points), theta };
+    index.by_name.emplace(name, id);
+    index.entity_ids.push_back(id);
+    addAttribute(map->second.entity_id, "has", id);
+    addAttribute(id, "name", name);
+    makeInstanceOf(id, GEOMETRY_CONCEPTS[kind]);
+    return id;
+  }
+
+  const GeometryRecord* findGeometry(uint id, GeometryKind kind) const
+  {
+    auto record = geometry.find(id);
+    if (record == geometry.end() || record->second.kind != kind)
+    {
+      return nullptr;
+    }
+    return &record->second;
+  }
+
+  const GeometryRecord* findGeometry(uint map_id, GeometryKind kind, const string& name) const
+  {
+    auto map = maps.find(map_id);
+    if (map == maps.end())
+    {
+      return nullptr;
+    }
+    const auto& by_name = map->second.geometry[kind].by_name;
+    auto id = by_name.find(name);
+    if (id == by_name.end())
+    {
+      return nullptr;
+    }
+    return &geometry.at(id->second);
+  }
+
+  /// Entity IDs of a map's geometry of one kind, in the order it was added
+  vector<uint> mapGeometry(uint map_id, GeometryKind kind) const
+  {
+    auto map = maps.find(map_id);
+    if (map == maps.end())
+    {
+      return {};
+    }
+    return map->second.geometry[kind].entity_ids;
+  }
+};
+
+LongTermMemoryConduitInMemory::UndoLog::UndoLog(const State& state)
+  : next_entity_id(state.next_entity_id), next_map_id(state.next_map_id)
+{
+}
+
+void LongTermMemoryConduitInMemory::UndoLog::restore(State& state) const
+{
+  if (snapshot)
+  {
+    state = *snapshot;
+  }
+  entities.restore(state.entities);
+  attribute_types.restore(state.attribute_types);
+  concept_ids.restore(state.concept_ids);
+  concept_names.restore(state.concept_names);
+  instances.restore(state.instances);
+  referrers.restore(state.referrers);
+  named.restore(state.named);
+  maps.restore(state.maps);
+  map_ids_by_name.restore(state.map_ids_by_name);
+  map_ids_by_entity.restore(state.map_ids_by_entity);
+  geometry.restore(state.geometry);
+  state.next_entity_id = next_entity_id;
+  state.next_map_id = next_map_id;
+  if (hierarchy_changed)
+  {
+    vector<std::pair<uint, uint>> is_a;
+    for (const auto& entity : state.entities)
+    {
+      for (const auto& attribute : entity.second.attributes)
+      {
+        if (attribute.name == "is_a" && attribute.value.which() == Id)
+        {
+          is_a.emplace_back(entity.first, attribute.value.get<uint>());
+        }
+      }
+    }
+    state.hierarchy.reset(is_a);
+  }
+}
+
+void LongTermMemoryConduitInMemory::UndoLog::mergeInto(UndoLog& enclosing)
+{
+  // Restoring the enclosing batch's own snapshot undoes everything that came after it
+  if (enclosing.snapshot)
+  {
+    return;
+  }
+  entities.mergeInto(enclosing.entities);
+  attribute_types.mergeInto(enclosing.attribute_types);
+  concept_ids.mergeInto(enclosing.concept_ids);
+  concept_names.mergeInto(enclosing.concept_names);
+  instances.mergeInto(enclosing.instances);
+  referrers.mergeInto(enclosing.referrers);
+  named.mergeInto(enclosing.named);
+  maps.mergeInto(enclosing.maps);
+  map_ids_by_name.mergeInto(enclosing.map_ids_by_name);
+  map_ids_by_entity.mergeInto(enclosing.map_ids_by_entity);
+  geometry.mergeInto(enclosing.geometry);
+  enclosing.hierarchy_changed = enclosing.hierarchy_changed || hierarchy_changed;
+  enclosing.snapshot = std::move(snapshot);
+}
+
+struct LongTermMemoryConduitInMemory::Store
+{
+  std::recursive_mutex mutex;
+  /**
+   * Taken before the store's lock by every change, and held by write batches from when they open until they close, so
+   * that changes from other threads wait for the batches instead of failing
+   */
+  std::recursive_mutex write_mutex;
+  State state;
+  /// The undo logs of the open write batches, outermost first
+  vector<std::unique_ptr<UndoLog>> write_batches;
+  /// The thread the open write batches belong to
+  std::thread::id batch_thread;
+  /// The knowledgebase without the open batches' changes, for other threads to read. Made when one first needs it.
+  std::unique_ptr<State> committed;
+};
+
+namespace
+{
+/// Knowledgebases by name, so that conduits opened on the same name share one
+std::mutex stores_mutex;
+std::unordered_map<string, std::weak_ptr<void>> stores;
+}  // namespace
+
+// The hostname and connection limit only exist to match the other backends' constructors
+LongTermMemoryConduitInMemory::LongTermMemoryConduitInMemory(const string& db_name, const string& /* hostname */,
+                                                             size_t /* max_connections */)
+{
+  std::lock_guard<std::mutex> lock(stores_mutex);
+  store = std::static_pointer_cast<Store>(stores[db_name].lock());
+  if (!store)
+  {
+    store = std::make_shared<Store>();
+    store->state.addDefaultAttributes();
+    store->state.addDefaultEntities();
+    stores[db_name] = store;
+  }
+}
+
+LongTermMemoryConduitInMemory::LongTermMemoryConduitInMemory(LongTermMemoryConduitInMemory&& that) noexcept = default;
+
+LongTermMemoryConduitInMemory::~LongTermMemoryConduitInMemory()
+{
+  if (store)
+  {
+    // Batches that are still open are discarded, which releases the lock they hold
+    while (open_write_batches > 0)
+    {
+      abortWriteBatch();
+    }
+  }
+}
+
+LongTermMemoryConduitInMemory&
+LongTermMemoryConduitInMemory::operator=(LongTermMemoryConduitInMemory&& that) noexcept = default;
+
+LongTermMemoryConduitInMemory::State& LongTermMemoryConduitInMemory::current() const
+{
+  if (store->write_batches.empty() || store->batch_thread == std::this_thread::get_id())
+  {
+    return store->state;
+  }
+  if (!store->committed)
+  {
+    store->committed.reset(new State(store->state));
+    // Older changes are undone last, so that the oldest saved entries win
+    for (auto undo = store->write_batches.rbegin(); undo != store->write_batches.rend(); ++undo)
+    {
+      (*undo)->restore(*store->committed);
+    }
+    store->committed->undo = nullptr;
+  }
+  return *store->committed;
+}
+
+bool LongTermMemoryConduitInMemory::beginWriteBatch()
+{
+  store->write_mutex.lock();
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  store->write_batches.emplace_back(new UndoLog(store->state));
+  store->state.undo = store->write_batches.back().get();
+  store->batch_thread = std::this_thread::get_id();
+  open_write_batches++;
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::commitWriteBatch()
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  assert(open_write_batches > 0 && !store->write_batches.empty());
+  std::unique_ptr<UndoLog> undo = std::move(store->write_batches.back());
+  store->write_batches.pop_back();
+  if (!store->write_batches.empty())
+  {
+    undo->mergeInto(*store->write_batches.back());
+  }
+  closeWriteBatch();
+  return true;
+}
+
+void LongTermMemoryConduitInMemory::abortWriteBatch()
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  assert(open_write_batches > 0 && !store->write_batches.empty());
+  std::unique_ptr<UndoLog> undo = std::move(store->write_batches.back());
+  store->write_batches.pop_back();
+  undo->restore(store->state);
+  closeWriteBatch();
+}
+
+void LongTermMemoryConduitInMemory::closeWriteBatch()
+{
+  if (store->write_batches.empty())
+  {
+    store->state.undo = nullptr;
+    store->batch_thread = std::thread::id();
+    store->committed.reset();
+  }
+  else
+  {
+    store->state.undo = store->write_batches.back().get();
+  }
+  open_write_batches--;
+  store->write_mutex.unlock();
+}
+
+bool LongTermMemoryConduitInMemory::addEntity(uint id)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().addEntity(id);
+}
+
+/**
+ * @brief Add a new attribute
+ * @param name the name of the attribute
+ * @param type the type of data for the attribute's values
+ * @return whether the attribute was added. Note that addition will fail if the attribute already exists.
+ */
+bool LongTermMemoryConduitInMemory::addNewAttribute(const string& name, const AttributeValueType type)
+{
+  // Names are held to the schemas' varchar(24) limit on every backend
+  if (!fitsAttributeString(name))
+  {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  State& state = current();
+  if (state.attribute_types.count(name) == 1)
+  {
+    return false;
+  }
+  state.save(&UndoLog::attribute_types, state.attribute_types, name);
+  state.attribute_types.emplace(name, type);
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::entityExists(uint id) const
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().entityExists(id);
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                              const uint other_entity_id)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(other_entity_id));
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                              const bool bool_val)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(bool_val));
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                              const int int_val)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(int_val));
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                              const double float_val)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(float_val));
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                              const char* string_val)
+{
+  return this->getEntitiesWithAttributeOfValue(attribute_name, std::string(string_val));
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                              const string& string_val)
+{
+  if (!fitsAttributeString(string_val))
+  {
+    return {};
+  }
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(string_val));
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getEntitiesWithAttributeValue(const string& attribute_name,
+                                                                            const AttributeValue& value)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const State& state = current();
+  vector<Entity> return_result;
+  // Values are stored as their attribute's type, so look for the value as that type
+  auto type = state.attribute_types.find(attribute_name);
+  if (type == state.attribute_types.end())
+  {
+    return return_result;
+  }
+  auto wanted = convertAttributeValue(value, type->second);
+  if (!wanted)
+  {
+    return return_result;
+  }
+  if (type->second == Id)
+  {
+    auto references = state.referrers.find(wanted->get<uint>());
+    if (references != state.referrers.end())
+    {
+      for (const auto& reference : references->second)
+      {
+        if (reference.attribute_name == attribute_name)
+        {
+          return_result.emplace_back(reference.entity_id, *this);
+        }
+      }
+    }
+    return return_result;
+  }
+  if (attribute_name == "name" && type->second == Str)
+  {
+    // Names are indexed, since they're how most things are looked up
+    auto entities_named = state.named.find(wanted->get<string>());
+    if (entities_named != state.named.end())
+    {
+      for (uint id : entities_named->second)
+      {
+        return_result.emplace_back(id, *this);
+      }
+    }
+    return return_result;
+  }
+  vector<uint> ids;
+  for (const auto& entity : state.entities)
+  {
+    for (const auto& attribute : entity.second.attributes)
+    {
+      if (attribute.name == attribute_name && sameValue(attribute.value, *wanted))
+      {
+        ids.push_back(entity.first);
+        break;
+      }
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  for (uint id : ids)
+  {
+    return_result.emplace_back(id, *this);
+  }
+  return return_result;
+}
+
+vector<Entity> LongTermMemoryConduitInMemory::getAllEntities()
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<uint> ids;
+  ids.reserve(current().entities.size());
+  for (const auto& entity : current().entities)
+  {
+    ids.push_back(entity.first);
+  }
+  std::sort(ids.begin(), ids.end());
+  vector<Entity> entities;
+  for (uint id : ids)
+  {
+    entities.emplace_back(id, *this);
+  }
+  return entities;
+}
+
+vector<Map> LongTermMemoryConduitInMemory::getAllMaps()
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<uint> map_ids;
+  for (const auto& map : current().maps)
+  {
+    map_ids.push_back(map.first);
+  }
+  std::sort(map_ids.begin(), map_ids.end());
+  vector<Map> maps;
+  for (uint map_id : map_ids)
+  {
+    const auto& map = current().maps.at(map_id);
+    maps.emplace_back(map.entity_id, map_id, map.name, *this);
+  }
+  return maps;
+}
+
+uint LongTermMemoryConduitInMemory::deleteAllAttributes()
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().deleteAllAttributes();
+}
+
+uint LongTermMemoryConduitInMemory::deleteAllEntities()
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().deleteAllEntities();
+}
+
+bool LongTermMemoryConduitInMemory::deleteAttribute(const string& name)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().deleteAttribute(name);
+}
+
+bool LongTermMemoryConduitInMemory::attributeExists(const string& name) const
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().attribute_types.count(name) == 1;
+}
+
+Concept LongTermMemoryConduitInMemory::getConcept(const string& name)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  State& state = current();
+  auto id = state.concept_ids.find(name);
+  if (id != state.concept_ids.end())
+  {
+    return { id->second, name, *this };
+  }
+  uint new_id = state.addEntity();
+  state.makeConcept(new_id, name);
+  return { new_id, name, *this };
+}
+
+boost::optional<Instance> LongTermMemoryConduitInMemory::getInstanceNamed(const Concept& concept, const string& name)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const State& state = current();
+  auto entities_named = state.named.find(name);
+  auto members = state.instances.find(concept.getName());
+  if (entities_named == state.named.end() || members == state.instances.end())
+  {
+    return {};
+  }
+  for (uint id : entities_named->second)
+  {
+    if (members->second.count(id) == 1)
+    {
+      return Instance{ id, *this };
+    }
+  }
+  return {};
+}
+
+boost::optional<Entity> LongTermMemoryConduitInMemory::getEntity(uint entity_id)
+{
+  if (entityExists(entity_id))
+  {
+    return Entity{ entity_id, *this };
+  }
+  return {};
+}
+
+boost::optional<Instance> LongTermMemoryConduitInMemory::getInstance(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  auto entity = current().entities.find(entity_id);
+  if (entity != current().entities.end() && !entity->second.concepts.empty())
+  {
+    return Instance{ entity_id, *this };
+  }
+  return {};
+}
+
+boost::optional<Concept> LongTermMemoryConduitInMemory::getConcept(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  auto name = current().concept_names.find(entity_id);
+  if (name != current().concept_names.end())
+  {
+    return Concept{ entity_id, name->second, *this };
+  }
+  return {};
+}
+
+boost::optional<Map> LongTermMemoryConduitInMemory::getMap(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  auto map_id = current().map_ids_by_entity.find(entity_id);
+  if (map_id != current().map_ids_by_entity.end())
+  {
+    return Map{ entity_id, map_id->second, current().maps.at(map_id->second).name, *this };
+  }
+  return {};
+}
+
+boost::optional<Point> LongTermMemoryConduitInMemory::getPoint(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* point = current().findGeometry(entity_id, PointGeometry);
+  if (point)
+  {
+    auto parent_map = *getMapForMapId(point->map_id);
+    return Point(entity_id, point->name, point->points[0].first, point->points[0].second, parent_map, *this);
+  }
+  return {};
+}
+
+boost::optional<Pose> LongTermMemoryConduitInMemory::getPose(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* pose = current().findGeometry(entity_id, PoseGeometry);
+  if (pose)
+  {
+    auto parent_map = *getMapForMapId(pose->map_id);
+    return Pose(entity_id, pose->name, pose->points[0].first, pose->points[0].second, pose->theta, parent_map, *this);
+  }
+  return {};
+}
+
+boost::optional<Region> LongTermMemoryConduitInMemory::getRegion(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* region = current().findGeometry(entity_id, RegionGeometry);
+  if (region)
+  {
+    auto parent_map = *getMapForMapId(region->map_id);
+    return Region{ entity_id, region->name, region->points, parent_map, *this };
+  }
+  return {};
+}
+
+boost::optional<Door> LongTermMemoryConduitInMemory::getDoor(uint entity_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* door = current().findGeometry(entity_id, DoorGeometry);
+  if (door)
+  {
+    auto parent_map = *getMapForMapId(door->map_id);
+    return Door{ entity_id,
+                 door->name,
+                 door->points[0].first,
+                 door->points[0].second,
+                 door->points[1].first,
+                 door->points[1].second,
+                 parent_map,
+                 *this };
+  }
+  return {};
+}
+
+Instance LongTermMemoryConduitInMemory::getRobot()
+{
+  Instance robot = Instance(1, *this);
+  assert(robot.isValid());
+  return robot;
+}
+
+Entity LongTermMemoryConduitInMemory::addEntity()
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return { current().addEntity(), *this };
+}
+
+std::vector<Concept> LongTermMemoryConduitInMemory::getAllConcepts()
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<std::pair<uint, string>> sorted(current().concept_names.begin(), current().concept_names.end());
+  std::sort(sorted.begin(), sorted.end());
+  vector<Concept> concepts;
+  for (const auto& concept : sorted)
+  {
+    concepts.emplace_back(concept.first, concept.second, *this);
+  }
+  return concepts;
+}
+
+std::vector<Instance> LongTermMemoryConduitInMemory::getAllInstances()
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<uint> ids;
+  for (const auto& entity : current().entities)
+  {
+    if (current().concept_names.count(entity.first) == 0)
+    {
+      ids.push_back(entity.first);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  vector<Instance> instances;
+  for (uint id : ids)
+  {
+    instances.emplace_back(id, *this);
+  }
+  return instances;
+}
+
+/**
+ * @brief Hands elements to a callback in batches of bounded size
+ *
+ * No lock is held while the callback runs, so it's free to use the LTMC.
+ * @param keys identify the elements, in the order they're delivered
+ * @param make builds the element for a key
+ */
+template <typename T, typename Key, typename Make>
+void batchKeys(const vector<Key>& keys, size_t batch_size, const std::function<void(vector<T>&)>& callback, Make make)
+{
+  assert(batch_size > 0);
+  vector<T> batch;
+  batch.reserve(std::min(batch_size, keys.size()));
+  for (const auto& key : keys)
+  {
+    batch.push_back(make(key));
+    if (batch.size() == batch_size)
+    {
+      callback(batch);
+      batch.clear();
+    }
+  }
+  if (!batch.empty())
+  {
+    callback(batch);
+  }
+}
+
+bool LongTermMemoryConduitInMemory::forEachEntityBatch(const std::function<void(vector<Entity>&)>& callback,
+                                                       size_t batch_size)
+{
+  vector<uint> ids;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    ids.reserve(current().entities.size());
+    for (const auto& entity : current().entities)
+    {
+      ids.push_back(entity.first);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  batchKeys(ids, batch_size, callback, [this](uint id) { return Entity(id, *this); });
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::forEachConceptBatch(const std::function<void(vector<Concept>&)>& callback,
+                                                        size_t batch_size)
+{
+  vector<std::pair<uint, string>> sorted;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    sorted.assign(current().concept_names.begin(), current().concept_names.end());
+  }
+  std::sort(sorted.begin(), sorted.end());
+  batchKeys(sorted, batch_size, callback,
+            [this](const std::pair<uint, string>& concept) { return Concept(concept.first, concept.second, *this); });
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::forEachInstanceBatch(const std::function<void(vector<Instance>&)>& callback,
+                                                         size_t batch_size)
+{
+  vector<uint> ids;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    for (const auto& entity : current().entities)
+    {
+      if (current().concept_names.count(entity.first) == 0)
+      {
+        ids.push_back(entity.first);
+      }
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  batchKeys(ids, batch_size, callback, [this](uint id) { return Instance(id, *this); });
+  return true;
+}
+
+/**
+ * @brief Keeps the first keys in order, as a page that starts where the keys do
+ *
+ * Entities aren't kept in order, so each page is picked out of every key after the last page's, in linear time.
+ */
+template <typename Key>
+void firstKeys(vector<Key>& keys, size_t limit)
+{
+  assert(limit > 0);
+  if (keys.size() > limit)
+  {
+    std::nth_element(keys.begin(), keys.begin() + limit, keys.end());
+    keys.resize(limit);
+  }
+  std::sort(keys.begin(), keys.end());
+}
+
+bool LongTermMemoryConduitInMemory::getEntityPage(uint after_id, size_t limit, vector<Entity>& page)
+{
+  vector<uint> ids;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    for (const auto& entity : current().entities)
+    {
+      if (entity.first > after_id)
+      {
+        ids.push_back(entity.first);
+      }
+    }
+  }
+  firstKeys(ids, limit);
+  page.clear();
+  for (uint id : ids)
+  {
+    page.emplace_back(id, *this);
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::getConceptPage(uint after_id, size_t limit, vector<Concept>& page)
+{
+  vector<std::pair<uint, string>> concepts;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    for (const auto& concept : current().concept_names)
+    {
+      if (concept.first > after_id)
+      {
+        concepts.push_back(concept);
+      }
+    }
+  }
+  firstKeys(concepts, limit);
+  page.clear();
+  for (const auto& concept : concepts)
+  {
+    page.emplace_back(concept.first, concept.second, *this);
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::getInstancePage(uint after_id, size_t limit, vector<Instance>& page)
+{
+  vector<uint> ids;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    for (const auto& entity : current().entities)
+    {
+      if (entity.first > after_id && current().concept_names.count(entity.first) == 0)
+      {
+        ids.push_back(entity.first);
+      }
+    }
+  }
+  firstKeys(ids, limit);
+  page.clear();
+  for (uint id : ids)
+  {
+    page.emplace_back(id, *this);
+  }
+  return true;
+}
+
+vector<std::pair<string, AttributeValueType>> LongTermMemoryConduitInMemory::getAllAttributes() const
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<std::pair<string, AttributeValueType>> attribute_names(current().attribute_types.begin(),
+                                                                current().attribute_types.end());
+  std::sort(attribute_names.begin(), attribute_names.end());
+  return attribute_names;
+}
+
+// MAP
+Map LongTermMemoryConduitInMemory::getMap(const std::string& name)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  auto map_id = current().map_ids_by_name.find(name);
+  if (map_id != current().map_ids_by_name.end())
+  {
+    return { current().maps.at(map_id->second).entity_id, map_id->second, name, *this };
+  }
+  Concept map_concept = getConcept("map");
+  // This should succeed because we would've retrieved it above if such an instance existed
+  Instance new_map = map_concept.createInstance(name).get();
+  uint new_map_id = current().addMap(new_map.entity_id, name);
+  return { new_map.entity_id, new_map_id, name, *this };
+}
+
+vector<EntityAttribute> LongTermMemoryConduitInMemory::getAllEntityAttributes()
+{
+  std::vector<EntityAttribute> entity_attrs;
+  forEachEntityAttributeBatch([&entity_attrs](vector<EntityAttribute>& batch) {
+    entity_attrs.insert(entity_attrs.end(), std::make_move_iterator(batch.begin()),
+                        std::make_move_iterator(batch.end()));
+  });
+  return entity_attrs;
+}
+
+bool LongTermMemoryConduitInMemory::getAllEntityAttributes(AttributeBatch& attributes) const
+{
+  attributes.clear();
+  return scanEntityAttributes<AttributeBatch>([&attributes](AttributeBatch& batch) { attributes.append(batch); },
+                                              10000);
+}
+
+bool LongTermMemoryConduitInMemory::forEachEntityAttributeBatch(
+    const std::function<void(std::vector<EntityAttribute>&)>& callback, size_t batch_size) const
+{
+  return scanEntityAttributes(callback, batch_size);
+}
+
+bool LongTermMemoryConduitInMemory::forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                                                size_t batch_size) const
+{
+  return scanEntityAttributes(callback, batch_size);
+}
+
+template <typename Attributes>
+bool LongTermMemoryConduitInMemory::scanEntityAttributes(const std::function<void(Attributes&)>& callback,
+                                                         size_t batch_size) const
+{
+  assert(batch_size > 0);
+  vector<uint> ids;
+  {
+    std::lock_guard<std::recursive_mutex> lock(store->mutex);
+    for (const auto& entity : current().entities)
+    {
+      ids.push_back(entity.first);
+    }
+  }
+  std::sort(ids.begin(), ids.end());
+  // The lock is only held while filling a batch, so the callback is free to use the LTMC
+  Attributes batch;
+  size_t next_attribute = 0;
+  auto id = ids.begin();
+  while (id != ids.end())
+  {
+    batch.clear();
+    {
+      std::lock_guard<std::recursive_mutex> lock(store->mutex);
+      const State& state = current();
+      while (id != ids.end() && batch.size() < batch_size)
+      {
+        auto entity = state.entities.find(*id);
+        const size_t num_attributes = entity == state.entities.end() ? 0 : entity->second.attributes.size();
+        while (next_attribute < num_attributes && batch.size() < batch_size)
+        {
+          const auto& attribute = entity->second.attributes[next_attribute++];
+          batch.emplace_back(*id, attribute.name, exposedValue(attribute.value));
+        }
+        if (next_attribute >= num_attributes)
+        {
+          next_attribute = 0;
+          ++id;
+        }
+      }
+    }
+    if (!batch.empty())
+    {
+      callback(batch);
+    }
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  State& state = current();
+
+  // Check every attribute before changing anything, so that a bad one leaves the knowledgebase untouched
+  vector<AttributeValue> values;
+  values.reserve(knowledge.attributes.size());
+  try
+  {
+    for (const auto& attribute : knowledge.attributes)
+    {
+      auto type = state.attribute_types.find(attribute.attribute_name);
+      if (type == state.attribute_types.end())
+      {
+        throw std::invalid_argument("No attribute named \"" + attribute.attribute_name + "\"");
+      }
+      // Entity IDs aren't known yet, so check that entity references are allowed with a placeholder
+      values.push_back(convertValue(attribute.value_entity ? AttributeValue(0u) : attribute.value, type->second));
+    }
+    bool names_instances = !knowledge.instances.empty() || !knowledge.instance_of.empty();
+    for (const auto& attribute : knowledge.attributes)
+    {
+      names_instances |=
+          !attribute.entity.isConcept() || (attribute.value_entity && !attribute.value_entity->isConcept());
+    }
+    if (names_instances && state.attribute_types.count("name") == 0)
+    {
+      throw std::invalid_argument("Instances can't be named without the name attribute");
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+
+  std::unordered_map<string, uint> instance_ids;
+  for (const auto& members : state.instances)
+  {
+    for (uint id : members.second)
+    {
+      for (const auto& attribute : state.entities.at(id).attributes)
+      {
+        if (attribute.name == "name" && attribute.value.which() == Str)
+        {
+          instance_ids.emplace(instanceKey(attribute.value.get<string>(), members.first), id);
+        }
+      }
+    }
+  }
+  auto resolve_concept = [&](const string& name) {
+    auto id = state.concept_ids.find(name);
+    if (id != state.concept_ids.end())
+    {
+      return id->second;
+    }
+    uint new_id = state.addEntity();
+    state.makeConcept(new_id, name);
+    return new_id;
+  };
+  auto resolve = [&](const BulkEntityRef& ref) {
+    if (ref.isConcept())
+    {
+      return resolve_concept(ref.name);
+    }
+    auto key = instanceKey(ref.name, ref.concept_name);
+    auto id = instance_ids.find(key);
+    if (id != instance_ids.end())
+    {
+      return id->second;
+    }
+    resolve_concept(ref.concept_name);
+    uint new_id = state.addEntity();
+    state.makeInstanceOf(new_id, ref.concept_name);
+    state.addAttribute(new_id, "name", ref.name);
+    instance_ids.emplace(key, new_id);
+    return new_id;
+  };
+
+  result.concept_ids.clear();
+  result.instance_ids.clear();
+  for (const auto& name : knowledge.concepts)
+  {
+    result.concept_ids.push_back(resolve_concept(name));
+  }
+  for (const auto& instance : knowledge.instances)
+  {
+    result.instance_ids.push_back(resolve(instance));
+  }
+  for (const auto& instance_of : knowledge.instance_of)
+  {
+    uint id = resolve(instance_of.first);
+    resolve_concept(instance_of.second);
+    state.makeInstanceOf(id, instance_of.second);
+  }
+  for (size_t i = 0; i < knowledge.attributes.size(); i++)
+  {
+    const auto& attribute = knowledge.attributes[i];
+    uint id = resolve(attribute.entity);
+    AttributeValue value = values[i];
+    if (attribute.value_entity)
+    {
+      value = convertValue(resolve(*attribute.value_entity), state.attribute_types.at(attribute.attribute_name));
+    }
+    // Attributes that are already set are left alone
+    state.addAttribute(id, attribute.attribute_name, std::move(value));
+  }
+  return true;
+}
+
+vector<vector<Concept>> LongTermMemoryConduitInMemory::getConceptsRecursive(const vector<Instance>& instances)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const State& state = current();
+  vector<vector<Concept>> concepts;
+  concepts.reserve(instances.size());
+  for (const auto& instance : instances)
+  {
+    concepts.emplace_back();
+    for (uint id : state.conceptsRecursive(instance.entity_id))
+    {
+      concepts.back().emplace_back(id, state.concept_names.at(id), *this);
+    }
+  }
+  return concepts;
+}
+
+vector<Instance> LongTermMemoryConduitInMemory::filterInstancesOf(const vector<Instance>& instances,
+                                                                  const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const State& state = current();
+  vector<Instance> filtered;
+  for (const auto& instance : instances)
+  {
+    if (state.instanceOf(instance.entity_id, concept.entity_id))
+    {
+      filtered.push_back(instance);
+    }
+  }
+  return filtered;
+}
+
+bool LongTermMemoryConduitInMemory::makeConcept(uint id, std::string name)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().makeConcept(id, name);
+}
+
+// ENTITY BACKERS
+
+bool LongTermMemoryConduitInMemory::deleteEntity(Entity& entity)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().deleteEntity(entity.entity_id);
+}
+
+bool LongTermMemoryConduitInMemory::addAttribute(Entity& entity, const std::string& attribute_name,
+                                                 const uint other_entity_id)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().addAttribute(entity.entity_id, attribute_name, other_entity_id);
+}
+
+bool LongTermMemoryConduitInMemory::addAttribute(Entity& entity, const std::string& attribute_name,
+                                                 const bool bool_val)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().addAttribute(entity.entity_id, attribute_name, bool_val);
+}
+
+bool LongTermMemoryConduitInMemory::addAttribute(Entity& entity, const std::string& attribute_name, const int int_val)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().addAttribute(entity.entity_id, attribute_name, int_val);
+}
+
+bool LongTermMemoryConduitInMemory::addAttribute(Entity& entity, const std::string& attribute_name,
+                                                 const double float_val)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().addAttribute(entity.entity_id, attribute_name, float_val);
+}
+
+bool LongTermMemoryConduitInMemory::addAttribute(Entity& entity, const std::string& attribute_name,
+                                                 const std::string& string_val)
+{
+  if (!fitsAttributeString(string_val))
+  {
+    return false;
+  }
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().addAttribute(entity.entity_id, attribute_name, string_val);
+}
+
+int LongTermMemoryConduitInMemory::removeAttribute(Entity& entity, const std::string& attribute_name)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().removeAttributes(entity.entity_id, [&attribute_name](const StoredAttribute& attribute) {
+    return attribute.name == attribute_name;
+  });
+}
+
+int LongTermMemoryConduitInMemory::removeAttributeOfValue(Entity& entity, const std::string& attribute_name,
+                                                          const Entity& other_entity)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const AttributeValue other_id = other_entity.entity_id;
+  return current().removeAttributes(entity.entity_id, [&](const StoredAttribute& attribute) {
+    return attribute.name == attribute_name && sameValue(attribute.value, other_id);
+  });
+}
+
+vector<EntityAttribute> LongTermMemoryConduitInMemory::getAttributes(const Entity& entity) const
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<EntityAttribute> attributes;
+  auto record = current().entities.find(entity.entity_id);
+  if (record != current().entities.end())
+  {
+    for (const auto& attribute : record->second.attributes)
+    {
+      attributes.emplace_back(entity.entity_id, attribute.name, exposedValue(attribute.value));
+    }
+  }
+  return attributes;
+}
+
+std::vector<EntityAttribute> LongTermMemoryConduitInMemory::getAttributes(const Entity& entity,
+                                                                          const std::string& attribute_name) const
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<EntityAttribute> attributes;
+  auto record = current().entities.find(entity.entity_id);
+  if (record != current().entities.end())
+  {
+    for (const auto& attribute : record->second.attributes)
+    {
+      if (attribute.name == attribute_name)
+      {
+        attributes.emplace_back(entity.entity_id, attribute.name, exposedValue(attribute.value));
+      }
+    }
+  }
+  return attributes;
+}
+
+bool LongTermMemoryConduitInMemory::getAttributes(const vector<Entity>& entities, AttributeBatch& attributes) const
+{
+  // Each entity's attributes come back once, however many times it's listed, as they do from the SQL backends
+  vector<uint> ids;
+  ids.reserve(entities.size());
+  for (const auto& entity : entities)
+  {
+    ids.push_back(entity.entity_id);
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  for (uint id : ids)
+  {
+    auto record = current().entities.find(id);
+    if (record != current().entities.end())
+    {
+      for (const auto& attribute : record->second.attributes)
+      {
+        attributes.emplace_back(id, attribute.name, exposedValue(attribute.value));
+      }
+    }
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::isValid(const Entity& entity) const
+{
+  return entityExists(entity.entity_id);
+}
+
+// INSTANCE BACKERS
+
+std::vector<Concept> LongTermMemoryConduitInMemory::getConcepts(const Instance& instance)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  std::vector<Concept> concepts{};
+  auto record = current().entities.find(instance.entity_id);
+  if (record != current().entities.end())
+  {
+    for (const auto& name : record->second.concepts)
+    {
+      concepts.emplace_back(current().concept_ids.at(name), name, *this);
+    }
+  }
+  return concepts;
+}
+
+std::vector<Concept> LongTermMemoryConduitInMemory::getConceptsRecursive(const Instance& instance)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const State& state = current();
+  std::vector<Concept> concepts{};
+  for (uint id : state.conceptsRecursive(instance.entity_id))
+  {
+    concepts.emplace_back(id, state.concept_names.at(id), *this);
+  }
+  return concepts;
+}
+
+bool LongTermMemoryConduitInMemory::makeInstanceOf(Instance& instance, const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().makeInstanceOf(instance.entity_id, concept.getName());
+}
+
+bool LongTermMemoryConduitInMemory::hasConceptRecursively(const Instance& instance, const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  return current().instanceOf(instance.entity_id, concept.entity_id);
+}
+
+// CONCEPT BACKERS
+
+vector<Concept> LongTermMemoryConduitInMemory::getChildren(const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  std::vector<Concept> concepts{};
+  for (uint id : current().children(concept.entity_id))
+  {
+    concepts.emplace_back(id, current().concept_names.at(id), *this);
+  }
+  return concepts;
+}
+
+vector<Concept> LongTermMemoryConduitInMemory::getChildrenRecursive(const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  std::vector<Concept> concepts{};
+  for (uint id : current().descendants(concept.entity_id))
+  {
+    concepts.emplace_back(id, current().concept_names.at(id), *this);
+  }
+  return concepts;
+}
+
+std::vector<Instance> LongTermMemoryConduitInMemory::getInstances(const ConceptImpl& concept)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  std::vector<Instance> instances{};
+  auto members = current().instances.find(concept.getName());
+  if (members != current().instances.end())
+  {
+    for (uint id : members->second)
+    {
+      instances.emplace_back(id, *this);
+    }
+  }
+  return instances;
+}
+
+int LongTermMemoryConduitInMemory::removeInstances(const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  State& state = current();
+  auto members = state.instances.find(concept.getName());
+  if (members == state.instances.end())
+  {
+    return 0;
+  }
+  const vector<uint> ids(members->second.begin(), members->second.end());
+  int num_deleted = 0;
+  for (uint id : ids)
+  {
+    num_deleted += state.deleteEntity(id);
+  }
+  return num_deleted;
+}
+
+int LongTermMemoryConduitInMemory::removeInstancesRecursive(const Concept& concept)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  State& state = current();
+  std::set<uint> ids;
+  for (uint concept_id : state.descendants(concept.entity_id))
+  {
+    auto members = state.instances.find(state.concept_names.at(concept_id));
+    if (members != state.instances.end())
+    {
+      ids.insert(members->second.begin(), members->second.end());
+    }
+  }
+  int num_deleted = 0;
+  for (uint id : ids)
+  {
+    num_deleted += state.deleteEntity(id);
+  }
+  return num_deleted;
+}
+
+// MAP BACKERS
+Point LongTermMemoryConduitInMemory::addPoint(Map& map, const std::string& name, double x, double y)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  uint id = current().addGeometry(map.getId(), PointGeometry, name, { { x, y } });
+  return { id, name, x, y, map, *this };
+}
+
+Pose LongTermMemoryConduitInMemory::addPose(Map& map, const string& name, double x, double y, double theta)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  // Normalize the angle the same way storing the pose as a line segment does
+  theta = std::atan2(std::sin(theta), std::cos(theta));
+  uint id = current().addGeometry(map.getId(), PoseGeometry, name, { { x, y } }, theta);
+  return { id, name, x, y, theta, map, *this };
+}
+
+Region LongTermMemoryConduitInMemory::addRegion(Map& map, const string& name, const vector<Region::Point2D>& points)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  if (points.empty())
+  {
+    throw std::invalid_argument("A region needs at least one point");
+  }
+  uint id = current().addGeometry(map.getId(), RegionGeometry, name, points);
+  return { id, name, points, map, *this };
+}
+
+Door LongTermMemoryConduitInMemory::addDoor(Map& map, const string& name, double x_0, double y_0, double x_1,
+                                            double y_1)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  uint id = current().addGeometry(map.getId(), DoorGeometry, name, { { x_0, y_0 }, { x_1, y_1 } });
+  return { id, name, x_0, y_0, x_1, y_1, map, *this };
+}
+
+boost::optional<Point> LongTermMemoryConduitInMemory::getPoint(Map& map, const string& name)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* point = current().findGeometry(map.getId(), PointGeometry, name);
+  if (point)
+  {
+    uint id = current().maps.at(map.getId()).geometry[PointGeometry].by_name.at(name);
+    return Point{ id, name, point->points[0].first, point->points[0].second, map, *this };
+  }
+  return {};
+}
+
+boost::optional<Pose> LongTermMemoryConduitInMemory::getPose(Map& map, const string& name)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* pose = current().findGeometry(map.getId(), PoseGeometry, name);
+  if (pose)
+  {
+    uint id = current().maps.at(map.getId()).geometry[PoseGeometry].by_name.at(name);
+    return Pose{ id, name, pose->points[0].first, pose->points[0].second, pose->theta, map, *this };
+  }
+  return {};
+}
+
+boost::optional<Region> LongTermMemoryConduitInMemory::getRegion(Map& map, const string& name)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* region = current().findGeometry(map.getId(), RegionGeometry, name);
+  if (region)
+  {
+    uint id = current().maps.at(map.getId()).geometry[RegionGeometry].by_name.at(name);
+    return Region{ id, name, region->points, map, *this };
+  }
+  return {};
+}
+
+boost::optional<Door> LongTermMemoryConduitInMemory::getDoor(Map& map, const string& name)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  const auto* door = current().findGeometry(map.getId(), DoorGeometry, name);
+  if (door)
+  {
+    uint id = current().maps.at(map.getId()).geometry[DoorGeometry].by_name.at(name);
+    return Door{ id,
+                 name,
+                 door->points[0].first,
+                 door->points[0].second,
+                 door->points[1].first,
+                 door->points[1].second,
+                 map,
+                 *this };
+  }
+  return {};
+}
+
+vector<Point> LongTermMemoryConduitInMemory::getAllPoints(Map& map)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Point> points;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (uint id : current().mapGeometry(map.getId(), PointGeometry))
+  {
+    const auto& point = current().geometry.at(id);
+    points.emplace_back(id, point.name, point.points[0].first, point.points[0].second, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitInMemory::getAllPoses(Map& map)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Pose> poses;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (uint id : current().mapGeometry(map.getId(), PoseGeometry))
+  {
+    const auto& pose = current().geometry.at(id);
+    poses.emplace_back(id, pose.name, pose.points[0].first, pose.points[0].second, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Region> LongTermMemoryConduitInMemory::getAllRegions(Map& map)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (uint id : current().mapGeometry(map.getId(), RegionGeometry))
+  {
+    const auto& region = current().geometry.at(id);
+    regions.emplace_back(id, region.name, region.points, parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Door> LongTermMemoryConduitInMemory::getAllDoors(Map& map)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (uint id : current().mapGeometry(map.getId(), DoorGeometry))
+  {
+    const auto& door = current().geometry.at(id);
+    doors.emplace_back(id, door.name, door.points[0].first, door.points[0].second, door.points[1].first,
+                       door.points[1].second, parent_map, *this);
+  }
+  return doors;
+}
+
+std::vector<Region> LongTermMemoryConduitInMemory::getContainingRegions(Map& map, double x, double y)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Region> regions;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return regions;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& region : record->second.spatial.containingRegions(x, y))
+  {
+    regions.emplace_back(region.entity_id, region.name, region.points, parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Point> LongTermMemoryConduitInMemory::getNearestPoints(Map& map, double x, double y, size_t k)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Point> points;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return points;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& point : record->second.spatial.nearestPoints(x, y, k))
+  {
+    points.emplace_back(point.entity_id, point.name, point.x, point.y, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitInMemory::getNearestPoses(Map& map, double x, double y, size_t k)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Pose> poses;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return poses;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& pose : record->second.spatial.nearestPoses(x, y, k))
+  {
+    poses.emplace_back(pose.entity_id, pose.name, pose.x, pose.y, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Door> LongTermMemoryConduitInMemory::getNearestDoors(Map& map, double x, double y, size_t k)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Door> doors;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return doors;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& door : record->second.spatial.nearestDoors(x, y, k))
+  {
+    doors.emplace_back(door.entity_id, door.name, door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return doors;
+}
+
+vector<Point> LongTermMemoryConduitInMemory::getPointsWithinRadius(Map& map, double x, double y, double radius)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Point> points;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return points;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& point : record->second.spatial.pointsWithinRadius(x, y, radius))
+  {
+    points.emplace_back(point.entity_id, point.name, point.x, point.y, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitInMemory::getPosesWithinRadius(Map& map, double x, double y, double radius)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Pose> poses;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return poses;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& pose : record->second.spatial.posesWithinRadius(x, y, radius))
+  {
+    poses.emplace_back(pose.entity_id, pose.name, pose.x, pose.y, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Door> LongTermMemoryConduitInMemory::getDoorsWithinRadius(Map& map, double x, double y, double radius)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Door> doors;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return doors;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& door : record->second.spatial.doorsWithinRadius(x, y, radius))
+  {
+    doors.emplace_back(door.entity_id, door.name, door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return doors;
+}
+
+vector<Region> LongTermMemoryConduitInMemory::getAdjacentRegions(Map& map, const Region& region)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Region> regions;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return regions;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& adjacent : record->second.spatial.adjacentRegions(region.entity_id))
+  {
+    regions.emplace_back(adjacent.entity_id, adjacent.name, adjacent.points, parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Region> LongTermMemoryConduitInMemory::getReachableRegions(Map& map, const Region& region)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Region> regions;
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return regions;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& reachable : record->second.spatial.reachableRegions(region.entity_id))
+  {
+    regions.emplace_back(reachable.entity_id, reachable.name, reachable.points, parent_map, *this);
+  }
+  return regions;
+}
+
+bool LongTermMemoryConduitInMemory::isRegionReachable(Map& map, const Region& from, const Region& to)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return false;
+  }
+  return record->second.spatial.isReachable(from.entity_id, to.entity_id);
+}
+
+bool LongTermMemoryConduitInMemory::getShortestPath(Map& map, const Region& from, const Region& to,
+                                                    vector<Region>& regions, vector<Door>& doors)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  regions.clear();
+  doors.clear();
+  auto record = current().maps.find(map.getId());
+  if (record == current().maps.end())
+  {
+    return false;
+  }
+  vector<MapSpatialIndex::RegionEntry> path_regions;
+  vector<MapSpatialIndex::DoorEntry> path_doors;
+  if (!record->second.spatial.shortestPath(from.entity_id, to.entity_id, path_regions, path_doors))
+  {
+    return false;
+  }
+  auto parent_map = std::make_shared<const Map>(map);
+  for (const auto& region : path_regions)
+  {
+    regions.emplace_back(region.entity_id, region.name, region.points, parent_map, *this);
+  }
+  for (const auto& door : path_doors)
+  {
+    doors.emplace_back(door.entity_id, door.name, door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitInMemory::renameMap(Map& map, const std::string& new_name)
+{
+  std::lock_guard<std::recursive_mutex> write_lock(store->write_mutex);
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  State& state = current();
+  auto map_id = state.map_ids_by_name.find(map.getName());
+  if (map_id == state.map_ids_by_name.end())
+  {
+    return false;
+  }
+  auto taken = state.map_ids_by_name.find(new_name);
+  if (taken != state.map_ids_by_name.end())
+  {
+    // Renaming a map to its current name is fine, but otherwise map names must be unique
+    return taken->second == map_id->second;
+  }
+  state.save(&UndoLog::map_ids_by_name, state.map_ids_by_name, map.getName());
+  state.save(&UndoLog::map_ids_by_name, state.map_ids_by_name, new_name);
+  state.save(&UndoLog::maps, state.maps, map_id->second);
+  auto& record = state.maps.at(map_id->second);
+  uint id = map_id->second;
+  state.map_ids_by_name.erase(map_id);
+  state.map_ids_by_name.emplace(new_name, id);
+  record.name = new_name;
+  state.removeAttributes(record.entity_id, [](const StoredAttribute& attribute) { return attribute.name == "name"; });
+  state.addAttribute(record.entity_id, "name", new_name);
+  return true;
+}
+
+// REGION BACKERS
+
+vector<Point> LongTermMemoryConduitInMemory::getContainedPoints(Region& region)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Point> points;
+  auto record = current().maps.find(region.parent_map->map_id);
+  if (record == current().maps.end())
+  {
+    return points;
+  }
+  for (const auto& point : record->second.spatial.containedPoints(region.entity_id))
+  {
+    points.emplace_back(point.entity_id, point.name, point.x, point.y, region.parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitInMemory::getContainedPoses(Region& region)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  vector<Pose> poses;
+  auto record = current().maps.find(region.parent_map->map_id);
+  if (record == current().maps.end())
+  {
+    return poses;
+  }
+  for (const auto& pose : record->second.spatial.containedPoses(region.entity_id))
+  {
+    poses.emplace_back(pose.entity_id, pose.name, pose.x, pose.y, pose.theta, region.parent_map, *this);
+  }
+  return poses;
+}
+
+boost::optional<Map> LongTermMemoryConduitInMemory::getMapForMapId(uint map_id)
+{
+  std::lock_guard<std::recursive_mutex> lock(store->mutex);
+  auto map = current().maps.find(map_id);
+  if (map != current().maps.end())
+  {
+    return Map(map->second.entity_id, map_id, map->second.name, *this);
+  }
+  return {};
+}
+
+}  // namespace knowledge_rep
@@ -11,7 +11,16 @@
 #include <knowledge_representation/LTMCDoor.h>
 #include <vector>
 #include <utility>
-#include <regex>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 
 using std::string;
 using std::vector;
@@ -25,57 +34,582 @@ typedef LTMCPose<LongTermMemoryConduitPostgreSQL> Pose;
 typedef LTMCRegion<LongTermMemoryConduitPostgreSQL> Region;
 typedef LTMCMap<LongTermMemoryConduitPostgreSQL> Map;
 
-template <typename Out>
-void split(const string& s, char delim, Out result)
+namespace
 {
-  std::istringstream iss(s);
-  std::string item;
-  while (std::getline(iss, item, delim))
-  {
-    *result++ = item;
-  }
+/// Bumped whenever any conduit in the process adds or deletes an attribute, so that each conduit's schema cache looks
+/// again for the names it has missed
+std::atomic<uint64_t> attribute_schema_generation(0);
+
+/// Whether c separates numbers in PostgreSQL's text format for geometry
+inline bool isGeometryDelimiter(char c)
+{
+  return c == '(' || c == ')' || c == ',' || c == ' ';
 }
 
-std::vector<std::string> split(const string& s, char delim)
+/// Reads a double at s and moves s past it, throwing if there isn't one
+inline double parseCoordinate(const char*& s, const char* text)
 {
-  std::vector<std::string> elems;
-  split(s, delim, std::back_inserter(elems));
-  return elems;
+  while (isGeometryDelimiter(*s))
+  {
+    s++;
+  }
+  char* end;
+  double value = std::strtod(s, &end);
+  if (end == s)
+  {
+    throw std::invalid_argument(string("Malformed polygon: ") + text);
+  }
+  s = end;
+  return value;
 }
+}  // namespace
 
-std::vector<Region::Point2D> strToPoints(const string& s)
+/**
+ * @brief Decodes a polygon in PostgreSQL's text format, ((x1,y1),...,(xn,yn)), into its vertices
+ *
+ * The text is read in place, and the vertices are counted from the commas first, so the returned vector is the only
+ * allocation. Region decoding used to dominate reading regions with many vertices.
+ */
+std::vector<Region::Point2D> strToPoints(const char* text)
 {
   std::vector<Region::Point2D> points;
-  std::regex paren_regex("\\(|\\)");
-  std::string result;
-  // write the results to an output iterator
-  std::regex_replace(back_inserter(result), s.begin(), s.end(), paren_regex, "");
-  auto components = split(result, ',');
-  auto i = components.begin();
-  while (i < components.end())
-  {
-    auto f = *i++;
-    auto s = *i++;
-    points.emplace_back(std::stod(f), std::stod(s));
+  size_t commas = 0;
+  for (const char* c = text; *c; c++)
+  {
+    commas += *c == ',';
+  }
+  // Each vertex has one comma inside its parentheses and one after, except the last
+  points.reserve(commas / 2 + 1);
+  const char* s = text;
+  while (true)
+  {
+    while (isGeometryDelimiter(*s))
+    {
+      s++;
+    }
+    if (!*s)
+    {
+      break;
+    }
+    double x = parseCoordinate(s, text);
+    double y = parseCoordinate(s, text);
+    points.emplace_back(x, y);
   }
   return points;
 }
 
-LongTermMemoryConduitPostgreSQL::LongTermMemoryConduitPostgreSQL(const string& db_name, const string& hostname)
+/// The parent map of a row from one of the get_*_by_id statements, which join it in
+template <typename Row>
+Map parentMap(const Row& row, LongTermMemoryConduitPostgreSQL& ltmc)
+{
+  return { row["map_entity_id"].template as<uint>(), row["parent_map_id"].template as<uint>(),
+           row["map_name"].template as<string>(), ltmc };
+}
+
+// One row per typed value across all five attribute tables. The type column holds the AttributeValueType and only
+// that type's value column is set, so the mixed result can be decoded in a single pass. Filters applied to the outer
+// query are pushed down into each branch. Attributes come back by ID, to be named from the schema cache.
+#define TYPED_ATTRIBUTES_QUERY                                                                                         \
+  "SELECT entity_id, attribute_id, 0 AS type, attribute_value AS id_value, NULL::int AS int_value, "                   \
+  "NULL::bool AS bool_value, NULL::double precision AS float_value, NULL::varchar AS str_value "                       \
+  "FROM entity_attributes_id "                                                                                         \
+  "UNION ALL SELECT entity_id, attribute_id, 2, NULL, attribute_value, NULL, NULL, NULL FROM entity_attributes_int "   \
+  "UNION ALL SELECT entity_id, attribute_id, 1, NULL, NULL, attribute_value, NULL, NULL "                              \
+  "FROM entity_attributes_bool "                                                                                       \
+  "UNION ALL SELECT entity_id, attribute_id, 3, NULL, NULL, NULL, attribute_value, NULL "                              \
+  "FROM entity_attributes_float "                                                                                      \
+  "UNION ALL SELECT entity_id, attribute_id, 4, NULL, NULL, NULL, NULL, attribute_value FROM entity_attributes_str"
+
+// The bulk getters run these as they are, and the forEach*Batch scans page through them with SCAN_QUERY
+#define ALL_ENTITIES_QUERY "TABLE entities"
+#define ALL_CONCEPTS_QUERY "SELECT entity_id, concept_name FROM concepts"
+#define ALL_INSTANCES_QUERY "SELECT entity_id FROM entities WHERE entity_id NOT IN (SELECT entity_id FROM concepts)"
+
+// The page of a query's rows that follows entity ID $1, at most $2 of them. The filter and limit are pushed down to
+// the entity_id index, so each page costs the same however far into the scan it is.
+#define SCAN_QUERY(QUERY) "SELECT * FROM (" QUERY ") AS scanned WHERE entity_id > $1 ORDER BY entity_id LIMIT $2"
+
+// The page of one attribute table's rows that follows the key ($1, $2, $3), at most $4 of them, with the columns of
+// the typed attribute union that unwrap_attribute_rows reads
+#define SCAN_ATTRIBUTES_QUERY(TABLE, TYPE, VALUE_COLUMN, VALUE_TYPE)                                                   \
+  "SELECT entity_id, attribute_id, " TYPE " AS type, attribute_value AS " VALUE_COLUMN " FROM " TABLE " "              \
+  "WHERE (entity_id, attribute_id, attribute_value) > ($1::int, $2::smallint, $3::" VALUE_TYPE ") "                    \
+  "ORDER BY entity_id, attribute_id, attribute_value LIMIT $4"
+
+// The ID of one of the default attributes, for statements that name it. Attributes change rarely and the lookup is a
+// probe of a small unique index, run once per statement rather than once per row.
+#define ATTRIBUTE_ID(NAME) "(SELECT attribute_id FROM attributes WHERE attribute_name = '" NAME "')"
+
+// Adds a map-owned geometry entity in one statement: the entity, its geometry row, the map's has attribute, the name
+// attribute and the instance_of row, all or nothing. $1 is the map's entity ID, $2 the name and $3 the map ID.
+// GEOMETRY_INSERT inserts from the new entity and returns its ID.
+#define ADD_GEOMETRY_QUERY(CONCEPT, GEOMETRY_INSERT)                                                                   \
+  "WITH entity AS (INSERT INTO entities VALUES (DEFAULT) RETURNING entity_id), "                                       \
+  "geometry AS (" GEOMETRY_INSERT "), "                                                                                \
+  "has_attribute AS (INSERT INTO entity_attributes_id "                                                                \
+  "SELECT $1::int, " ATTRIBUTE_ID("has") ", entity_id FROM entity), "                                                  \
+  "name_attribute AS (INSERT INTO entity_attributes_str "                                                              \
+  "SELECT entity_id, " ATTRIBUTE_ID("name") ", $2::varchar FROM entity), "                                             \
+  "instance AS (INSERT INTO instance_of SELECT entity.entity_id, concepts.entity_id FROM entity, concepts "            \
+  "WHERE concept_name = '" CONCEPT "') "                                                                               \
+  "SELECT entity_id FROM geometry"
+
+// Every fixed statement the conduit issues, keyed by the name it is prepared under. Only the raw select queries
+// that callers pass in are sent as plain text.
+static const std::pair<const char*, const char*> PREPARED_STATEMENTS[] = {
+  // Entities
+  { "add_entity", "INSERT INTO entities VALUES (DEFAULT) RETURNING entity_id" },
+  { "add_entity_with_id", "INSERT INTO entities VALUES ($1) ON CONFLICT DO NOTHING RETURNING entity_id" },
+  { "reserve_entity_ids", "SELECT nextval('entities_entity_id_seq') AS entity_id FROM generate_series(1, $1)" },
+  { "entity_exists", "SELECT count(*) FROM entities WHERE entity_id = $1" },
+  { "delete_entity", "DELETE FROM entities WHERE entity_id = $1" },
+  { "get_all_entities", ALL_ENTITIES_QUERY },
+  { "scan_entities", SCAN_QUERY(ALL_ENTITIES_QUERY) },
+  { "delete_all_entities", "DELETE FROM entities" },
+  { "add_default_entities", "SELECT * FROM add_default_entities()" },
+  // Attributes
+  { "add_new_attribute", "INSERT INTO attributes (attribute_name, type) VALUES ($1, $2) ON CONFLICT DO NOTHING "
+                         "RETURNING attribute_id" },
+  { "delete_attribute", "DELETE FROM attributes WHERE attribute_name = $1" },
+  { "get_all_attributes", "TABLE attributes" },
+  { "delete_all_attributes", "DELETE FROM attributes" },
+  { "add_default_attributes", "SELECT * FROM add_default_attributes()" },
+  // Entity attributes
+  { "add_attribute_id", "INSERT INTO entity_attributes_id VALUES ($1, $2, $3)" },
+  { "add_attribute_bool", "INSERT INTO entity_attributes_bool VALUES ($1, $2, $3)" },
+  { "add_attribute_int", "INSERT INTO entity_attributes_int VALUES ($1, $2, $3)" },
+  { "add_attribute_float", "INSERT INTO entity_attributes_float VALUES ($1, $2, $3)" },
+  { "add_attribute_str", "INSERT INTO entity_attributes_str VALUES ($1, $2, $3)" },
+  { "remove_attribute", "SELECT * FROM remove_attribute($1, $2) AS count" },
+  { "get_attributes", "SELECT * FROM (" TYPED_ATTRIBUTES_QUERY ") AS typed WHERE entity_id = $1" },
+  // get_attributes for an array of entities at once
+  { "get_attributes_batch", "SELECT * FROM (" TYPED_ATTRIBUTES_QUERY ") AS typed WHERE entity_id = ANY($1::int[])" },
+  { "scan_attributes_id", SCAN_ATTRIBUTES_QUERY("entity_attributes_id", "0", "id_value", "int") },
+  { "scan_attributes_bool", SCAN_ATTRIBUTES_QUERY("entity_attributes_bool", "1", "bool_value", "bool") },
+  { "scan_attributes_int", SCAN_ATTRIBUTES_QUERY("entity_attributes_int", "2", "int_value", "int") },
+  { "scan_attributes_float", SCAN_ATTRIBUTES_QUERY("entity_attributes_float", "3", "float_value", "double precision") },
+  { "scan_attributes_str", SCAN_ATTRIBUTES_QUERY("entity_attributes_str", "4", "str_value", "varchar") },
+  { "get_named_attributes",
+    "SELECT * FROM (" TYPED_ATTRIBUTES_QUERY ") AS typed WHERE entity_id = $1 AND attribute_id = $2" },
+  { "get_entities_with_attribute_of_value_id",
+    "SELECT entity_id FROM entity_attributes_id WHERE attribute_value = $1 AND attribute_id = $2" },
+  { "get_entities_with_attribute_of_value_bool",
+    "SELECT entity_id FROM entity_attributes_bool WHERE attribute_value = $1 AND attribute_id = $2" },
+  { "get_entities_with_attribute_of_value_int",
+    "SELECT entity_id FROM entity_attributes_int WHERE attribute_value = $1 AND attribute_id = $2" },
+  { "get_entities_with_attribute_of_value_float",
+    "SELECT entity_id FROM entity_attributes_float WHERE attribute_value = $1 AND attribute_id = $2" },
+  { "get_entities_with_attribute_of_value_str",
+    "SELECT entity_id FROM entity_attributes_str WHERE attribute_value = $1 AND attribute_id = $2" },
+  // Concepts and instances. instance_of refers to concepts by their entity IDs.
+  { "add_concept", "INSERT INTO concepts VALUES ($1, $2)" },
+  { "get_concept_by_name", "SELECT entity_id FROM concepts WHERE concept_name = $1" },
+  { "get_concept_by_id", "SELECT concept_name FROM concepts WHERE entity_id = $1" },
+  { "get_all_concepts", ALL_CONCEPTS_QUERY },
+  { "scan_concepts", SCAN_QUERY(ALL_CONCEPTS_QUERY) },
+  { "get_all_instances", ALL_INSTANCES_QUERY },
+  { "scan_instances", SCAN_QUERY(ALL_INSTANCES_QUERY) },
+  { "instance_exists", "SELECT count(*) FROM instance_of WHERE entity_id = $1" },
+  { "get_instance_named", "SELECT entity_id FROM entity_attributes_str WHERE attribute_id = " ATTRIBUTE_ID("name")
+                          " AND attribute_value = $1 AND entity_id IN (SELECT entity_id FROM instance_of WHERE "
+                          "concept_id = $2)" },
+  { "make_instance_of", "INSERT INTO instance_of VALUES ($1, $2)" },
+  { "get_named_instances", "SELECT instance_of.entity_id, concept_name, attribute_value AS name "
+                           "FROM instance_of INNER JOIN concepts ON concepts.entity_id = instance_of.concept_id "
+                           "INNER JOIN entity_attributes_str eas ON eas.entity_id = instance_of.entity_id "
+                           "WHERE attribute_id = " ATTRIBUTE_ID("name") },
+  { "get_concepts", "SELECT concepts.entity_id, concepts.concept_name FROM instance_of "
+                    "INNER JOIN concepts ON concepts.entity_id = instance_of.concept_id "
+                    "WHERE instance_of.entity_id = $1" },
+  { "get_concepts_recursive", "SELECT * FROM get_concepts_recursive($1)" },
+  // get_concepts_recursive() for an array of instances at once, with each concept labelled by its instance
+  { "get_concepts_recursive_batch",
+    "WITH RECURSIVE ancestors (instance_id, id) AS (SELECT entity_id, concept_id FROM instance_of "
+    "WHERE entity_id = ANY($1::int[]) "
+    "UNION SELECT ancestors.instance_id, eai.attribute_value FROM entity_attributes_id eai INNER JOIN ancestors "
+    "ON eai.attribute_id = " ATTRIBUTE_ID("is_a") " AND eai.entity_id = ancestors.id) "
+    "SELECT instance_id, entity_id, concept_name FROM ancestors INNER JOIN concepts ON entity_id = id" },
+  // Walks down from the concept rather than up from each instance, so the hierarchy is only walked once
+  { "filter_instances_of", "SELECT DISTINCT entity_id FROM instance_of WHERE entity_id = ANY($1::int[]) "
+                           "AND concept_id IN (SELECT entity_id FROM get_all_concept_descendants($2))" },
+  { "get_children", "SELECT concepts.entity_id, concept_name FROM entity_attributes_id eai "
+                    "INNER JOIN concepts ON eai.entity_id = concepts.entity_id "
+                    "WHERE attribute_id = " ATTRIBUTE_ID("is_a") " AND attribute_value = $1" },
+  { "get_children_recursive", "SELECT * FROM get_all_concept_descendants($1)" },
+  { "get_is_a_relations",
+    "SELECT entity_id, attribute_value FROM entity_attributes_id WHERE attribute_id = " ATTRIBUTE_ID("is_a") },
+  { "get_instances", "SELECT entity_id FROM instance_of WHERE concept_id = $1" },
+  { "remove_instances", "DELETE FROM entities WHERE entity_id IN "
+                        "(SELECT entity_id FROM instance_of WHERE concept_id = $1)" },
+  { "remove_instances_recursive", "DELETE FROM entities WHERE entity_id IN "
+                                  "(SELECT entity_id FROM get_all_instances_of_concept_recursive($1))" },
+  // Maps
+  { "add_map", "INSERT INTO maps VALUES ($1, DEFAULT, $2) RETURNING map_id" },
+  { "get_map_by_name", "SELECT entity_id, map_id FROM maps WHERE map_name = $1" },
+  { "get_map_by_id", "SELECT map_name, map_id FROM maps WHERE entity_id = $1" },
+  { "get_all_maps", "TABLE maps" },
+  { "rename_map", "UPDATE maps SET map_name = $1 WHERE map_name = $2" },
+  // Map geometry
+  { "add_point", ADD_GEOMETRY_QUERY("point", "INSERT INTO points SELECT entity_id, $2::varchar, $3::int, "
+                                             "point($4::float8, $5::float8) FROM entity RETURNING entity_id") },
+  { "add_pose", ADD_GEOMETRY_QUERY("pose", "INSERT INTO poses SELECT entity_id, $2::varchar, $3::int, "
+                                           "lseg(point($4::float8, $5::float8), "
+                                           "point($4::float8 + COS($6::float8), $5::float8 + SIN($6::float8))) "
+                                           "FROM entity RETURNING entity_id") },
+  { "add_region", ADD_GEOMETRY_QUERY("region", "INSERT INTO regions SELECT entity_id, $2::varchar, $3::int, "
+                                               "$4::polygon FROM entity RETURNING entity_id") },
+  { "add_door", ADD_GEOMETRY_QUERY("door", "INSERT INTO doors SELECT entity_id, $2::varchar, $3::int, "
+                                           "lseg(point($4::float8, $5::float8), point($6::float8, $7::float8)) "
+                                           "FROM entity RETURNING entity_id") },
+  // By-ID lookups join in the parent map, so that building its handle doesn't take a second round trip
+  { "get_point_by_id", "SELECT point_name, x, y, parent_map_id, maps.entity_id AS map_entity_id, map_name "
+                       "FROM points_xy JOIN maps ON map_id = parent_map_id WHERE points_xy.entity_id = $1" },
+  { "get_pose_by_id", "SELECT pose_name, x, y, theta, parent_map_id, maps.entity_id AS map_entity_id, map_name "
+                      "FROM poses_point_angle JOIN maps ON map_id = parent_map_id "
+                      "WHERE poses_point_angle.entity_id = $1" },
+  { "get_region_by_id", "SELECT region_name, region, parent_map_id, maps.entity_id AS map_entity_id, map_name "
+                        "FROM regions JOIN maps ON map_id = parent_map_id WHERE regions.entity_id = $1" },
+  { "get_door_by_id", "SELECT door_name, x_0, y_0, x_1, y_1, parent_map_id, maps.entity_id AS map_entity_id, "
+                      "map_name FROM doors_points JOIN maps ON map_id = parent_map_id "
+                      "WHERE doors_points.entity_id = $1" },
+  { "get_point_by_name", "SELECT entity_id, x, y FROM points_xy WHERE parent_map_id = $1 AND point_name = $2" },
+  { "get_pose_by_name", "SELECT entity_id, x, y, theta FROM poses_point_angle "
+                        "WHERE parent_map_id = $1 AND pose_name = $2" },
+  { "get_region_by_name", "SELECT entity_id, region, region_name FROM regions "
+                          "WHERE parent_map_id = $1 AND region_name = $2" },
+  { "get_door_by_name", "SELECT entity_id, x_0, y_0, x_1, y_1, door_name FROM doors_points "
+                        "WHERE parent_map_id = $1 AND door_name = $2" },
+  { "get_all_points", "SELECT entity_id, x, y, point_name FROM points_xy WHERE parent_map_id = $1" },
+  { "get_all_poses", "SELECT entity_id, x, y, theta, pose_name FROM poses_point_angle WHERE parent_map_id = $1" },
+  { "get_all_regions", "SELECT entity_id, region, region_name FROM regions WHERE parent_map_id = $1" },
+  { "get_all_doors", "SELECT entity_id, door_name, x_0, y_0, x_1, y_1 FROM doors_points WHERE parent_map_id = $1" },
+};
+
+/**
+ * @brief Registers every statement in PREPARED_STATEMENTS with a connection
+ *
+ * Registration is lazy. The server parses and plans a statement the first time it runs on the connection, and every
+ * later call skips straight to execution.
+ */
+void prepareStatements(pqxx::connection& connection)
+{
+  for (const auto& statement : PREPARED_STATEMENTS)
+  {
+    connection.prepare(statement.first, statement.second);
+  }
+}
+
+/**
+ * @brief Readies a new pooled connection
+ *
+ * Before PostgreSQL 12, floats were sent as text rounded to 15 digits unless asked for more. Scans page through the
+ * float attribute table by value, so the values they read have to be exact.
+ */
+void setUpConnection(pqxx::connection& connection)
+{
+  connection.set_variable("extra_float_digits", "3");
+  prepareStatements(connection);
+}
+
+/**
+ * @brief Decodes rows from the typed attribute union (see the get_attributes statement)
+ *
+ * The type column says which of the value columns holds the row's value, so rows of every type can be mixed freely.
+ * Text is read in place, so decoding doesn't allocate.
+ * @tparam Attributes a vector of EntityAttributes or an AttributeBatch
+ * @param name_of names the attribute IDs in the rows
+ */
+template <typename Attributes>
+void unwrap_attribute_rows(const pqxx::result& rows, Attributes& entity_attributes,
+                           const std::function<AttributeString(int)>& name_of)
+{
+  entity_attributes.reserve(entity_attributes.size() + rows.size());
+  for (const auto& row : rows)
+  {
+    auto entity_id = row["entity_id"].as<uint>();
+    auto attribute_name = name_of(row["attribute_id"].as<int>());
+    switch (row["type"].as<int>())
+    {
+      case Id:
+        // Databases rarely have uint support, so IDs have always come back as ints
+        entity_attributes.emplace_back(entity_id, attribute_name, row["id_value"].as<int>());
+        break;
+      case Bool:
+        entity_attributes.emplace_back(entity_id, attribute_name, row["bool_value"].as<bool>());
+        break;
+      case Int:
+        entity_attributes.emplace_back(entity_id, attribute_name, row["int_value"].as<int>());
+        break;
+      case Float:
+        entity_attributes.emplace_back(entity_id, attribute_name, row["float_value"].as<double>());
+        break;
+      case Str:
+        entity_attributes.emplace_back(entity_id, attribute_name,
+                                       AttributeString(row["str_value"].c_str(), row["str_value"].size()));
+        break;
+      default:
+        assert(false);
+    }
+  }
+}
+
+/**
+ * @brief Streams rows into a table with COPY
+ *
+ * libpqxx replaced tablewriter with stream_to in 6.3, so use whichever one the installed version provides.
+ */
+void copyRows(pqxx::transaction_base& txn, const string& table, const vector<vector<string>>& rows)
+{
+#if PQXX_VERSION_MAJOR > 6 || (PQXX_VERSION_MAJOR == 6 && PQXX_VERSION_MINOR >= 3)
+  pqxx::stream_to stream{ txn, table };
+  for (const auto& row : rows)
+  {
+    stream << row;
+  }
+  stream.complete();
+#else
+  pqxx::tablewriter writer{ txn, table };
+  for (const auto& row : rows)
+  {
+    writer << row;
+  }
+  writer.complete();
+#endif
+}
+
+/**
+ * @brief Formats an attribute value as a COPY field for a table of the given type
+ *
+ * Values are converted as convertAttributeValue does, so loaders don't need to know exactly which numeric type an
+ * attribute was declared with.
+ * @throws std::invalid_argument if the value can't be stored as the given type
+ */
+string toCopyField(const AttributeValue& value, AttributeValueType type)
+{
+  auto converted = convertAttributeValue(value, type);
+  if (!converted)
+  {
+    throw std::invalid_argument("Can't store " + toString(value) + " as an attribute of type " +
+                                attribute_value_type_to_string[type]);
+  }
+  switch (type)
+  {
+    case Id:
+      return pqxx::to_string(converted->get<uint>());
+    case Bool:
+      return converted->get<bool>() ? "t" : "f";
+    case Int:
+      return pqxx::to_string(converted->get<int>());
+    case Float:
+      return pqxx::to_string(converted->get<double>());
+    default:
+      return converted->get<string>();
+  }
+}
+
+/**
+ * @brief Binds an attribute value as the next parameter of a prepared statement
+ */
+template <typename Invocation>
+typename std::remove_reference<Invocation>::type& bindValue(Invocation&& invocation, const AttributeValue& value)
+{
+  switch (value.which())
+  {
+    case Id:
+      return invocation(value.get<uint>());
+    case Bool:
+      return invocation(value.get<bool>());
+    case Int:
+      return invocation(value.get<int>());
+    case Float:
+      return invocation(value.get<double>());
+    default:
+      return invocation(value.get<string>());
+  }
+}
+
+string instanceKey(const string& name, const string& concept_name)
+{
+  // Names can't contain NUL, so this can't be ambiguous
+  return concept_name + '\0' + name;
+}
+
+LongTermMemoryConduitPostgreSQL::LongTermMemoryConduitPostgreSQL(const string& db_name, const string& hostname,
+                                                                 size_t max_connections)
   : LongTermMemoryConduitInterface<LongTermMemoryConduitPostgreSQL>()
+  , connections(new PostgreSQLConnectionPool("postgresql://postgres@" + hostname + "/" + db_name, max_connections,
+                                             setUpConnection))
+  , attribute_schema(new AttributeSchema())
+  , concept_index(new ConceptIndex())
+  , spatial_indexes(new SpatialIndexes())
+  , write_batches(new WriteBatches())
+{
+  // Connect once up front so a bad database name or host is reported here rather than on first use
+  connections->acquire();
+}
+
+LongTermMemoryConduitPostgreSQL::~LongTermMemoryConduitPostgreSQL()
 {
-  conn = std::unique_ptr<pqxx::connection>(new pqxx::connection("postgresql://postgres@" + hostname + "/" + db_name));
+  if (!write_batches)
+  {
+    return;
+  }
+  // Anything still open was never committed. Inner batches have to be closed before the ones they belong to.
+  for (auto& thread : write_batches->by_thread)
+  {
+    auto& batches = thread.second.batches;
+    while (!batches.empty())
+    {
+      batches.pop_back();
+    }
+  }
 }
 
-LongTermMemoryConduitPostgreSQL::~LongTermMemoryConduitPostgreSQL() = default;
+PostgreSQLConnectionPool::Lease LongTermMemoryConduitPostgreSQL::borrowConnection()
+{
+  return connections->acquire();
+}
+
+LongTermMemoryConduitPostgreSQL::Transaction
+LongTermMemoryConduitPostgreSQL::openTransaction(const std::string& name) const
+{
+  {
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+    if (thread != write_batches->by_thread.end())
+    {
+      // A savepoint inside the batch means a failed operation only rolls back its own changes
+      auto& batch = thread->second.batches.back().txn;
+      return { {}, std::unique_ptr<pqxx::dbtransaction>(new pqxx::subtransaction(*batch, name)) };
+    }
+  }
+  auto connection = connections->acquire();
+  std::unique_ptr<pqxx::dbtransaction> txn(new pqxx::work(*connection, name));
+  return { std::move(connection), std::move(txn) };
+}
+
+// WRITE BATCH BACKERS
+
+bool LongTermMemoryConduitPostgreSQL::beginWriteBatch()
+{
+  try
+  {
+    // The outermost batch is a real transaction, and nested ones are savepoints within it. Either way, the batch
+    // belongs to this thread, and other threads keep working on connections of their own.
+    auto batch = openTransaction("writeBatch");
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    write_batches->by_thread[std::this_thread::get_id()].batches.push_back({ std::move(batch), {}, {} });
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitPostgreSQL::commitWriteBatch()
+{
+  return closeWriteBatch([](Transaction& batch) {
+    try
+    {
+      batch->commit();
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+    return true;
+  });
+}
+
+void LongTermMemoryConduitPostgreSQL::abortWriteBatch()
+{
+  closeWriteBatch([](Transaction& batch) {
+    try
+    {
+      batch->abort();
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+    }
+    return false;
+  });
+}
+
+bool LongTermMemoryConduitPostgreSQL::closeWriteBatch(const std::function<bool(Transaction&)>& close)
+{
+  auto id = std::this_thread::get_id();
+  std::unique_lock<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(id);
+  assert(thread != write_batches->by_thread.end());
+  auto batch = std::move(thread->second.batches.back());
+  thread->second.batches.pop_back();
+  bool outermost = thread->second.batches.empty();
+  if (outermost)
+  {
+    write_batches->by_thread.erase(thread);
+  }
+  lock.unlock();
+
+  bool committed = close(batch.txn);
+  if (!committed)
+  {
+    // The batch may have added attributes that are now gone, so the schema cache can't be trusted
+    std::lock_guard<std::mutex> schema_lock(attribute_schema->mutex);
+    attribute_schema->loaded = false;
+  }
+  if (outermost)
+  {
+    if (committed)
+    {
+      for (const auto& change : batch.concept_changes)
+      {
+        change(*concept_index);
+      }
+      for (const auto& change : batch.spatial_changes)
+      {
+        change(*spatial_indexes);
+      }
+    }
+    return committed;
+  }
+
+  lock.lock();
+  auto& outer = write_batches->by_thread.at(id);
+  if (committed)
+  {
+    auto& parent = outer.batches.back();
+    parent.concept_changes.insert(parent.concept_changes.end(), batch.concept_changes.begin(),
+                                  batch.concept_changes.end());
+    parent.spatial_changes.insert(parent.spatial_changes.end(), batch.spatial_changes.begin(),
+                                  batch.spatial_changes.end());
+    return true;
+  }
+  // The thread's own indexes took on the changes that were just rolled back. They're read again from what's left of
+  // the batch, or dropped if the batches left haven't changed them, so that the shared indexes are read again.
+  if (!batch.concept_changes.empty())
+  {
+    bool changed = std::any_of(outer.batches.begin(), outer.batches.end(),
+                               [](const OpenBatch& open) { return !open.concept_changes.empty(); });
+    outer.concept_index.reset(changed ? new ConceptIndex() : nullptr);
+  }
+  if (!batch.spatial_changes.empty())
+  {
+    bool changed = std::any_of(outer.batches.begin(), outer.batches.end(),
+                               [](const OpenBatch& open) { return !open.spatial_changes.empty(); });
+    outer.spatial_indexes.reset(changed ? new SpatialIndexes() : nullptr);
+  }
+  return false;
+}
 
 bool LongTermMemoryConduitPostgreSQL::addEntity(uint id)
 {
-  pqxx::work txn{ *conn };
-  pqxx::result result = txn.exec("INSERT INTO entities "
-                                 "VALUES (" +
-                                 txn.quote(id) + ") ON CONFLICT DO NOTHING RETURNING entity_id");
-  txn.commit();
+  auto txn = openTransaction();
+  pqxx::result result = txn->prepared("add_entity_with_id")(id).exec();
+  txn->commit();
   return result.size() == 1;
 }
 
@@ -87,95 +621,64 @@ bool LongTermMemoryConduitPostgreSQL::addEntity(uint id)
  */
 bool LongTermMemoryConduitPostgreSQL::addNewAttribute(const string& name, const AttributeValueType type)
 {
+  // The schema would refuse longer names anyway, but this turns them away without a round trip
+  if (!fitsAttributeString(name))
+  {
+    return false;
+  }
   try
   {
-    pqxx::work txn{ *conn };
-    pqxx::result result = txn.exec("INSERT INTO attributes VALUES (" + txn.quote(name) + ", " +
-                                   txn.quote(attribute_value_type_to_string[type]) + ") ON CONFLICT DO NOTHING");
-    txn.commit();
-    return result.affected_rows() == 1;
+    auto txn = openTransaction();
+    pqxx::result result = txn->prepared("add_new_attribute")(name)(attribute_value_type_to_string[type]).exec();
+    txn->commit();
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    attribute_schema_generation++;
+    if (result.affected_rows() != 1)
+    {
+      return false;
+    }
+    cacheAttribute(name, result[0]["attribute_id"].as<int>(), type);
+    return true;
   }
   catch (const std::exception& e)
   {
     std::cerr << e.what() << std::endl;
+    // Most likely the attribute already exists, so it's worth looking for again even if the cache has missed it
+    attribute_schema_generation++;
     return false;
   }
 }
 
 bool LongTermMemoryConduitPostgreSQL::entityExists(uint id) const
 {
-  pqxx::work txn{ *conn, "entityExists" };
-  auto result = txn.exec("SELECT count(*) FROM entities WHERE entity_id=" + txn.quote(id));
-  txn.commit();
+  auto txn = openTransaction("entityExists");
+  auto result = txn->prepared("entity_exists")(id).exec();
+  txn->commit();
   return result[0]["count"].as<uint>() == 1;
 }
 
 vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(const string& attribute_name,
                                                                                 const uint other_entity_id)
 {
-  pqxx::work txn{ *conn, "getEntitiesWithAttributeOfValueId" };
-  auto result = txn.exec("SELECT entity_id FROM entity_attributes_id "
-                         "WHERE attribute_value=" +
-                         txn.quote(other_entity_id) + " and attribute_name = " + txn.quote(attribute_name));
-  txn.commit();
-
-  vector<Entity> return_result;
-  for (const auto& row : result)
-  {
-    return_result.emplace_back(row["entity_id"].as<uint>(), *this);
-  }
-  return return_result;
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(other_entity_id));
 }
 
 vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(const string& attribute_name,
                                                                                 const bool bool_val)
 {
-  pqxx::work txn{ *conn, "getEntitiesWithAttributeOfValueBool" };
-  auto result = txn.parameterized("SELECT entity_id FROM entity_attributes_bool "
-                                  "WHERE attribute_value= $1  AND attribute_name = $2")(bool_val)(attribute_name)
-                    .exec();
-  txn.commit();
-
-  vector<Entity> return_result;
-  for (const auto& row : result)
-  {
-    return_result.emplace_back(row["entity_id"].as<uint>(), *this);
-  }
-  return return_result;
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(bool_val));
 }
 
 vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(const string& attribute_name,
                                                                                 const int int_val)
 {
-  pqxx::work txn{ *conn, "getEntitiesWithAttributeOfValueInt" };
-  auto result = txn.exec("SELECT entity_id FROM entity_attributes_int "
-                         "WHERE attribute_value=" +
-                         txn.quote(int_val) + " and attribute_name = " + txn.quote(attribute_name));
-  txn.commit();
-
-  vector<Entity> return_result;
-  for (const auto& row : result)
-  {
-    return_result.emplace_back(row["entity_id"].as<uint>(), *this);
-  }
-  return return_result;
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(int_val));
 }
 
 vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(const string& attribute_name,
                                                                                 const double float_val)
 {
-  pqxx::work txn{ *conn, "getEntitiesWithAttributeOfValueFloat" };
-  auto result = txn.exec("SELECT entity_id FROM entity_attributes_float "
-                         "WHERE attribute_value=" +
-                         txn.quote(float_val) + " and attribute_name = " + txn.quote(attribute_name));
-  txn.commit();
-
-  vector<Entity> return_result;
-  for (const auto& row : result)
-  {
-    return_result.emplace_back(row["entity_id"].as<uint>(), *this);
-  }
-  return return_result;
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(float_val));
 }
 
 vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(const string& attribute_name,
@@ -187,11 +690,32 @@ vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(
 vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(const string& attribute_name,
                                                                                 const string& string_val)
 {
-  pqxx::work txn{ *conn, "getEntitiesWithAttributeOfValueString" };
-  auto result = txn.exec("SELECT entity_id FROM entity_attributes_str "
-                         "WHERE attribute_value=" +
-                         txn.quote(string_val) + " and attribute_name = " + txn.quote(attribute_name));
-  txn.commit();
+  // The schema stores values as varchar(24), so no longer one could match
+  if (!fitsAttributeString(string_val))
+  {
+    return {};
+  }
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(string_val));
+}
+
+vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeValue(const string& attribute_name,
+                                                                              const AttributeValue& value)
+{
+  // Values live in the table for their attribute's type, so no other table could hold a match
+  auto key = attributeKey(attribute_name);
+  if (!key)
+  {
+    return {};
+  }
+  auto converted = convertAttributeValue(value, key->second);
+  if (!converted)
+  {
+    return {};
+  }
+  auto statement = "get_entities_with_attribute_of_value_" + attribute_value_type_to_string[key->second];
+  auto txn = openTransaction("getEntitiesWithAttributeOfValue");
+  auto result = bindValue(txn->prepared(statement), *converted)(key->first).exec();
+  txn->commit();
 
   vector<Entity> return_result;
   for (const auto& row : result)
@@ -203,10 +727,10 @@ vector<Entity> LongTermMemoryConduitPostgreSQL::getEntitiesWithAttributeOfValue(
 
 vector<Entity> LongTermMemoryConduitPostgreSQL::getAllEntities()
 {
-  pqxx::work txn{ *conn, "getAllEntities" };
+  auto txn = openTransaction("getAllEntities");
 
-  auto result = txn.exec("TABLE entities");
-  txn.commit();
+  auto result = txn->prepared("get_all_entities").exec();
+  txn->commit();
 
   vector<Entity> entities;
   for (const auto& row : result)
@@ -218,10 +742,10 @@ vector<Entity> LongTermMemoryConduitPostgreSQL::getAllEntities()
 
 vector<Map> LongTermMemoryConduitPostgreSQL::getAllMaps()
 {
-  pqxx::work txn{ *conn, "getAllMaps" };
+  auto txn = openTransaction("getAllMaps");
 
-  auto result = txn.exec("TABLE maps");
-  txn.commit();
+  auto result = txn->prepared("get_all_maps").exec();
+  txn->commit();
 
   vector<Map> maps;
   for (const auto& row : result)
@@ -233,73 +757,382 @@ vector<Map> LongTermMemoryConduitPostgreSQL::getAllMaps()
 
 uint LongTermMemoryConduitPostgreSQL::deleteAllAttributes()
 {
-  pqxx::work txn{ *conn };
+  auto txn = openTransaction();
 
   // Remove all entities
-  uint num_deleted = txn.exec("DELETE FROM attributes").affected_rows();
+  uint num_deleted = txn->prepared("delete_all_attributes").exec().affected_rows();
   // Use the baked in function to get the default configuration back
-  txn.exec("SELECT * FROM add_default_attributes()");
-  txn.commit();
+  txn->prepared("add_default_attributes").exec();
+  txn->commit();
+  // Reloaded on next use, rather than keeping a second copy of the defaults here
+  {
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    attribute_schema->loaded = false;
+  }
+  unloadConceptIndex();
   return num_deleted;
 }
 
 uint LongTermMemoryConduitPostgreSQL::deleteAllEntities()
 {
-  pqxx::work txn{ *conn };
-
-  // Remove all entities
-  uint num_deleted = txn.exec("DELETE FROM entities").affected_rows();
-  // Use the baked in function to get the default configuration back
-  txn.exec("SELECT * FROM add_default_entities()");
-  txn.commit();
+  uint num_deleted;
+  {
+    auto txn = openTransaction();
+    // Remove all entities
+    num_deleted = txn->prepared("delete_all_entities").exec().affected_rows();
+    // Use the baked in function to get the default configuration back
+    txn->prepared("add_default_entities").exec();
+    txn->commit();
+  }
+  unloadConceptIndex();
+  unloadSpatialIndexes();
   assert(entityExists(1));
   return num_deleted;
 }
 
 bool LongTermMemoryConduitPostgreSQL::deleteAttribute(const string& name)
 {
-  pqxx::work txn{ *conn };
-  uint num_deleted = txn.exec("DELETE FROM attributes WHERE attribute_name = " + txn.quote(name)).affected_rows();
-  txn.commit();
+  auto txn = openTransaction();
+  uint num_deleted = txn->prepared("delete_attribute")(name).exec().affected_rows();
+  txn->commit();
+  if (name == "is_a")
+  {
+    unloadConceptIndex();
+  }
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  attribute_schema_generation++;
+  auto id = attribute_schema->ids.find(name);
+  if (id != attribute_schema->ids.end())
+  {
+    attribute_schema->names.erase(id->second);
+    attribute_schema->ids.erase(id);
+  }
+  attribute_schema->types.erase(name);
   return num_deleted;
 }
 
 bool LongTermMemoryConduitPostgreSQL::attributeExists(const string& name) const
 {
-  pqxx::work txn{ *conn, "attributeExists" };
-  auto result = txn.exec("SELECT count(*) FROM attributes WHERE attribute_name=" + txn.quote(name));
-  txn.commit();
-  return result[0]["count"].as<uint>() == 1;
+  return attributeType(name).is_initialized();
 }
 
-Concept LongTermMemoryConduitPostgreSQL::getConcept(const string& name)
+boost::optional<AttributeValueType> LongTermMemoryConduitPostgreSQL::attributeType(const string& name) const
 {
-  pqxx::work txn{ *conn, "getConcept" };
-  auto result = txn.exec("SELECT entity_id FROM concepts WHERE concept_name =" + txn.quote(name));
-  txn.commit();
+  auto key = attributeKey(name);
+  if (key)
+  {
+    return key->second;
+  }
+  return {};
+}
 
-  if (result.empty())
+boost::optional<std::pair<int, AttributeValueType>>
+LongTermMemoryConduitPostgreSQL::attributeKey(const string& name) const
+{
   {
-    Entity new_concept = addEntity();
-    pqxx::work txn{ *conn, "getConcept" };
-    auto result = txn.parameterized("INSERT INTO concepts VALUES ($1, $2)")(new_concept.entity_id)(name).exec();
-    txn.commit();
-    return { new_concept.entity_id, name, *this };
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    if (attribute_schema->loaded)
+    {
+      auto id = attribute_schema->ids.find(name);
+      if (id != attribute_schema->ids.end())
+      {
+        return std::make_pair(id->second, attribute_schema->types.at(name));
+      }
+      if (attribute_schema->loaded_generation == attribute_schema_generation)
+      {
+        // Already looked for since the schema last changed
+        return {};
+      }
+    }
   }
-  else
+  // Either the cache hasn't been loaded, or the attribute was added by someone else since it was
+  loadAttributeSchema();
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  auto id = attribute_schema->ids.find(name);
+  if (id != attribute_schema->ids.end())
+  {
+    return std::make_pair(id->second, attribute_schema->types.at(name));
+  }
+  return {};
+}
+
+AttributeString LongTermMemoryConduitPostgreSQL::attributeName(int id) const
+{
+  {
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    if (attribute_schema->loaded)
+    {
+      auto name = attribute_schema->names.find(id);
+      if (name != attribute_schema->names.end())
+      {
+        return name->second;
+      }
+      if (attribute_schema->loaded_generation == attribute_schema_generation)
+      {
+        throw std::out_of_range("No attribute with ID " + std::to_string(id));
+      }
+    }
+  }
+  loadAttributeSchema();
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  auto name = attribute_schema->names.find(id);
+  if (name == attribute_schema->names.end())
+  {
+    throw std::out_of_range("No attribute with ID " + std::to_string(id));
+  }
+  return name->second;
+}
+
+void LongTermMemoryConduitPostgreSQL::cacheAttribute(const string& name, int id, AttributeValueType type) const
+{
+  attribute_schema->types[name] = type;
+  attribute_schema->ids[name] = id;
+  attribute_schema->names[id] = name;
+}
+
+void LongTermMemoryConduitPostgreSQL::loadAttributeSchema() const
+{
+  uint64_t generation = attribute_schema_generation;
+  // The lock isn't held while querying, as waiting for a connection with it held could hold up every other thread
+  pqxx::result result;
+  {
+    auto txn = openTransaction("loadAttributeSchema");
+    result = txn->prepared("get_all_attributes").exec();
+    txn->commit();
+  }
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  attribute_schema->types.clear();
+  attribute_schema->ids.clear();
+  attribute_schema->names.clear();
+  for (const auto& row : result)
+  {
+    cacheAttribute(row["attribute_name"].as<string>(), row["attribute_id"].as<int>(),
+                   string_to_attribute_value_type[row["type"].as<string>()]);
+  }
+  attribute_schema->loaded = true;
+  // If the schema changed while we were reading, what we read may be missing it, so misses are looked up again
+  attribute_schema->loaded_generation = generation;
+}
+
+void LongTermMemoryConduitPostgreSQL::updateConceptIndex(const std::function<void(ConceptHierarchy&)>& update)
+{
+  changeConceptIndex([update](ConceptIndex& index) {
+    std::lock_guard<std::mutex> lock(index.mutex);
+    index.generation++;
+    if (index.loaded)
+    {
+      update(index.hierarchy);
+    }
+  });
+}
+
+void LongTermMemoryConduitPostgreSQL::unloadConceptIndex()
+{
+  changeConceptIndex([](ConceptIndex& index) {
+    std::lock_guard<std::mutex> lock(index.mutex);
+    index.generation++;
+    index.loaded = false;
+    index.hierarchy.clear();
+  });
+}
+
+void LongTermMemoryConduitPostgreSQL::changeConceptIndex(const std::function<void(ConceptIndex&)>& change)
+{
+  {
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+    if (thread != write_batches->by_thread.end())
+    {
+      // A fresh copy is loaded from inside the batch, so it sees the batch's earlier changes too
+      auto& own = thread->second.concept_index;
+      if (!own)
+      {
+        own.reset(new ConceptIndex());
+      }
+      change(*own);
+      thread->second.batches.back().concept_changes.push_back(change);
+      return;
+    }
+  }
+  change(*concept_index);
+}
+
+LongTermMemoryConduitPostgreSQL::ConceptIndex& LongTermMemoryConduitPostgreSQL::conceptIndex() const
+{
+  std::lock_guard<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+  if (thread != write_batches->by_thread.end() && thread->second.concept_index)
+  {
+    return *thread->second.concept_index;
+  }
+  return *concept_index;
+}
+
+void LongTermMemoryConduitPostgreSQL::querySpatialIndex(uint map_entity_id, uint map_id,
+                                                        const std::function<void(const MapSpatialIndex&)>& query)
+{
+  auto& indexes = spatialIndexes();
+  while (true)
   {
-    return { result[0]["entity_id"].as<uint>(), name, *this };
+    uint64_t generation;
+    {
+      std::lock_guard<std::mutex> lock(indexes.mutex);
+      auto index = indexes.by_map_id.find(map_id);
+      if (index != indexes.by_map_id.end())
+      {
+        query(index->second.second);
+        return;
+      }
+      generation = indexes.generation;
+    }
+    // The map's geometry is read and indexed without the lock held, as with the concept index
+    auto txn = openTransaction("loadSpatialIndex");
+    auto region_rows = txn->prepared("get_all_regions")(map_id).exec();
+    auto point_rows = txn->prepared("get_all_points")(map_id).exec();
+    auto pose_rows = txn->prepared("get_all_poses")(map_id).exec();
+    auto door_rows = txn->prepared("get_all_doors")(map_id).exec();
+    txn->commit();
+    vector<MapSpatialIndex::RegionEntry> regions;
+    regions.reserve(region_rows.size());
+    for (const auto& row : region_rows)
+    {
+      regions.push_back(
+          { row["entity_id"].as<uint>(), row["region_name"].as<string>(), strToPoints(row["region"].c_str()) });
+    }
+    vector<MapSpatialIndex::PointEntry> points;
+    points.reserve(point_rows.size());
+    for (const auto& row : point_rows)
+    {
+      points.push_back({ row["entity_id"].as<uint>(), row["point_name"].as<string>(), row["x"].as<double>(),
+                         row["y"].as<double>(), 0 });
+    }
+    vector<MapSpatialIndex::PointEntry> poses;
+    poses.reserve(pose_rows.size());
+    for (const auto& row : pose_rows)
+    {
+      poses.push_back({ row["entity_id"].as<uint>(), row["pose_name"].as<string>(), row["x"].as<double>(),
+                        row["y"].as<double>(), row["theta"].as<double>() });
+    }
+    vector<MapSpatialIndex::DoorEntry> doors;
+    doors.reserve(door_rows.size());
+    for (const auto& row : door_rows)
+    {
+      doors.push_back({ row["entity_id"].as<uint>(), row["door_name"].as<string>(), row["x_0"].as<double>(),
+                        row["y_0"].as<double>(), row["x_1"].as<double>(), row["y_1"].as<double>() });
+    }
+    MapSpatialIndex loaded;
+    loaded.reset(std::move(regions), std::move(points), std::move(poses), std::move(doors));
+
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    if (indexes.generation != generation)
+    {
+      // Something changed while we were reading, so what we read may already be out of date
+      continue;
+    }
+    auto& index = indexes.by_map_id[map_id];
+    index = std::make_pair(map_entity_id, std::move(loaded));
+    query(index.second);
+    return;
   }
 }
 
+void LongTermMemoryConduitPostgreSQL::updateSpatialIndex(uint map_id,
+                                                         const std::function<void(MapSpatialIndex&)>& update)
+{
+  changeSpatialIndexes([map_id, update](SpatialIndexes& indexes) {
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    indexes.generation++;
+    auto index = indexes.by_map_id.find(map_id);
+    if (index != indexes.by_map_id.end())
+    {
+      update(index->second.second);
+    }
+  });
+}
+
+void LongTermMemoryConduitPostgreSQL::removeFromSpatialIndexes(uint entity_id)
+{
+  changeSpatialIndexes([entity_id](SpatialIndexes& indexes) {
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    indexes.generation++;
+    auto& by_map_id = indexes.by_map_id;
+    for (auto index = by_map_id.begin(); index != by_map_id.end();)
+    {
+      if (index->second.first == entity_id)
+      {
+        index = by_map_id.erase(index);
+        continue;
+      }
+      index->second.second.removeEntity(entity_id);
+      ++index;
+    }
+  });
+}
+
+void LongTermMemoryConduitPostgreSQL::unloadSpatialIndexes()
+{
+  changeSpatialIndexes([](SpatialIndexes& indexes) {
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    indexes.generation++;
+    indexes.by_map_id.clear();
+  });
+}
+
+void LongTermMemoryConduitPostgreSQL::changeSpatialIndexes(const std::function<void(SpatialIndexes&)>& change)
+{
+  {
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+    if (thread != write_batches->by_thread.end())
+    {
+      auto& own = thread->second.spatial_indexes;
+      if (!own)
+      {
+        own.reset(new SpatialIndexes());
+      }
+      change(*own);
+      thread->second.batches.back().spatial_changes.push_back(change);
+      return;
+    }
+  }
+  change(*spatial_indexes);
+}
+
+LongTermMemoryConduitPostgreSQL::SpatialIndexes& LongTermMemoryConduitPostgreSQL::spatialIndexes() const
+{
+  std::lock_guard<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+  if (thread != write_batches->by_thread.end() && thread->second.spatial_indexes)
+  {
+    return *thread->second.spatial_indexes;
+  }
+  return *spatial_indexes;
+}
+
+Concept LongTermMemoryConduitPostgreSQL::getConcept(const string& name)
+{
+  // The lookup's connection goes back to the pool before addEntity takes one of its own
+  {
+    auto txn = openTransaction("getConcept");
+    auto result = txn->prepared("get_concept_by_name")(name).exec();
+    txn->commit();
+    if (!result.empty())
+    {
+      return { result[0]["entity_id"].as<uint>(), name, *this };
+    }
+  }
+  Entity new_concept = addEntity();
+  auto txn = openTransaction("getConcept");
+  txn->prepared("add_concept")(new_concept.entity_id)(name).exec();
+  txn->commit();
+  return { new_concept.entity_id, name, *this };
+}
+
 boost::optional<Instance> LongTermMemoryConduitPostgreSQL::getInstanceNamed(const Concept& concept, const string& name)
 {
-  pqxx::work txn{ *conn, "getInstanceNamed" };
-  auto result = txn.parameterized("SELECT entity_id FROM entity_attributes_str WHERE attribute_name = 'name' "
-                                  "AND attribute_value = $1 AND entity_id IN (SELECT entity_id FROM instance_of WHERE "
-                                  "concept_name = $2)")(name)(concept.getName())
-                    .exec();
-  txn.commit();
+  auto txn = openTransaction("getInstanceNamed");
+  auto result = txn->prepared("get_instance_named")(name)(concept.entity_id).exec();
+  txn->commit();
   if (result.empty())
   {
     return {};
@@ -325,9 +1158,9 @@ boost::optional<Instance> LongTermMemoryConduitPostgreSQL::getInstance(uint enti
 {
   try
   {
-    pqxx::work txn{ *conn, "getInstance" };
-    auto result = txn.parameterized("SELECT count(*) FROM instance_of WHERE entity_id = $1")(entity_id).exec();
-    txn.commit();
+    auto txn = openTransaction("getInstance");
+    auto result = txn->prepared("instance_exists")(entity_id).exec();
+    txn->commit();
     if (result[0]["count"].as<uint>() == 1)
     {
       return Instance{ entity_id, *this };
@@ -345,10 +1178,10 @@ boost::optional<Concept> LongTermMemoryConduitPostgreSQL::getConcept(uint entity
 {
   try
   {
-    pqxx::work txn{ *conn, "getConcept" };
+    auto txn = openTransaction("getConcept");
     // A simple count won't do because we need the name
-    auto result = txn.parameterized("SELECT concept_name FROM concepts WHERE entity_id = $1")(entity_id).exec();
-    txn.commit();
+    auto result = txn->prepared("get_concept_by_id")(entity_id).exec();
+    txn->commit();
     if (!result.empty())
     {
       return Concept{ entity_id, result[0]["concept_name"].as<string>(), *this };
@@ -366,10 +1199,10 @@ boost::optional<Map> LongTermMemoryConduitPostgreSQL::getMap(uint entity_id)
 {
   try
   {
-    pqxx::work txn{ *conn, "getMap" };
+    auto txn = openTransaction("getMap");
     // A simple count won't do because we need the name
-    auto result = txn.parameterized("SELECT map_name, map_id FROM maps WHERE entity_id = $1")(entity_id).exec();
-    txn.commit();
+    auto result = txn->prepared("get_map_by_id")(entity_id).exec();
+    txn->commit();
     if (!result.empty())
     {
       return Map{ entity_id, result[0]["map_id"].as<uint>(), result[0]["map_name"].as<string>(), *this };
@@ -387,17 +1220,14 @@ boost::optional<Point> LongTermMemoryConduitPostgreSQL::getPoint(uint entity_id)
 {
   try
   {
-    pqxx::work txn{ *conn, "getPoint" };
+    auto txn = openTransaction("getPoint");
     // A simple count won't do because we need the name
-    auto result = txn.parameterized("SELECT point_name, x, y, parent_map_id FROM points_xy WHERE "
-                                    "entity_id = $1")(entity_id)
-                      .exec();
-    txn.commit();
+    auto result = txn->prepared("get_point_by_id")(entity_id).exec();
+    txn->commit();
     if (!result.empty())
     {
-      auto parent_map = *getMapForMapId(result[0]["parent_map_id"].as<uint>());
       return Point(entity_id, result[0]["point_name"].as<string>(), result[0]["x"].as<double>(),
-                   result[0]["y"].as<double>(), parent_map, *this);
+                   result[0]["y"].as<double>(), parentMap(result[0], *this), *this);
     }
     return {};
   }
@@ -412,17 +1242,14 @@ boost::optional<Pose> LongTermMemoryConduitPostgreSQL::getPose(uint entity_id)
 {
   try
   {
-    pqxx::work txn{ *conn, "getPose" };
+    auto txn = openTransaction("getPose");
     // A simple count won't do because we need the name
-    auto result = txn.parameterized("SELECT entity_id, pose_name, parent_map_id, x, y, theta FROM poses_point_angle "
-                                    "WHERE entity_id = $1")(entity_id)
-                      .exec();
-    txn.commit();
+    auto result = txn->prepared("get_pose_by_id")(entity_id).exec();
+    txn->commit();
     if (!result.empty())
     {
-      auto parent_map = *getMapForMapId(result[0]["parent_map_id"].as<uint>());
       return Pose(entity_id, result[0]["pose_name"].as<string>(), result[0]["x"].as<double>(),
-                  result[0]["y"].as<double>(), result[0]["theta"].as<double>(), parent_map, *this);
+                  result[0]["y"].as<double>(), result[0]["theta"].as<double>(), parentMap(result[0], *this), *this);
     }
     return {};
   }
@@ -437,19 +1264,14 @@ boost::optional<Region> LongTermMemoryConduitPostgreSQL::getRegion(uint entity_i
 {
   try
   {
-    pqxx::work txn{ *conn, "getRegion" };
-    string query = "SELECT entity_id, region_name, region, parent_map_id "
-                   "FROM regions WHERE entity_id"
-                   "= $1";
-    auto result = txn.parameterized(query)(entity_id).exec();
-    txn.commit();
+    auto txn = openTransaction("getRegion");
+    auto result = txn->prepared("get_region_by_id")(entity_id).exec();
+    txn->commit();
     if (!result.empty())
     {
       auto region = result[0];
-      auto str = region["region"].as<string>();
-      const auto points = strToPoints(str);
-      auto parent_map = *getMapForMapId(result[0]["parent_map_id"].as<uint>());
-      return Region{ region["entity_id"].as<uint>(), region["region_name"].as<string>(), points, parent_map, *this };
+      return Region{ entity_id, region["region_name"].as<string>(), strToPoints(region["region"].c_str()),
+                     parentMap(region, *this), *this };
     }
     return {};
   }
@@ -464,23 +1286,19 @@ boost::optional<Door> LongTermMemoryConduitPostgreSQL::getDoor(uint entity_id)
 {
   try
   {
-    pqxx::work txn{ *conn, "getDoor" };
-    string query = "SELECT entity_id, door_name, x_0, y_0, x_1, y_1, parent_map_id "
-                   "FROM doors_points WHERE entity_id"
-                   "= $1";
-    auto result = txn.parameterized(query)(entity_id).exec();
-    txn.commit();
+    auto txn = openTransaction("getDoor");
+    auto result = txn->prepared("get_door_by_id")(entity_id).exec();
+    txn->commit();
     if (!result.empty())
     {
       auto door = result[0];
-      auto parent_map = *getMapForMapId(result[0]["parent_map_id"].as<uint>());
-      return Door{ door["entity_id"].as<uint>(),
+      return Door{ entity_id,
                    door["door_name"].as<string>(),
                    door["x_0"].as<double>(),
                    door["y_0"].as<double>(),
                    door["x_1"].as<double>(),
                    door["y_1"].as<double>(),
-                   parent_map,
+                   parentMap(door, *this),
                    *this };
     }
     return {};
@@ -501,87 +1319,486 @@ Instance LongTermMemoryConduitPostgreSQL::getRobot()
 
 Entity LongTermMemoryConduitPostgreSQL::addEntity()
 {
-  pqxx::work txn{ *conn, "addEntity" };
+  auto txn = openTransaction("addEntity");
 
-  auto result = txn.exec("INSERT INTO entities VALUES (DEFAULT) RETURNING entity_id");
-  txn.commit();
+  auto result = txn->prepared("add_entity").exec();
+  txn->commit();
   return { result[0]["entity_id"].as<uint>(), *this };
 }
 
 std::vector<Concept> LongTermMemoryConduitPostgreSQL::getAllConcepts()
 {
-  pqxx::work txn{ *conn, "getAllConcepts" };
-  auto result = txn.exec("SELECT entity_id, concept_name FROM concepts");
-  txn.commit();
+  auto txn = openTransaction("getAllConcepts");
+  auto result = txn->prepared("get_all_concepts").exec();
+  txn->commit();
   vector<Concept> concepts;
   for (const auto& row : result)
   {
-    concepts.emplace_back(row["entity_id"].as<uint>(), row["concept_name"].as<string>(), *this);
+    concepts.emplace_back(row["entity_id"].as<uint>(), row["concept_name"].as<string>(), *this);
+  }
+  return concepts;
+}
+
+std::vector<Instance> LongTermMemoryConduitPostgreSQL::getAllInstances()
+{
+  auto txn = openTransaction("getAllInstances");
+  auto result = txn->prepared("get_all_instances").exec();
+  txn->commit();
+  vector<Instance> instances;
+  for (const auto& row : result)
+  {
+    instances.emplace_back(row["entity_id"].as<uint>(), *this);
+  }
+  return instances;
+}
+
+template <typename T, typename Make>
+bool LongTermMemoryConduitPostgreSQL::readPage(const char* statement, uint after_id, size_t limit, vector<T>& page,
+                                               Make make)
+{
+  assert(limit > 0);
+  try
+  {
+    pqxx::result rows;
+    {
+      auto txn = openTransaction(statement);
+      rows = txn->prepared(statement)(after_id)(limit).exec();
+      txn->commit();
+    }
+    page.clear();
+    page.reserve(rows.size());
+    for (const auto& row : rows)
+    {
+      page.push_back(make(row));
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitPostgreSQL::getEntityPage(uint after_id, size_t limit, vector<Entity>& page)
+{
+  return readPage("scan_entities", after_id, limit, page,
+                  [this](const pqxx::row& row) { return Entity(row["entity_id"].as<uint>(), *this); });
+}
+
+bool LongTermMemoryConduitPostgreSQL::getConceptPage(uint after_id, size_t limit, vector<Concept>& page)
+{
+  return readPage("scan_concepts", after_id, limit, page, [this](const pqxx::row& row) {
+    return Concept(row["entity_id"].as<uint>(), row["concept_name"].as<string>(), *this);
+  });
+}
+
+bool LongTermMemoryConduitPostgreSQL::getInstancePage(uint after_id, size_t limit, vector<Instance>& page)
+{
+  return readPage("scan_instances", after_id, limit, page,
+                  [this](const pqxx::row& row) { return Instance(row["entity_id"].as<uint>(), *this); });
+}
+
+bool LongTermMemoryConduitPostgreSQL::forEachEntityBatch(const std::function<void(vector<Entity>&)>& callback,
+                                                         size_t batch_size)
+{
+  return forEachPage<Entity>(
+      [this](uint after_id, size_t limit, vector<Entity>& page) { return getEntityPage(after_id, limit, page); },
+      batch_size, callback);
+}
+
+bool LongTermMemoryConduitPostgreSQL::forEachConceptBatch(const std::function<void(vector<Concept>&)>& callback,
+                                                          size_t batch_size)
+{
+  return forEachPage<Concept>(
+      [this](uint after_id, size_t limit, vector<Concept>& page) { return getConceptPage(after_id, limit, page); },
+      batch_size, callback);
+}
+
+bool LongTermMemoryConduitPostgreSQL::forEachInstanceBatch(const std::function<void(vector<Instance>&)>& callback,
+                                                           size_t batch_size)
+{
+  return forEachPage<Instance>(
+      [this](uint after_id, size_t limit, vector<Instance>& page) { return getInstancePage(after_id, limit, page); },
+      batch_size, callback);
+}
+
+vector<std::pair<string, AttributeValueType>> LongTermMemoryConduitPostgreSQL::getAllAttributes() const
+{
+  bool loaded;
+  {
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    loaded = attribute_schema->loaded;
+  }
+  if (!loaded)
+  {
+    loadAttributeSchema();
+  }
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  return { attribute_schema->types.begin(), attribute_schema->types.end() };
+}
+
+// MAP
+Map LongTermMemoryConduitPostgreSQL::getMap(const std::string& name)
+{
+  // As in getConcept, the lookup's connection is returned before creating the map takes more
+  {
+    auto txn = openTransaction("getMap");
+    auto result = txn->prepared("get_map_by_name")(name).exec();
+    txn->commit();
+    if (!result.empty())
+    {
+      return { result[0]["entity_id"].as<uint>(), result[0]["map_id"].as<uint>(), name, *this };
+    }
+  }
+  Concept map_concept = getConcept("map");
+  // This should succeed because we would've retrieved it above if such an instance existed
+  Instance new_map = map_concept.createInstance(name).get();
+  auto txn = openTransaction("getMap");
+  auto result = txn->prepared("add_map")(new_map.entity_id)(name).exec();
+  txn->commit();
+  return { new_map.entity_id, result[0]["map_id"].as<uint>(), name, *this };
+}
+
+vector<EntityAttribute> LongTermMemoryConduitPostgreSQL::getAllEntityAttributes()
+{
+  std::vector<EntityAttribute> entity_attrs;
+  forEachEntityAttributeBatch([&entity_attrs](vector<EntityAttribute>& batch) {
+    entity_attrs.insert(entity_attrs.end(), std::make_move_iterator(batch.begin()),
+                        std::make_move_iterator(batch.end()));
+  });
+  return entity_attrs;
+}
+
+bool LongTermMemoryConduitPostgreSQL::getAllEntityAttributes(AttributeBatch& attributes) const
+{
+  attributes.clear();
+  return scanEntityAttributes<AttributeBatch>([&attributes](AttributeBatch& batch) { attributes.append(batch); },
+                                              10000);
+}
+
+bool LongTermMemoryConduitPostgreSQL::forEachEntityAttributeBatch(
+    const std::function<void(std::vector<EntityAttribute>&)>& callback, size_t batch_size) const
+{
+  return scanEntityAttributes(callback, batch_size);
+}
+
+bool LongTermMemoryConduitPostgreSQL::forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                                                  size_t batch_size) const
+{
+  return scanEntityAttributes(callback, batch_size);
+}
+
+template <typename Attributes>
+bool LongTermMemoryConduitPostgreSQL::scanEntityAttributes(const std::function<void(Attributes&)>& callback,
+                                                           size_t batch_size) const
+{
+  assert(batch_size > 0);
+  try
+  {
+    // Pages are named once their transaction has closed, but loading the names now saves doing it mid-scan
+    loadAttributeSchema();
+    Attributes batch;
+    scanAttributeTable<Attributes, int>("scan_attributes_id", "id_value", batch_size, callback, batch);
+    scanAttributeTable<Attributes, bool>("scan_attributes_bool", "bool_value", batch_size, callback, batch);
+    scanAttributeTable<Attributes, int>("scan_attributes_int", "int_value", batch_size, callback, batch);
+    scanAttributeTable<Attributes, double>("scan_attributes_float", "float_value", batch_size, callback, batch);
+    scanAttributeTable<Attributes, string>("scan_attributes_str", "str_value", batch_size, callback, batch);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+template <typename Attributes, typename Value>
+void LongTermMemoryConduitPostgreSQL::scanAttributeTable(const char* statement, const char* value_column,
+                                                         size_t batch_size,
+                                                         const std::function<void(Attributes&)>& callback,
+                                                         Attributes& batch) const
+{
+  // Every entity ID is positive, so the first page starts from the beginning whatever the value
+  uint entity_id = 0;
+  int attribute_id = 0;
+  Value value{};
+  while (true)
+  {
+    pqxx::result rows;
+    {
+      auto txn = openTransaction("forEachEntityAttributeBatch");
+      rows = txn->prepared(statement)(entity_id)(attribute_id)(value)(batch_size).exec();
+      txn->commit();
+    }
+    if (rows.empty())
+    {
+      return;
+    }
+    const auto last = rows[rows.size() - 1];
+    entity_id = last["entity_id"].as<uint>();
+    attribute_id = last["attribute_id"].as<int>();
+    value = last[value_column].as<Value>();
+    batch.clear();
+    unwrap_attribute_rows(rows, batch, [this](int id) { return attributeName(id); });
+    callback(batch);
+    if (rows.size() < batch_size)
+    {
+      return;
+    }
+  }
+}
+
+bool LongTermMemoryConduitPostgreSQL::bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result)
+{
+  try
+  {
+    auto txn = openTransaction("bulkLoad");
+
+    // Everything that already exists is resolved in a couple of queries, and everything else is created with IDs
+    // reserved up front, so names never need a round trip of their own
+    std::unordered_map<string, uint> concept_ids;
+    for (const auto& row : txn->prepared("get_all_concepts").exec())
+    {
+      concept_ids.emplace(row["concept_name"].as<string>(), row["entity_id"].as<uint>());
+    }
+    std::unordered_map<string, uint> instance_ids;
+    for (const auto& row : txn->prepared("get_named_instances").exec())
+    {
+      instance_ids.emplace(instanceKey(row["name"].as<string>(), row["concept_name"].as<string>()),
+                           row["entity_id"].as<uint>());
+    }
+    std::unordered_map<string, std::pair<string, AttributeValueType>> attribute_keys;
+    for (const auto& row : txn->prepared("get_all_attributes").exec())
+    {
+      attribute_keys.emplace(row["attribute_name"].as<string>(),
+                             std::make_pair(row["attribute_id"].as<string>(),
+                                            string_to_attribute_value_type[row["type"].as<string>()]));
+    }
+
+    // Collect the names that don't exist yet, in the order they first appear. A zero ID marks a pending entity.
+    vector<string> new_concepts;
+    vector<BulkEntityRef> new_instances;
+    auto need_concept = [&](const string& name) {
+      if (concept_ids.emplace(name, 0).second)
+      {
+        new_concepts.push_back(name);
+      }
+    };
+    auto need_entity = [&](const BulkEntityRef& ref) {
+      need_concept(ref.isConcept() ? ref.name : ref.concept_name);
+      if (!ref.isConcept() && instance_ids.emplace(instanceKey(ref.name, ref.concept_name), 0).second)
+      {
+        new_instances.push_back(ref);
+      }
+    };
+    for (const auto& name : knowledge.concepts)
+    {
+      need_concept(name);
+    }
+    for (const auto& instance : knowledge.instances)
+    {
+      need_entity(instance);
+    }
+    for (const auto& instance_of : knowledge.instance_of)
+    {
+      need_entity(instance_of.first);
+      need_concept(instance_of.second);
+    }
+    for (const auto& attribute : knowledge.attributes)
+    {
+      need_entity(attribute.entity);
+      if (attribute.value_entity)
+      {
+        need_entity(*attribute.value_entity);
+      }
+    }
+
+    auto reserved = txn->prepared("reserve_entity_ids")(new_concepts.size() + new_instances.size()).exec();
+    size_t next_id = 0;
+    vector<vector<string>> entity_rows;
+    vector<vector<string>> concept_rows;
+    vector<vector<string>> instance_of_rows;
+    vector<vector<string>> attribute_rows[5];
+    for (const auto& name : new_concepts)
+    {
+      auto id = reserved[next_id++]["entity_id"].as<uint>();
+      concept_ids[name] = id;
+      entity_rows.push_back({ pqxx::to_string(id) });
+      concept_rows.push_back({ pqxx::to_string(id), name });
+    }
+    for (const auto& instance : new_instances)
+    {
+      auto id = reserved[next_id++]["entity_id"].as<uint>();
+      instance_ids[instanceKey(instance.name, instance.concept_name)] = id;
+      entity_rows.push_back({ pqxx::to_string(id) });
+      instance_of_rows.push_back({ pqxx::to_string(id), pqxx::to_string(concept_ids.at(instance.concept_name)) });
+      attribute_rows[Str].push_back({ pqxx::to_string(id), attribute_keys.at("name").first, instance.name });
+    }
+
+    auto resolve = [&](const BulkEntityRef& ref) {
+      return ref.isConcept() ? concept_ids.at(ref.name) : instance_ids.at(instanceKey(ref.name, ref.concept_name));
+    };
+    for (const auto& instance_of : knowledge.instance_of)
+    {
+      instance_of_rows.push_back(
+          { pqxx::to_string(resolve(instance_of.first)), pqxx::to_string(concept_ids.at(instance_of.second)) });
+    }
+    for (const auto& attribute : knowledge.attributes)
+    {
+      auto key = attribute_keys.find(attribute.attribute_name);
+      if (key == attribute_keys.end())
+      {
+        throw std::invalid_argument("No attribute named " + attribute.attribute_name);
+      }
+      auto type = key->second.second;
+      auto value = attribute.value_entity ? AttributeValue(resolve(*attribute.value_entity)) : attribute.value;
+      attribute_rows[type].push_back(
+          { pqxx::to_string(resolve(attribute.entity)), key->second.first, toCopyField(value, type) });
+    }
+
+    // Fresh entities can't collide with anything, so they go straight into their tables
+    copyRows(*txn, "entities", entity_rows);
+    copyRows(*txn, "concepts", concept_rows);
+
+    // Rows that may already exist are staged first so duplicates can be skipped instead of failing the whole load
+    std::pair<string, const vector<vector<string>>*> staged[] = { { "instance_of", &instance_of_rows },
+                                                                  { "entity_attributes_id", &attribute_rows[Id] },
+                                                                  { "entity_attributes_bool", &attribute_rows[Bool] },
+                                                                  { "entity_attributes_int", &attribute_rows[Int] },
+                                                                  { "entity_attributes_float", &attribute_rows[Float] },
+                                                                  { "entity_attributes_str", &attribute_rows[Str] } };
+    for (const auto& table : staged)
+    {
+      if (table.second->empty())
+      {
+        continue;
+      }
+      auto staging_table = "bulk_load_" + table.first;
+      txn->exec("CREATE TEMPORARY TABLE " + staging_table + " (LIKE " + table.first + ")");
+      copyRows(*txn, staging_table, *table.second);
+      txn->exec("INSERT INTO " + table.first + " SELECT DISTINCT * FROM " + staging_table + " ON CONFLICT DO NOTHING");
+      txn->exec("DROP TABLE " + staging_table);
+    }
+    txn->commit();
+    unloadConceptIndex();
+    unloadSpatialIndexes();
+
+    result.concept_ids.clear();
+    result.instance_ids.clear();
+    for (const auto& name : knowledge.concepts)
+    {
+      result.concept_ids.push_back(concept_ids.at(name));
+    }
+    for (const auto& instance : knowledge.instances)
+    {
+      result.instance_ids.push_back(resolve(instance));
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
   }
-  return concepts;
+  return true;
 }
 
-std::vector<Instance> LongTermMemoryConduitPostgreSQL::getAllInstances()
+/**
+ * @brief Formats entities' IDs as an array literal, for binding to an int[] parameter
+ */
+template <typename Entities>
+string idArray(const Entities& entities)
 {
-  pqxx::work txn{ *conn, "getAllInstances" };
-  auto result = txn.exec("SELECT entity_id FROM entities WHERE entity_id NOT IN ("
-                         "SELECT entity_id FROM concepts)");
-  txn.commit();
-  vector<Instance> instances;
-  for (const auto& row : result)
+  string array = "{";
+  for (const auto& entity : entities)
   {
-    instances.emplace_back(row["entity_id"].as<uint>(), *this);
+    if (array.size() > 1)
+    {
+      array += ',';
+    }
+    array += std::to_string(entity.entity_id);
   }
-  return instances;
+  return array + "}";
 }
 
-vector<std::pair<string, AttributeValueType>> LongTermMemoryConduitPostgreSQL::getAllAttributes() const
+vector<vector<Concept>> LongTermMemoryConduitPostgreSQL::getConceptsRecursive(const vector<Instance>& instances)
 {
-  vector<std::pair<string, AttributeValueType>> attribute_names;
-  pqxx::work txn{ *conn, "getAllAttributes" };
-  auto result = txn.exec("TABLE attributes");
-  txn.commit();
-  for (const auto& row : result)
+  try
   {
-    attribute_names.emplace_back(row["attribute_name"].as<string>(),
-                                 string_to_attribute_value_type[row["type"].as<string>()]);
+    auto txn = openTransaction("getConceptsRecursive");
+    auto result = txn->prepared("get_concepts_recursive_batch")(idArray(instances)).exec();
+    txn->commit();
+    std::unordered_map<uint, vector<Concept>> by_instance;
+    for (const auto& row : result)
+    {
+      by_instance[row["instance_id"].as<uint>()].emplace_back(row["entity_id"].as<uint>(),
+                                                              row["concept_name"].as<string>(), *this);
+    }
+    vector<vector<Concept>> concepts;
+    concepts.reserve(instances.size());
+    for (const auto& instance : instances)
+    {
+      auto found = by_instance.find(instance.entity_id);
+      concepts.push_back(found != by_instance.end() ? found->second : vector<Concept>{});
+    }
+    return concepts;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
   }
-  return attribute_names;
 }
 
-// MAP
-Map LongTermMemoryConduitPostgreSQL::getMap(const std::string& name)
+bool LongTermMemoryConduitPostgreSQL::getAttributes(const vector<Entity>& entities, AttributeBatch& attributes) const
 {
-  pqxx::work txn{ *conn, "getMap" };
-  auto result = txn.parameterized("SELECT entity_id, map_id FROM maps WHERE map_name = $1")(name).exec();
-  txn.commit();
-
-  if (result.empty())
+  try
   {
-    Concept map_concept = getConcept("map");
-    // This should succeed because we would've retrieved it above if such an instance existed
-    Instance new_map = map_concept.createInstance(name).get();
-    pqxx::work txn{ *conn, "getMap" };
-    auto result =
-        txn.parameterized("INSERT INTO maps VALUES ($1, DEFAULT, $2) RETURNING map_id")(new_map.entity_id)(name).exec();
-    txn.commit();
-    return { new_map.entity_id, result[0]["map_id"].as<uint>(), name, *this };
+    pqxx::result result;
+    {
+      auto txn = openTransaction("getAttributes");
+      result = txn->prepared("get_attributes_batch")(idArray(entities)).exec();
+      txn->commit();
+    }
+    // Naming an attribute may load the schema, which needs a connection of its own
+    unwrap_attribute_rows(result, attributes, [this](int id) { return attributeName(id); });
   }
-  else
+  catch (const std::exception& e)
   {
-    return { result[0]["entity_id"].as<uint>(), result[0]["map_id"].as<uint>(), name, *this };
+    std::cerr << e.what() << std::endl;
+    return false;
   }
+  return true;
 }
 
-vector<EntityAttribute> LongTermMemoryConduitPostgreSQL::getAllEntityAttributes()
+vector<Instance> LongTermMemoryConduitPostgreSQL::filterInstancesOf(const vector<Instance>& instances,
+                                                                    const Concept& concept)
 {
-  std::vector<EntityAttribute> entity_attrs;
-  for (const auto entity : this->getAllEntities())
+  try
   {
-    auto attrs = entity.getAttributes();
-    entity_attrs.insert(entity_attrs.end(), attrs.begin(), attrs.end());
+    auto txn = openTransaction("filterInstancesOf");
+    auto result = txn->prepared("filter_instances_of")(idArray(instances))(concept.entity_id).exec();
+    txn->commit();
+    std::unordered_set<uint> matching;
+    for (const auto& row : result)
+    {
+      matching.insert(row["entity_id"].as<uint>());
+    }
+    vector<Instance> filtered;
+    for (const auto& instance : instances)
+    {
+      if (matching.count(instance.entity_id) == 1)
+      {
+        filtered.push_back(instance);
+      }
+    }
+    return filtered;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
   }
-  return entity_attrs;
 }
 
 // PROMOTERS
@@ -590,9 +1807,9 @@ bool LongTermMemoryConduitPostgreSQL::makeConcept(uint id, std::string name)
 {
   try
   {
-    pqxx::work txn{ *conn, "makeConcept" };
-    auto result = txn.parameterized("INSERT INTO concepts VALUES ($1, $2)")(id)(name).exec();
-    txn.commit();
+    auto txn = openTransaction("makeConcept");
+    auto result = txn->prepared("add_concept")(id)(name).exec();
+    txn->commit();
     return result.affected_rows() == 1;
   }
   catch (const std::exception& e)
@@ -615,9 +1832,16 @@ bool LongTermMemoryConduitPostgreSQL::deleteEntity(Entity& entity)
   // this should clear out any references to this entity in other tables as well
   try
   {
-    pqxx::work txn{ *conn, "deleteEntity" };
-    auto result = txn.exec("DELETE FROM entities WHERE entity_id = " + txn.quote(entity.entity_id));
-    txn.commit();
+    auto txn = openTransaction("deleteEntity");
+    auto result = txn->prepared("delete_entity")(entity.entity_id).exec();
+    txn->commit();
+    // The delete may have cascaded to other instances, as when a map takes its geometry with it
+    uint entity_id = entity.entity_id;
+    updateConceptIndex([entity_id](ConceptHierarchy& hierarchy) {
+      hierarchy.removeEntity(entity_id);
+      hierarchy.forgetInstances();
+    });
+    removeFromSpatialIndexes(entity_id);
     return result.affected_rows() == 1;
   }
   catch (const std::exception& e)
@@ -627,15 +1851,32 @@ bool LongTermMemoryConduitPostgreSQL::deleteEntity(Entity& entity)
   }
 }
 
-bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::string& attribute_name,
-                                                   const uint other_entity_id)
+bool LongTermMemoryConduitPostgreSQL::addAttributeValue(Entity& entity, const std::string& attribute_name,
+                                                        const AttributeValue& value)
 {
   try
   {
-    pqxx::work txn{ *conn, "addAttribute (id)" };
-    auto result = txn.exec("INSERT INTO entity_attributes_id VALUES (" + txn.quote(entity.entity_id) + ", " +
-                           txn.quote(attribute_name) + ", " + txn.quote(other_entity_id) + ")");
-    txn.commit();
+    // Checked against the schema cache, so writes that could never succeed don't cost a round trip
+    auto key = attributeKey(attribute_name);
+    if (!key)
+    {
+      return false;
+    }
+    auto converted = convertAttributeValue(value, key->second);
+    if (!converted)
+    {
+      return false;
+    }
+    auto statement = "add_attribute_" + attribute_value_type_to_string[key->second];
+    auto txn = openTransaction("addAttribute");
+    auto result = bindValue(txn->prepared(statement)(entity.entity_id)(key->first), *converted).exec();
+    txn->commit();
+    if (attribute_name == "is_a" && key->second == Id)
+    {
+      uint child = entity.entity_id;
+      uint parent = converted->get<uint>();
+      updateConceptIndex([child, parent](ConceptHierarchy& hierarchy) { hierarchy.addIsA(child, parent); });
+    }
     return result.affected_rows() == 1;
   }
   catch (const std::exception& e)
@@ -645,92 +1886,57 @@ bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::st
   }
 }
 
+bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::string& attribute_name,
+                                                   const uint other_entity_id)
+{
+  return addAttributeValue(entity, attribute_name, AttributeValue(other_entity_id));
+}
+
 bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::string& attribute_name,
                                                    const bool bool_val)
 {
-  try
-  {
-    pqxx::work txn{ *conn, "addAttribute (bool)" };
-    auto result =
-        txn.exec("INSERT INTO entity_attributes_bool "
-                 "VALUES (" +
-                 txn.quote(entity.entity_id) + ", " + txn.quote(attribute_name) + ", " + txn.quote(bool_val) + ")");
-    txn.commit();
-    return result.affected_rows() == 1;
-  }
-  catch (const std::exception& e)
-  {
-    std::cerr << e.what() << std::endl;
-    return false;
-  }
+  return addAttributeValue(entity, attribute_name, AttributeValue(bool_val));
 }
 
 bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::string& attribute_name, const int int_val)
 {
-  try
-  {
-    pqxx::work txn{ *conn, "addAttribute (int)" };
-    auto result = txn.parameterized("INSERT INTO entity_attributes_int "
-                                    "VALUES ($1, $2, $3)")(entity.entity_id)(attribute_name)(int_val)
-                      .exec();
-    txn.commit();
-    return result.affected_rows() == 1;
-  }
-  catch (const std::exception& e)
-  {
-    std::cerr << e.what() << std::endl;
-    return false;
-  }
+  return addAttributeValue(entity, attribute_name, AttributeValue(int_val));
 }
 
 bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::string& attribute_name,
                                                    const double float_val)
 {
-  try
-  {
-    pqxx::work txn{ *conn, "addAttribute (float)" };
-    auto result = txn.parameterized("INSERT INTO entity_attributes_float "
-                                    "VALUES ($1, $2, $3)")(entity.entity_id)(attribute_name)(float_val)
-                      .exec();
-    txn.commit();
-    return result.affected_rows() == 1;
-  }
-  catch (const std::exception& e)
-  {
-    std::cerr << e.what() << std::endl;
-    return false;
-  }
+  return addAttributeValue(entity, attribute_name, AttributeValue(float_val));
 }
 
 bool LongTermMemoryConduitPostgreSQL::addAttribute(Entity& entity, const std::string& attribute_name,
                                                    const std::string& string_val)
 {
-  try
-  {
-    pqxx::work txn{ *conn, "addAttribute (str)" };
-    auto result = txn.parameterized("INSERT INTO entity_attributes_str "
-                                    "VALUES ($1, $2, $3)")(entity.entity_id)(attribute_name)(string_val)
-                      .exec();
-    txn.commit();
-    return result.affected_rows() == 1;
-  }
-  catch (const std::exception& e)
+  // The schema stores values as varchar(24), so longer ones can't be stored
+  if (!fitsAttributeString(string_val))
   {
-    std::cerr << e.what() << std::endl;
     return false;
   }
+  return addAttributeValue(entity, attribute_name, AttributeValue(string_val));
 }
 
 int LongTermMemoryConduitPostgreSQL::removeAttribute(Entity& entity, const std::string& attribute_name)
 {
-  string query;
-  pqxx::work txn{ *conn, "removeAttribute" };
+  auto key = attributeKey(attribute_name);
+  if (!key)
+  {
+    return 0;
+  }
+  auto txn = openTransaction("removeAttribute");
   try
   {
-    auto result = txn.parameterized("SELECT * FROM remove_attribute"
-                                    "($1, $2) AS count")(entity.entity_id)(attribute_name)
-                      .exec();
-    txn.commit();
+    auto result = txn->prepared("remove_attribute")(entity.entity_id)(key->first).exec();
+    txn->commit();
+    if (attribute_name == "is_a")
+    {
+      uint child = entity.entity_id;
+      updateConceptIndex([child](ConceptHierarchy& hierarchy) { hierarchy.removeIsA(child); });
+    }
     return result[0]["count"].as<int>();
   }
   catch (const std::exception& e)
@@ -746,65 +1952,23 @@ int LongTermMemoryConduitPostgreSQL::removeAttributeOfValue(Entity& entity, cons
   assert(false);
 }
 
-void unwrap_attribute_rows(const pqxx::result& rows, vector<EntityAttribute>& entity_attributes)
-{
-  pqxx::oid type = rows[0]["attribute_value"].type();
-  if (type == 23)
-  {
-    for (const auto& row : rows)
-    {
-      entity_attributes.emplace_back(row["entity_id"].as<uint>(), row["attribute_name"].as<string>(),
-                                     row["attribute_value"].as<int>());
-    }
-  }
-  else if (type == 1043)
-  {
-    for (const auto& row : rows)
-    {
-      entity_attributes.emplace_back(row["entity_id"].as<uint>(), row["attribute_name"].as<string>(),
-                                     row["attribute_value"].as<string>());
-    }
-  }
-  else if (type == 701)
-  {
-    for (const auto& row : rows)
-    {
-      entity_attributes.emplace_back(row["entity_id"].as<uint>(), row["attribute_name"].as<string>(),
-                                     row["attribute_value"].as<double>());
-    }
-  }
-  else if (type == 16)
-  {
-    for (const auto& row : rows)
-    {
-      entity_attributes.emplace_back(row["entity_id"].as<uint>(), row["attribute_name"].as<string>(),
-                                     row["attribute_value"].as<bool>());
-    }
-  }
-  else
-  {
-    assert(false);
-  }
-}
-
 vector<EntityAttribute> LongTermMemoryConduitPostgreSQL::getAttributes(const Entity& entity) const
 {
   vector<EntityAttribute> attributes;
-  for (const auto& name : TABLE_NAMES)
+  try
   {
-    try
-    {
-      pqxx::work txn{ *conn, "getAttributes" };
-      auto result =
-          txn.parameterized("SELECT * FROM " + std::string(name) + " WHERE entity_id = $1")(entity.entity_id).exec();
-      txn.commit();
-      unwrap_attribute_rows(result, attributes);
-    }
-    catch (const std::exception& e)
+    pqxx::result result;
     {
-      std::cerr << e.what() << std::endl;
-      return {};
+      auto txn = openTransaction("getAttributes");
+      result = txn->prepared("get_attributes")(entity.entity_id).exec();
+      txn->commit();
     }
+    unwrap_attribute_rows(result, attributes, [this](int id) { return attributeName(id); });
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
   }
   return attributes;
 }
@@ -813,22 +1977,25 @@ std::vector<EntityAttribute> LongTermMemoryConduitPostgreSQL::getAttributes(cons
                                                                             const std::string& attribute_name) const
 {
   vector<EntityAttribute> attributes;
-  for (const auto& name : TABLE_NAMES)
+  try
   {
-    try
+    auto key = attributeKey(attribute_name);
+    if (!key)
     {
-      pqxx::work txn{ *conn, "getAttributes" };
-      auto result = txn.parameterized("SELECT * FROM " + std::string(name) +
-                                      " WHERE entity_id = $1 AND attribute_name = $2")(entity.entity_id)(attribute_name)
-                        .exec();
-      txn.commit();
-      unwrap_attribute_rows(result, attributes);
+      return {};
     }
-    catch (const std::exception& e)
+    pqxx::result result;
     {
-      std::cerr << e.what() << std::endl;
-      return {};
+      auto txn = openTransaction("getAttributes");
+      result = txn->prepared("get_named_attributes")(entity.entity_id)(key->first).exec();
+      txn->commit();
     }
+    unwrap_attribute_rows(result, attributes, [this](int id) { return attributeName(id); });
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
   }
   return attributes;
 }
@@ -844,12 +2011,9 @@ std::vector<Concept> LongTermMemoryConduitPostgreSQL::getConcepts(const Instance
 {
   try
   {
-    pqxx::work txn{ *conn, "getConcepts" };
-    auto result = txn.parameterized("SELECT concepts.entity_id, concepts.concept_name FROM instance_of "
-                                    "INNER JOIN concepts ON concepts.concept_name = instance_of.concept_name "
-                                    "WHERE instance_of.entity_id = $1")(instance.entity_id)
-                      .exec();
-    txn.commit();
+    auto txn = openTransaction("getConcepts");
+    auto result = txn->prepared("get_concepts")(instance.entity_id).exec();
+    txn->commit();
     std::vector<Concept> concepts{};
     for (const auto& row : result)
     {
@@ -868,9 +2032,9 @@ std::vector<Concept> LongTermMemoryConduitPostgreSQL::getConceptsRecursive(const
 {
   try
   {
-    pqxx::work txn{ *conn, "getConceptsRecursive" };
-    auto result = txn.parameterized("SELECT * FROM get_concepts_recursive($1)")(instance.entity_id).exec();
-    txn.commit();
+    auto txn = openTransaction("getConceptsRecursive");
+    auto result = txn->prepared("get_concepts_recursive")(instance.entity_id).exec();
+    txn->commit();
     std::vector<Concept> concepts{};
     for (const auto& row : result)
     {
@@ -889,10 +2053,14 @@ bool LongTermMemoryConduitPostgreSQL::makeInstanceOf(Instance& instance, const C
 {
   try
   {
-    pqxx::work txn{ *conn, "makeInstanceOf" };
-    auto result =
-        txn.parameterized("INSERT INTO instance_of VALUES ($1,$2) ")(instance.entity_id)(concept.getName()).exec();
-    txn.commit();
+    auto txn = openTransaction("makeInstanceOf");
+    auto result = txn->prepared("make_instance_of")(instance.entity_id)(concept.entity_id).exec();
+    txn->commit();
+    uint instance_id = instance.entity_id;
+    uint concept_id = concept.entity_id;
+    updateConceptIndex([instance_id, concept_id](ConceptHierarchy& hierarchy) {
+      hierarchy.addConcept(instance_id, concept_id);
+    });
     return result.affected_rows() == 1;
   }
   catch (const std::exception& e)
@@ -902,18 +2070,78 @@ bool LongTermMemoryConduitPostgreSQL::makeInstanceOf(Instance& instance, const C
   }
 }
 
+bool LongTermMemoryConduitPostgreSQL::hasConceptRecursively(const Instance& instance, const Concept& concept)
+{
+  try
+  {
+    auto& index = conceptIndex();
+    while (true)
+    {
+      bool loaded;
+      uint64_t generation;
+      {
+        std::lock_guard<std::mutex> lock(index.mutex);
+        const auto& hierarchy = index.hierarchy;
+        if (index.loaded && hierarchy.knowsInstance(instance.entity_id))
+        {
+          return hierarchy.instanceOf(instance.entity_id, concept.entity_id);
+        }
+        loaded = index.loaded;
+        generation = index.generation;
+      }
+      // Whatever the index is missing is read without the lock held, as with the attribute schema
+      auto txn = openTransaction("hasConceptRecursively");
+      pqxx::result is_a_rows;
+      if (!loaded)
+      {
+        is_a_rows = txn->prepared("get_is_a_relations").exec();
+      }
+      auto concept_rows = txn->prepared("get_concepts")(instance.entity_id).exec();
+      txn->commit();
+
+      std::lock_guard<std::mutex> lock(index.mutex);
+      if (index.generation != generation)
+      {
+        // Something changed while we were reading, so what we read may already be out of date
+        continue;
+      }
+      auto& hierarchy = index.hierarchy;
+      if (!loaded)
+      {
+        vector<std::pair<uint, uint>> is_a;
+        is_a.reserve(is_a_rows.size());
+        for (const auto& row : is_a_rows)
+        {
+          is_a.emplace_back(row["entity_id"].as<uint>(), row["attribute_value"].as<uint>());
+        }
+        hierarchy.reset(is_a);
+        index.loaded = true;
+      }
+      vector<uint> concept_ids;
+      for (const auto& row : concept_rows)
+      {
+        concept_ids.push_back(row["entity_id"].as<uint>());
+      }
+      hierarchy.setConcepts(instance.entity_id, std::move(concept_ids));
+      return hierarchy.instanceOf(instance.entity_id, concept.entity_id);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
 // CONCEPT BACKERS
 
 vector<Concept> LongTermMemoryConduitPostgreSQL::getChildren(const Concept& concept)
 {
   try
   {
-    pqxx::work txn{ *conn, "getChildren" };
-    auto result = txn.parameterized("SELECT concepts.entity_id, concept_name FROM entity_attributes_id eai"
-                                    " INNER JOIN concepts ON eai.entity_id = concepts.entity_id WHERE attribute_name = "
-                                    "'is_a' AND attribute_value = $1")(concept.entity_id)
-                      .exec();
-    txn.commit();
+    auto txn = openTransaction("getChildren");
+    auto result = txn->prepared("get_children")(concept.entity_id).exec();
+    txn->commit();
     std::vector<Concept> concepts{};
     for (const auto& row : result)
     {
@@ -932,9 +2160,9 @@ vector<Concept> LongTermMemoryConduitPostgreSQL::getChildrenRecursive(const Conc
 {
   try
   {
-    pqxx::work txn{ *conn, "getChildrenRecursive" };
-    auto result = txn.parameterized("SELECT * FROM get_all_concept_descendants($1)")(concept.entity_id).exec();
-    txn.commit();
+    auto txn = openTransaction("getChildrenRecursive");
+    auto result = txn->prepared("get_children_recursive")(concept.entity_id).exec();
+    txn->commit();
     std::vector<Concept> concepts{};
     for (const auto& row : result)
     {
@@ -953,10 +2181,9 @@ std::vector<Instance> LongTermMemoryConduitPostgreSQL::getInstances(const Concep
 {
   try
   {
-    pqxx::work txn{ *conn, "getInstances" };
-    auto result =
-        txn.parameterized("SELECT entity_id FROM instance_of WHERE concept_name = $1")(concept.getName()).exec();
-    txn.commit();
+    auto txn = openTransaction("getInstances");
+    auto result = txn->prepared("get_instances")(concept.entity_id).exec();
+    txn->commit();
     std::vector<Instance> instances{};
     for (const auto& row : result)
     {
@@ -973,60 +2200,50 @@ std::vector<Instance> LongTermMemoryConduitPostgreSQL::getInstances(const Concep
 
 int LongTermMemoryConduitPostgreSQL::removeInstances(const Concept& concept)
 {
-  pqxx::work txn{ *conn, "removeInstances" };
-  auto result = txn.parameterized("DELETE FROM entities WHERE entity_id IN "
-                                  "(SELECT entity_id FROM instance_of WHERE concept_name = $1)")(concept.getName())
-                    .exec();
-  txn.commit();
+  auto txn = openTransaction("removeInstances");
+  auto result = txn->prepared("remove_instances")(concept.entity_id).exec();
+  txn->commit();
+  unloadConceptIndex();
+  unloadSpatialIndexes();
   return result.affected_rows();
 }
 
 int LongTermMemoryConduitPostgreSQL::removeInstancesRecursive(const Concept& concept)
 {
-  pqxx::work txn{ *conn, "removeInstancesRecursive" };
-  auto result =
-      txn.parameterized("DELETE FROM entities WHERE entity_id IN "
-                        "(SELECT entity_id FROM get_all_instances_of_concept_recursive($1))")(concept.entity_id)
-          .exec();
-  txn.commit();
+  auto txn = openTransaction("removeInstancesRecursive");
+  auto result = txn->prepared("remove_instances_recursive")(concept.entity_id).exec();
+  txn->commit();
+  unloadConceptIndex();
+  unloadSpatialIndexes();
   return result.affected_rows();
 }
 
 // MAP BACKERS
 Point LongTermMemoryConduitPostgreSQL::addPoint(Map& map, const std::string& name, double x, double y)
 {
-  auto point_entity = addEntity();
-  map.addAttribute("has", point_entity);
-  pqxx::work txn{ *conn, "addPoint" };
-  auto result = txn.parameterized("INSERT INTO points VALUES ($1, $2, $3, point($4 ,$5)) RETURNING entity_id")(
-                       point_entity.entity_id)(name)(map.getId())(x)(y)
-                    .exec();
-
-  txn.parameterized("INSERT INTO instance_of VALUES ($1,$2)")(point_entity.entity_id)("point").exec();
-  txn.commit();
-  point_entity.addAttribute("name", name);
-  return { point_entity.entity_id, name, x, y, map, *this };
+  auto txn = openTransaction("addPoint");
+  auto result = txn->prepared("add_point")(map.entity_id)(name)(map.getId())(x)(y).exec();
+  txn->commit();
+  uint entity_id = result[0]["entity_id"].as<uint>();
+  updateSpatialIndex(map.map_id, [=](MapSpatialIndex& index) { index.addPoint({ entity_id, name, x, y, 0 }); });
+  return { entity_id, name, x, y, map, *this };
 }
 
 Pose LongTermMemoryConduitPostgreSQL::addPose(Map& map, const string& name, double x, double y, double theta)
 {
-  auto pose_entity = addEntity();
-  map.addAttribute("has", pose_entity);
-  pqxx::work txn{ *conn, "addPose" };
-  auto result =
-      txn.parameterized("INSERT INTO poses VALUES ($1, $2, $3, lseg(point($4, $5), point($4+COS($6),$5+SIN($6))))")(
-             pose_entity.entity_id)(name)(map.getId())(x)(y)(theta)
-          .exec();
-  txn.parameterized("INSERT INTO instance_of VALUES ($1,$2)")(pose_entity.entity_id)("pose").exec();
-  txn.commit();
-  pose_entity.addAttribute("name", name);
-  return { pose_entity.entity_id, name, x, y, theta, map, *this };
+  auto txn = openTransaction("addPose");
+  auto result = txn->prepared("add_pose")(map.entity_id)(name)(map.getId())(x)(y)(theta).exec();
+  txn->commit();
+  uint entity_id = result[0]["entity_id"].as<uint>();
+  // Indexed with its angle normalized, as the poses_point_angle view will read it back
+  updateSpatialIndex(map.map_id, [=](MapSpatialIndex& index) {
+    index.addPose({ entity_id, name, x, y, std::atan2(std::sin(theta), std::cos(theta)) });
+  });
+  return { entity_id, name, x, y, theta, map, *this };
 }
 
 Region LongTermMemoryConduitPostgreSQL::addRegion(Map& map, const string& name, const vector<Region::Point2D>& points)
 {
-  auto region_entity = addEntity();
-  map.addAttribute("has", region_entity);
   std::ostringstream points_stream;
   points_stream << "(";
   for (const auto& point : points)
@@ -1035,40 +2252,34 @@ Region LongTermMemoryConduitPostgreSQL::addRegion(Map& map, const string& name,
   }
   points_stream.seekp(-1, points_stream.cur) << ")";
 
-  pqxx::work txn{ *conn, "addRegion" };
-  auto result = txn.parameterized("INSERT INTO regions VALUES ($1, $2, $3, $4)")(region_entity.entity_id)(name)(
-                       map.getId())(points_stream.str())
-                    .exec();
-  txn.parameterized("INSERT INTO instance_of VALUES ($1,$2)")(region_entity.entity_id)("region").exec();
-  txn.commit();
-  region_entity.addAttribute("name", name);
-  return { region_entity.entity_id, name, points, map, *this };
+  auto txn = openTransaction("addRegion");
+  auto result = txn->prepared("add_region")(map.entity_id)(name)(map.getId())(points_stream.str()).exec();
+  txn->commit();
+  uint entity_id = result[0]["entity_id"].as<uint>();
+  // Indexed as stored, which is at the stream's precision rather than the exact vertices
+  auto stored = strToPoints(points_stream.str().c_str());
+  updateSpatialIndex(map.map_id, [=](MapSpatialIndex& index) { index.addRegion({ entity_id, name, stored }); });
+  return { entity_id, name, points, map, *this };
 }
 
 Door LongTermMemoryConduitPostgreSQL::addDoor(Map& map, const string& name, double x_0, double y_0, double x_1,
                                               double y_1)
 {
-  auto door_entity = addEntity();
-  map.addAttribute("has", door_entity);
-
-  pqxx::work txn{ *conn, "addDoor" };
-  auto result = txn.parameterized("INSERT INTO doors VALUES ($1, $2, $3, lseg(point($4, $5), point($6,$7)))")(
-                       door_entity.entity_id)(name)(map.getId())(x_0)(y_0)(x_1)(y_1)
-                    .exec();
-  txn.parameterized("INSERT INTO instance_of VALUES ($1,$2)")(door_entity.entity_id)("door").exec();
-  txn.commit();
-  door_entity.addAttribute("name", name);
-  return { door_entity.entity_id, name, x_0, y_0, x_1, y_1, map, *this };
+  auto txn = openTransaction("addDoor");
+  auto result = txn->prepared("add_door")(map.entity_id)(name)(map.getId())(x_0)(y_0)(x_1)(y_1).exec();
+  txn->commit();
+  uint entity_id = result[0]["entity_id"].as<uint>();
+  updateSpatialIndex(map.map_id,
+                     [=](MapSpatialIndex& index) { index.addDoor({ entity_id, name, x_0, y_0, x_1, y_1 }); });
+  return { entity_id, name, x_0, y_0, x_1, y_1, map, *this };
 }
 
 boost::optional<Point> LongTermMemoryConduitPostgreSQL::getPoint(Map& map, const string& name)
 {
-  pqxx::work txn{ *conn, "getPoint" };
+  auto txn = openTransaction("getPoint");
 
-  auto q_result = txn.parameterized("SELECT entity_id, x, y FROM points_xy WHERE parent_map_id "
-                                    "= $1 AND point_name = $2")(map.getId())(name)
-                      .exec();
-  txn.commit();
+  auto q_result = txn->prepared("get_point_by_name")(map.getId())(name).exec();
+  txn->commit();
   assert(q_result.size() <= 1);
   if (q_result.size() == 1)
   {
@@ -1080,12 +2291,9 @@ boost::optional<Point> LongTermMemoryConduitPostgreSQL::getPoint(Map& map, const
 
 boost::optional<Pose> LongTermMemoryConduitPostgreSQL::getPose(Map& map, const string& name)
 {
-  pqxx::work txn{ *conn, "getPose" };
-  string query = "SELECT entity_id, x, y, theta FROM poses_point_angle WHERE parent_map_id "
-                 "= $1 AND pose_name = $2";
-
-  auto q_result = txn.parameterized(query)(map.getId())(name).exec();
-  txn.commit();
+  auto txn = openTransaction("getPose");
+  auto q_result = txn->prepared("get_pose_by_name")(map.getId())(name).exec();
+  txn->commit();
   assert(q_result.size() <= 1);
   if (q_result.size() == 1)
   {
@@ -1103,31 +2311,23 @@ boost::optional<Pose> LongTermMemoryConduitPostgreSQL::getPose(Map& map, const s
 
 boost::optional<Region> LongTermMemoryConduitPostgreSQL::getRegion(Map& map, const string& name)
 {
-  pqxx::work txn{ *conn, "getRegion" };
-  string query = "SELECT entity_id, region, region_name "
-                 "FROM regions WHERE parent_map_id "
-                 "= $1 AND region_name = $2";
-  auto q_result = txn.parameterized(query)(map.getId())(name).exec();
-  txn.commit();
+  auto txn = openTransaction("getRegion");
+  auto q_result = txn->prepared("get_region_by_name")(map.getId())(name).exec();
+  txn->commit();
   assert(q_result.size() <= 1);
   if (q_result.size() == 1)
   {
     auto region = q_result[0];
-    auto str = region["region"].as<string>();
-    const auto points = strToPoints(str);
-    return Region{ region["entity_id"].as<uint>(), name, points, map, *this };
+    return Region{ region["entity_id"].as<uint>(), name, strToPoints(region["region"].c_str()), map, *this };
   }
   return {};
 }
 
 boost::optional<Door> LongTermMemoryConduitPostgreSQL::getDoor(Map& map, const string& name)
 {
-  pqxx::work txn{ *conn, "getDoor" };
-  string query = "SELECT entity_id, x_0, y_0, x_1, y_1, door_name "
-                 "FROM doors_points WHERE parent_map_id "
-                 "= $1 AND door_name = $2";
-  auto q_result = txn.parameterized(query)(map.getId())(name).exec();
-  txn.commit();
+  auto txn = openTransaction("getDoor");
+  auto q_result = txn->prepared("get_door_by_name")(map.getId())(name).exec();
+  txn->commit();
   assert(q_result.size() <= 1);
   if (q_result.size() == 1)
   {
@@ -1146,101 +2346,238 @@ boost::optional<Door> LongTermMemoryConduitPostgreSQL::getDoor(Map& map, const s
 
 vector<Point> LongTermMemoryConduitPostgreSQL::getAllPoints(Map& map)
 {
-  pqxx::work txn{ *conn, "getAllPoints" };
-  auto q_result = txn.parameterized("SELECT entity_id, x, y, point_name FROM points_xy WHERE "
-                                    "parent_map_id = $1")(map.getId())
-                      .exec();
-  txn.commit();
+  auto txn = openTransaction("getAllPoints");
+  auto q_result = txn->prepared("get_all_points")(map.getId()).exec();
+  txn->commit();
   vector<Point> points;
+  auto parent_map = std::make_shared<const Map>(map);
   for (const auto& row : q_result)
   {
     points.emplace_back(row["entity_id"].as<uint>(), row["point_name"].as<string>(), row["x"].as<double>(),
-                        row["y"].as<double>(), map, *this);
+                        row["y"].as<double>(), parent_map, *this);
   }
   return points;
 }
 
 vector<Pose> LongTermMemoryConduitPostgreSQL::getAllPoses(Map& map)
 {
-  pqxx::work txn{ *conn, "getAllPoses" };
+  auto txn = openTransaction("getAllPoses");
 
-  auto q_result = txn.parameterized("SELECT entity_id, x, y, theta, pose_name FROM poses_point_angle WHERE "
-                                    "parent_map_id = $1")(map.getId())
-                      .exec();
-  txn.commit();
+  auto q_result = txn->prepared("get_all_poses")(map.getId()).exec();
+  txn->commit();
   vector<Pose> poses;
+  auto parent_map = std::make_shared<const Map>(map);
   for (const auto& row : q_result)
   {
     poses.emplace_back(row["entity_id"].as<uint>(), row["pose_name"].as<string>(), row["x"].as<double>(),
-                       row["y"].as<double>(), row["theta"].as<double>(), map, *this);
+                       row["y"].as<double>(), row["theta"].as<double>(), parent_map, *this);
   }
   return poses;
 }
 
 vector<Region> LongTermMemoryConduitPostgreSQL::getAllRegions(Map& map)
 {
-  pqxx::work txn{ *conn, "getAllPoses" };
-  string query = "SELECT entity_id, region, region_name FROM regions WHERE parent_map_id = $1";
-
-  auto q_result = txn.parameterized(query)(map.getId()).exec();
-  txn.commit();
+  auto txn = openTransaction("getAllRegions");
+  auto q_result = txn->prepared("get_all_regions")(map.getId()).exec();
+  txn->commit();
   vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
   for (const auto& row : q_result)
   {
-    auto str = row["region"].as<string>();
-    const auto points = strToPoints(str);
-    regions.emplace_back(row["entity_id"].as<uint>(), row["region_name"].as<string>(), points, map, *this);
+    regions.emplace_back(row["entity_id"].as<uint>(), row["region_name"].as<string>(),
+                         strToPoints(row["region"].c_str()), parent_map, *this);
   }
   return regions;
 }
 
 vector<Door> LongTermMemoryConduitPostgreSQL::getAllDoors(Map& map)
 {
-  pqxx::work txn{ *conn, "getAllDoors" };
-  string query = "SELECT entity_id, door_name, x_0, y_0, x_1, y_1 FROM doors_points WHERE parent_map_id = $1";
-
-  auto q_result = txn.parameterized(query)(map.getId()).exec();
-  txn.commit();
+  auto txn = openTransaction("getAllDoors");
+  auto q_result = txn->prepared("get_all_doors")(map.getId()).exec();
+  txn->commit();
   vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
   for (const auto& row : q_result)
   {
     doors.emplace_back(row["entity_id"].as<uint>(), row["door_name"].as<string>(), row["x_0"].as<double>(),
-                       row["y_0"].as<double>(), row["x_1"].as<double>(), row["y_1"].as<double>(), map, *this);
+                       row["y_0"].as<double>(), row["x_1"].as<double>(), row["y_1"].as<double>(), parent_map, *this);
   }
   return doors;
 }
 
 std::vector<Region> LongTermMemoryConduitPostgreSQL::getContainingRegions(Map& map, double x, double y)
 {
-  pqxx::work txn{ *conn, "getContainingRegions" };
-  auto result = txn.parameterized("SELECT entity_id, region, region_name FROM regions WHERE parent_map_id = $1 AND "
-                                  "region @> point($2,$3)")(map.map_id)(x)(y)
-                    .exec();
-  txn.commit();
+  vector<MapSpatialIndex::RegionEntry> containing;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { containing = index.containingRegions(x, y); });
   vector<Region> regions;
-  for (const auto& row : result)
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& region : containing)
+  {
+    regions.emplace_back(region.entity_id, std::move(region.name), std::move(region.points), parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Point> LongTermMemoryConduitPostgreSQL::getNearestPoints(Map& map, double x, double y, size_t k)
+{
+  vector<MapSpatialIndex::PointEntry> nearest;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearest = index.nearestPoints(x, y, k); });
+  vector<Point> points;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& point : nearest)
+  {
+    points.emplace_back(point.entity_id, std::move(point.name), point.x, point.y, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitPostgreSQL::getNearestPoses(Map& map, double x, double y, size_t k)
+{
+  vector<MapSpatialIndex::PointEntry> nearest;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearest = index.nearestPoses(x, y, k); });
+  vector<Pose> poses;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& pose : nearest)
+  {
+    poses.emplace_back(pose.entity_id, std::move(pose.name), pose.x, pose.y, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Door> LongTermMemoryConduitPostgreSQL::getNearestDoors(Map& map, double x, double y, size_t k)
+{
+  vector<MapSpatialIndex::DoorEntry> nearest;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearest = index.nearestDoors(x, y, k); });
+  vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& door : nearest)
   {
-    auto str = row["region"].as<string>();
-    const auto points = strToPoints(str);
-    regions.emplace_back(row["entity_id"].as<uint>(), row["region_name"].as<string>(), points, map, *this);
+    doors.emplace_back(door.entity_id, std::move(door.name), door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return doors;
+}
+
+vector<Point> LongTermMemoryConduitPostgreSQL::getPointsWithinRadius(Map& map, double x, double y, double radius)
+{
+  vector<MapSpatialIndex::PointEntry> nearby;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearby = index.pointsWithinRadius(x, y, radius); });
+  vector<Point> points;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& point : nearby)
+  {
+    points.emplace_back(point.entity_id, std::move(point.name), point.x, point.y, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitPostgreSQL::getPosesWithinRadius(Map& map, double x, double y, double radius)
+{
+  vector<MapSpatialIndex::PointEntry> nearby;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearby = index.posesWithinRadius(x, y, radius); });
+  vector<Pose> poses;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& pose : nearby)
+  {
+    poses.emplace_back(pose.entity_id, std::move(pose.name), pose.x, pose.y, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Door> LongTermMemoryConduitPostgreSQL::getDoorsWithinRadius(Map& map, double x, double y, double radius)
+{
+  vector<MapSpatialIndex::DoorEntry> nearby;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearby = index.doorsWithinRadius(x, y, radius); });
+  vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& door : nearby)
+  {
+    doors.emplace_back(door.entity_id, std::move(door.name), door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return doors;
+}
+
+vector<Region> LongTermMemoryConduitPostgreSQL::getAdjacentRegions(Map& map, const Region& region)
+{
+  vector<MapSpatialIndex::RegionEntry> adjacent;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { adjacent = index.adjacentRegions(region.entity_id); });
+  vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& entry : adjacent)
+  {
+    regions.emplace_back(entry.entity_id, std::move(entry.name), std::move(entry.points), parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Region> LongTermMemoryConduitPostgreSQL::getReachableRegions(Map& map, const Region& region)
+{
+  vector<MapSpatialIndex::RegionEntry> reachable;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { reachable = index.reachableRegions(region.entity_id); });
+  vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& entry : reachable)
+  {
+    regions.emplace_back(entry.entity_id, std::move(entry.name), std::move(entry.points), parent_map, *this);
   }
   return regions;
 }
 
+bool LongTermMemoryConduitPostgreSQL::isRegionReachable(Map& map, const Region& from, const Region& to)
+{
+  bool reachable = false;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { reachable = index.isReachable(from.entity_id, to.entity_id); });
+  return reachable;
+}
+
+bool LongTermMemoryConduitPostgreSQL::getShortestPath(Map& map, const Region& from, const Region& to,
+                                                      vector<Region>& regions, vector<Door>& doors)
+{
+  vector<MapSpatialIndex::RegionEntry> path_regions;
+  vector<MapSpatialIndex::DoorEntry> path_doors;
+  bool found = false;
+  querySpatialIndex(map.entity_id, map.map_id, [&](const MapSpatialIndex& index) {
+    found = index.shortestPath(from.entity_id, to.entity_id, path_regions, path_doors);
+  });
+  regions.clear();
+  doors.clear();
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& region : path_regions)
+  {
+    regions.emplace_back(region.entity_id, std::move(region.name), std::move(region.points), parent_map, *this);
+  }
+  for (auto& door : path_doors)
+  {
+    doors.emplace_back(door.entity_id, std::move(door.name), door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return found;
+}
+
 bool LongTermMemoryConduitPostgreSQL::renameMap(Map& map, const std::string& new_name)
 {
   try
   {
-    pqxx::work txn{ *conn, "renameMap" };
-    auto result =
-        txn.parameterized("UPDATE maps SET map_name = $1 WHERE map_name = $2")(new_name)(map.getName()).exec();
-    txn.commit();
-    if (result.affected_rows() == 1)
+    bool renamed;
+    {
+      auto txn = openTransaction("renameMap");
+      renamed = txn->prepared("rename_map")(new_name)(map.getName()).exec().affected_rows() == 1;
+      txn->commit();
+    }
+    if (renamed)
     {
       map.removeAttribute("name");
       map.addAttribute("name", new_name);
     }
-    return result.affected_rows() == 1;
+    return renamed;
   }
   catch (const std::exception& e)
   {
@@ -1253,60 +2590,28 @@ bool LongTermMemoryConduitPostgreSQL::renameMap(Map& map, const std::string& new
 
 vector<Point> LongTermMemoryConduitPostgreSQL::getContainedPoints(Region& region)
 {
-  pqxx::work txn{ *conn, "getContainedPoints" };
-
-  auto result =
-      txn.parameterized("SELECT entity_id, x, y, point_name FROM points_xy WHERE parent_map_id = $1 AND (SELECT region "
-                        "FROM regions WHERE entity_id = $2) @> point(x,y)")(region.parent_map.map_id)(region.entity_id)
-          .exec();
-  txn.commit();
+  vector<MapSpatialIndex::PointEntry> contained;
+  querySpatialIndex(region.parent_map->entity_id, region.parent_map->map_id,
+                    [&](const MapSpatialIndex& index) { contained = index.containedPoints(region.entity_id); });
   vector<Point> points;
-  for (const auto& row : result)
+  for (auto& point : contained)
   {
-    points.emplace_back(row["entity_id"].as<uint>(), row["point_name"].as<string>(), row["x"].as<double>(),
-                        row["y"].as<double>(), region.parent_map, *this);
+    points.emplace_back(point.entity_id, std::move(point.name), point.x, point.y, region.parent_map, *this);
   }
   return points;
 }
 
 vector<Pose> LongTermMemoryConduitPostgreSQL::getContainedPoses(Region& region)
 {
-  pqxx::work txn{ *conn, "getContainedPoses" };
-
-  string query = "SELECT entity_id, x, y, theta, pose_name FROM poses_point_angle "
-                 "WHERE parent_map_id = $1 "
-                 "AND (SELECT region FROM regions WHERE entity_id = $2) @> point(x,y)";
-  auto result = txn.parameterized(query)(region.parent_map.map_id)(region.entity_id).exec();
-  txn.commit();
+  vector<MapSpatialIndex::PointEntry> contained;
+  querySpatialIndex(region.parent_map->entity_id, region.parent_map->map_id,
+                    [&](const MapSpatialIndex& index) { contained = index.containedPoses(region.entity_id); });
   vector<Pose> poses;
-  for (const auto& row : result)
+  for (auto& pose : contained)
   {
-    poses.emplace_back(row["entity_id"].as<uint>(), row["pose_name"].as<string>(), row["x"].as<double>(),
-                       row["y"].as<double>(), row["theta"].as<double>(), region.parent_map, *this);
+    poses.emplace_back(pose.entity_id, std::move(pose.name), pose.x, pose.y, pose.theta, region.parent_map, *this);
   }
   return poses;
 }
 
-bool LongTermMemoryConduitPostgreSQL::isPointContained(const Region& region, double x, double y)
-{
-  pqxx::work txn{ *conn, "isPointContained" };
-  auto result = txn.parameterized("SELECT count(*) FROM regions WHERE entity_id = $1 AND region @> point($2,$3)")(
-                       region.entity_id)(x)(y)
-                    .exec();
-  txn.commit();
-  return result[0]["count"].as<uint>() == 1;
-}
-
-boost::optional<Map> LongTermMemoryConduitPostgreSQL::getMapForMapId(uint map_id)
-{
-  pqxx::work txn{ *conn, "getMapForId" };
-  auto result = txn.parameterized("SELECT entity_id, map_name FROM maps WHERE map_id= $1")(map_id).exec();
-  txn.commit();
-  if (result.size() == 1)
-  {
-    return Map(result[0]["entity_id"].as<uint>(), map_id, result[0]["map_name"].as<string>(), *this);
-  }
-  return {};
-}
-
 }  // namespace knowledge_rep
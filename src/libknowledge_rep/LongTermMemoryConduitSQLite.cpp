@@ -0,0 +1,2510 @@
+#include <knowledge_representation/LongTermMemoryConduitSQLite.h>
+#include <knowledge_representation/LongTermMemoryConduitInterface.h>
+#include <iostream>
+#include <string>
+#include <knowledge_representation/LTMCConcept.h>
+#include <knowledge_representation/LTMCInstance.h>
+#include <knowledge_representation/LTMCMap.h>
+#include <knowledge_representation/LTMCPoint.h>
+#include <knowledge_representation/LTMCPose.h>
+#include <knowledge_representation/LTMCRegion.h>
+#include <knowledge_representation/LTMCDoor.h>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+// Generated from sql/schema_sqlite.sql when the build is configured
+#include "schema_sqlite.h"
+
+using std::string;
+using std::vector;
+namespace knowledge_rep
+{
+typedef LTMCEntity<LongTermMemoryConduitSQLite> Entity;
+typedef LTMCConcept<LongTermMemoryConduitSQLite> Concept;
+typedef LTMCInstance<LongTermMemoryConduitSQLite> Instance;
+typedef LTMCPoint<LongTermMemoryConduitSQLite> Point;
+typedef LTMCPose<LongTermMemoryConduitSQLite> Pose;
+typedef LTMCRegion<LongTermMemoryConduitSQLite> Region;
+typedef LTMCMap<LongTermMemoryConduitSQLite> Map;
+
+namespace
+{
+/// Bumped whenever any conduit in the process adds or deletes an attribute, so that each conduit's schema cache looks
+/// again for the names it has missed
+std::atomic<uint64_t> attribute_schema_generation(0);
+
+/// How long a connection waits for another to release the write lock before giving up
+const int BUSY_TIMEOUT_MS = 10000;
+
+// One row per typed value across all five attribute tables. SQLite values carry their own type, so every table's
+// values share one column, and the type column holds the AttributeValueType to decode it as.
+#define TYPED_ATTRIBUTES_QUERY                                                                                         \
+  "SELECT entity_id, attribute_name, 0 AS type, attribute_value FROM entity_attributes_id "                            \
+  "UNION ALL SELECT entity_id, attribute_name, 1, attribute_value FROM entity_attributes_bool "                        \
+  "UNION ALL SELECT entity_id, attribute_name, 2, attribute_value FROM entity_attributes_int "                         \
+  "UNION ALL SELECT entity_id, attribute_name, 3, attribute_value FROM entity_attributes_float "                       \
+  "UNION ALL SELECT entity_id, attribute_name, 4, attribute_value FROM entity_attributes_str"
+
+// The concept ?1 and every concept that is_a it, directly or not, as a CTE named descendants. This is
+// get_all_concept_descendants() from the PostgreSQL schema. UNION rather than UNION ALL keeps a cycle in the
+// hierarchy from recursing forever.
+#define CONCEPT_DESCENDANTS_CTE                                                                                        \
+  "WITH RECURSIVE descendants (id) AS (SELECT entity_id FROM concepts WHERE entity_id = ?1 "                           \
+  "UNION SELECT eai.entity_id FROM entity_attributes_id eai INNER JOIN descendants "                                   \
+  "ON eai.attribute_name = 'is_a' AND eai.attribute_value = descendants.id) "
+
+#define REMOVE_ATTRIBUTE_QUERY(TABLE) "DELETE FROM " TABLE " WHERE entity_id = ?1 AND attribute_name = ?2"
+
+// The page of one attribute table's rows that follows rowid ?1, at most ?2 of them. The columns are those of the typed
+// attribute union, followed by the rowid.
+#define SCAN_ATTRIBUTES_QUERY(TABLE, TYPE)                                                                             \
+  "SELECT entity_id, attribute_name, " TYPE ", attribute_value, rowid FROM " TABLE " WHERE rowid > ?1 "                \
+  "ORDER BY rowid LIMIT ?2"
+
+// Every fixed statement the conduit issues, keyed by the name it is prepared under. Only the raw select queries
+// that callers pass in are compiled on each use.
+const std::pair<const char*, const char*> PREPARED_STATEMENTS[] = {
+  // Entities
+  { "add_entity", "INSERT INTO entities DEFAULT VALUES" },
+  { "add_entity_with_id", "INSERT OR IGNORE INTO entities VALUES (?1)" },
+  { "entity_exists", "SELECT count(*) FROM entities WHERE entity_id = ?1" },
+  { "delete_entity", "DELETE FROM entities WHERE entity_id = ?1" },
+  { "get_all_entities", "SELECT entity_id FROM entities" },
+  // The forEach*Batch scans page through entities by ID. ?1 is the last ID of the previous page and ?2 the page size.
+  { "scan_entities", "SELECT entity_id FROM entities WHERE entity_id > ?1 ORDER BY entity_id LIMIT ?2" },
+  { "delete_all_entities", "DELETE FROM entities" },
+  // add_default_entities() from the PostgreSQL schema
+  { "add_default_entities", "INSERT INTO entities VALUES (1), (2), (3), (4), (5), (6), (7)" },
+  { "add_default_concepts", "INSERT INTO concepts VALUES (2, 'robot'), (3, 'map'), (4, 'point'), (5, 'pose'), "
+                            "(6, 'region'), (7, 'door')" },
+  { "add_default_instances", "INSERT INTO instance_of VALUES (1, 'robot')" },
+  // Manual inserts don't lower the AUTOINCREMENT counter, so new entities would skip past the deleted IDs
+  { "reset_entity_ids", "UPDATE sqlite_sequence SET seq = (SELECT max(entity_id) FROM entities) "
+                        "WHERE name = 'entities'" },
+  // Attributes
+  { "add_new_attribute", "INSERT OR IGNORE INTO attributes VALUES (?1, ?2)" },
+  { "delete_attribute", "DELETE FROM attributes WHERE attribute_name = ?1" },
+  { "get_all_attributes", "SELECT attribute_name, type FROM attributes" },
+  { "delete_all_attributes", "DELETE FROM attributes" },
+  // add_default_attributes() from the PostgreSQL schema
+  { "add_default_attributes", "INSERT INTO attributes VALUES ('answer_to', 'id'), ('count', 'int'), "
+                              "('default_location', 'id'), ('has', 'id'), ('height', 'float'), ('width', 'float'), "
+                              "('is_a', 'id'), ('is_connected', 'id'), ('is_delivered', 'id'), ('is_facing', 'id'), "
+                              "('is_holding', 'id'), ('is_in', 'id'), ('is_near', 'id'), ('is_open', 'bool'), "
+                              "('is_placed', 'id'), ('name', 'str'), ('part_of', 'id'), ('approach_to', 'id')" },
+  // Entity attributes
+  { "add_attribute_id", "INSERT INTO entity_attributes_id VALUES (?1, ?2, ?3)" },
+  { "add_attribute_bool", "INSERT INTO entity_attributes_bool VALUES (?1, ?2, ?3)" },
+  { "add_attribute_int", "INSERT INTO entity_attributes_int VALUES (?1, ?2, ?3)" },
+  { "add_attribute_float", "INSERT INTO entity_attributes_float VALUES (?1, ?2, ?3)" },
+  { "add_attribute_str", "INSERT INTO entity_attributes_str VALUES (?1, ?2, ?3)" },
+  // Bulk loads skip attributes that are already set instead of failing
+  { "load_attribute_id", "INSERT OR IGNORE INTO entity_attributes_id VALUES (?1, ?2, ?3)" },
+  { "load_attribute_bool", "INSERT OR IGNORE INTO entity_attributes_bool VALUES (?1, ?2, ?3)" },
+  { "load_attribute_int", "INSERT OR IGNORE INTO entity_attributes_int VALUES (?1, ?2, ?3)" },
+  { "load_attribute_float", "INSERT OR IGNORE INTO entity_attributes_float VALUES (?1, ?2, ?3)" },
+  { "load_attribute_str", "INSERT OR IGNORE INTO entity_attributes_str VALUES (?1, ?2, ?3)" },
+  // remove_attribute() from the PostgreSQL schema, one table at a time
+  { "remove_attribute_id", REMOVE_ATTRIBUTE_QUERY("entity_attributes_id") },
+  { "remove_attribute_bool", REMOVE_ATTRIBUTE_QUERY("entity_attributes_bool") },
+  { "remove_attribute_int", REMOVE_ATTRIBUTE_QUERY("entity_attributes_int") },
+  { "remove_attribute_float", REMOVE_ATTRIBUTE_QUERY("entity_attributes_float") },
+  { "remove_attribute_str", REMOVE_ATTRIBUTE_QUERY("entity_attributes_str") },
+  { "remove_attribute_of_value", REMOVE_ATTRIBUTE_QUERY("entity_attributes_id") " AND attribute_value = ?3" },
+  { "get_attributes", "SELECT * FROM (" TYPED_ATTRIBUTES_QUERY ") WHERE entity_id = ?1" },
+  { "get_named_attributes", "SELECT * FROM (" TYPED_ATTRIBUTES_QUERY ") WHERE entity_id = ?1 AND attribute_name = ?2" },
+  // get_attributes for a JSON array of entities at once
+  { "get_attributes_batch",
+    "SELECT * FROM (" TYPED_ATTRIBUTES_QUERY ") WHERE entity_id IN (SELECT value FROM json_each(?1))" },
+  { "scan_attributes_id", SCAN_ATTRIBUTES_QUERY("entity_attributes_id", "0") },
+  { "scan_attributes_bool", SCAN_ATTRIBUTES_QUERY("entity_attributes_bool", "1") },
+  { "scan_attributes_int", SCAN_ATTRIBUTES_QUERY("entity_attributes_int", "2") },
+  { "scan_attributes_float", SCAN_ATTRIBUTES_QUERY("entity_attributes_float", "3") },
+  { "scan_attributes_str", SCAN_ATTRIBUTES_QUERY("entity_attributes_str", "4") },
+  { "get_entities_with_attribute_of_value_id",
+    "SELECT entity_id FROM entity_attributes_id WHERE attribute_value = ?1 AND attribute_name = ?2" },
+  { "get_entities_with_attribute_of_value_bool",
+    "SELECT entity_id FROM entity_attributes_bool WHERE attribute_value = ?1 AND attribute_name = ?2" },
+  { "get_entities_with_attribute_of_value_int",
+    "SELECT entity_id FROM entity_attributes_int WHERE attribute_value = ?1 AND attribute_name = ?2" },
+  { "get_entities_with_attribute_of_value_float",
+    "SELECT entity_id FROM entity_attributes_float WHERE attribute_value = ?1 AND attribute_name = ?2" },
+  { "get_entities_with_attribute_of_value_str",
+    "SELECT entity_id FROM entity_attributes_str WHERE attribute_value = ?1 AND attribute_name = ?2" },
+  // Concepts and instances
+  { "add_concept", "INSERT INTO concepts VALUES (?1, ?2)" },
+  { "get_concept_by_name", "SELECT entity_id FROM concepts WHERE concept_name = ?1" },
+  { "get_concept_by_id", "SELECT concept_name FROM concepts WHERE entity_id = ?1" },
+  { "get_all_concepts", "SELECT entity_id, concept_name FROM concepts" },
+  { "scan_concepts", "SELECT entity_id, concept_name FROM concepts WHERE entity_id > ?1 ORDER BY entity_id LIMIT ?2" },
+  { "get_all_instances", "SELECT entity_id FROM entities WHERE entity_id NOT IN (SELECT entity_id FROM concepts)" },
+  { "scan_instances", "SELECT entity_id FROM entities WHERE entity_id > ?1 AND entity_id NOT IN "
+                      "(SELECT entity_id FROM concepts) ORDER BY entity_id LIMIT ?2" },
+  { "instance_exists", "SELECT count(*) FROM instance_of WHERE entity_id = ?1" },
+  { "get_instance_named", "SELECT entity_id FROM entity_attributes_str WHERE attribute_name = 'name' "
+                          "AND attribute_value = ?1 AND entity_id IN (SELECT entity_id FROM instance_of WHERE "
+                          "concept_name = ?2)" },
+  { "make_instance_of", "INSERT INTO instance_of VALUES (?1, ?2)" },
+  { "load_instance_of", "INSERT OR IGNORE INTO instance_of VALUES (?1, ?2)" },
+  { "get_named_instances", "SELECT instance_of.entity_id, instance_of.concept_name, attribute_value AS name "
+                           "FROM instance_of INNER JOIN entity_attributes_str "
+                           "ON entity_attributes_str.entity_id = instance_of.entity_id "
+                           "WHERE attribute_name = 'name'" },
+  { "get_concepts", "SELECT concepts.entity_id, concepts.concept_name FROM instance_of "
+                    "INNER JOIN concepts ON concepts.concept_name = instance_of.concept_name "
+                    "WHERE instance_of.entity_id = ?1" },
+  // get_concepts_recursive() from the PostgreSQL schema
+  { "get_concepts_recursive", "WITH RECURSIVE ancestors (id) AS (SELECT concepts.entity_id FROM concepts "
+                              "INNER JOIN instance_of ON instance_of.concept_name = concepts.concept_name "
+                              "WHERE instance_of.entity_id = ?1 "
+                              "UNION SELECT eai.attribute_value FROM entity_attributes_id eai INNER JOIN ancestors "
+                              "ON eai.attribute_name = 'is_a' AND eai.entity_id = ancestors.id) "
+                              "SELECT entity_id, concept_name FROM ancestors INNER JOIN concepts ON entity_id = id" },
+  // get_concepts_recursive for a JSON array of instances at once, with each concept labelled by its instance
+  { "get_concepts_recursive_batch",
+    "WITH RECURSIVE ancestors (instance_id, id) AS (SELECT instance_of.entity_id, concepts.entity_id FROM instance_of "
+    "INNER JOIN concepts ON concepts.concept_name = instance_of.concept_name "
+    "WHERE instance_of.entity_id IN (SELECT value FROM json_each(?1)) "
+    "UNION SELECT ancestors.instance_id, eai.attribute_value FROM entity_attributes_id eai INNER JOIN ancestors "
+    "ON eai.attribute_name = 'is_a' AND eai.entity_id = ancestors.id) "
+    "SELECT instance_id, entity_id, concept_name FROM ancestors INNER JOIN concepts ON entity_id = id" },
+  // Walks down from the concept rather than up from each instance, so the hierarchy is only walked once
+  { "filter_instances_of", CONCEPT_DESCENDANTS_CTE "SELECT DISTINCT instance_of.entity_id FROM instance_of "
+                                                   "INNER JOIN concepts USING (concept_name) "
+                                                   "WHERE concepts.entity_id IN descendants "
+                                                   "AND instance_of.entity_id IN (SELECT value FROM json_each(?2))" },
+  { "get_children", "SELECT concepts.entity_id, concept_name FROM entity_attributes_id eai "
+                    "INNER JOIN concepts ON eai.entity_id = concepts.entity_id "
+                    "WHERE attribute_name = 'is_a' AND attribute_value = ?1" },
+  { "get_children_recursive", CONCEPT_DESCENDANTS_CTE "SELECT entity_id, concept_name FROM descendants "
+                                                      "INNER JOIN concepts ON entity_id = id" },
+  { "get_instances", "SELECT entity_id FROM instance_of WHERE concept_name = ?1" },
+  { "get_is_a_relations", "SELECT entity_id, attribute_value FROM entity_attributes_id WHERE attribute_name = 'is_a'" },
+  { "remove_instances", "DELETE FROM entities WHERE entity_id IN "
+                        "(SELECT entity_id FROM instance_of WHERE concept_name = ?1)" },
+  // get_all_instances_of_concept_recursive() from the PostgreSQL schema
+  { "remove_instances_recursive", CONCEPT_DESCENDANTS_CTE "DELETE FROM entities WHERE entity_id IN "
+                                                          "(SELECT instance_of.entity_id FROM instance_of "
+                                                          "INNER JOIN concepts USING (concept_name) "
+                                                          "WHERE concepts.entity_id IN descendants)" },
+  // Maps
+  { "add_map", "INSERT INTO maps (entity_id, map_name) VALUES (?1, ?2)" },
+  { "get_map_by_name", "SELECT entity_id, map_id FROM maps WHERE map_name = ?1" },
+  { "get_map_by_id", "SELECT map_name, map_id FROM maps WHERE entity_id = ?1" },
+  { "get_all_maps", "SELECT entity_id, map_id, map_name FROM maps" },
+  { "rename_map", "UPDATE maps SET map_name = ?1 WHERE map_name = ?2" },
+  // Map geometry. The entity, the map's has attribute, the name attribute and the instance_of row are added with the
+  // statements above.
+  { "add_point", "INSERT INTO points VALUES (?1, ?2, ?3, ?4, ?5)" },
+  { "add_pose", "INSERT INTO poses VALUES (?1, ?2, ?3, ?4, ?5, ?6)" },
+  { "add_region", "INSERT INTO regions VALUES (?1, ?2, ?3, ?4)" },
+  { "add_door", "INSERT INTO doors VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7)" },
+  // By-ID lookups join in the parent map, so that building its handle doesn't take a second statement
+  { "get_point_by_id", "SELECT point_name, x, y, parent_map_id, maps.entity_id, map_name "
+                       "FROM points JOIN maps ON map_id = parent_map_id WHERE points.entity_id = ?1" },
+  { "get_pose_by_id", "SELECT pose_name, x, y, theta, parent_map_id, maps.entity_id, map_name "
+                      "FROM poses JOIN maps ON map_id = parent_map_id WHERE poses.entity_id = ?1" },
+  { "get_region_by_id", "SELECT region_name, region, parent_map_id, maps.entity_id, map_name "
+                        "FROM regions JOIN maps ON map_id = parent_map_id WHERE regions.entity_id = ?1" },
+  { "get_door_by_id", "SELECT door_name, x_0, y_0, x_1, y_1, parent_map_id, maps.entity_id, map_name "
+                      "FROM doors JOIN maps ON map_id = parent_map_id WHERE doors.entity_id = ?1" },
+  { "get_point_by_name", "SELECT entity_id, x, y FROM points WHERE parent_map_id = ?1 AND point_name = ?2" },
+  { "get_pose_by_name", "SELECT entity_id, x, y, theta FROM poses WHERE parent_map_id = ?1 AND pose_name = ?2" },
+  { "get_region_by_name", "SELECT entity_id, region FROM regions WHERE parent_map_id = ?1 AND region_name = ?2" },
+  { "get_door_by_name", "SELECT entity_id, x_0, y_0, x_1, y_1 FROM doors WHERE parent_map_id = ?1 AND door_name = ?2" },
+  { "get_all_points", "SELECT entity_id, point_name, x, y FROM points WHERE parent_map_id = ?1" },
+  { "get_all_poses", "SELECT entity_id, pose_name, x, y, theta FROM poses WHERE parent_map_id = ?1" },
+  { "get_all_regions", "SELECT entity_id, region_name, region FROM regions WHERE parent_map_id = ?1" },
+  { "get_all_doors", "SELECT entity_id, door_name, x_0, y_0, x_1, y_1 FROM doors WHERE parent_map_id = ?1" },
+};
+
+/// The remove_attribute_* statements, one per attribute table
+const char* REMOVE_ATTRIBUTE_STATEMENTS[] = { "remove_attribute_id", "remove_attribute_bool", "remove_attribute_int",
+                                              "remove_attribute_float", "remove_attribute_str" };
+
+/// The load_attribute_* statements, indexed by AttributeValueType
+const char* LOAD_ATTRIBUTE_STATEMENTS[] = { "load_attribute_id", "load_attribute_bool", "load_attribute_int",
+                                            "load_attribute_float", "load_attribute_str" };
+
+/**
+ * @brief Decodes a region blob, which holds its vertices as packed (x, y) doubles
+ */
+vector<std::pair<double, double>> blobToPoints(const void* data, size_t size)
+{
+  vector<std::pair<double, double>> points(size / (2 * sizeof(double)));
+  // The blob may not be aligned for doubles, so copy rather than cast
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    std::memcpy(&points[i].first, static_cast<const char*>(data) + 2 * i * sizeof(double), sizeof(double));
+    std::memcpy(&points[i].second, static_cast<const char*>(data) + (2 * i + 1) * sizeof(double), sizeof(double));
+  }
+  return points;
+}
+
+vector<std::pair<double, double>> regionPoints(const SQLiteStatement& row, int column)
+{
+  size_t size;
+  auto data = row.blob(column, size);
+  return blobToPoints(data, size);
+}
+
+/// The parent map of a row from one of the get_*_by_id statements, which join in its map ID, entity ID and name
+Map parentMap(const SQLiteStatement& row, int column, LongTermMemoryConduitSQLite& ltmc)
+{
+  return { row.get<uint>(column + 1), row.get<uint>(column), row.get<string>(column + 2), ltmc };
+}
+
+/**
+ * @brief The polygon_contains(region, x, y) SQL function
+ */
+void polygonContainsFunction(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+  assert(argc == 3);
+  if (sqlite3_value_type(argv[0]) != SQLITE_BLOB || sqlite3_value_type(argv[1]) == SQLITE_NULL ||
+      sqlite3_value_type(argv[2]) == SQLITE_NULL)
+  {
+    sqlite3_result_null(context);
+    return;
+  }
+  auto polygon = blobToPoints(sqlite3_value_blob(argv[0]), sqlite3_value_bytes(argv[0]));
+  if (polygon.empty())
+  {
+    sqlite3_result_int(context, 0);
+    return;
+  }
+  sqlite3_result_int(context,
+                     polygonContains(polygon, sqlite3_value_double(argv[1]), sqlite3_value_double(argv[2])) ? 1 : 0);
+}
+
+/**
+ * @brief Configures each connection as it's opened
+ *
+ * Registers the prepared statements and SQL functions, which are per connection in SQLite, and turns on the settings
+ * that don't persist in the database file.
+ */
+void setupConnection(SQLiteConnection& connection)
+{
+  sqlite3_busy_timeout(connection.handle(), BUSY_TIMEOUT_MS);
+  // WAL lets readers work alongside a writer, and in WAL mode, syncing only at checkpoints is still safe against
+  // corruption. Foreign keys are what the cascading deletes rely on.
+  connection.exec("PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL; PRAGMA foreign_keys = ON");
+  int result = sqlite3_create_function(connection.handle(), "polygon_contains", 3,
+                                       SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, polygonContainsFunction,
+                                       nullptr, nullptr);
+  if (result != SQLITE_OK)
+  {
+    throw SQLiteError(result, sqlite3_errmsg(connection.handle()));
+  }
+  for (const auto& statement : PREPARED_STATEMENTS)
+  {
+    connection.prepare(statement.first, statement.second);
+  }
+}
+
+void addDefaultEntities(SQLiteConnection& connection)
+{
+  connection.prepared("add_default_entities").exec();
+  connection.prepared("add_default_concepts").exec();
+  connection.prepared("add_default_instances").exec();
+  connection.prepared("reset_entity_ids").exec();
+}
+
+/**
+ * @brief Creates the schema and adds the default knowledge if the database file is new
+ */
+void createSchema(SQLiteConnection& connection)
+{
+  // Taking the write lock first means only one process creates the schema
+  connection.exec("BEGIN IMMEDIATE");
+  try
+  {
+    bool is_new;
+    {
+      auto version = connection.query("PRAGMA user_version");
+      version.step();
+      is_new = version.get<int>(0) == 0;
+    }
+    if (is_new)
+    {
+      connection.exec(SCHEMA_SQLITE);
+      connection.prepared("add_default_attributes").exec();
+      addDefaultEntities(connection);
+    }
+    connection.exec("COMMIT");
+  }
+  catch (...)
+  {
+    connection.exec("ROLLBACK");
+    throw;
+  }
+}
+
+/**
+ * @brief Decodes rows from the typed attribute union (see the get_attributes statement)
+ *
+ * The type column says how to read the value column, so rows of every type can be mixed freely. Text is read in
+ * place, so decoding doesn't allocate.
+ * @tparam Attributes a vector of EntityAttributes or an AttributeBatch
+ */
+template <typename Attributes>
+void unwrapAttributeRow(const SQLiteStatement& row, Attributes& entity_attributes)
+{
+  auto entity_id = row.get<uint>(0);
+  size_t size;
+  auto text = row.text(1, size);
+  AttributeString attribute_name(text, size);
+  switch (row.get<int>(2))
+  {
+    case Id:
+      // Databases rarely have uint support, so IDs have always come back as ints
+      entity_attributes.emplace_back(entity_id, attribute_name, row.get<int>(3));
+      break;
+    case Bool:
+      entity_attributes.emplace_back(entity_id, attribute_name, row.get<bool>(3));
+      break;
+    case Int:
+      entity_attributes.emplace_back(entity_id, attribute_name, row.get<int>(3));
+      break;
+    case Float:
+      entity_attributes.emplace_back(entity_id, attribute_name, row.get<double>(3));
+      break;
+    case Str:
+      text = row.text(3, size);
+      entity_attributes.emplace_back(entity_id, attribute_name, AttributeString(text, size));
+      break;
+    default:
+      assert(false);
+  }
+}
+
+/**
+ * @brief Binds an attribute value as the next parameter of a statement
+ */
+SQLiteStatement& bindValue(SQLiteStatement& statement, const AttributeValue& value)
+{
+  switch (value.which())
+  {
+    case Id:
+      return statement(value.get<uint>());
+    case Bool:
+      return statement(value.get<bool>());
+    case Int:
+      return statement(value.get<int>());
+    case Float:
+      return statement(value.get<double>());
+    default:
+      return statement(value.get<string>());
+  }
+}
+
+string instanceKey(const string& name, const string& concept_name)
+{
+  // Names can't contain NUL, so this can't be ambiguous
+  return concept_name + '\0' + name;
+}
+}  // namespace
+
+// The hostname only exists to match the PostgreSQL backend's constructor
+LongTermMemoryConduitSQLite::LongTermMemoryConduitSQLite(const string& db_name, const string& /* hostname */,
+                                                         size_t max_connections)
+  : LongTermMemoryConduitInterface<LongTermMemoryConduitSQLite>()
+  , connections(new SQLiteConnectionPool(db_name, max_connections, setupConnection))
+  , attribute_schema(new AttributeSchema())
+  , concept_index(new ConceptIndex())
+  , spatial_indexes(new SpatialIndexes())
+  , write_batches(new WriteBatches())
+{
+  // Open a connection up front so a bad path is reported here rather than on first use
+  createSchema(*connections->acquire());
+}
+
+LongTermMemoryConduitSQLite::~LongTermMemoryConduitSQLite()
+{
+  if (!write_batches)
+  {
+    return;
+  }
+  // Anything still open was never committed. Inner batches have to be closed before the ones they belong to.
+  for (auto& thread : write_batches->by_thread)
+  {
+    auto& batches = thread.second.batches;
+    while (!batches.empty())
+    {
+      batches.pop_back();
+    }
+  }
+}
+
+SQLiteConnectionPool::Lease LongTermMemoryConduitSQLite::borrowConnection()
+{
+  return connections->acquire();
+}
+
+LongTermMemoryConduitSQLite::Transaction::~Transaction()
+{
+  try
+  {
+    abort();
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+  }
+}
+
+void LongTermMemoryConduitSQLite::Transaction::commit()
+{
+  if (open)
+  {
+    // Closed first, as a failed commit leaves nothing that could be rolled back
+    open = false;
+    connection->exec(commit_sql);
+  }
+}
+
+void LongTermMemoryConduitSQLite::Transaction::abort()
+{
+  if (open)
+  {
+    open = false;
+    connection->exec(rollback_sql);
+  }
+}
+
+SQLiteConnection* LongTermMemoryConduitSQLite::batchConnection() const
+{
+  std::lock_guard<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+  if (thread != write_batches->by_thread.end())
+  {
+    return &*thread->second.batches.back().txn;
+  }
+  return nullptr;
+}
+
+LongTermMemoryConduitSQLite::Transaction LongTermMemoryConduitSQLite::openTransaction() const
+{
+  if (auto batch = batchConnection())
+  {
+    batch->exec("SAVEPOINT operation");
+    return { {}, *batch, "RELEASE operation", "ROLLBACK TO operation; RELEASE operation" };
+  }
+  auto connection = connections->acquire();
+  connection->exec("BEGIN IMMEDIATE");
+  SQLiteConnection& db = *connection;
+  return { std::move(connection), db, "COMMIT", "ROLLBACK" };
+}
+
+LongTermMemoryConduitSQLite::Transaction LongTermMemoryConduitSQLite::openReadTransaction() const
+{
+  if (auto batch = batchConnection())
+  {
+    return { {}, *batch, "", "" };
+  }
+  auto connection = connections->acquire();
+  SQLiteConnection& db = *connection;
+  return { std::move(connection), db, "", "" };
+}
+
+// WRITE BATCH BACKERS
+
+bool LongTermMemoryConduitSQLite::beginWriteBatch()
+{
+  try
+  {
+    // The outermost batch is a real transaction, and nested ones are savepoints within it. Either way, the batch
+    // belongs to this thread. Other threads can keep reading while it's open, but their writes wait for it.
+    auto outer = batchConnection();
+    if (outer)
+    {
+      outer->exec("SAVEPOINT write_batch");
+    }
+    Transaction batch = outer ? Transaction({}, *outer, "RELEASE write_batch",
+                                            "ROLLBACK TO write_batch; RELEASE write_batch") :
+                                openTransaction();
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    write_batches->by_thread[std::this_thread::get_id()].batches.push_back({ std::move(batch), {}, {} });
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitSQLite::commitWriteBatch()
+{
+  return closeWriteBatch([](Transaction& batch) {
+    try
+    {
+      batch.commit();
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+      return false;
+    }
+    return true;
+  });
+}
+
+void LongTermMemoryConduitSQLite::abortWriteBatch()
+{
+  closeWriteBatch([](Transaction& batch) {
+    try
+    {
+      batch.abort();
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << e.what() << std::endl;
+    }
+    return false;
+  });
+}
+
+bool LongTermMemoryConduitSQLite::closeWriteBatch(const std::function<bool(Transaction&)>& close)
+{
+  auto id = std::this_thread::get_id();
+  std::unique_lock<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(id);
+  assert(thread != write_batches->by_thread.end());
+  auto batch = std::move(thread->second.batches.back());
+  thread->second.batches.pop_back();
+  bool outermost = thread->second.batches.empty();
+  if (outermost)
+  {
+    write_batches->by_thread.erase(thread);
+  }
+  lock.unlock();
+
+  bool committed = close(batch.txn);
+  if (!committed)
+  {
+    // The batch may have added attributes that are now gone, so the schema cache can't be trusted
+    std::lock_guard<std::mutex> schema_lock(attribute_schema->mutex);
+    attribute_schema->loaded = false;
+  }
+  if (outermost)
+  {
+    if (committed)
+    {
+      for (const auto& change : batch.concept_changes)
+      {
+        change(*concept_index);
+      }
+      for (const auto& change : batch.spatial_changes)
+      {
+        change(*spatial_indexes);
+      }
+    }
+    return committed;
+  }
+
+  lock.lock();
+  auto& outer = write_batches->by_thread.at(id);
+  if (committed)
+  {
+    auto& parent = outer.batches.back();
+    parent.concept_changes.insert(parent.concept_changes.end(), batch.concept_changes.begin(),
+                                  batch.concept_changes.end());
+    parent.spatial_changes.insert(parent.spatial_changes.end(), batch.spatial_changes.begin(),
+                                  batch.spatial_changes.end());
+    return true;
+  }
+  // The thread's own indexes took on the changes that were just rolled back. They're read again from what's left of
+  // the batch, or dropped if the batches left haven't changed them, so that the shared indexes are read again.
+  if (!batch.concept_changes.empty())
+  {
+    bool changed = std::any_of(outer.batches.begin(), outer.batches.end(),
+                               [](const OpenBatch& open) { return !open.concept_changes.empty(); });
+    outer.concept_index.reset(changed ? new ConceptIndex() : nullptr);
+  }
+  if (!batch.spatial_changes.empty())
+  {
+    bool changed = std::any_of(outer.batches.begin(), outer.batches.end(),
+                               [](const OpenBatch& open) { return !open.spatial_changes.empty(); });
+    outer.spatial_indexes.reset(changed ? new SpatialIndexes() : nullptr);
+  }
+  return false;
+}
+
+bool LongTermMemoryConduitSQLite::addEntity(uint id)
+{
+  auto txn = openTransaction();
+  int added = txn->prepared("add_entity_with_id")(id).exec();
+  txn.commit();
+  return added == 1;
+}
+
+/**
+ * @brief Add a new attribute
+ * @param name the name of the attribute
+ * @param type the type of data for the attribute's values
+ * @return whether the attribute was added. Note that addition will fail if the attribute already exists.
+ */
+bool LongTermMemoryConduitSQLite::addNewAttribute(const string& name, const AttributeValueType type)
+{
+  // Names are held to the schemas' varchar(24) limit on every backend
+  if (!fitsAttributeString(name))
+  {
+    return false;
+  }
+  try
+  {
+    auto txn = openTransaction();
+    int added = txn->prepared("add_new_attribute")(name)(attribute_value_type_to_string[type]).exec();
+    txn.commit();
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    attribute_schema_generation++;
+    if (added != 1)
+    {
+      return false;
+    }
+    attribute_schema->types[name] = type;
+    return true;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    // Most likely the attribute already exists, so it's worth looking for again even if the cache has missed it
+    attribute_schema_generation++;
+    return false;
+  }
+}
+
+bool LongTermMemoryConduitSQLite::entityExists(uint id) const
+{
+  auto txn = openReadTransaction();
+  auto result = txn->prepared("entity_exists")(id);
+  result.step();
+  return result.get<uint>(0) == 1;
+}
+
+/**
+ * @brief Collects the entity IDs in the first column of a statement's rows
+ */
+template <typename LTMC>
+vector<LTMCEntity<LTMC>> entityRows(SQLiteStatement&& rows, LTMC& ltmc)
+{
+  vector<LTMCEntity<LTMC>> entities;
+  while (rows.step())
+  {
+    entities.emplace_back(rows.get<uint>(0), ltmc);
+  }
+  return entities;
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                            const uint other_entity_id)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(other_entity_id));
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                            const bool bool_val)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(bool_val));
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                            const int int_val)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(int_val));
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                            const double float_val)
+{
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(float_val));
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                            const char* string_val)
+{
+  return this->getEntitiesWithAttributeOfValue(attribute_name, std::string(string_val));
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeOfValue(const string& attribute_name,
+                                                                            const string& string_val)
+{
+  if (!fitsAttributeString(string_val))
+  {
+    return {};
+  }
+  return getEntitiesWithAttributeValue(attribute_name, AttributeValue(string_val));
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getEntitiesWithAttributeValue(const string& attribute_name,
+                                                                          const AttributeValue& value)
+{
+  // Values live in the table for their attribute's type, so no other table could hold a match
+  auto type = attributeType(attribute_name);
+  if (!type)
+  {
+    return {};
+  }
+  auto converted = convertAttributeValue(value, *type);
+  if (!converted)
+  {
+    return {};
+  }
+  auto txn = openReadTransaction();
+  auto statement = txn->prepared("get_entities_with_attribute_of_value_" + attribute_value_type_to_string[*type]);
+  return entityRows(std::move(bindValue(statement, *converted)(attribute_name)), *this);
+}
+
+vector<Entity> LongTermMemoryConduitSQLite::getAllEntities()
+{
+  auto txn = openReadTransaction();
+  return entityRows(txn->prepared("get_all_entities"), *this);
+}
+
+vector<Map> LongTermMemoryConduitSQLite::getAllMaps()
+{
+  auto txn = openReadTransaction();
+  auto rows = txn->prepared("get_all_maps");
+  vector<Map> maps;
+  while (rows.step())
+  {
+    maps.emplace_back(rows.get<uint>(0), rows.get<uint>(1), rows.get<string>(2), *this);
+  }
+  return maps;
+}
+
+uint LongTermMemoryConduitSQLite::deleteAllAttributes()
+{
+  auto txn = openTransaction();
+
+  // Remove all attributes
+  uint num_deleted = txn->prepared("delete_all_attributes").exec();
+  // Put the default configuration back
+  txn->prepared("add_default_attributes").exec();
+  txn.commit();
+  // Reloaded on next use, rather than keeping a second copy of the defaults here
+  {
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    attribute_schema->loaded = false;
+  }
+  unloadConceptIndex();
+  return num_deleted;
+}
+
+uint LongTermMemoryConduitSQLite::deleteAllEntities()
+{
+  uint num_deleted;
+  {
+    auto txn = openTransaction();
+    // Remove all entities
+    num_deleted = txn->prepared("delete_all_entities").exec();
+    // Put the default configuration back
+    addDefaultEntities(*txn);
+    txn.commit();
+  }
+  unloadConceptIndex();
+  unloadSpatialIndexes();
+  assert(entityExists(1));
+  return num_deleted;
+}
+
+bool LongTermMemoryConduitSQLite::deleteAttribute(const string& name)
+{
+  auto txn = openTransaction();
+  int num_deleted = txn->prepared("delete_attribute")(name).exec();
+  txn.commit();
+  if (name == "is_a")
+  {
+    unloadConceptIndex();
+  }
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  attribute_schema_generation++;
+  attribute_schema->types.erase(name);
+  return num_deleted;
+}
+
+bool LongTermMemoryConduitSQLite::attributeExists(const string& name) const
+{
+  return attributeType(name).is_initialized();
+}
+
+boost::optional<AttributeValueType> LongTermMemoryConduitSQLite::attributeType(const string& name) const
+{
+  {
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    if (attribute_schema->loaded)
+    {
+      auto type = attribute_schema->types.find(name);
+      if (type != attribute_schema->types.end())
+      {
+        return type->second;
+      }
+      if (attribute_schema->loaded_generation == attribute_schema_generation)
+      {
+        // Already looked for since the schema last changed
+        return {};
+      }
+    }
+  }
+  // Either the cache hasn't been loaded, or the attribute was added by someone else since it was
+  loadAttributeSchema();
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  auto type = attribute_schema->types.find(name);
+  if (type != attribute_schema->types.end())
+  {
+    return type->second;
+  }
+  return {};
+}
+
+void LongTermMemoryConduitSQLite::loadAttributeSchema() const
+{
+  uint64_t generation = attribute_schema_generation;
+  // The lock isn't held while querying, as waiting for a connection with it held could hold up every other thread
+  std::unordered_map<string, AttributeValueType> types;
+  {
+    auto txn = openReadTransaction();
+    auto rows = txn->prepared("get_all_attributes");
+    while (rows.step())
+    {
+      types.emplace(rows.get<string>(0), string_to_attribute_value_type[rows.get<string>(1)]);
+    }
+  }
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  attribute_schema->types = std::move(types);
+  attribute_schema->loaded = true;
+  // If the schema changed while we were reading, what we read may be missing it, so misses are looked up again
+  attribute_schema->loaded_generation = generation;
+}
+
+void LongTermMemoryConduitSQLite::updateConceptIndex(const std::function<void(ConceptHierarchy&)>& update)
+{
+  changeConceptIndex([update](ConceptIndex& index) {
+    std::lock_guard<std::mutex> lock(index.mutex);
+    index.generation++;
+    if (index.loaded)
+    {
+      update(index.hierarchy);
+    }
+  });
+}
+
+void LongTermMemoryConduitSQLite::unloadConceptIndex()
+{
+  changeConceptIndex([](ConceptIndex& index) {
+    std::lock_guard<std::mutex> lock(index.mutex);
+    index.generation++;
+    index.loaded = false;
+    index.hierarchy.clear();
+  });
+}
+
+void LongTermMemoryConduitSQLite::changeConceptIndex(const std::function<void(ConceptIndex&)>& change)
+{
+  {
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+    if (thread != write_batches->by_thread.end())
+    {
+      // A fresh copy is loaded from inside the batch, so it sees the batch's earlier changes too
+      auto& own = thread->second.concept_index;
+      if (!own)
+      {
+        own.reset(new ConceptIndex());
+      }
+      change(*own);
+      thread->second.batches.back().concept_changes.push_back(change);
+      return;
+    }
+  }
+  change(*concept_index);
+}
+
+LongTermMemoryConduitSQLite::ConceptIndex& LongTermMemoryConduitSQLite::conceptIndex() const
+{
+  std::lock_guard<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+  if (thread != write_batches->by_thread.end() && thread->second.concept_index)
+  {
+    return *thread->second.concept_index;
+  }
+  return *concept_index;
+}
+
+void LongTermMemoryConduitSQLite::querySpatialIndex(uint map_entity_id, uint map_id,
+                                                    const std::function<void(const MapSpatialIndex&)>& query)
+{
+  auto& indexes = spatialIndexes();
+  while (true)
+  {
+    uint64_t generation;
+    {
+      std::lock_guard<std::mutex> lock(indexes.mutex);
+      auto index = indexes.by_map_id.find(map_id);
+      if (index != indexes.by_map_id.end())
+      {
+        query(index->second.second);
+        return;
+      }
+      generation = indexes.generation;
+    }
+    // The map's geometry is read and indexed without the lock held, as with the concept index
+    vector<MapSpatialIndex::RegionEntry> regions;
+    vector<MapSpatialIndex::PointEntry> points;
+    vector<MapSpatialIndex::PointEntry> poses;
+    vector<MapSpatialIndex::DoorEntry> doors;
+    {
+      auto txn = openReadTransaction();
+      auto region_rows = txn->prepared("get_all_regions")(map_id);
+      while (region_rows.step())
+      {
+        regions.push_back({ region_rows.get<uint>(0), region_rows.get<string>(1), regionPoints(region_rows, 2) });
+      }
+      auto point_rows = txn->prepared("get_all_points")(map_id);
+      while (point_rows.step())
+      {
+        points.push_back({ point_rows.get<uint>(0), point_rows.get<string>(1), point_rows.get<double>(2),
+                           point_rows.get<double>(3), 0 });
+      }
+      auto pose_rows = txn->prepared("get_all_poses")(map_id);
+      while (pose_rows.step())
+      {
+        poses.push_back({ pose_rows.get<uint>(0), pose_rows.get<string>(1), pose_rows.get<double>(2),
+                          pose_rows.get<double>(3), pose_rows.get<double>(4) });
+      }
+      auto door_rows = txn->prepared("get_all_doors")(map_id);
+      while (door_rows.step())
+      {
+        doors.push_back({ door_rows.get<uint>(0), door_rows.get<string>(1), door_rows.get<double>(2),
+                          door_rows.get<double>(3), door_rows.get<double>(4), door_rows.get<double>(5) });
+      }
+    }
+    MapSpatialIndex loaded;
+    loaded.reset(std::move(regions), std::move(points), std::move(poses), std::move(doors));
+
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    if (indexes.generation != generation)
+    {
+      // Something changed while we were reading, so what we read may already be out of date
+      continue;
+    }
+    auto& index = indexes.by_map_id[map_id];
+    index = std::make_pair(map_entity_id, std::move(loaded));
+    query(index.second);
+    return;
+  }
+}
+
+void LongTermMemoryConduitSQLite::updateSpatialIndex(uint map_id, const std::function<void(MapSpatialIndex&)>& update)
+{
+  changeSpatialIndexes([map_id, update](SpatialIndexes& indexes) {
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    indexes.generation++;
+    auto index = indexes.by_map_id.find(map_id);
+    if (index != indexes.by_map_id.end())
+    {
+      update(index->second.second);
+    }
+  });
+}
+
+void LongTermMemoryConduitSQLite::removeFromSpatialIndexes(uint entity_id)
+{
+  changeSpatialIndexes([entity_id](SpatialIndexes& indexes) {
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    indexes.generation++;
+    auto& by_map_id = indexes.by_map_id;
+    for (auto index = by_map_id.begin(); index != by_map_id.end();)
+    {
+      if (index->second.first == entity_id)
+      {
+        index = by_map_id.erase(index);
+        continue;
+      }
+      index->second.second.removeEntity(entity_id);
+      ++index;
+    }
+  });
+}
+
+void LongTermMemoryConduitSQLite::unloadSpatialIndexes()
+{
+  changeSpatialIndexes([](SpatialIndexes& indexes) {
+    std::lock_guard<std::mutex> lock(indexes.mutex);
+    indexes.generation++;
+    indexes.by_map_id.clear();
+  });
+}
+
+void LongTermMemoryConduitSQLite::changeSpatialIndexes(const std::function<void(SpatialIndexes&)>& change)
+{
+  {
+    std::lock_guard<std::mutex> lock(write_batches->mutex);
+    auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+    if (thread != write_batches->by_thread.end())
+    {
+      auto& own = thread->second.spatial_indexes;
+      if (!own)
+      {
+        own.reset(new SpatialIndexes());
+      }
+      change(*own);
+      thread->second.batches.back().spatial_changes.push_back(change);
+      return;
+    }
+  }
+  change(*spatial_indexes);
+}
+
+LongTermMemoryConduitSQLite::SpatialIndexes& LongTermMemoryConduitSQLite::spatialIndexes() const
+{
+  std::lock_guard<std::mutex> lock(write_batches->mutex);
+  auto thread = write_batches->by_thread.find(std::this_thread::get_id());
+  if (thread != write_batches->by_thread.end() && thread->second.spatial_indexes)
+  {
+    return *thread->second.spatial_indexes;
+  }
+  return *spatial_indexes;
+}
+
+Concept LongTermMemoryConduitSQLite::getConcept(const string& name)
+{
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("get_concept_by_name")(name);
+    if (result.step())
+    {
+      return { result.get<uint>(0), name, *this };
+    }
+  }
+  Entity new_concept = addEntity();
+  auto txn = openTransaction();
+  txn->prepared("add_concept")(new_concept.entity_id)(name).exec();
+  txn.commit();
+  return { new_concept.entity_id, name, *this };
+}
+
+boost::optional<Instance> LongTermMemoryConduitSQLite::getInstanceNamed(const Concept& concept, const string& name)
+{
+  auto txn = openReadTransaction();
+  auto result = txn->prepared("get_instance_named")(name)(concept.getName());
+  if (!result.step())
+  {
+    return {};
+  }
+  // Can only be one instance with a given name
+  Instance instance{ result.get<uint>(0), *this };
+  assert(!result.step());
+  return instance;
+}
+
+boost::optional<Entity> LongTermMemoryConduitSQLite::getEntity(uint entity_id)
+{
+  if (entityExists(entity_id))
+  {
+    return Entity{ entity_id, *this };
+  }
+  return {};
+}
+
+boost::optional<Instance> LongTermMemoryConduitSQLite::getInstance(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("instance_exists")(entity_id);
+    result.step();
+    if (result.get<uint>(0) == 1)
+    {
+      return Instance{ entity_id, *this };
+    }
+    return {};
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+boost::optional<Concept> LongTermMemoryConduitSQLite::getConcept(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    // A simple count won't do because we need the name
+    auto result = txn->prepared("get_concept_by_id")(entity_id);
+    if (result.step())
+    {
+      return Concept{ entity_id, result.get<string>(0), *this };
+    }
+    return {};
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+boost::optional<Map> LongTermMemoryConduitSQLite::getMap(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    // A simple count won't do because we need the name
+    auto result = txn->prepared("get_map_by_id")(entity_id);
+    if (result.step())
+    {
+      return Map{ entity_id, result.get<uint>(1), result.get<string>(0), *this };
+    }
+    return {};
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+boost::optional<Point> LongTermMemoryConduitSQLite::getPoint(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("get_point_by_id")(entity_id);
+    if (!result.step())
+    {
+      return {};
+    }
+    return Point(entity_id, result.get<string>(0), result.get<double>(1), result.get<double>(2),
+                 parentMap(result, 3, *this), *this);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+boost::optional<Pose> LongTermMemoryConduitSQLite::getPose(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("get_pose_by_id")(entity_id);
+    if (!result.step())
+    {
+      return {};
+    }
+    return Pose(entity_id, result.get<string>(0), result.get<double>(1), result.get<double>(2),
+                result.get<double>(3), parentMap(result, 4, *this), *this);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+boost::optional<Region> LongTermMemoryConduitSQLite::getRegion(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("get_region_by_id")(entity_id);
+    if (!result.step())
+    {
+      return {};
+    }
+    return Region{ entity_id, result.get<string>(0), regionPoints(result, 1), parentMap(result, 2, *this), *this };
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+boost::optional<Door> LongTermMemoryConduitSQLite::getDoor(uint entity_id)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("get_door_by_id")(entity_id);
+    if (!result.step())
+    {
+      return {};
+    }
+    return Door{ entity_id,
+                 result.get<string>(0),
+                 result.get<double>(1),
+                 result.get<double>(2),
+                 result.get<double>(3),
+                 result.get<double>(4),
+                 parentMap(result, 5, *this),
+                 *this };
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+Instance LongTermMemoryConduitSQLite::getRobot()
+{
+  Instance robot = Instance(1, *this);
+  assert(robot.isValid());
+  return robot;
+}
+
+Entity LongTermMemoryConduitSQLite::addEntity()
+{
+  auto txn = openTransaction();
+  txn->prepared("add_entity").exec();
+  uint entity_id = txn->lastInsertId();
+  txn.commit();
+  return { entity_id, *this };
+}
+
+std::vector<Concept> LongTermMemoryConduitSQLite::getAllConcepts()
+{
+  auto txn = openReadTransaction();
+  auto rows = txn->prepared("get_all_concepts");
+  vector<Concept> concepts;
+  while (rows.step())
+  {
+    concepts.emplace_back(rows.get<uint>(0), rows.get<string>(1), *this);
+  }
+  return concepts;
+}
+
+std::vector<Instance> LongTermMemoryConduitSQLite::getAllInstances()
+{
+  auto txn = openReadTransaction();
+  auto rows = txn->prepared("get_all_instances");
+  vector<Instance> instances;
+  while (rows.step())
+  {
+    instances.emplace_back(rows.get<uint>(0), *this);
+  }
+  return instances;
+}
+
+/// A page size that can be bound to a statement's LIMIT
+int pageLimit(size_t batch_size)
+{
+  return static_cast<int>(std::min<size_t>(batch_size, std::numeric_limits<int>::max()));
+}
+
+template <typename T, typename Make>
+bool LongTermMemoryConduitSQLite::readPage(const char* statement, uint after_id, size_t limit, vector<T>& page,
+                                           Make make)
+{
+  assert(limit > 0);
+  page.clear();
+  try
+  {
+    auto txn = openReadTransaction();
+    auto rows = txn->prepared(statement)(after_id)(pageLimit(limit));
+    while (rows.step())
+    {
+      page.push_back(make(rows));
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitSQLite::getEntityPage(uint after_id, size_t limit, vector<Entity>& page)
+{
+  return readPage("scan_entities", after_id, limit, page,
+                  [this](const SQLiteStatement& row) { return Entity(row.get<uint>(0), *this); });
+}
+
+bool LongTermMemoryConduitSQLite::getConceptPage(uint after_id, size_t limit, vector<Concept>& page)
+{
+  return readPage("scan_concepts", after_id, limit, page, [this](const SQLiteStatement& row) {
+    return Concept(row.get<uint>(0), row.get<string>(1), *this);
+  });
+}
+
+bool LongTermMemoryConduitSQLite::getInstancePage(uint after_id, size_t limit, vector<Instance>& page)
+{
+  return readPage("scan_instances", after_id, limit, page,
+                  [this](const SQLiteStatement& row) { return Instance(row.get<uint>(0), *this); });
+}
+
+bool LongTermMemoryConduitSQLite::forEachEntityBatch(const std::function<void(vector<Entity>&)>& callback,
+                                                     size_t batch_size)
+{
+  return forEachPage<Entity>(
+      [this](uint after_id, size_t limit, vector<Entity>& page) { return getEntityPage(after_id, limit, page); },
+      batch_size, callback);
+}
+
+bool LongTermMemoryConduitSQLite::forEachConceptBatch(const std::function<void(vector<Concept>&)>& callback,
+                                                      size_t batch_size)
+{
+  return forEachPage<Concept>(
+      [this](uint after_id, size_t limit, vector<Concept>& page) { return getConceptPage(after_id, limit, page); },
+      batch_size, callback);
+}
+
+bool LongTermMemoryConduitSQLite::forEachInstanceBatch(const std::function<void(vector<Instance>&)>& callback,
+                                                       size_t batch_size)
+{
+  return forEachPage<Instance>(
+      [this](uint after_id, size_t limit, vector<Instance>& page) { return getInstancePage(after_id, limit, page); },
+      batch_size, callback);
+}
+
+vector<std::pair<string, AttributeValueType>> LongTermMemoryConduitSQLite::getAllAttributes() const
+{
+  bool loaded;
+  {
+    std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+    loaded = attribute_schema->loaded;
+  }
+  if (!loaded)
+  {
+    loadAttributeSchema();
+  }
+  std::lock_guard<std::mutex> lock(attribute_schema->mutex);
+  return { attribute_schema->types.begin(), attribute_schema->types.end() };
+}
+
+// MAP
+Map LongTermMemoryConduitSQLite::getMap(const std::string& name)
+{
+  {
+    auto txn = openReadTransaction();
+    auto result = txn->prepared("get_map_by_name")(name);
+    if (result.step())
+    {
+      return { result.get<uint>(0), result.get<uint>(1), name, *this };
+    }
+  }
+  Concept map_concept = getConcept("map");
+  // This should succeed because we would've retrieved it above if such an instance existed
+  Instance new_map = map_concept.createInstance(name).get();
+  auto txn = openTransaction();
+  txn->prepared("add_map")(new_map.entity_id)(name).exec();
+  uint map_id = txn->lastInsertId();
+  txn.commit();
+  return { new_map.entity_id, map_id, name, *this };
+}
+
+vector<EntityAttribute> LongTermMemoryConduitSQLite::getAllEntityAttributes()
+{
+  std::vector<EntityAttribute> entity_attrs;
+  forEachEntityAttributeBatch([&entity_attrs](vector<EntityAttribute>& batch) {
+    entity_attrs.insert(entity_attrs.end(), std::make_move_iterator(batch.begin()),
+                        std::make_move_iterator(batch.end()));
+  });
+  return entity_attrs;
+}
+
+bool LongTermMemoryConduitSQLite::getAllEntityAttributes(AttributeBatch& attributes) const
+{
+  attributes.clear();
+  return scanEntityAttributes<AttributeBatch>([&attributes](AttributeBatch& batch) { attributes.append(batch); },
+                                              10000);
+}
+
+bool LongTermMemoryConduitSQLite::forEachEntityAttributeBatch(
+    const std::function<void(std::vector<EntityAttribute>&)>& callback, size_t batch_size) const
+{
+  return scanEntityAttributes(callback, batch_size);
+}
+
+bool LongTermMemoryConduitSQLite::forEachEntityAttributeBatch(const std::function<void(AttributeBatch&)>& callback,
+                                                              size_t batch_size) const
+{
+  return scanEntityAttributes(callback, batch_size);
+}
+
+template <typename Attributes>
+bool LongTermMemoryConduitSQLite::scanEntityAttributes(const std::function<void(Attributes&)>& callback,
+                                                       size_t batch_size) const
+{
+  assert(batch_size > 0);
+  try
+  {
+    Attributes batch;
+    for (const char* statement : { "scan_attributes_id", "scan_attributes_bool", "scan_attributes_int",
+                                   "scan_attributes_float", "scan_attributes_str" })
+    {
+      uint last_rowid = 0;
+      while (true)
+      {
+        batch.clear();
+        size_t num_rows = 0;
+        {
+          auto txn = openReadTransaction();
+          auto rows = txn->prepared(statement)(last_rowid)(pageLimit(batch_size));
+          while (rows.step())
+          {
+            unwrapAttributeRow(rows, batch);
+            last_rowid = rows.get<uint>(4);
+            num_rows++;
+          }
+        }
+        if (num_rows == 0)
+        {
+          break;
+        }
+        callback(batch);
+        if (num_rows < batch_size)
+        {
+          break;
+        }
+      }
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LongTermMemoryConduitSQLite::bulkLoad(const BulkKnowledge& knowledge, BulkLoadResult& result)
+{
+  try
+  {
+    auto txn = openTransaction();
+
+    // Everything that already exists is resolved in a couple of queries. Inserts run in process and reuse their
+    // prepared statements, so there's no need for anything like COPY.
+    std::unordered_map<string, uint> concept_ids;
+    {
+      auto rows = txn->prepared("get_all_concepts");
+      while (rows.step())
+      {
+        concept_ids.emplace(rows.get<string>(1), rows.get<uint>(0));
+      }
+    }
+    std::unordered_map<string, uint> instance_ids;
+    {
+      auto rows = txn->prepared("get_named_instances");
+      while (rows.step())
+      {
+        instance_ids.emplace(instanceKey(rows.get<string>(2), rows.get<string>(1)), rows.get<uint>(0));
+      }
+    }
+    std::unordered_map<string, AttributeValueType> attribute_types;
+    {
+      auto rows = txn->prepared("get_all_attributes");
+      while (rows.step())
+      {
+        attribute_types.emplace(rows.get<string>(0), string_to_attribute_value_type[rows.get<string>(1)]);
+      }
+    }
+
+    auto add_entity = [&txn]() -> uint {
+      txn->prepared("add_entity").exec();
+      return txn->lastInsertId();
+    };
+    auto need_concept = [&](const string& name) {
+      if (concept_ids.count(name) == 0)
+      {
+        uint id = add_entity();
+        txn->prepared("add_concept")(id)(name).exec();
+        concept_ids.emplace(name, id);
+      }
+    };
+    auto resolve = [&](const BulkEntityRef& ref) -> uint {
+      if (ref.isConcept())
+      {
+        need_concept(ref.name);
+        return concept_ids.at(ref.name);
+      }
+      auto key = instanceKey(ref.name, ref.concept_name);
+      auto existing = instance_ids.find(key);
+      if (existing != instance_ids.end())
+      {
+        return existing->second;
+      }
+      need_concept(ref.concept_name);
+      uint id = add_entity();
+      txn->prepared("make_instance_of")(id)(ref.concept_name).exec();
+      txn->prepared("add_attribute_str")(id)("name")(ref.name).exec();
+      instance_ids.emplace(key, id);
+      return id;
+    };
+
+    result.concept_ids.clear();
+    result.instance_ids.clear();
+    for (const auto& name : knowledge.concepts)
+    {
+      need_concept(name);
+      result.concept_ids.push_back(concept_ids.at(name));
+    }
+    for (const auto& instance : knowledge.instances)
+    {
+      result.instance_ids.push_back(resolve(instance));
+    }
+    for (const auto& instance_of : knowledge.instance_of)
+    {
+      uint id = resolve(instance_of.first);
+      need_concept(instance_of.second);
+      txn->prepared("load_instance_of")(id)(instance_of.second).exec();
+    }
+    for (const auto& attribute : knowledge.attributes)
+    {
+      auto type = attribute_types.find(attribute.attribute_name);
+      if (type == attribute_types.end())
+      {
+        throw std::invalid_argument("No attribute named " + attribute.attribute_name);
+      }
+      uint id = resolve(attribute.entity);
+      auto value = attribute.value_entity ? AttributeValue(resolve(*attribute.value_entity)) : attribute.value;
+      auto converted = convertAttributeValue(value, type->second);
+      if (!converted)
+      {
+        throw std::invalid_argument("Can't store " + toString(value) + " as an attribute of type " +
+                                    attribute_value_type_to_string[type->second]);
+      }
+      auto statement = txn->prepared(LOAD_ATTRIBUTE_STATEMENTS[type->second]);
+      bindValue(statement(id)(attribute.attribute_name), *converted).exec();
+    }
+    txn.commit();
+    unloadConceptIndex();
+    unloadSpatialIndexes();
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    result.concept_ids.clear();
+    result.instance_ids.clear();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Formats entities' IDs as a JSON array, which statements take apart with json_each() as SQLite has no arrays
+ */
+template <typename Entities>
+string idArray(const Entities& entities)
+{
+  string array = "[";
+  for (const auto& entity : entities)
+  {
+    if (array.size() > 1)
+    {
+      array += ',';
+    }
+    array += std::to_string(entity.entity_id);
+  }
+  return array + "]";
+}
+
+vector<vector<Concept>> LongTermMemoryConduitSQLite::getConceptsRecursive(const vector<Instance>& instances)
+{
+  try
+  {
+    std::unordered_map<uint, vector<Concept>> by_instance;
+    {
+      auto txn = openReadTransaction();
+      auto rows = txn->prepared("get_concepts_recursive_batch")(idArray(instances));
+      while (rows.step())
+      {
+        by_instance[rows.get<uint>(0)].emplace_back(rows.get<uint>(1), rows.get<string>(2), *this);
+      }
+    }
+    vector<vector<Concept>> concepts;
+    concepts.reserve(instances.size());
+    for (const auto& instance : instances)
+    {
+      auto found = by_instance.find(instance.entity_id);
+      concepts.push_back(found != by_instance.end() ? found->second : vector<Concept>{});
+    }
+    return concepts;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+bool LongTermMemoryConduitSQLite::getAttributes(const vector<Entity>& entities, AttributeBatch& attributes) const
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto rows = txn->prepared("get_attributes_batch")(idArray(entities));
+    while (rows.step())
+    {
+      unwrapAttributeRow(rows, attributes);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+vector<Instance> LongTermMemoryConduitSQLite::filterInstancesOf(const vector<Instance>& instances,
+                                                                const Concept& concept)
+{
+  try
+  {
+    std::unordered_set<uint> matching;
+    {
+      auto txn = openReadTransaction();
+      auto rows = txn->prepared("filter_instances_of")(concept.entity_id)(idArray(instances));
+      while (rows.step())
+      {
+        matching.insert(rows.get<uint>(0));
+      }
+    }
+    vector<Instance> filtered;
+    for (const auto& instance : instances)
+    {
+      if (matching.count(instance.entity_id) == 1)
+      {
+        filtered.push_back(instance);
+      }
+    }
+    return filtered;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+// PROMOTERS
+
+bool LongTermMemoryConduitSQLite::makeConcept(uint id, std::string name)
+{
+  try
+  {
+    auto txn = openTransaction();
+    int added = txn->prepared("add_concept")(id)(name).exec();
+    txn.commit();
+    return added == 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+// ENTITY BACKERS
+
+bool LongTermMemoryConduitSQLite::deleteEntity(Entity& entity)
+{
+  if (!entity.isValid())
+  {
+    return false;
+  }
+  // Because we've all references to this entity have foreign key relationships with cascade set,
+  // this should clear out any references to this entity in other tables as well
+  try
+  {
+    auto txn = openTransaction();
+    int deleted = txn->prepared("delete_entity")(entity.entity_id).exec();
+    txn.commit();
+    // The delete may have cascaded to other instances, as when a map takes its geometry with it
+    uint entity_id = entity.entity_id;
+    updateConceptIndex([entity_id](ConceptHierarchy& hierarchy) {
+      hierarchy.removeEntity(entity_id);
+      hierarchy.forgetInstances();
+    });
+    removeFromSpatialIndexes(entity_id);
+    return deleted == 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool LongTermMemoryConduitSQLite::addAttributeValue(Entity& entity, const std::string& attribute_name,
+                                                    const AttributeValue& value)
+{
+  try
+  {
+    // Checked against the schema cache, so writes that could never succeed don't reach the database
+    auto type = attributeType(attribute_name);
+    if (!type)
+    {
+      return false;
+    }
+    auto converted = convertAttributeValue(value, *type);
+    if (!converted)
+    {
+      return false;
+    }
+    auto txn = openTransaction();
+    auto statement = txn->prepared("add_attribute_" + attribute_value_type_to_string[*type]);
+    int added = bindValue(statement(entity.entity_id)(attribute_name), *converted).exec();
+    txn.commit();
+    if (attribute_name == "is_a" && *type == Id)
+    {
+      uint child = entity.entity_id;
+      uint parent = converted->get<uint>();
+      updateConceptIndex([child, parent](ConceptHierarchy& hierarchy) { hierarchy.addIsA(child, parent); });
+    }
+    return added == 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool LongTermMemoryConduitSQLite::addAttribute(Entity& entity, const std::string& attribute_name,
+                                               const uint other_entity_id)
+{
+  return addAttributeValue(entity, attribute_name, AttributeValue(other_entity_id));
+}
+
+bool LongTermMemoryConduitSQLite::addAttribute(Entity& entity, const std::string& attribute_name, const bool bool_val)
+{
+  return addAttributeValue(entity, attribute_name, AttributeValue(bool_val));
+}
+
+bool LongTermMemoryConduitSQLite::addAttribute(Entity& entity, const std::string& attribute_name, const int int_val)
+{
+  return addAttributeValue(entity, attribute_name, AttributeValue(int_val));
+}
+
+bool LongTermMemoryConduitSQLite::addAttribute(Entity& entity, const std::string& attribute_name,
+                                               const double float_val)
+{
+  return addAttributeValue(entity, attribute_name, AttributeValue(float_val));
+}
+
+bool LongTermMemoryConduitSQLite::addAttribute(Entity& entity, const std::string& attribute_name,
+                                               const std::string& string_val)
+{
+  if (!fitsAttributeString(string_val))
+  {
+    return false;
+  }
+  return addAttributeValue(entity, attribute_name, AttributeValue(string_val));
+}
+
+int LongTermMemoryConduitSQLite::removeAttribute(Entity& entity, const std::string& attribute_name)
+{
+  try
+  {
+    auto txn = openTransaction();
+    int num_deleted = 0;
+    for (const auto statement : REMOVE_ATTRIBUTE_STATEMENTS)
+    {
+      num_deleted += txn->prepared(statement)(entity.entity_id)(attribute_name).exec();
+    }
+    txn.commit();
+    if (attribute_name == "is_a")
+    {
+      uint child = entity.entity_id;
+      updateConceptIndex([child](ConceptHierarchy& hierarchy) { hierarchy.removeIsA(child); });
+    }
+    return num_deleted;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 0;
+  }
+}
+
+int LongTermMemoryConduitSQLite::removeAttributeOfValue(Entity& entity, const std::string& attribute_name,
+                                                        const Entity& other_entity)
+{
+  try
+  {
+    auto txn = openTransaction();
+    int num_deleted =
+        txn->prepared("remove_attribute_of_value")(entity.entity_id)(attribute_name)(other_entity.entity_id).exec();
+    txn.commit();
+    if (attribute_name == "is_a")
+    {
+      uint child = entity.entity_id;
+      uint parent = other_entity.entity_id;
+      updateConceptIndex([child, parent](ConceptHierarchy& hierarchy) { hierarchy.removeIsA(child, parent); });
+    }
+    return num_deleted;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return 0;
+  }
+}
+
+vector<EntityAttribute> LongTermMemoryConduitSQLite::getAttributes(const Entity& entity) const
+{
+  vector<EntityAttribute> attributes;
+  try
+  {
+    auto txn = openReadTransaction();
+    auto rows = txn->prepared("get_attributes")(entity.entity_id);
+    while (rows.step())
+    {
+      unwrapAttributeRow(rows, attributes);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+  return attributes;
+}
+
+std::vector<EntityAttribute> LongTermMemoryConduitSQLite::getAttributes(const Entity& entity,
+                                                                        const std::string& attribute_name) const
+{
+  vector<EntityAttribute> attributes;
+  try
+  {
+    auto txn = openReadTransaction();
+    auto rows = txn->prepared("get_named_attributes")(entity.entity_id)(attribute_name);
+    while (rows.step())
+    {
+      unwrapAttributeRow(rows, attributes);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+  return attributes;
+}
+
+bool LongTermMemoryConduitSQLite::isValid(const Entity& entity) const
+{
+  return entityExists(entity.entity_id);
+}
+
+// INSTANCE BACKERS
+
+/**
+ * @brief Collects the (entity_id, concept_name) rows of a statement as concepts
+ */
+template <typename LTMC>
+vector<LTMCConcept<LTMC>> conceptRows(SQLiteStatement&& rows, LTMC& ltmc)
+{
+  vector<LTMCConcept<LTMC>> concepts;
+  while (rows.step())
+  {
+    concepts.emplace_back(rows.get<uint>(0), rows.get<string>(1), ltmc);
+  }
+  return concepts;
+}
+
+std::vector<Concept> LongTermMemoryConduitSQLite::getConcepts(const Instance& instance)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    return conceptRows(txn->prepared("get_concepts")(instance.entity_id), *this);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+std::vector<Concept> LongTermMemoryConduitSQLite::getConceptsRecursive(const Instance& instance)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    return conceptRows(txn->prepared("get_concepts_recursive")(instance.entity_id), *this);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+bool LongTermMemoryConduitSQLite::makeInstanceOf(Instance& instance, const Concept& concept)
+{
+  try
+  {
+    auto txn = openTransaction();
+    int added = txn->prepared("make_instance_of")(instance.entity_id)(concept.getName()).exec();
+    txn.commit();
+    uint instance_id = instance.entity_id;
+    uint concept_id = concept.entity_id;
+    updateConceptIndex([instance_id, concept_id](ConceptHierarchy& hierarchy) {
+      hierarchy.addConcept(instance_id, concept_id);
+    });
+    return added == 1;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+bool LongTermMemoryConduitSQLite::hasConceptRecursively(const Instance& instance, const Concept& concept)
+{
+  try
+  {
+    auto& index = conceptIndex();
+    while (true)
+    {
+      bool loaded;
+      uint64_t generation;
+      {
+        std::lock_guard<std::mutex> lock(index.mutex);
+        const auto& hierarchy = index.hierarchy;
+        if (index.loaded && hierarchy.knowsInstance(instance.entity_id))
+        {
+          return hierarchy.instanceOf(instance.entity_id, concept.entity_id);
+        }
+        loaded = index.loaded;
+        generation = index.generation;
+      }
+      // Whatever the index is missing is read without the lock held, as with the attribute schema
+      vector<std::pair<uint, uint>> is_a;
+      vector<uint> concept_ids;
+      {
+        auto txn = openReadTransaction();
+        if (!loaded)
+        {
+          auto rows = txn->prepared("get_is_a_relations");
+          while (rows.step())
+          {
+            is_a.emplace_back(rows.get<uint>(0), rows.get<uint>(1));
+          }
+        }
+        auto rows = txn->prepared("get_concepts")(instance.entity_id);
+        while (rows.step())
+        {
+          concept_ids.push_back(rows.get<uint>(0));
+        }
+      }
+
+      std::lock_guard<std::mutex> lock(index.mutex);
+      if (index.generation != generation)
+      {
+        // Something changed while we were reading, so what we read may already be out of date
+        continue;
+      }
+      auto& hierarchy = index.hierarchy;
+      if (!loaded)
+      {
+        hierarchy.reset(is_a);
+        index.loaded = true;
+      }
+      hierarchy.setConcepts(instance.entity_id, std::move(concept_ids));
+      return hierarchy.instanceOf(instance.entity_id, concept.entity_id);
+    }
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return false;
+  }
+}
+
+// CONCEPT BACKERS
+
+vector<Concept> LongTermMemoryConduitSQLite::getChildren(const Concept& concept)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    return conceptRows(txn->prepared("get_children")(concept.entity_id), *this);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+vector<Concept> LongTermMemoryConduitSQLite::getChildrenRecursive(const Concept& concept)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    return conceptRows(txn->prepared("get_children_recursive")(concept.entity_id), *this);
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+std::vector<Instance> LongTermMemoryConduitSQLite::getInstances(const ConceptImpl& concept)
+{
+  try
+  {
+    auto txn = openReadTransaction();
+    auto rows = txn->prepared("get_instances")(concept.getName());
+    std::vector<Instance> instances{};
+    while (rows.step())
+    {
+      instances.emplace_back(rows.get<uint>(0), *this);
+    }
+    return instances;
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl;
+    return {};
+  }
+}
+
+int LongTermMemoryConduitSQLite::removeInstances(const Concept& concept)
+{
+  auto txn = openTransaction();
+  int num_deleted = txn->prepared("remove_instances")(concept.getName()).exec();
+  txn.commit();
+  unloadConceptIndex();
+  unloadSpatialIndexes();
+  return num_deleted;
+}
+
+int LongTermMemoryConduitSQLite::removeInstancesRecursive(const Concept& concept)
+{
+  auto txn = openTransaction();
+  int num_deleted = txn->prepared("remove_instances_recursive")(concept.entity_id).exec();
+  txn.commit();
+  unloadConceptIndex();
+  unloadSpatialIndexes();
+  return num_deleted;
+}
+
+// MAP BACKERS
+
+/**
+ * @brief Adds the entity for a piece of map geometry: the entity, the map's has attribute, the name attribute and the
+ * instance_of row. The caller adds the geometry row.
+ * @return the new entity's ID
+ */
+uint addGeometryEntity(SQLiteConnection& connection, uint map_entity_id, const string& name, const char* concept_name)
+{
+  connection.prepared("add_entity").exec();
+  uint entity_id = connection.lastInsertId();
+  connection.prepared("add_attribute_id")(map_entity_id)("has")(entity_id).exec();
+  connection.prepared("add_attribute_str")(entity_id)("name")(name).exec();
+  connection.prepared("make_instance_of")(entity_id)(concept_name).exec();
+  return entity_id;
+}
+
+Point LongTermMemoryConduitSQLite::addPoint(Map& map, const std::string& name, double x, double y)
+{
+  auto txn = openTransaction();
+  uint entity_id = addGeometryEntity(*txn, map.entity_id, name, "point");
+  txn->prepared("add_point")(entity_id)(name)(map.getId())(x)(y).exec();
+  txn.commit();
+  updateSpatialIndex(map.map_id, [=](MapSpatialIndex& index) { index.addPoint({ entity_id, name, x, y, 0 }); });
+  return { entity_id, name, x, y, map, *this };
+}
+
+Pose LongTermMemoryConduitSQLite::addPose(Map& map, const string& name, double x, double y, double theta)
+{
+  auto txn = openTransaction();
+  uint entity_id = addGeometryEntity(*txn, map.entity_id, name, "pose");
+  // Stored normalized, as PostgreSQL's poses_point_angle view would return it
+  double normalized = std::atan2(std::sin(theta), std::cos(theta));
+  txn->prepared("add_pose")(entity_id)(name)(map.getId())(x)(y)(normalized).exec();
+  txn.commit();
+  updateSpatialIndex(map.map_id,
+                     [=](MapSpatialIndex& index) { index.addPose({ entity_id, name, x, y, normalized }); });
+  return { entity_id, name, x, y, theta, map, *this };
+}
+
+Region LongTermMemoryConduitSQLite::addRegion(Map& map, const string& name, const vector<Region::Point2D>& points)
+{
+  vector<double> coordinates;
+  coordinates.reserve(2 * points.size());
+  for (const auto& point : points)
+  {
+    coordinates.push_back(point.first);
+    coordinates.push_back(point.second);
+  }
+
+  auto txn = openTransaction();
+  uint entity_id = addGeometryEntity(*txn, map.entity_id, name, "region");
+  txn->prepared("add_region")(entity_id)(name)(map.getId())(coordinates.data(), coordinates.size() * sizeof(double))
+      .exec();
+  txn.commit();
+  updateSpatialIndex(map.map_id, [=](MapSpatialIndex& index) { index.addRegion({ entity_id, name, points }); });
+  return { entity_id, name, points, map, *this };
+}
+
+Door LongTermMemoryConduitSQLite::addDoor(Map& map, const string& name, double x_0, double y_0, double x_1, double y_1)
+{
+  auto txn = openTransaction();
+  uint entity_id = addGeometryEntity(*txn, map.entity_id, name, "door");
+  txn->prepared("add_door")(entity_id)(name)(map.getId())(x_0)(y_0)(x_1)(y_1).exec();
+  txn.commit();
+  updateSpatialIndex(map.map_id,
+                     [=](MapSpatialIndex& index) { index.addDoor({ entity_id, name, x_0, y_0, x_1, y_1 }); });
+  return { entity_id, name, x_0, y_0, x_1, y_1, map, *this };
+}
+
+boost::optional<Point> LongTermMemoryConduitSQLite::getPoint(Map& map, const string& name)
+{
+  auto txn = openReadTransaction();
+  auto point = txn->prepared("get_point_by_name")(map.getId())(name);
+  if (point.step())
+  {
+    return Point{ point.get<uint>(0), name, point.get<double>(1), point.get<double>(2), map, *this };
+  }
+  return {};
+}
+
+boost::optional<Pose> LongTermMemoryConduitSQLite::getPose(Map& map, const string& name)
+{
+  auto txn = openReadTransaction();
+  auto pose = txn->prepared("get_pose_by_name")(map.getId())(name);
+  if (pose.step())
+  {
+    return Pose{ pose.get<uint>(0), name, pose.get<double>(1), pose.get<double>(2), pose.get<double>(3), map, *this };
+  }
+  return {};
+}
+
+boost::optional<Region> LongTermMemoryConduitSQLite::getRegion(Map& map, const string& name)
+{
+  auto txn = openReadTransaction();
+  auto region = txn->prepared("get_region_by_name")(map.getId())(name);
+  if (region.step())
+  {
+    return Region{ region.get<uint>(0), name, regionPoints(region, 1), map, *this };
+  }
+  return {};
+}
+
+boost::optional<Door> LongTermMemoryConduitSQLite::getDoor(Map& map, const string& name)
+{
+  auto txn = openReadTransaction();
+  auto door = txn->prepared("get_door_by_name")(map.getId())(name);
+  if (door.step())
+  {
+    return Door{ door.get<uint>(0),   name, door.get<double>(1), door.get<double>(2), door.get<double>(3),
+                 door.get<double>(4), map,  *this };
+  }
+  return {};
+}
+
+/**
+ * @brief Collects (entity_id, point_name, x, y) rows as points
+ */
+template <typename LTMC>
+vector<LTMCPoint<LTMC>> pointRows(SQLiteStatement&& rows, LTMCMap<LTMC>& map, LTMC& ltmc)
+{
+  vector<LTMCPoint<LTMC>> points;
+  auto parent_map = std::make_shared<const LTMCMap<LTMC>>(map);
+  while (rows.step())
+  {
+    points.emplace_back(rows.get<uint>(0), rows.get<string>(1), rows.get<double>(2), rows.get<double>(3), parent_map,
+                        ltmc);
+  }
+  return points;
+}
+
+/**
+ * @brief Collects (entity_id, pose_name, x, y, theta) rows as poses
+ */
+template <typename LTMC>
+vector<LTMCPose<LTMC>> poseRows(SQLiteStatement&& rows, LTMCMap<LTMC>& map, LTMC& ltmc)
+{
+  vector<LTMCPose<LTMC>> poses;
+  auto parent_map = std::make_shared<const LTMCMap<LTMC>>(map);
+  while (rows.step())
+  {
+    poses.emplace_back(rows.get<uint>(0), rows.get<string>(1), rows.get<double>(2), rows.get<double>(3),
+                       rows.get<double>(4), parent_map, ltmc);
+  }
+  return poses;
+}
+
+/**
+ * @brief Collects (entity_id, region_name, region) rows as regions
+ */
+template <typename LTMC>
+vector<LTMCRegion<LTMC>> regionRows(SQLiteStatement&& rows, LTMCMap<LTMC>& map, LTMC& ltmc)
+{
+  vector<LTMCRegion<LTMC>> regions;
+  auto parent_map = std::make_shared<const LTMCMap<LTMC>>(map);
+  while (rows.step())
+  {
+    regions.emplace_back(rows.get<uint>(0), rows.get<string>(1), regionPoints(rows, 2), parent_map, ltmc);
+  }
+  return regions;
+}
+
+vector<Point> LongTermMemoryConduitSQLite::getAllPoints(Map& map)
+{
+  auto txn = openReadTransaction();
+  return pointRows(txn->prepared("get_all_points")(map.getId()), map, *this);
+}
+
+vector<Pose> LongTermMemoryConduitSQLite::getAllPoses(Map& map)
+{
+  auto txn = openReadTransaction();
+  return poseRows(txn->prepared("get_all_poses")(map.getId()), map, *this);
+}
+
+vector<Region> LongTermMemoryConduitSQLite::getAllRegions(Map& map)
+{
+  auto txn = openReadTransaction();
+  return regionRows(txn->prepared("get_all_regions")(map.getId()), map, *this);
+}
+
+vector<Door> LongTermMemoryConduitSQLite::getAllDoors(Map& map)
+{
+  auto txn = openReadTransaction();
+  auto rows = txn->prepared("get_all_doors")(map.getId());
+  vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
+  while (rows.step())
+  {
+    doors.emplace_back(rows.get<uint>(0), rows.get<string>(1), rows.get<double>(2), rows.get<double>(3),
+                       rows.get<double>(4), rows.get<double>(5), parent_map, *this);
+  }
+  return doors;
+}
+
+std::vector<Region> LongTermMemoryConduitSQLite::getContainingRegions(Map& map, double x, double y)
+{
+  vector<MapSpatialIndex::RegionEntry> containing;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { containing = index.containingRegions(x, y); });
+  vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& region : containing)
+  {
+    regions.emplace_back(region.entity_id, std::move(region.name), std::move(region.points), parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Point> LongTermMemoryConduitSQLite::getNearestPoints(Map& map, double x, double y, size_t k)
+{
+  vector<MapSpatialIndex::PointEntry> nearest;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearest = index.nearestPoints(x, y, k); });
+  vector<Point> points;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& point : nearest)
+  {
+    points.emplace_back(point.entity_id, std::move(point.name), point.x, point.y, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitSQLite::getNearestPoses(Map& map, double x, double y, size_t k)
+{
+  vector<MapSpatialIndex::PointEntry> nearest;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearest = index.nearestPoses(x, y, k); });
+  vector<Pose> poses;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& pose : nearest)
+  {
+    poses.emplace_back(pose.entity_id, std::move(pose.name), pose.x, pose.y, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Door> LongTermMemoryConduitSQLite::getNearestDoors(Map& map, double x, double y, size_t k)
+{
+  vector<MapSpatialIndex::DoorEntry> nearest;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearest = index.nearestDoors(x, y, k); });
+  vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& door : nearest)
+  {
+    doors.emplace_back(door.entity_id, std::move(door.name), door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return doors;
+}
+
+vector<Point> LongTermMemoryConduitSQLite::getPointsWithinRadius(Map& map, double x, double y, double radius)
+{
+  vector<MapSpatialIndex::PointEntry> nearby;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearby = index.pointsWithinRadius(x, y, radius); });
+  vector<Point> points;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& point : nearby)
+  {
+    points.emplace_back(point.entity_id, std::move(point.name), point.x, point.y, parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitSQLite::getPosesWithinRadius(Map& map, double x, double y, double radius)
+{
+  vector<MapSpatialIndex::PointEntry> nearby;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearby = index.posesWithinRadius(x, y, radius); });
+  vector<Pose> poses;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& pose : nearby)
+  {
+    poses.emplace_back(pose.entity_id, std::move(pose.name), pose.x, pose.y, pose.theta, parent_map, *this);
+  }
+  return poses;
+}
+
+vector<Door> LongTermMemoryConduitSQLite::getDoorsWithinRadius(Map& map, double x, double y, double radius)
+{
+  vector<MapSpatialIndex::DoorEntry> nearby;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { nearby = index.doorsWithinRadius(x, y, radius); });
+  vector<Door> doors;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& door : nearby)
+  {
+    doors.emplace_back(door.entity_id, std::move(door.name), door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return doors;
+}
+
+vector<Region> LongTermMemoryConduitSQLite::getAdjacentRegions(Map& map, const Region& region)
+{
+  vector<MapSpatialIndex::RegionEntry> adjacent;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { adjacent = index.adjacentRegions(region.entity_id); });
+  vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& entry : adjacent)
+  {
+    regions.emplace_back(entry.entity_id, std::move(entry.name), std::move(entry.points), parent_map, *this);
+  }
+  return regions;
+}
+
+vector<Region> LongTermMemoryConduitSQLite::getReachableRegions(Map& map, const Region& region)
+{
+  vector<MapSpatialIndex::RegionEntry> reachable;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { reachable = index.reachableRegions(region.entity_id); });
+  vector<Region> regions;
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& entry : reachable)
+  {
+    regions.emplace_back(entry.entity_id, std::move(entry.name), std::move(entry.points), parent_map, *this);
+  }
+  return regions;
+}
+
+bool LongTermMemoryConduitSQLite::isRegionReachable(Map& map, const Region& from, const Region& to)
+{
+  bool reachable = false;
+  querySpatialIndex(map.entity_id, map.map_id,
+                    [&](const MapSpatialIndex& index) { reachable = index.isReachable(from.entity_id, to.entity_id); });
+  return reachable;
+}
+
+bool LongTermMemoryConduitSQLite::getShortestPath(Map& map, const Region& from, const Region& to,
+                                                  vector<Region>& regions, vector<Door>& doors)
+{
+  vector<MapSpatialIndex::RegionEntry> path_regions;
+  vector<MapSpatialIndex::DoorEntry> path_doors;
+  bool found = false;
+  querySpatialIndex(map.entity_id, map.map_id, [&](const MapSpatialIndex& index) {
+    found = index.shortestPath(from.entity_id, to.entity_id, path_regions, path_doors);
+  });
+  regions.clear();
+  doors.clear();
+  auto parent_map = std::make_shared<const Map>(map);
+  for (auto& region : path_regions)
+  {
+    regions.emplace_back(region.entity_id, std::move(region.name), std::move(region.points), parent_map, *this);
+  }
+  for (auto& door : path_doors)
+  {
+    doors.emplace_back(door.entity_id, std::move(door.name), door.x_0, door.y_0, door.x_1, door.y_1, parent_map, *this);
+  }
+  return found;
+}
+
+bool LongTermMemoryConduitSQLite::renameMap(Map& map, const std::string& new_name)
+{
+  try
+  {
+    int renamed;
+    {
+      auto txn = openTransaction();
+      renamed = txn->prepared("rename_map")(new_name)(map.getName()).exec();
+      txn.commit();
+    }
+    if (renamed == 1)
+    {
+      map.removeAttribute("name");
+      map.addAttribute("name", new_name);
+    }
+    return renamed == 1;
+  }
+  catch (const std::exception& e)
+  {
+    // Likely a naming collision. In any case, we didn't rename, so return false
+    return false;
+  }
+}
+
+// REGION BACKERS
+
+vector<Point> LongTermMemoryConduitSQLite::getContainedPoints(Region& region)
+{
+  vector<MapSpatialIndex::PointEntry> contained;
+  querySpatialIndex(region.parent_map->entity_id, region.parent_map->map_id,
+                    [&](const MapSpatialIndex& index) { contained = index.containedPoints(region.entity_id); });
+  vector<Point> points;
+  for (auto& point : contained)
+  {
+    points.emplace_back(point.entity_id, std::move(point.name), point.x, point.y, region.parent_map, *this);
+  }
+  return points;
+}
+
+vector<Pose> LongTermMemoryConduitSQLite::getContainedPoses(Region& region)
+{
+  vector<MapSpatialIndex::PointEntry> contained;
+  querySpatialIndex(region.parent_map->entity_id, region.parent_map->map_id,
+                    [&](const MapSpatialIndex& index) { contained = index.containedPoses(region.entity_id); });
+  vector<Pose> poses;
+  for (auto& pose : contained)
+  {
+    poses.emplace_back(pose.entity_id, std::move(pose.name), pose.x, pose.y, pose.theta, region.parent_map, *this);
+  }
+  return poses;
+}
+
+}  // namespace knowledge_rep
@@ -0,0 +1,431 @@
+#include <knowledge_representation/MapSpatialIndex.h>
+#include <boost/geometry.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bg = boost::geometry;
+namespace bgi = boost::geometry::index;
+using std::vector;
+
+namespace knowledge_rep
+{
+namespace
+{
+/// The same tolerance PostgreSQL's geometric operators use
+const double EPSILON = 1.0E-06;
+
+template <typename Entry>
+void sortById(vector<Entry>& entries)
+{
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.entity_id < b.entity_id; });
+}
+
+/**
+ * @brief Looks up the entries for tree values, nearest to the origin first and equally distant ones in ID order
+ */
+template <typename Point, typename Value, typename Entry>
+vector<Entry> sortByDistance(const Point& origin, const vector<Value>& values,
+                             const std::unordered_map<uint, Entry>& entries)
+{
+  vector<std::pair<double, uint>> distances;
+  distances.reserve(values.size());
+  for (const auto& value : values)
+  {
+    distances.emplace_back(bg::comparable_distance(origin, value.first), value.second);
+  }
+  std::sort(distances.begin(), distances.end());
+  vector<Entry> sorted;
+  sorted.reserve(distances.size());
+  for (const auto& distance : distances)
+  {
+    sorted.push_back(entries.at(distance.second));
+  }
+  return sorted;
+}
+}  // namespace
+
+void MapSpatialIndex::clear()
+{
+  regions.clear();
+  points.clear();
+  poses.clear();
+  doors.clear();
+  region_tree.clear();
+  point_tree.clear();
+  pose_tree.clear();
+  door_tree.clear();
+  region_graph.clear();
+  graph_stale = true;
+}
+
+void MapSpatialIndex::reset(vector<RegionEntry> new_regions, vector<PointEntry> new_points,
+                            vector<PointEntry> new_poses, vector<DoorEntry> new_doors)
+{
+  clear();
+  vector<std::pair<Box, uint>> region_values;
+  region_values.reserve(new_regions.size());
+  for (auto& region : new_regions)
+  {
+    uint id = region.entity_id;
+    if (!region.points.empty())
+    {
+      region_values.emplace_back(bounds(region.points), id);
+    }
+    regions.emplace(id, std::move(region));
+  }
+  vector<std::pair<IndexedPoint, uint>> point_values;
+  point_values.reserve(new_points.size());
+  for (auto& point : new_points)
+  {
+    point_values.emplace_back(IndexedPoint(point.x, point.y), point.entity_id);
+    points.emplace(point.entity_id, std::move(point));
+  }
+  vector<std::pair<IndexedPoint, uint>> pose_values;
+  pose_values.reserve(new_poses.size());
+  for (auto& pose : new_poses)
+  {
+    pose_values.emplace_back(IndexedPoint(pose.x, pose.y), pose.entity_id);
+    poses.emplace(pose.entity_id, std::move(pose));
+  }
+  vector<std::pair<Segment, uint>> door_values;
+  door_values.reserve(new_doors.size());
+  for (auto& door : new_doors)
+  {
+    door_values.emplace_back(Segment(IndexedPoint(door.x_0, door.y_0), IndexedPoint(door.x_1, door.y_1)),
+                             door.entity_id);
+    doors.emplace(door.entity_id, std::move(door));
+  }
+  // The range constructors pack the trees, which gives better trees than inserting one value at a time
+  region_tree = RegionTree(region_values);
+  point_tree = PointTree(point_values);
+  pose_tree = PointTree(pose_values);
+  door_tree = DoorTree(door_values);
+}
+
+void MapSpatialIndex::addRegion(RegionEntry region)
+{
+  uint id = region.entity_id;
+  if (!region.points.empty())
+  {
+    region_tree.insert(std::make_pair(bounds(region.points), id));
+  }
+  regions[id] = std::move(region);
+  graph_stale = true;
+}
+
+void MapSpatialIndex::addPoint(PointEntry point)
+{
+  point_tree.insert(std::make_pair(IndexedPoint(point.x, point.y), point.entity_id));
+  points[point.entity_id] = std::move(point);
+}
+
+void MapSpatialIndex::addPose(PointEntry pose)
+{
+  pose_tree.insert(std::make_pair(IndexedPoint(pose.x, pose.y), pose.entity_id));
+  poses[pose.entity_id] = std::move(pose);
+}
+
+void MapSpatialIndex::addDoor(DoorEntry door)
+{
+  door_tree.insert(
+      std::make_pair(Segment(IndexedPoint(door.x_0, door.y_0), IndexedPoint(door.x_1, door.y_1)), door.entity_id));
+  doors[door.entity_id] = std::move(door);
+  graph_stale = true;
+}
+
+void MapSpatialIndex::removeEntity(uint entity_id)
+{
+  auto region = regions.find(entity_id);
+  if (region != regions.end())
+  {
+    if (!region->second.points.empty())
+    {
+      region_tree.remove(std::make_pair(bounds(region->second.points), entity_id));
+    }
+    regions.erase(region);
+    graph_stale = true;
+    return;
+  }
+  auto point = points.find(entity_id);
+  if (point != points.end())
+  {
+    point_tree.remove(std::make_pair(IndexedPoint(point->second.x, point->second.y), entity_id));
+    points.erase(point);
+    return;
+  }
+  auto pose = poses.find(entity_id);
+  if (pose != poses.end())
+  {
+    pose_tree.remove(std::make_pair(IndexedPoint(pose->second.x, pose->second.y), entity_id));
+    poses.erase(pose);
+    return;
+  }
+  auto door = doors.find(entity_id);
+  if (door != doors.end())
+  {
+    const auto& entry = door->second;
+    door_tree.remove(
+        std::make_pair(Segment(IndexedPoint(entry.x_0, entry.y_0), IndexedPoint(entry.x_1, entry.y_1)), entity_id));
+    doors.erase(door);
+    graph_stale = true;
+  }
+}
+
+vector<MapSpatialIndex::RegionEntry> MapSpatialIndex::containingRegions(double x, double y) const
+{
+  vector<std::pair<Box, uint>> candidates;
+  region_tree.query(bgi::intersects(IndexedPoint(x, y)), std::back_inserter(candidates));
+  vector<RegionEntry> containing;
+  for (const auto& candidate : candidates)
+  {
+    const auto& region = regions.at(candidate.second);
+    if (polygonContains(region.points, x, y))
+    {
+      containing.push_back(region);
+    }
+  }
+  sortById(containing);
+  return containing;
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::containedPoints(uint region_id) const
+{
+  auto region = regions.find(region_id);
+  if (region == regions.end())
+  {
+    return {};
+  }
+  return contained(point_tree, points, region->second);
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::containedPoses(uint region_id) const
+{
+  auto region = regions.find(region_id);
+  if (region == regions.end())
+  {
+    return {};
+  }
+  return contained(pose_tree, poses, region->second);
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::nearestPoints(double x, double y, size_t k) const
+{
+  return nearest(point_tree, points, x, y, k);
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::nearestPoses(double x, double y, size_t k) const
+{
+  return nearest(pose_tree, poses, x, y, k);
+}
+
+vector<MapSpatialIndex::DoorEntry> MapSpatialIndex::nearestDoors(double x, double y, size_t k) const
+{
+  return nearest(door_tree, doors, x, y, k);
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::pointsWithinRadius(double x, double y, double radius) const
+{
+  return withinRadius(point_tree, points, x, y, radius);
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::posesWithinRadius(double x, double y, double radius) const
+{
+  return withinRadius(pose_tree, poses, x, y, radius);
+}
+
+vector<MapSpatialIndex::DoorEntry> MapSpatialIndex::doorsWithinRadius(double x, double y, double radius) const
+{
+  return withinRadius(door_tree, doors, x, y, radius);
+}
+
+vector<MapSpatialIndex::RegionEntry> MapSpatialIndex::adjacentRegions(uint region_id) const
+{
+  vector<RegionEntry> adjacent;
+  for (auto id : regionGraph().adjacent(region_id))
+  {
+    adjacent.push_back(regions.at(id));
+  }
+  return adjacent;
+}
+
+vector<MapSpatialIndex::RegionEntry> MapSpatialIndex::reachableRegions(uint region_id) const
+{
+  vector<RegionEntry> reachable;
+  for (auto id : regionGraph().reachable(region_id))
+  {
+    reachable.push_back(regions.at(id));
+  }
+  return reachable;
+}
+
+bool MapSpatialIndex::isReachable(uint from_region_id, uint to_region_id) const
+{
+  return regionGraph().connected(from_region_id, to_region_id);
+}
+
+bool MapSpatialIndex::shortestPath(uint from_region_id, uint to_region_id, vector<RegionEntry>& path_regions,
+                                   vector<DoorEntry>& path_doors) const
+{
+  path_regions.clear();
+  path_doors.clear();
+  vector<uint> region_ids;
+  vector<uint> door_ids;
+  if (!regionGraph().shortestPath(from_region_id, to_region_id, region_ids, door_ids))
+  {
+    return false;
+  }
+  for (auto id : region_ids)
+  {
+    path_regions.push_back(regions.at(id));
+  }
+  for (auto id : door_ids)
+  {
+    path_doors.push_back(doors.at(id));
+  }
+  return true;
+}
+
+bool MapSpatialIndex::touches(const RegionEntry& region, const DoorEntry& door)
+{
+  if (region.points.empty())
+  {
+    return false;
+  }
+  if (polygonContains(region.points, door.x_0, door.y_0) || polygonContains(region.points, door.x_1, door.y_1))
+  {
+    return true;
+  }
+  // Neither end is inside, so the door touches the region only if it meets one of the edges
+  Segment line(IndexedPoint(door.x_0, door.y_0), IndexedPoint(door.x_1, door.y_1));
+  for (size_t i = 0; i < region.points.size(); i++)
+  {
+    const auto& a = region.points[i];
+    const auto& b = region.points[(i + 1) % region.points.size()];
+    Segment edge(IndexedPoint(a.first, a.second), IndexedPoint(b.first, b.second));
+    if (bg::distance(line, edge) <= EPSILON)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+const RegionGraph& MapSpatialIndex::regionGraph() const
+{
+  if (!graph_stale)
+  {
+    return region_graph;
+  }
+  vector<uint> region_ids;
+  region_ids.reserve(regions.size());
+  for (const auto& region : regions)
+  {
+    region_ids.push_back(region.first);
+  }
+  vector<std::pair<uint, vector<uint>>> door_regions;
+  door_regions.reserve(doors.size());
+  for (const auto& door : doors)
+  {
+    const auto& entry = door.second;
+    // Only regions whose boxes meet the door's line can touch it. The boxes are grown by the tolerance already.
+    Box line_bounds(IndexedPoint(std::min(entry.x_0, entry.x_1), std::min(entry.y_0, entry.y_1)),
+                    IndexedPoint(std::max(entry.x_0, entry.x_1), std::max(entry.y_0, entry.y_1)));
+    vector<std::pair<Box, uint>> candidates;
+    region_tree.query(bgi::intersects(line_bounds), std::back_inserter(candidates));
+    vector<uint> touched;
+    for (const auto& candidate : candidates)
+    {
+      if (touches(regions.at(candidate.second), entry))
+      {
+        touched.push_back(candidate.second);
+      }
+    }
+    door_regions.emplace_back(door.first, std::move(touched));
+  }
+  region_graph.reset(std::move(region_ids), door_regions);
+  graph_stale = false;
+  return region_graph;
+}
+
+MapSpatialIndex::Box MapSpatialIndex::bounds(const vector<Point2D>& points)
+{
+  double min_x = points.front().first;
+  double max_x = min_x;
+  double min_y = points.front().second;
+  double max_y = min_y;
+  for (const auto& point : points)
+  {
+    min_x = std::min(min_x, point.first);
+    max_x = std::max(max_x, point.first);
+    min_y = std::min(min_y, point.second);
+    max_y = std::max(max_y, point.second);
+  }
+  return { IndexedPoint(min_x - EPSILON, min_y - EPSILON), IndexedPoint(max_x + EPSILON, max_y + EPSILON) };
+}
+
+vector<MapSpatialIndex::PointEntry> MapSpatialIndex::contained(const PointTree& tree,
+                                                               const std::unordered_map<uint, PointEntry>& entries,
+                                                               const RegionEntry& region)
+{
+  vector<PointEntry> inside;
+  if (region.points.empty())
+  {
+    return inside;
+  }
+  vector<std::pair<IndexedPoint, uint>> candidates;
+  tree.query(bgi::covered_by(bounds(region.points)), std::back_inserter(candidates));
+  vector<Point2D> positions;
+  positions.reserve(candidates.size());
+  for (const auto& candidate : candidates)
+  {
+    positions.emplace_back(candidate.first.get<0>(), candidate.first.get<1>());
+  }
+  auto contains = PreparedPolygon(region.points).contains(positions);
+  for (size_t i = 0; i < candidates.size(); i++)
+  {
+    if (contains[i])
+    {
+      inside.push_back(entries.at(candidates[i].second));
+    }
+  }
+  sortById(inside);
+  return inside;
+}
+
+template <typename Tree, typename Entry>
+vector<Entry> MapSpatialIndex::nearest(const Tree& tree, const std::unordered_map<uint, Entry>& entries, double x,
+                                       double y, size_t k)
+{
+  if (k == 0 || tree.empty())
+  {
+    return {};
+  }
+  IndexedPoint origin(x, y);
+  vector<typename Tree::value_type> found;
+  tree.query(bgi::nearest(origin, static_cast<unsigned>(std::min(k, tree.size()))), std::back_inserter(found));
+  return sortByDistance(origin, found, entries);
+}
+
+template <typename Tree, typename Entry>
+vector<Entry> MapSpatialIndex::withinRadius(const Tree& tree, const std::unordered_map<uint, Entry>& entries,
+                                            double x, double y, double radius)
+{
+  if (radius < 0)
+  {
+    return {};
+  }
+  IndexedPoint origin(x, y);
+  Box search_box(IndexedPoint(x - radius, y - radius), IndexedPoint(x + radius, y + radius));
+  vector<typename Tree::value_type> found;
+  // The box narrows the search to a tree descent, then the exact distance trims its corners
+  tree.query(bgi::intersects(search_box) && bgi::satisfies([&](const typename Tree::value_type& value) {
+               return bg::distance(origin, value.first) <= radius;
+             }),
+             std::back_inserter(found));
+  return sortByDistance(origin, found, entries);
+}
+}  // namespace knowledge_rep
@@ -0,0 +1,79 @@
+#include <knowledge_representation/PostgreSQLConnectionPool.h>
+#include <cassert>
+#include <string>
+#include <utility>
+
+namespace knowledge_rep
+{
+PostgreSQLConnectionPool::PostgreSQLConnectionPool(std::string connection_string, size_t max_connections,
+                                                   std::function<void(pqxx::connection&)> setup)
+  : connection_string(std::move(connection_string)), max_connections(max_connections), setup(std::move(setup))
+{
+  assert(max_connections > 0);
+}
+
+PostgreSQLConnectionPool::Lease PostgreSQLConnectionPool::acquire()
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    returned.wait(lock, [this] { return !idle.empty() || num_open < max_connections; });
+    if (!idle.empty())
+    {
+      auto connection = std::move(idle.back());
+      idle.pop_back();
+      return { *this, std::move(connection) };
+    }
+    // Claim the slot now so other threads don't open past the limit while we connect
+    num_open++;
+  }
+  try
+  {
+    std::unique_ptr<pqxx::connection> connection(new pqxx::connection(connection_string));
+    setup(*connection);
+    return { *this, std::move(connection) };
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    num_open--;
+    returned.notify_one();
+    throw;
+  }
+}
+
+void PostgreSQLConnectionPool::release(std::unique_ptr<pqxx::connection> connection)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  // A connection that dropped is closed for good, so let its slot be refilled with a fresh one
+  if (connection->is_open())
+  {
+    idle.push_back(std::move(connection));
+  }
+  else
+  {
+    num_open--;
+  }
+  returned.notify_one();
+}
+
+PostgreSQLConnectionPool::Lease& PostgreSQLConnectionPool::Lease::operator=(Lease&& that) noexcept
+{
+  release();
+  pool = that.pool;
+  connection = std::move(that.connection);
+  return *this;
+}
+
+PostgreSQLConnectionPool::Lease::~Lease()
+{
+  release();
+}
+
+void PostgreSQLConnectionPool::Lease::release()
+{
+  if (connection)
+  {
+    pool->release(std::move(connection));
+  }
+}
+}  // namespace knowledge_rep
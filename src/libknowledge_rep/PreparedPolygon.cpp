@@ -0,0 +1,269 @@
+#include <knowledge_representation/PreparedPolygon.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+using std::vector;
+
+namespace knowledge_rep
+{
+namespace
+{
+/// The same tolerance PostgreSQL's geometric operators use
+const double EPSILON = 1.0E-06;
+
+/// One edge, in the form the kernels test points against
+struct Edge
+{
+  double ax, ay, by, ex, ey, inverse_slope, tolerance, min_x, max_x, min_y, max_y;
+};
+
+Edge makeEdge(const std::pair<double, double>& a, const std::pair<double, double>& b)
+{
+  double ex = b.first - a.first;
+  double ey = b.second - a.second;
+  return { a.first,
+           a.second,
+           b.second,
+           ex,
+           ey,
+           ey == 0 ? 0 : ex / ey,
+           EPSILON * std::max(std::hypot(ex, ey), 1.0),
+           std::min(a.first, b.first) - EPSILON,
+           std::max(a.first, b.first) + EPSILON,
+           std::min(a.second, b.second) - EPSILON,
+           std::max(a.second, b.second) + EPSILON };
+}
+
+/**
+ * @brief Tests a point against one edge
+ * @param inside flipped if a ray from the point in the -x direction crosses the edge
+ * @return whether the point is on the edge
+ */
+inline bool testEdge(double ax, double ay, double by, double ex, double ey, double inverse_slope, double tolerance,
+                     double min_x, double max_x, double min_y, double max_y, double x, double y, bool& inside)
+{
+  if ((ay > y) != (by > y) && x < inverse_slope * (y - ay) + ax)
+  {
+    inside = !inside;
+  }
+  double cross = ex * (y - ay) - ey * (x - ax);
+  return std::abs(cross) <= tolerance && x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+}
+
+/// The edge arrays of a prepared polygon, for the kernels
+struct EdgeArrays
+{
+  const double *ax, *ay, *by, *ex, *ey, *inverse_slope, *tolerance, *min_x, *max_x, *min_y, *max_y;
+  size_t count;
+
+  bool contains(double x, double y) const
+  {
+    bool inside = false;
+    for (size_t i = 0; i < count; i++)
+    {
+      if (testEdge(ax[i], ay[i], by[i], ex[i], ey[i], inverse_slope[i], tolerance[i], min_x[i], max_x[i], min_y[i],
+                   max_y[i], x, y, inside))
+      {
+        return true;
+      }
+    }
+    return inside;
+  }
+};
+
+#if defined(__SSE2__)
+/**
+ * @brief Tests points two at a time, starting from begin
+ * @return the index of the first point left untested
+ */
+size_t containsSse2(const EdgeArrays& edges, const double* xs, const double* ys, size_t begin, size_t count,
+                    vector<bool>& result)
+{
+  const __m128d sign = _mm_set1_pd(-0.0);
+  size_t i = begin;
+  for (; i + 2 <= count; i += 2)
+  {
+    __m128d x = _mm_loadu_pd(xs + i);
+    __m128d y = _mm_loadu_pd(ys + i);
+    __m128d inside = _mm_setzero_pd();
+    __m128d boundary = _mm_setzero_pd();
+    for (size_t e = 0; e < edges.count; e++)
+    {
+      __m128d ax = _mm_set1_pd(edges.ax[e]);
+      __m128d ay = _mm_set1_pd(edges.ay[e]);
+      __m128d dy = _mm_sub_pd(y, ay);
+      __m128d straddles = _mm_xor_pd(_mm_cmpgt_pd(ay, y), _mm_cmpgt_pd(_mm_set1_pd(edges.by[e]), y));
+      __m128d crossing_x = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(edges.inverse_slope[e]), dy), ax);
+      inside = _mm_xor_pd(inside, _mm_and_pd(straddles, _mm_cmplt_pd(x, crossing_x)));
+      __m128d cross = _mm_sub_pd(_mm_mul_pd(_mm_set1_pd(edges.ex[e]), dy),
+                                 _mm_mul_pd(_mm_set1_pd(edges.ey[e]), _mm_sub_pd(x, ax)));
+      __m128d near = _mm_cmple_pd(_mm_andnot_pd(sign, cross), _mm_set1_pd(edges.tolerance[e]));
+      __m128d in_x = _mm_and_pd(_mm_cmpge_pd(x, _mm_set1_pd(edges.min_x[e])),
+                                _mm_cmple_pd(x, _mm_set1_pd(edges.max_x[e])));
+      __m128d in_y = _mm_and_pd(_mm_cmpge_pd(y, _mm_set1_pd(edges.min_y[e])),
+                                _mm_cmple_pd(y, _mm_set1_pd(edges.max_y[e])));
+      boundary = _mm_or_pd(boundary, _mm_and_pd(near, _mm_and_pd(in_x, in_y)));
+    }
+    int mask = _mm_movemask_pd(_mm_or_pd(inside, boundary));
+    result[i] = mask & 1;
+    result[i + 1] = mask & 2;
+  }
+  return i;
+}
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+/**
+ * @brief Tests points four at a time, starting from begin. Only called on CPUs that support AVX2.
+ * @return the index of the first point left untested
+ */
+__attribute__((target("avx2"))) size_t containsAvx2(const EdgeArrays& edges, const double* xs, const double* ys,
+                                                    size_t begin, size_t count, vector<bool>& result)
+{
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  size_t i = begin;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m256d x = _mm256_loadu_pd(xs + i);
+    __m256d y = _mm256_loadu_pd(ys + i);
+    __m256d inside = _mm256_setzero_pd();
+    __m256d boundary = _mm256_setzero_pd();
+    for (size_t e = 0; e < edges.count; e++)
+    {
+      __m256d ax = _mm256_set1_pd(edges.ax[e]);
+      __m256d ay = _mm256_set1_pd(edges.ay[e]);
+      __m256d dy = _mm256_sub_pd(y, ay);
+      __m256d straddles =
+          _mm256_xor_pd(_mm256_cmp_pd(ay, y, _CMP_GT_OQ), _mm256_cmp_pd(_mm256_set1_pd(edges.by[e]), y, _CMP_GT_OQ));
+      // Multiply then add rather than fused, so the rounding matches the scalar path
+      __m256d crossing_x = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(edges.inverse_slope[e]), dy), ax);
+      inside = _mm256_xor_pd(inside, _mm256_and_pd(straddles, _mm256_cmp_pd(x, crossing_x, _CMP_LT_OQ)));
+      __m256d cross = _mm256_sub_pd(_mm256_mul_pd(_mm256_set1_pd(edges.ex[e]), dy),
+                                    _mm256_mul_pd(_mm256_set1_pd(edges.ey[e]), _mm256_sub_pd(x, ax)));
+      __m256d near = _mm256_cmp_pd(_mm256_andnot_pd(sign, cross), _mm256_set1_pd(edges.tolerance[e]), _CMP_LE_OQ);
+      __m256d in_x = _mm256_and_pd(_mm256_cmp_pd(x, _mm256_set1_pd(edges.min_x[e]), _CMP_GE_OQ),
+                                   _mm256_cmp_pd(x, _mm256_set1_pd(edges.max_x[e]), _CMP_LE_OQ));
+      __m256d in_y = _mm256_and_pd(_mm256_cmp_pd(y, _mm256_set1_pd(edges.min_y[e]), _CMP_GE_OQ),
+                                   _mm256_cmp_pd(y, _mm256_set1_pd(edges.max_y[e]), _CMP_LE_OQ));
+      boundary = _mm256_or_pd(boundary, _mm256_and_pd(near, _mm256_and_pd(in_x, in_y)));
+    }
+    int mask = _mm256_movemask_pd(_mm256_or_pd(inside, boundary));
+    for (int lane = 0; lane < 4; lane++)
+    {
+      result[i + lane] = mask & (1 << lane);
+    }
+  }
+  return i;
+}
+
+bool haveAvx2()
+{
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+#endif
+}  // namespace
+
+bool polygonContains(const vector<std::pair<double, double>>& polygon, double x, double y)
+{
+  bool inside = false;
+  for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+  {
+    auto edge = makeEdge(polygon[i], polygon[j]);
+    if (testEdge(edge.ax, edge.ay, edge.by, edge.ex, edge.ey, edge.inverse_slope, edge.tolerance, edge.min_x,
+                 edge.max_x, edge.min_y, edge.max_y, x, y, inside))
+    {
+      return true;
+    }
+  }
+  return inside;
+}
+
+PreparedPolygon::PreparedPolygon(const vector<Point2D>& vertices)
+  : bounds{ std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(),
+            std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() }
+{
+  for (auto* edge_array : { &ax, &ay, &by, &ex, &ey, &inverse_slope, &tolerance, &min_x, &max_x, &min_y, &max_y })
+  {
+    edge_array->reserve(vertices.size());
+  }
+  for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++)
+  {
+    auto edge = makeEdge(vertices[i], vertices[j]);
+    ax.push_back(edge.ax);
+    ay.push_back(edge.ay);
+    by.push_back(edge.by);
+    ex.push_back(edge.ex);
+    ey.push_back(edge.ey);
+    inverse_slope.push_back(edge.inverse_slope);
+    tolerance.push_back(edge.tolerance);
+    min_x.push_back(edge.min_x);
+    max_x.push_back(edge.max_x);
+    min_y.push_back(edge.min_y);
+    max_y.push_back(edge.max_y);
+    bounds[0] = std::min(bounds[0], edge.min_x);
+    bounds[1] = std::max(bounds[1], edge.max_x);
+    bounds[2] = std::min(bounds[2], edge.min_y);
+    bounds[3] = std::max(bounds[3], edge.max_y);
+  }
+}
+
+bool PreparedPolygon::contains(double x, double y) const
+{
+  if (x < bounds[0] || x > bounds[1] || y < bounds[2] || y > bounds[3])
+  {
+    return false;
+  }
+  EdgeArrays edges{ ax.data(),        ay.data(),    by.data(),    ex.data(),    ey.data(),    inverse_slope.data(),
+                    tolerance.data(), min_x.data(), max_x.data(), min_y.data(), max_y.data(), ax.size() };
+  return edges.contains(x, y);
+}
+
+vector<bool> PreparedPolygon::contains(const vector<Point2D>& points) const
+{
+  vector<bool> result(points.size());
+  // Points far from the polygon are settled by its bounding box, and only the rest go through the kernel
+  vector<size_t> candidates;
+  vector<double> xs;
+  vector<double> ys;
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    const auto& point = points[i];
+    if (point.first >= bounds[0] && point.first <= bounds[1] && point.second >= bounds[2] && point.second <= bounds[3])
+    {
+      candidates.push_back(i);
+      xs.push_back(point.first);
+      ys.push_back(point.second);
+    }
+  }
+  EdgeArrays edges{ ax.data(),        ay.data(),    by.data(),    ex.data(),    ey.data(),    inverse_slope.data(),
+                    tolerance.data(), min_x.data(), max_x.data(), min_y.data(), max_y.data(), ax.size() };
+  vector<bool> tested(candidates.size());
+  size_t done = 0;
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  if (haveAvx2())
+  {
+    done = containsAvx2(edges, xs.data(), ys.data(), done, xs.size(), tested);
+  }
+#endif
+#if defined(__SSE2__)
+  done = containsSse2(edges, xs.data(), ys.data(), done, xs.size(), tested);
+#endif
+  for (size_t i = done; i < xs.size(); i++)
+  {
+    tested[i] = edges.contains(xs[i], ys[i]);
+  }
+  for (size_t i = 0; i < candidates.size(); i++)
+  {
+    result[candidates[i]] = tested[i];
+  }
+  return result;
+}
+}  // namespace knowledge_rep
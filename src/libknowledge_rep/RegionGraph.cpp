@@ -0,0 +1,179 @@
+#include <knowledge_representation/RegionGraph.h>
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+namespace knowledge_rep
+{
+namespace
+{
+const uint UNVISITED = std::numeric_limits<uint>::max();
+}  // namespace
+
+void RegionGraph::clear()
+{
+  region_ids.clear();
+  nodes.clear();
+  edges.clear();
+  components.clear();
+  members.clear();
+}
+
+void RegionGraph::reset(vector<uint> new_region_ids, const vector<std::pair<uint, vector<uint>>>& doors)
+{
+  clear();
+  std::sort(new_region_ids.begin(), new_region_ids.end());
+  new_region_ids.erase(std::unique(new_region_ids.begin(), new_region_ids.end()), new_region_ids.end());
+  region_ids = std::move(new_region_ids);
+  for (uint i = 0; i < region_ids.size(); i++)
+  {
+    nodes.emplace(region_ids[i], i);
+  }
+
+  edges.resize(region_ids.size());
+  for (const auto& door : doors)
+  {
+    vector<uint> touched;
+    for (auto region_id : door.second)
+    {
+      auto node = nodes.find(region_id);
+      if (node != nodes.end())
+      {
+        touched.push_back(node->second);
+      }
+    }
+    for (auto a : touched)
+    {
+      for (auto b : touched)
+      {
+        if (a != b)
+        {
+          edges[a].emplace_back(b, door.first);
+        }
+      }
+    }
+  }
+  // Sorting puts each neighbour's lowest door first, and keeping only that one keeps the search deterministic
+  for (auto& neighbours : edges)
+  {
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end(),
+                                 [](const std::pair<uint, uint>& a, const std::pair<uint, uint>& b) {
+                                   return a.first == b.first;
+                                 }),
+                     neighbours.end());
+  }
+
+  components.assign(region_ids.size(), UNVISITED);
+  for (uint start = 0; start < region_ids.size(); start++)
+  {
+    if (components[start] != UNVISITED)
+    {
+      continue;
+    }
+    uint component = members.size();
+    members.emplace_back();
+    vector<uint> stack{ start };
+    components[start] = component;
+    while (!stack.empty())
+    {
+      uint node = stack.back();
+      stack.pop_back();
+      members[component].push_back(node);
+      for (const auto& edge : edges[node])
+      {
+        if (components[edge.first] == UNVISITED)
+        {
+          components[edge.first] = component;
+          stack.push_back(edge.first);
+        }
+      }
+    }
+    std::sort(members[component].begin(), members[component].end());
+  }
+}
+
+vector<uint> RegionGraph::adjacent(uint region_id) const
+{
+  vector<uint> neighbours;
+  auto node = nodes.find(region_id);
+  if (node == nodes.end())
+  {
+    return neighbours;
+  }
+  for (const auto& edge : edges[node->second])
+  {
+    neighbours.push_back(region_ids[edge.first]);
+  }
+  return neighbours;
+}
+
+vector<uint> RegionGraph::reachable(uint region_id) const
+{
+  vector<uint> reached;
+  auto node = nodes.find(region_id);
+  if (node == nodes.end())
+  {
+    return reached;
+  }
+  for (auto member : members[components[node->second]])
+  {
+    reached.push_back(region_ids[member]);
+  }
+  return reached;
+}
+
+bool RegionGraph::connected(uint from, uint to) const
+{
+  auto from_node = nodes.find(from);
+  auto to_node = nodes.find(to);
+  if (from_node == nodes.end() || to_node == nodes.end())
+  {
+    return false;
+  }
+  return components[from_node->second] == components[to_node->second];
+}
+
+bool RegionGraph::shortestPath(uint from, uint to, vector<uint>& regions, vector<uint>& doors) const
+{
+  regions.clear();
+  doors.clear();
+  if (!connected(from, to))
+  {
+    return false;
+  }
+  uint start = nodes.at(from);
+  uint goal = nodes.at(to);
+  // The node each node was first reached from, and through which door
+  vector<std::pair<uint, uint>> previous(region_ids.size(), { UNVISITED, UNVISITED });
+  previous[start] = { start, UNVISITED };
+  std::deque<uint> frontier{ start };
+  while (!frontier.empty() && previous[goal].first == UNVISITED)
+  {
+    uint node = frontier.front();
+    frontier.pop_front();
+    for (const auto& edge : edges[node])
+    {
+      if (previous[edge.first].first == UNVISITED)
+      {
+        previous[edge.first] = { node, edge.second };
+        frontier.push_back(edge.first);
+      }
+    }
+  }
+
+  for (uint node = goal; node != start; node = previous[node].first)
+  {
+    regions.push_back(region_ids[node]);
+    doors.push_back(previous[node].second);
+  }
+  regions.push_back(region_ids[start]);
+  std::reverse(regions.begin(), regions.end());
+  std::reverse(doors.begin(), doors.end());
+  return true;
+}
+}  // namespace knowledge_rep
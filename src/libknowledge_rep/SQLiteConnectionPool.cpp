@@ -0,0 +1,270 @@
+#include <knowledge_representation/SQLiteConnectionPool.h>
+#include <cassert>
+#include <string>
+#include <utility>
+
+namespace knowledge_rep
+{
+namespace
+{
+void check(sqlite3* db, int result)
+{
+  if (result != SQLITE_OK)
+  {
+    throw SQLiteError(sqlite3_extended_errcode(db), sqlite3_errmsg(db));
+  }
+}
+}  // namespace
+
+// STATEMENT
+
+SQLiteStatement::~SQLiteStatement()
+{
+  if (!stmt)
+  {
+    return;
+  }
+  if (owned)
+  {
+    sqlite3_finalize(stmt);
+  }
+  else
+  {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+  }
+}
+
+SQLiteStatement& SQLiteStatement::bound(int result)
+{
+  check(sqlite3_db_handle(stmt), result);
+  next_parameter++;
+  return *this;
+}
+
+SQLiteStatement& SQLiteStatement::operator()(int value) &
+{
+  return bound(sqlite3_bind_int(stmt, next_parameter, value));
+}
+
+SQLiteStatement& SQLiteStatement::operator()(uint value) &
+{
+  return bound(sqlite3_bind_int64(stmt, next_parameter, value));
+}
+
+SQLiteStatement& SQLiteStatement::operator()(bool value) &
+{
+  return bound(sqlite3_bind_int(stmt, next_parameter, value ? 1 : 0));
+}
+
+SQLiteStatement& SQLiteStatement::operator()(double value) &
+{
+  return bound(sqlite3_bind_double(stmt, next_parameter, value));
+}
+
+SQLiteStatement& SQLiteStatement::operator()(const std::string& value) &
+{
+  return bound(sqlite3_bind_text(stmt, next_parameter, value.data(), value.size(), SQLITE_TRANSIENT));
+}
+
+SQLiteStatement& SQLiteStatement::operator()(const void* data, size_t size) &
+{
+  return bound(sqlite3_bind_blob(stmt, next_parameter, data, size, SQLITE_TRANSIENT));
+}
+
+bool SQLiteStatement::step()
+{
+  switch (sqlite3_step(stmt))
+  {
+    case SQLITE_ROW:
+      return true;
+    case SQLITE_DONE:
+      return false;
+    default:
+    {
+      auto db = sqlite3_db_handle(stmt);
+      throw SQLiteError(sqlite3_extended_errcode(db),
+                        std::string(sqlite3_errmsg(db)) + " (in " + sqlite3_sql(stmt) + ")");
+    }
+  }
+}
+
+int SQLiteStatement::exec()
+{
+  while (step())
+  {
+  }
+  return sqlite3_changes(sqlite3_db_handle(stmt));
+}
+
+int SQLiteStatement::columnIndex(const std::string& name) const
+{
+  for (int i = 0; i < sqlite3_column_count(stmt); i++)
+  {
+    if (name == sqlite3_column_name(stmt, i))
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <>
+int SQLiteStatement::get<int>(int column) const
+{
+  return sqlite3_column_int(stmt, column);
+}
+
+template <>
+uint SQLiteStatement::get<uint>(int column) const
+{
+  return static_cast<uint>(sqlite3_column_int64(stmt, column));
+}
+
+template <>
+bool SQLiteStatement::get<bool>(int column) const
+{
+  return sqlite3_column_int(stmt, column) != 0;
+}
+
+template <>
+double SQLiteStatement::get<double>(int column) const
+{
+  return sqlite3_column_double(stmt, column);
+}
+
+template <>
+std::string SQLiteStatement::get<std::string>(int column) const
+{
+  auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+  return text ? std::string(text, sqlite3_column_bytes(stmt, column)) : std::string();
+}
+
+// CONNECTION
+
+SQLiteConnection::SQLiteConnection(const std::string& path)
+{
+  // Each connection is only used by one thread at a time, so SQLite doesn't need to lock it
+  int result = sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+                               nullptr);
+  if (result != SQLITE_OK)
+  {
+    std::string message = db ? sqlite3_errmsg(db) : sqlite3_errstr(result);
+    sqlite3_close(db);
+    throw SQLiteError(result, "Couldn't open " + path + ": " + message);
+  }
+  sqlite3_extended_result_codes(db, 1);
+}
+
+SQLiteConnection::~SQLiteConnection()
+{
+  for (auto& statement : statements)
+  {
+    sqlite3_finalize(statement.second.stmt);
+  }
+  sqlite3_close(db);
+}
+
+void SQLiteConnection::prepare(const std::string& name, const std::string& sql)
+{
+  statements[name] = { sql, nullptr };
+}
+
+SQLiteStatement SQLiteConnection::prepared(const std::string& name)
+{
+  auto statement = statements.find(name);
+  if (statement == statements.end())
+  {
+    throw std::invalid_argument("No statement prepared as " + name);
+  }
+  auto& prepared = statement->second;
+  if (!prepared.stmt)
+  {
+    check(db, sqlite3_prepare_v2(db, prepared.sql.c_str(), prepared.sql.size() + 1, &prepared.stmt, nullptr));
+  }
+  else if (sqlite3_stmt_busy(prepared.stmt))
+  {
+    // Still stepping through rows further up the stack, so this use gets a copy of its own
+    return query(prepared.sql);
+  }
+  return { prepared.stmt, false };
+}
+
+SQLiteStatement SQLiteConnection::query(const std::string& sql)
+{
+  sqlite3_stmt* stmt = nullptr;
+  check(db, sqlite3_prepare_v2(db, sql.c_str(), sql.size() + 1, &stmt, nullptr));
+  return { stmt, true };
+}
+
+void SQLiteConnection::exec(const std::string& sql)
+{
+  check(db, sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr));
+}
+
+// POOL
+
+SQLiteConnectionPool::SQLiteConnectionPool(std::string path, size_t max_connections,
+                                           std::function<void(SQLiteConnection&)> setup)
+  : path(std::move(path)), max_connections(max_connections), setup(std::move(setup))
+{
+  assert(max_connections > 0);
+}
+
+SQLiteConnectionPool::Lease SQLiteConnectionPool::acquire()
+{
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    returned.wait(lock, [this] { return !idle.empty() || num_open < max_connections; });
+    if (!idle.empty())
+    {
+      auto connection = std::move(idle.back());
+      idle.pop_back();
+      return { *this, std::move(connection) };
+    }
+    // Claim the slot now so other threads don't open past the limit while we connect
+    num_open++;
+  }
+  try
+  {
+    std::unique_ptr<SQLiteConnection> connection(new SQLiteConnection(path));
+    setup(*connection);
+    return { *this, std::move(connection) };
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    num_open--;
+    returned.notify_one();
+    throw;
+  }
+}
+
+void SQLiteConnectionPool::release(std::unique_ptr<SQLiteConnection> connection)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  idle.push_back(std::move(connection));
+  returned.notify_one();
+}
+
+SQLiteConnectionPool::Lease& SQLiteConnectionPool::Lease::operator=(Lease&& that) noexcept
+{
+  release();
+  pool = that.pool;
+  connection = std::move(that.connection);
+  return *this;
+}
+
+SQLiteConnectionPool::Lease::~Lease()
+{
+  release();
+}
+
+void SQLiteConnectionPool::Lease::release()
+{
+  if (connection)
+  {
+    pool->release(std::move(connection));
+  }
+}
+}  // namespace knowledge_rep
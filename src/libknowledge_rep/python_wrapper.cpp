@@ -15,6 +15,7 @@
 #include <knowledge_representation/LTMCPoint.h>
 #include <knowledge_representation/LTMCRegion.h>
 #include <knowledge_representation/LTMCDoor.h>
+#include <knowledge_representation/LTMCRange.h>
 #include <knowledge_representation/convenience.h>
 #include <vector>
 #include <string>
@@ -30,6 +31,7 @@ using knowledge_rep::Entity;
 using knowledge_rep::EntityAttribute;
 using knowledge_rep::Instance;
 using knowledge_rep::LongTermMemoryConduit;
+using knowledge_rep::LTMCRange;
 using knowledge_rep::Map;
 using knowledge_rep::Point;
 using knowledge_rep::Pose;
@@ -154,6 +156,21 @@ struct PythonToPairConverter
   }
 };
 
+/// @brief Converts a std::vector to a Python list. Used where an indexing suite can't work, as with std::vector<bool>.
+template <typename T>
+struct VectorToListConverter
+{
+  static PyObject* convert(const std::vector<T>& vector)
+  {
+    boost::python::list list;
+    for (const auto& element : vector)
+    {
+      list.append(static_cast<T>(element));
+    }
+    return boost::python::incref(list.ptr());
+  }
+};
+
 template <typename T1, typename T2>
 struct py_pair
 {
@@ -216,49 +233,170 @@ struct iterable_converter
   }
 };
 
-template <typename Variant>
-struct variant_adaptor
+/**
+ * @brief Converts attribute values to the Python value they hold, and Python values of each attribute type to
+ * attribute values
+ */
+struct attribute_value_adaptor
 {
-  variant_adaptor()
+  attribute_value_adaptor()
   {
-    boost::python::to_python_converter<Variant, variant_adaptor>{};
-    register_convertibles<Variant>::apply();
+    boost::python::to_python_converter<AttributeValue, attribute_value_adaptor>{};
+    boost::python::implicitly_convertible<uint, AttributeValue>();
+    boost::python::implicitly_convertible<bool, AttributeValue>();
+    boost::python::implicitly_convertible<int, AttributeValue>();
+    boost::python::implicitly_convertible<double, AttributeValue>();
+    boost::python::implicitly_convertible<std::string, AttributeValue>();
   }
 
-  template <typename T>
-  struct register_convertibles;
-  template <typename T>
-  struct register_convertibles<boost::variant<T>>
+  static PyObject* convert(AttributeValue const& v)
   {
-    static void apply()
+    boost::python::object value;
+    switch (v.which())
     {
-      boost::python::implicitly_convertible<T, Variant>();
+      case AttributeValueType::Id:
+        value = boost::python::object(v.get<uint>());
+        break;
+      case AttributeValueType::Bool:
+        value = boost::python::object(v.get<bool>());
+        break;
+      case AttributeValueType::Int:
+        value = boost::python::object(v.get<int>());
+        break;
+      case AttributeValueType::Float:
+        value = boost::python::object(v.get<double>());
+        break;
+      default:
+        value = boost::python::object(v.get<std::string>());
+        break;
     }
-  };
-  template <typename T, typename... Ts>
-  struct register_convertibles<boost::variant<T, Ts...>>
-  {
-    static void apply()
-    {
-      boost::python::implicitly_convertible<T, Variant>();
-      register_convertibles<boost::variant<Ts...>>::apply();
-    }
-  };
+    return boost::python::incref(value.ptr());
+  }
+};
+
+/// Names are held inline, so they're handed to Python as copies
+std::string getAttributeName(const EntityAttribute& attribute)
+{
+  return attribute.attribute_name;
+}
+
+/// Geometry shares its parent map with the geometry read alongside it, so each element hands Python a copy
+template <typename Geometry>
+Map getParentMap(const Geometry& geometry)
+{
+  return *geometry.parent_map;
+}
+
+/*
+ * The forEach*Batch scans, taking any Python callable. Each batch is handed over as a copy, since the conduit reuses
+ * it. An exception raised by the callable stops the scan and propagates back to the caller.
+ */
+
+bool forEachEntityBatch(LongTermMemoryConduit& ltmc, const python::object& callback, size_t batch_size)
+{
+  return ltmc.forEachEntityBatch([&callback](vector<Entity>& batch) { callback(batch); }, batch_size);
+}
+
+bool forEachConceptBatch(LongTermMemoryConduit& ltmc, const python::object& callback, size_t batch_size)
+{
+  return ltmc.forEachConceptBatch([&callback](vector<Concept>& batch) { callback(batch); }, batch_size);
+}
+
+bool forEachInstanceBatch(LongTermMemoryConduit& ltmc, const python::object& callback, size_t batch_size)
+{
+  return ltmc.forEachInstanceBatch([&callback](vector<Instance>& batch) { callback(batch); }, batch_size);
+}
+
+bool forEachEntityAttributeBatch(const LongTermMemoryConduit& ltmc, const python::object& callback, size_t batch_size)
+{
+  return ltmc.forEachEntityAttributeBatch([&callback](vector<EntityAttribute>& batch) { callback(batch); },
+                                          batch_size);
+}
 
-  static PyObject* convert(Variant const& v)
+/**
+ * @brief A Python iterator over one of the LTMC's entity ranges
+ *
+ * Entities are read a page at a time as next() asks for them, so a loop over the whole knowledge base starts at once
+ * and never holds more than a page. A page that can't be read raises RuntimeError rather than ending the loop early.
+ */
+template <typename T>
+class PyEntityIterator
+{
+public:
+  explicit PyEntityIterator(LTMCRange<T> range) : range(std::move(range))
   {
-    return apply_visitor(to_python{}, v);
   }
-  struct to_python : boost::static_visitor<PyObject*>
+
+  T next()
   {
-    template <typename T>
-    result_type operator()(T const& t) const
+    if (!started)
+    {
+      current = range.begin();
+      started = true;
+    }
+    else if (current != range.end())
+    {
+      ++current;
+    }
+    if (current == range.end())
     {
-      return boost::python::incref(boost::python::object(t).ptr());
+      if (range.failed())
+      {
+        PyErr_SetString(PyExc_RuntimeError, "Couldn't read the next page from the LTMC");
+      }
+      else
+      {
+        PyErr_SetNone(PyExc_StopIteration);
+      }
+      python::throw_error_already_set();
     }
-  };
+    return *current;
+  }
+
+private:
+  LTMCRange<T> range;
+  typename LTMCRange<T>::iterator current;
+  bool started = false;
 };
 
+/// An empty page can't be told from the end, so a page size of zero is refused before it reaches LTMCRange
+void checkPageSize(size_t page_size)
+{
+  if (page_size == 0)
+  {
+    PyErr_SetString(PyExc_ValueError, "page_size must be positive");
+    python::throw_error_already_set();
+  }
+}
+
+PyEntityIterator<Entity> entities(LongTermMemoryConduit& ltmc, size_t page_size)
+{
+  checkPageSize(page_size);
+  return PyEntityIterator<Entity>(ltmc.entities(page_size));
+}
+
+PyEntityIterator<Concept> concepts(LongTermMemoryConduit& ltmc, size_t page_size)
+{
+  checkPageSize(page_size);
+  return PyEntityIterator<Concept>(ltmc.concepts(page_size));
+}
+
+PyEntityIterator<Instance> instances(LongTermMemoryConduit& ltmc, size_t page_size)
+{
+  checkPageSize(page_size);
+  return PyEntityIterator<Instance>(ltmc.instances(page_size));
+}
+
+/// Exposes a PyEntityIterator as a Python iterator, under both Python 2's and Python 3's name for next
+template <typename T>
+void exportEntityIterator(const char* name)
+{
+  class_<PyEntityIterator<T>>(name, python::no_init)
+      .def("__iter__", python::objects::identity_function())
+      .def("__next__", &PyEntityIterator<T>::next)
+      .def("next", &PyEntityIterator<T>::next);
+}
+
 /**
  * @brief wraps a stream output overload into a to-string function for __str__ implementations
  * @tparam T
@@ -286,8 +424,12 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
   py_pair<double, double>();
   py_pair<string, AttributeValueType>();
 
+  // vector<bool> hands out proxies rather than references, so it goes back to Python as a plain list
+  python::to_python_converter<vector<bool>, VectorToListConverter<bool>>();
+
   // Automatically convert Python lists into vectors
   iterable_converter().from_python<vector<Region::Point2D>>();
+  iterable_converter().from_python<vector<Instance>>();
 
   // Expose C++ vectors of certain types as special Python classes via vector indexing suite.
   // No proxy must be set to true for the contained elements to be converted to tuples on demand
@@ -297,6 +439,14 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
 
   class_<vector<Instance>>("PyInstanceList").def(vector_indexing_suite<vector<Instance>, true>());
 
+  exportEntityIterator<Entity>("PyEntityIterator");
+
+  exportEntityIterator<Concept>("PyConceptIterator");
+
+  exportEntityIterator<Instance>("PyInstanceIterator");
+
+  class_<vector<vector<Concept>>>("PyConceptListList").def(vector_indexing_suite<vector<vector<Concept>>, true>());
+
   class_<vector<Point>>("PyPointList").def(vector_indexing_suite<vector<Point>, true>());
 
   class_<vector<Pose>>("PyPoseList").def(vector_indexing_suite<vector<Pose>, true>());
@@ -360,10 +510,10 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
       .def("has_concept_recursively", &Instance::hasConceptRecursively)
       .def("__str__", to_str_wrap<Instance>);
 
-  variant_adaptor<AttributeValue>();
+  attribute_value_adaptor();
   class_<EntityAttribute>("EntityAttribute", init<uint, string, AttributeValue>())
       .def_readonly("entity_id", &EntityAttribute::entity_id)
-      .def_readonly("attribute_name", &EntityAttribute::attribute_name)
+      .add_property("attribute_name", getAttributeName)
       .def_readonly("value", &EntityAttribute::getValue)
       .def("get_id_value", &EntityAttribute::getIdValue)
       .def("get_bool_value", &EntityAttribute::getBoolValue)
@@ -389,6 +539,17 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
       .def("get_all_poses", &Map::getAllPoses)
       .def("get_all_regions", &Map::getAllRegions)
       .def("get_all_doors", &Map::getAllDoors)
+      .def("get_nearest_points", &Map::getNearestPoints)
+      .def("get_nearest_poses", &Map::getNearestPoses)
+      .def("get_nearest_doors", &Map::getNearestDoors)
+      .def("get_points_within_radius", &Map::getPointsWithinRadius)
+      .def("get_poses_within_radius", &Map::getPosesWithinRadius)
+      .def("get_doors_within_radius", &Map::getDoorsWithinRadius)
+      .def("get_adjacent_regions", &Map::getAdjacentRegions)
+      .def("get_reachable_regions", &Map::getReachableRegions)
+      .def("is_region_reachable", &Map::isRegionReachable)
+      .def("get_region_path", &Map::getRegionPath)
+      .def("get_door_path", &Map::getDoorPath)
       .def("deep_copy", &Map::deepCopy)
       .def("rename", &Map::rename)
       .def("__str__", to_str_wrap<Map>);
@@ -396,7 +557,7 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
   class_<Point, bases<Instance>>("Point", init<uint, string, double, double, Map, LTMC&>())
       .def_readonly("x", &Point::x)
       .def_readonly("y", &Point::y)
-      .def_readonly("parent_map", &Point::parent_map)
+      .add_property("parent_map", getParentMap<Point>)
       .def("get_containing_regions", &Point::getContainingRegions)
       .def("__str__", to_str_wrap<Point>);
 
@@ -404,23 +565,25 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
       .def_readonly("x", &Pose::x)
       .def_readonly("y", &Pose::y)
       .def_readonly("theta", &Pose::theta)
-      .def_readonly("parent_map", &Pose::parent_map)
+      .add_property("parent_map", getParentMap<Pose>)
       .def("get_containing_regions", &Pose::getContainingRegions)
       .def("__str__", to_str_wrap<Pose>);
 
   class_<Region, bases<Instance>>("Region", init<uint, string, const vector<Region::Point2D>, Map, LTMC&>())
       .def_readonly("points", &Region::points)
-      .def_readonly("parent_map", &Region::parent_map)
+      .add_property("parent_map", getParentMap<Region>)
       .def("get_contained_points", &Region::getContainedPoints)
       .def("get_contained_poses", &Region::getContainedPoses)
-      .def<bool (Region::*)(double, double)>("is_point_contained", &Region::isPointContained)
-      .def<bool (Region::*)(const Region::Point2D&)>("is_point_contained", &Region::isPointContained)
-      .def<bool (Region::*)(const Point&)>("is_point_contained", &Region::isPointContained)
-      .def<bool (Region::*)(const Pose&)>("is_pose_contained", &Region::isPoseContained)
+      .def<bool (Region::*)(double, double) const>("is_point_contained", &Region::isPointContained)
+      .def<bool (Region::*)(const Region::Point2D&) const>("is_point_contained", &Region::isPointContained)
+      .def<bool (Region::*)(const Point&) const>("is_point_contained", &Region::isPointContained)
+      .def<vector<bool> (Region::*)(const vector<Region::Point2D>&) const>("are_points_contained",
+                                                                         &Region::isPointContained)
+      .def<bool (Region::*)(const Pose&) const>("is_pose_contained", &Region::isPoseContained)
       .def("__str__", to_str_wrap<Region>);
 
   class_<Door, bases<Instance>>("Door", init<uint, string, double, double, double, double, Map, LTMC&>())
-      .def_readonly("parent_map", &Door::parent_map)
+      .add_property("parent_map", getParentMap<Door>)
       .def_readonly("x_0", &Door::x_0)
       .def_readonly("y_0", &Door::y_0)
       .def_readonly("x_1", &Door::x_1)
@@ -459,8 +622,23 @@ BOOST_PYTHON_MODULE(_libknowledge_rep_wrapper_cpp)
       .def("get_all_entities", &LTMC::getAllEntities)
       .def("get_all_concepts", &LTMC::getAllConcepts)
       .def("get_all_instances", &LTMC::getAllInstances)
+      .def("for_each_entity_batch", forEachEntityBatch, (python::arg("callback"), python::arg("batch_size") = 10000))
+      .def("for_each_concept_batch", forEachConceptBatch,
+           (python::arg("callback"), python::arg("batch_size") = 10000))
+      .def("for_each_instance_batch", forEachInstanceBatch,
+           (python::arg("callback"), python::arg("batch_size") = 10000))
+      .def("for_each_entity_attribute_batch", forEachEntityAttributeBatch,
+           (python::arg("callback"), python::arg("batch_size") = 10000))
+      // The iterators keep the LTMC alive, as they read from it for as long as they're used
+      .def("entities", entities, (python::arg("page_size") = 10000), python::with_custodian_and_ward_postcall<0, 1>())
+      .def("concepts", concepts, (python::arg("page_size") = 10000), python::with_custodian_and_ward_postcall<0, 1>())
+      .def("instances", instances, (python::arg("page_size") = 10000),
+           python::with_custodian_and_ward_postcall<0, 1>())
       .def("get_all_maps", &LTMC::getAllMaps)
       .def("get_all_attributes", &LTMC::getAllAttributes)
+      .def<vector<vector<Concept>> (LTMC::*)(const vector<Instance>&)>("get_concepts_recursive",
+                                                                        &LTMC::getConceptsRecursive)
+      .def("filter_instances_of", &LTMC::filterInstancesOf)
       .def("get_entity", &LTMC::getEntity, python::return_value_policy<ReturnOptional>())
       .def("get_instance", &LTMC::getInstance, python::return_value_policy<ReturnOptional>())
       .def<optional<Concept> (LTMC::*)(uint)>("get_concept", &LTMC::getConcept,
@@ -1,4 +1,5 @@
 #include <knowledge_representation/LongTermMemoryConduit.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <knowledge_representation/convenience.h>
@@ -80,6 +81,69 @@ TEST_F(ConceptInstanceTest, GetConceptsRecursiveWorks)
   EXPECT_EQ(2, instance.getConceptsRecursive().size());
 }
 
+TEST_F(ConceptInstanceTest, BatchConceptQueriesMatchSingleQueries)
+{
+  instance.makeInstanceOf(concept);
+  concept.addAttribute("is_a", parent_concept);
+  auto parent_instance = parent_concept.createInstance();
+  Instance no_concepts(entity.entity_id, ltmc);
+  vector<Instance> instances{ instance, no_concepts, parent_instance, instance };
+
+  auto concepts = ltmc.getConceptsRecursive(instances);
+  ASSERT_EQ(4, concepts.size());
+  for (size_t i = 0; i < instances.size(); i++)
+  {
+    auto expected = instances[i].getConceptsRecursive();
+    ASSERT_EQ(expected.size(), concepts[i].size());
+    EXPECT_TRUE(std::is_permutation(expected.begin(), expected.end(), concepts[i].begin()));
+  }
+  EXPECT_EQ(2, concepts[0].size());
+  EXPECT_TRUE(concepts[1].empty());
+
+  auto filtered = ltmc.filterInstancesOf(instances, parent_concept);
+  ASSERT_EQ(3, filtered.size());
+  EXPECT_EQ(instance, filtered[0]);
+  EXPECT_EQ(parent_instance, filtered[1]);
+  EXPECT_EQ(instance, filtered[2]);
+  filtered = ltmc.filterInstancesOf(instances, concept);
+  ASSERT_EQ(2, filtered.size());
+  EXPECT_TRUE(ltmc.filterInstancesOf({}, concept).empty());
+}
+
+TEST_F(ConceptInstanceTest, HasConceptRecursivelyFollowsExistingIsA)
+{
+  // The relations are already stored when the first check loads them
+  concept.addAttribute("is_a", parent_concept);
+  instance.makeInstanceOf(concept);
+  EXPECT_TRUE(instance.hasConceptRecursively(parent_concept));
+}
+
+TEST_F(ConceptInstanceTest, HasConceptRecursivelyFollowsIsA)
+{
+  instance.makeInstanceOf(concept);
+  Concept grandparent_concept = ltmc.getConcept("grandparent concept");
+  EXPECT_TRUE(instance.hasConceptRecursively(concept));
+  EXPECT_FALSE(instance.hasConceptRecursively(parent_concept));
+  // Relations added after the first check are picked up
+  concept.addAttribute("is_a", parent_concept);
+  parent_concept.addAttribute("is_a", grandparent_concept);
+  EXPECT_TRUE(instance.hasConceptRecursively(parent_concept));
+  EXPECT_TRUE(instance.hasConceptRecursively(grandparent_concept));
+  EXPECT_FALSE(parent_concept.createInstance().hasConceptRecursively(concept));
+
+  concept.removeAttribute("is_a");
+  EXPECT_FALSE(instance.hasConceptRecursively(parent_concept));
+  EXPECT_FALSE(instance.hasConceptRecursively(grandparent_concept));
+
+  Concept other_concept = ltmc.getConcept("other concept");
+  other_concept.addAttribute("is_a", parent_concept);
+  instance.makeInstanceOf(other_concept);
+  EXPECT_TRUE(instance.hasConceptRecursively(grandparent_concept));
+  grandparent_concept.deleteEntity();
+  EXPECT_FALSE(instance.hasConceptRecursively(grandparent_concept));
+  EXPECT_TRUE(instance.hasConceptRecursively(parent_concept));
+}
+
 TEST_F(ConceptInstanceTest, CreateInstanceWorks)
 {
   auto instance = concept.createInstance();
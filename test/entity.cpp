@@ -75,12 +75,12 @@ TEST_F(EntityTest, AddEntityWorks)
 
 TEST_F(EntityTest, IdAttributeWorks)
 {
-  entity.addAttribute("is_open", 1u);
-  auto attrs = entity.getAttributes("is_open");
+  entity.addAttribute("is_near", 1u);
+  auto attrs = entity.getAttributes("is_near");
   // That's right, we aren't actually storing these as uint, because databases rarely have uint support
   ASSERT_EQ(typeid(int), attrs.at(0).value.type());
-  EXPECT_EQ(1, boost::get<int>(attrs.at(0).value));
-  EXPECT_EQ(1, entity.removeAttribute("is_open"));
+  EXPECT_EQ(1, attrs.at(0).value.get<int>());
+  EXPECT_EQ(1, entity.removeAttribute("is_near"));
 }
 
 TEST_F(EntityTest, BoolAttributeWorks)
@@ -88,13 +88,13 @@ TEST_F(EntityTest, BoolAttributeWorks)
   entity.addAttribute("is_open", true);
   auto attrs = entity.getAttributes("is_open");
   ASSERT_EQ(typeid(bool), attrs.at(0).value.type());
-  EXPECT_TRUE(boost::get<bool>(attrs.at(0).value));
+  EXPECT_TRUE(attrs.at(0).value.get<bool>());
   EXPECT_EQ(1, entity.removeAttribute("is_open"));
 
   entity.addAttribute("is_open", false);
   attrs = entity.getAttributes("is_open");
   ASSERT_EQ(typeid(bool), attrs.at(0).value.type());
-  EXPECT_FALSE(boost::get<bool>(attrs.at(0).value));
+  EXPECT_FALSE(attrs.at(0).value.get<bool>());
   EXPECT_EQ(1, entity.removeAttribute("is_open"));
 }
 
@@ -103,26 +103,110 @@ TEST_F(EntityTest, IntAttributeWorks)
   entity.addAttribute("count", -1);
   auto attrs = entity.getAttributes("count");
   ASSERT_EQ(typeid(int), attrs.at(0).value.type());
-  EXPECT_EQ(-1, boost::get<int>(attrs.at(0).value));
+  EXPECT_EQ(-1, attrs.at(0).value.get<int>());
   EXPECT_EQ(1, entity.removeAttribute("count"));
 }
 
 TEST_F(EntityTest, FloatAttributeWorks)
 {
-  entity.addAttribute("is_open", 1.f);
-  auto attrs = entity.getAttributes("is_open");
+  entity.addAttribute("height", 1.f);
+  auto attrs = entity.getAttributes("height");
   ASSERT_EQ(typeid(double), attrs.at(0).value.type());
-  EXPECT_EQ(1, boost::get<double>(attrs.at(0).value));
-  EXPECT_EQ(1, entity.removeAttribute("is_open"));
+  EXPECT_EQ(1, attrs.at(0).value.get<double>());
+  EXPECT_EQ(1, entity.removeAttribute("height"));
 }
 
 TEST_F(EntityTest, StringAttributeWorks)
 {
-  entity.addAttribute("is_open", "test");
-  auto attrs = entity.getAttributes("is_open");
+  entity.addAttribute("name", "test");
+  auto attrs = entity.getAttributes("name");
   ASSERT_EQ(typeid(string), attrs.at(0).value.type());
-  EXPECT_EQ("test", boost::get<string>(attrs.at(0).value));
-  EXPECT_EQ(1, entity.removeAttribute("is_open"));
+  EXPECT_EQ("test", attrs.at(0).value.get<string>());
+  EXPECT_EQ(1, entity.removeAttribute("name"));
+}
+
+TEST_F(EntityTest, StringAttributesLongerThan24CharactersFail)
+{
+  EXPECT_TRUE(entity.addAttribute("name", string(24, 'a')));
+  EXPECT_FALSE(entity.addAttribute("name", string(25, 'a')));
+  EXPECT_EQ(1, entity.getAttributes("name").size());
+  EXPECT_EQ(1, ltmc.getEntitiesWithAttributeOfValue("name", string(24, 'a')).size());
+  EXPECT_TRUE(ltmc.getEntitiesWithAttributeOfValue("name", string(25, 'a')).empty());
+  EXPECT_FALSE(ltmc.addNewAttribute(string(25, 'a'), AttributeValueType::Str));
+}
+
+TEST_F(EntityTest, StringAttributesCountCharactersRatherThanBytes)
+{
+  // Each of these takes two bytes of UTF-8
+  string twenty_four, twenty_five;
+  for (int i = 0; i < 24; i++)
+  {
+    twenty_four += "\u00e9";
+  }
+  twenty_five = twenty_four + "\u00e9";
+  EXPECT_TRUE(entity.addAttribute("name", twenty_four));
+  EXPECT_FALSE(entity.addAttribute("name", twenty_five));
+  auto attrs = entity.getAttributes("name");
+  ASSERT_EQ(1, attrs.size());
+  EXPECT_EQ(twenty_four, attrs.at(0).value.get<string>());
+  EXPECT_EQ(1, ltmc.getEntitiesWithAttributeOfValue("name", twenty_four).size());
+  EXPECT_TRUE(ltmc.getEntitiesWithAttributeOfValue("name", twenty_five).empty());
+  EXPECT_TRUE(ltmc.addNewAttribute(twenty_four, AttributeValueType::Str));
+  EXPECT_TRUE(entity.addAttribute(twenty_four, "value"));
+  EXPECT_EQ(1, entity.getAttributes(twenty_four).size());
+  EXPECT_FALSE(ltmc.addNewAttribute(twenty_five, AttributeValueType::Str));
+}
+
+TEST_F(EntityTest, AttributeValuesTakeTheAttributesType)
+{
+  // Numbers that fit are stored as the type the attribute was declared with
+  EXPECT_TRUE(entity.addAttribute("height", 2));
+  auto attrs = entity.getAttributes("height");
+  ASSERT_EQ(typeid(double), attrs.at(0).value.type());
+  EXPECT_EQ(2., attrs.at(0).value.get<double>());
+  EXPECT_EQ(1, ltmc.getEntitiesWithAttributeOfValue("height", 2).size());
+
+  EXPECT_TRUE(entity.addAttribute("count", 3.));
+  attrs = entity.getAttributes("count");
+  ASSERT_EQ(typeid(int), attrs.at(0).value.type());
+  EXPECT_EQ(3, attrs.at(0).value.get<int>());
+
+  // Anything else is turned away
+  EXPECT_FALSE(entity.addAttribute("count", 3.5));
+  EXPECT_FALSE(entity.addAttribute("is_open", "test"));
+  EXPECT_FALSE(entity.addAttribute("name", 1));
+  EXPECT_EQ(2, entity.getAttributes().size());
+}
+
+TEST_F(EntityTest, GetAttributesReturnsAllTypes)
+{
+  entity.addAttribute("is_open", true);
+  entity.addAttribute("count", -1);
+  entity.addAttribute("height", 1.5);
+  entity.addAttribute("name", "test");
+  auto attrs = entity.getAttributes();
+  ASSERT_EQ(4, attrs.size());
+  for (const auto& attr : attrs)
+  {
+    EXPECT_EQ(entity.entity_id, attr.entity_id);
+    if (attr.attribute_name == "is_open")
+    {
+      EXPECT_TRUE(attr.value.get<bool>());
+    }
+    else if (attr.attribute_name == "count")
+    {
+      EXPECT_EQ(-1, attr.value.get<int>());
+    }
+    else if (attr.attribute_name == "height")
+    {
+      EXPECT_EQ(1.5, attr.value.get<double>());
+    }
+    else
+    {
+      EXPECT_EQ("name", attr.attribute_name);
+      EXPECT_EQ("test", attr.value.get<string>());
+    }
+  }
 }
 
 TEST_F(EntityTest, CantRemoveEntityAttributeTwice)
@@ -1,17 +1,23 @@
 #include <knowledge_representation/LongTermMemoryConduit.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <knowledge_representation/convenience.h>
 
 #include <gtest/gtest.h>
 #include <knowledge_representation/LTMCEntity.h>
+#include <knowledge_representation/LTMCDoor.h>
 #include <knowledge_representation/LTMCConcept.h>
 #include <knowledge_representation/LTMCInstance.h>
 #include <knowledge_representation/LTMCMap.h>
 #include <knowledge_representation/LTMCPoint.h>
 #include <knowledge_representation/LTMCPose.h>
 #include <knowledge_representation/LTMCRegion.h>
+#include <knowledge_representation/LTMCWriteBatch.h>
+#include <stdexcept>
+#include <thread>
 
+using knowledge_rep::AttributeBatch;
 using knowledge_rep::AttributeValueType;
 using knowledge_rep::Concept;
 using knowledge_rep::Entity;
@@ -21,6 +27,7 @@ using knowledge_rep::Map;
 using knowledge_rep::Point;
 using knowledge_rep::Pose;
 using knowledge_rep::Region;
+using knowledge_rep::WriteBatch;
 using std::cout;
 using std::endl;
 using std::string;
@@ -141,6 +148,19 @@ TEST_F(LTMCTest, GetRegionIdWorks)
   EXPECT_EQ(fresh_region, *retrieved_region);
 }
 
+TEST_F(LTMCTest, GetDoorIdWorks)
+{
+  auto fresh_map = ltmc.getMap("test map");
+  auto fresh_door = fresh_map.addDoor("test door", 0, 1, 2, 3);
+  auto retrieved_door = ltmc.getDoor(fresh_door.entity_id);
+  ASSERT_TRUE(static_cast<bool>(retrieved_door));
+  EXPECT_EQ(fresh_door, *retrieved_door);
+  // The parent map comes back with the door rather than from a lookup of its own
+  EXPECT_EQ(fresh_map, *retrieved_door->parent_map);
+  EXPECT_EQ("test map", retrieved_door->parent_map->getName());
+  EXPECT_FALSE(static_cast<bool>(ltmc.getDoor(fresh_map.entity_id)));
+}
+
 TEST_F(LTMCTest, SQLQueryIdWorks)
 {
   vector<EntityAttribute> query_result;
@@ -274,6 +294,418 @@ TEST_F(LTMCTest, AddNewAttributeWorks)
   EXPECT_FALSE(ltmc.addNewAttribute("neverseenbeforeattr", AttributeValueType::Bool));
 }
 
+TEST_F(LTMCTest, AttributeSchemaFollowsChanges)
+{
+  auto other_ltmc = knowledge_rep::getDefaultLTMC();
+  EXPECT_FALSE(other_ltmc.attributeExists("neverseenbeforeattr"));
+  ASSERT_TRUE(ltmc.addNewAttribute("neverseenbeforeattr", AttributeValueType::Int));
+  EXPECT_TRUE(ltmc.attributeExists("neverseenbeforeattr"));
+  // Attributes added through another conduit are picked up too
+  EXPECT_TRUE(other_ltmc.attributeExists("neverseenbeforeattr"));
+
+  auto entity = ltmc.addEntity();
+  EXPECT_TRUE(entity.addAttribute("neverseenbeforeattr", 1));
+  EXPECT_TRUE(ltmc.deleteAttribute("neverseenbeforeattr"));
+  EXPECT_FALSE(ltmc.attributeExists("neverseenbeforeattr"));
+  EXPECT_FALSE(entity.addAttribute("neverseenbeforeattr", 2));
+}
+
+TEST_F(LTMCTest, ForEachEntityAttributeBatchWorks)
+{
+  for (int i = 0; i < 5; i++)
+  {
+    auto entity = ltmc.addEntity();
+    entity.addAttribute("count", i);
+    entity.addAttribute("is_open", true);
+  }
+  size_t total = 0;
+  ASSERT_TRUE(ltmc.forEachEntityAttributeBatch(
+      [&total](vector<EntityAttribute>& batch) {
+        EXPECT_LE(batch.size(), 3);
+        total += batch.size();
+      },
+      3));
+  EXPECT_EQ(ltmc.getAllEntityAttributes().size(), total);
+}
+
+TEST_F(LTMCTest, ForEachEntityBatchWorks)
+{
+  ltmc.getConcept("batched concept");
+  for (int i = 0; i < 4; i++)
+  {
+    ltmc.addEntity();
+  }
+  vector<Entity> entities;
+  ASSERT_TRUE(ltmc.forEachEntityBatch(
+      [&entities](vector<Entity>& batch) {
+        EXPECT_LE(batch.size(), 2);
+        entities.insert(entities.end(), batch.begin(), batch.end());
+      },
+      2));
+  EXPECT_EQ(ltmc.getAllEntities().size(), entities.size());
+
+  size_t concepts = 0;
+  ASSERT_TRUE(ltmc.forEachConceptBatch([&concepts](vector<Concept>& batch) { concepts += batch.size(); }, 2));
+  EXPECT_EQ(ltmc.getAllConcepts().size(), concepts);
+
+  size_t instances = 0;
+  ASSERT_TRUE(ltmc.forEachInstanceBatch([&instances](vector<Instance>& batch) { instances += batch.size(); }, 2));
+  EXPECT_EQ(ltmc.getAllInstances().size(), instances);
+}
+
+TEST_F(LTMCTest, EntityRangesVisitEveryEntityInOrder)
+{
+  ltmc.getConcept("ranged concept");
+  for (int i = 0; i < 4; i++)
+  {
+    ltmc.addEntity();
+  }
+  auto all_entities = ltmc.getAllEntities();
+  auto entities = ltmc.entities(2);
+  vector<Entity> visited;
+  for (const auto& entity : entities)
+  {
+    // The loop body can use the LTMC, as no connection is held between pages
+    EXPECT_TRUE(entity.isValid());
+    visited.push_back(entity);
+  }
+  EXPECT_FALSE(entities.failed());
+  ASSERT_EQ(all_entities.size(), visited.size());
+  for (size_t i = 1; i < visited.size(); i++)
+  {
+    EXPECT_LT(visited[i - 1].entity_id, visited[i].entity_id);
+  }
+
+  size_t concepts = 0;
+  for (const auto& concept : ltmc.concepts(2))
+  {
+    EXPECT_FALSE(concept.getName().empty());
+    concepts++;
+  }
+  EXPECT_EQ(ltmc.getAllConcepts().size(), concepts);
+
+  // A page size that divides the instances evenly ends on an empty page
+  auto instances = ltmc.instances(ltmc.getAllInstances().size());
+  EXPECT_EQ(ltmc.getAllInstances().size(), std::distance(instances.begin(), instances.end()));
+  vector<Instance> page;
+  ASSERT_TRUE(ltmc.getInstancePage(0, 1, page));
+  ASSERT_EQ(1, page.size());
+  uint first_id = page[0].entity_id;
+  ASSERT_TRUE(ltmc.getInstancePage(first_id, 1, page));
+  ASSERT_EQ(1, page.size());
+  EXPECT_LT(first_id, page[0].entity_id);
+}
+
+TEST_F(LTMCTest, BatchCallbacksCanUseTheLTMC)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    ltmc.addEntity().addAttribute("count", i);
+  }
+  // Inside a write batch, everything the callbacks do shares the batch's connection
+  WriteBatch batch{ ltmc };
+  size_t looked_up = 0;
+  ASSERT_TRUE(ltmc.forEachEntityBatch(
+      [&looked_up](vector<Entity>& entities) {
+        for (auto& entity : entities)
+        {
+          looked_up += entity.getAttributes().size();
+        }
+      },
+      2));
+  size_t scanned = 0;
+  ASSERT_TRUE(ltmc.forEachEntityAttributeBatch(
+      [&](vector<EntityAttribute>& attributes) {
+        for (const auto& attribute : attributes)
+        {
+          EXPECT_TRUE(ltmc.entityExists(attribute.entity_id));
+        }
+        scanned += attributes.size();
+      },
+      2));
+  EXPECT_EQ(looked_up, scanned);
+  EXPECT_TRUE(batch.commit());
+}
+
+TEST_F(LTMCTest, AttributeBatchesMatchAttributeVectors)
+{
+  vector<Entity> entities;
+  for (int i = 0; i < 3; i++)
+  {
+    auto entity = ltmc.addEntity();
+    entity.addAttribute("count", i);
+    entity.addAttribute("name", "entity " + std::to_string(i));
+    entities.push_back(entity);
+  }
+  AttributeBatch all;
+  ASSERT_TRUE(ltmc.getAllEntityAttributes(all));
+  auto expected = ltmc.getAllEntityAttributes();
+  ASSERT_EQ(expected.size(), all.size());
+  for (size_t i = 0; i < all.size(); i++)
+  {
+    EXPECT_EQ(std::count(expected.begin(), expected.end(), all[i]), 1);
+  }
+
+  AttributeBatch batch;
+  ASSERT_TRUE(ltmc.getAttributes({ entities[0], entities[2] }, batch));
+  ASSERT_EQ(4, batch.size());
+  // Each name is stored once, however many rows use it
+  EXPECT_EQ(2, batch.attributeNames().size());
+  EXPECT_EQ(2, batch.intValues().size());
+  ASSERT_EQ(2, batch.stringCount());
+  for (size_t i = 0; i < batch.size(); i++)
+  {
+    EXPECT_TRUE(batch.entityId(i) == entities[0].entity_id || batch.entityId(i) == entities[2].entity_id);
+    if (batch.type(i) == AttributeValueType::Str)
+    {
+      size_t size;
+      const char* value = batch.stringValue(batch.valueIndexColumn()[i], size);
+      EXPECT_EQ("entity " + std::to_string(batch.entityId(i) == entities[0].entity_id ? 0 : 2), string(value, size));
+    }
+  }
+}
+
+TEST_F(LTMCTest, BulkLoadWorks)
+{
+  using knowledge_rep::BulkEntityRef;
+  Concept existing = ltmc.getConcept("fruit");
+  knowledge_rep::BulkKnowledge knowledge;
+  knowledge.concepts = { "fruit", "apple" };
+  knowledge.instances = { BulkEntityRef::instanceNamed("fuji", "apple") };
+  knowledge.instance_of = { { BulkEntityRef::instanceNamed("fuji", "apple"), "fruit" } };
+  knowledge.attributes = {
+    { BulkEntityRef::conceptNamed("apple"), "is_a", {}, BulkEntityRef::conceptNamed("fruit") },
+    { BulkEntityRef::instanceNamed("fuji", "apple"), "height", 0.25, {} },
+    // Lossless numeric conversions are allowed
+    { BulkEntityRef::instanceNamed("fuji", "apple"), "width", 1, {} },
+    { BulkEntityRef::instanceNamed("fuji", "apple"), "is_in", {}, BulkEntityRef::instanceNamed("kitchen", "room") },
+  };
+  knowledge_rep::BulkLoadResult result;
+  ASSERT_TRUE(ltmc.bulkLoad(knowledge, result));
+  ASSERT_EQ(2, result.concept_ids.size());
+  ASSERT_EQ(1, result.instance_ids.size());
+  EXPECT_EQ(existing.entity_id, result.concept_ids[0]);
+  Concept apple = ltmc.getConcept("apple");
+  EXPECT_EQ(apple.entity_id, result.concept_ids[1]);
+
+  auto fuji = apple.getInstanceNamed("fuji");
+  ASSERT_TRUE(static_cast<bool>(fuji));
+  EXPECT_EQ(fuji->entity_id, result.instance_ids[0]);
+  EXPECT_EQ(2, fuji->getConcepts().size());
+  EXPECT_EQ(1, fuji->getAttributes("height").size());
+  EXPECT_EQ(1, fuji->getAttributes("width").size());
+  auto kitchen = ltmc.getConcept("room").getInstanceNamed("kitchen");
+  ASSERT_TRUE(static_cast<bool>(kitchen));
+  EXPECT_EQ(1, ltmc.getEntitiesWithAttributeOfValue("is_in", kitchen->entity_id).size());
+  EXPECT_EQ(1, apple.getAttributes("is_a").size());
+
+  // Loading the same knowledge again reuses everything and adds nothing
+  auto num_entities = ltmc.getAllEntities().size();
+  knowledge_rep::BulkLoadResult second_result;
+  ASSERT_TRUE(ltmc.bulkLoad(knowledge, second_result));
+  EXPECT_EQ(result.concept_ids, second_result.concept_ids);
+  EXPECT_EQ(result.instance_ids, second_result.instance_ids);
+  EXPECT_EQ(num_entities, ltmc.getAllEntities().size());
+  EXPECT_EQ(1, fuji->getAttributes("height").size());
+}
+
+TEST_F(LTMCTest, BulkLoadIsAllOrNothing)
+{
+  using knowledge_rep::BulkEntityRef;
+  auto num_entities = ltmc.getAllEntities().size();
+  knowledge_rep::BulkKnowledge knowledge;
+  knowledge.concepts = { "apple" };
+  knowledge.attributes = { { BulkEntityRef::conceptNamed("apple"), "not a real attribute", true, {} } };
+  knowledge_rep::BulkLoadResult result;
+  EXPECT_FALSE(ltmc.bulkLoad(knowledge, result));
+  EXPECT_EQ(num_entities, ltmc.getAllEntities().size());
+}
+
+TEST_F(LTMCTest, WriteBatchCommitsOnScopeExit)
+{
+  Concept soda = ltmc.getConcept("soda");
+  boost::optional<Instance> coke;
+  {
+    WriteBatch batch{ ltmc };
+    ASSERT_TRUE(batch.isOpen());
+    coke = soda.createInstance("coke");
+    ASSERT_TRUE(static_cast<bool>(coke));
+    EXPECT_TRUE(coke->addAttribute("count", 3));
+  }
+  EXPECT_TRUE(coke->isValid());
+  EXPECT_EQ(1, coke->getAttributes("count").size());
+}
+
+TEST_F(LTMCTest, WriteBatchAbortDiscardsChanges)
+{
+  WriteBatch batch{ ltmc };
+  auto entity = ltmc.addEntity();
+  EXPECT_TRUE(entity.isValid());
+  batch.abort();
+  EXPECT_FALSE(batch.isOpen());
+  EXPECT_FALSE(entity.isValid());
+}
+
+TEST_F(LTMCTest, WriteBatchAbortsOnException)
+{
+  boost::optional<Entity> entity;
+  try
+  {
+    WriteBatch batch{ ltmc };
+    entity = ltmc.addEntity();
+    throw std::runtime_error("perception failed");
+  }
+  catch (const std::runtime_error&)
+  {
+  }
+  EXPECT_FALSE(entity->isValid());
+}
+
+TEST_F(LTMCTest, WriteBatchSurvivesFailedOperation)
+{
+  WriteBatch batch{ ltmc };
+  auto entity = ltmc.addEntity();
+  EXPECT_TRUE(entity.addAttribute("count", 1));
+  EXPECT_FALSE(entity.addAttribute("not a real attribute", true));
+  EXPECT_TRUE(entity.addAttribute("is_open", true));
+  EXPECT_TRUE(batch.commit());
+  EXPECT_EQ(2, entity.getAttributes().size());
+}
+
+TEST_F(LTMCTest, NestedWriteBatchAbortKeepsOuterChanges)
+{
+  WriteBatch outer{ ltmc };
+  auto kept = ltmc.addEntity();
+  boost::optional<Entity> discarded;
+  {
+    WriteBatch inner{ ltmc };
+    discarded = ltmc.addEntity();
+    inner.abort();
+  }
+  EXPECT_TRUE(outer.commit());
+  EXPECT_TRUE(kept.isValid());
+  EXPECT_FALSE(discarded->isValid());
+}
+
+TEST_F(LTMCTest, WriteBatchAbortRestoresDeletedEntities)
+{
+  Concept drink = ltmc.getConcept("drink");
+  Concept soda = ltmc.getConcept("soda");
+  soda.addAttribute("is_a", drink);
+  auto coke = soda.createInstance("coke");
+  ASSERT_TRUE(static_cast<bool>(coke));
+  coke->addAttribute("count", 3);
+  {
+    WriteBatch outer{ ltmc };
+    WriteBatch inner{ ltmc };
+    EXPECT_TRUE(soda.deleteEntity());
+    EXPECT_EQ(1, coke->removeAttribute("count"));
+    inner.commit();
+    outer.abort();
+  }
+  EXPECT_TRUE(soda.isValid());
+  EXPECT_EQ(1, coke->getAttributes("count").size());
+  EXPECT_TRUE(coke->hasConcept(soda));
+  EXPECT_TRUE(coke->hasConceptRecursively(drink));
+  EXPECT_EQ(1, soda.getInstances().size());
+}
+
+TEST_F(LTMCTest, ConcurrentReadsWork)
+{
+  auto entity = ltmc.addEntity();
+  entity.addAttribute("count", 3);
+  std::vector<std::thread> threads;
+  std::vector<int> failures(4, 0);
+  for (size_t i = 0; i < failures.size(); i++)
+  {
+    threads.emplace_back([&, i]() {
+      for (int j = 0; j < 50; j++)
+      {
+        if (!ltmc.entityExists(entity.entity_id) || entity.getAttributes("count").size() != 1)
+        {
+          failures[i]++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  EXPECT_EQ(vector<int>(failures.size(), 0), failures);
+}
+
+TEST_F(LTMCTest, WriteBatchBelongsToItsThread)
+{
+  WriteBatch batch{ ltmc };
+  auto entity = ltmc.addEntity();
+  bool visible_elsewhere = true;
+  std::thread([&]() { visible_elsewhere = ltmc.entityExists(entity.entity_id); }).join();
+  EXPECT_FALSE(visible_elsewhere);
+
+  EXPECT_TRUE(batch.commit());
+  std::thread([&]() { visible_elsewhere = ltmc.entityExists(entity.entity_id); }).join();
+  EXPECT_TRUE(visible_elsewhere);
+}
+
+TEST_F(LTMCTest, WriteBatchIndexChangesAreSharedOnCommit)
+{
+  Concept drink = ltmc.getConcept("drink");
+  Concept soda = ltmc.getConcept("soda");
+  auto coke = soda.createInstance();
+  bool elsewhere = true;
+  auto check_elsewhere = [&]() {
+    std::thread([&]() { elsewhere = coke.hasConceptRecursively(drink); }).join();
+    return elsewhere;
+  };
+  // Loads the index, so that what follows checks changes reaching a loaded one
+  EXPECT_FALSE(check_elsewhere());
+  {
+    WriteBatch batch{ ltmc };
+    soda.addAttribute("is_a", drink);
+    EXPECT_TRUE(coke.hasConceptRecursively(drink));
+    EXPECT_FALSE(check_elsewhere());
+    {
+      WriteBatch inner{ ltmc };
+      soda.removeAttribute("is_a");
+      EXPECT_FALSE(coke.hasConceptRecursively(drink));
+      inner.abort();
+    }
+    EXPECT_TRUE(coke.hasConceptRecursively(drink));
+    EXPECT_TRUE(batch.commit());
+  }
+  EXPECT_TRUE(check_elsewhere());
+  EXPECT_TRUE(coke.hasConceptRecursively(drink));
+}
+
+TEST_F(LTMCTest, WriteBatchGeometryIsSharedOnCommit)
+{
+  Map map = ltmc.getMap("batch map");
+  auto probe = map.addPoint("probe", 5, 5);
+  size_t elsewhere = 0;
+  auto check_elsewhere = [&]() {
+    std::thread([&]() { elsewhere = probe.getContainingRegions().size(); }).join();
+    return elsewhere;
+  };
+  EXPECT_EQ(0, check_elsewhere());
+  {
+    WriteBatch batch{ ltmc };
+    map.addRegion("room", { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } });
+    EXPECT_EQ(1, probe.getContainingRegions().size());
+    EXPECT_EQ(0, check_elsewhere());
+    EXPECT_TRUE(batch.commit());
+  }
+  EXPECT_EQ(1, check_elsewhere());
+  {
+    WriteBatch batch{ ltmc };
+    map.addRegion("hall", { { 4, 4 }, { 6, 4 }, { 6, 6 }, { 4, 6 } });
+    EXPECT_EQ(2, probe.getContainingRegions().size());
+    batch.abort();
+  }
+  EXPECT_EQ(1, probe.getContainingRegions().size());
+  EXPECT_EQ(1, check_elsewhere());
+}
+
 TEST_F(LTMCTest, RecursiveRemoveWorks)
 {
   Concept parent = ltmc.getConcept("parent concept");
@@ -53,6 +53,46 @@ class TestLTMC(unittest.TestCase):
         nsb_concept.remove_instances()
         self.assertEqual(len(nsb_concept.get_instances()), 0)
 
+    def test_batch_concept_queries(self):
+        parent = ltmc.get_concept("parent concept")
+        child = ltmc.get_concept("child concept")
+        child.add_attribute("is_a", parent)
+        unrelated = ltmc.get_concept("unrelated concept").create_instance()
+        instance = child.create_instance()
+        concepts = ltmc.get_concepts_recursive([unrelated, instance])
+        self.assertEqual(len(concepts), 2)
+        self.assertEqual(len(concepts[0]), 1)
+        self.assertEqual(len(concepts[1]), 2)
+        filtered = ltmc.filter_instances_of([unrelated, instance], parent)
+        self.assertEqual(len(filtered), 1)
+        self.assertEqual(filtered[0].entity_id, instance.entity_id)
+
+    def test_for_each_batch(self):
+        concept = ltmc.get_concept("never seen before")
+        for _ in range(3):
+            concept.create_instance()
+        batches = []
+        self.assertTrue(ltmc.for_each_instance_batch(batches.append, 2))
+        # Other tests' instances may be scanned too, so only the batch size and the total are pinned down
+        self.assertTrue(all(0 < len(batch) <= 2 for batch in batches))
+        self.assertEqual(len(ltmc.get_all_instances()), sum(map(len, batches)))
+        entities = []
+        self.assertTrue(ltmc.for_each_entity_batch(entities.extend))
+        self.assertEqual(len(ltmc.get_all_entities()), len(entities))
+
+    def test_iterate_pages(self):
+        concept = ltmc.get_concept("never seen before")
+        for _ in range(3):
+            concept.create_instance()
+        # A small page size makes the iterators cross pages, which should be invisible to the loop
+        instance_ids = [instance.entity_id for instance in ltmc.instances(2)]
+        self.assertEqual(sorted(instance.entity_id for instance in ltmc.get_all_instances()), instance_ids)
+        self.assertEqual(len(ltmc.get_all_concepts()), sum(1 for _ in ltmc.concepts(2)))
+        entities = ltmc.entities(2)
+        self.assertIs(entities, iter(entities))
+        self.assertEqual(len(ltmc.get_all_entities()), len(list(entities)))
+        self.assertEqual([], list(entities))
+
     def test_select_query(self):
         result_list = PyAttributeList()
         ltmc.select_query_string("SELECT * FROM entity_attributes_str", result_list)
@@ -96,6 +136,10 @@ class TestLTMC(unittest.TestCase):
         self.assertEqual(region, map.get_region("test region"))
         self.assertEqual(1, len(map.get_all_regions()))
 
+        square = map.add_region("square", [(0.0, 0.0), (2.0, 0.0), (2.0, 2.0), (0.0, 2.0)])
+        self.assertTrue(square.is_point_contained(1.0, 1.0))
+        self.assertEqual([True, True, False], square.are_points_contained([(1.0, 1.0), (2.0, 1.0), (3.0, 1.0)]))
+
         door = map.add_door("test door", 0.0, 1.1, 2.2, 3.3)
         self.assertTrue(door)
         self.assertEqual(door.x_0, 0.0)
@@ -106,6 +150,19 @@ class TestLTMC(unittest.TestCase):
         self.assertEqual(door, map.get_door("test door"))
         self.assertEqual(1, len(map.get_all_doors()))
 
+        self.assertEqual(point, map.get_nearest_points(0, 0, 1)[0])
+        self.assertEqual(pose, map.get_nearest_poses(0, 0, 1)[0])
+        self.assertEqual(door, map.get_nearest_doors(0, 0, 1)[0])
+        self.assertEqual(1, len(map.get_points_within_radius(0, 0, 2)))
+        self.assertEqual(0, len(map.get_poses_within_radius(10, 10, 2)))
+        self.assertEqual(1, len(map.get_doors_within_radius(0, 0, 2)))
+
+        # The door touches both regions, so it joins them
+        self.assertEqual([region], list(map.get_adjacent_regions(square)))
+        self.assertTrue(map.is_region_reachable(square, region))
+        self.assertEqual([square, region], list(map.get_region_path(square, region)))
+        self.assertEqual([door], list(map.get_door_path(square, region)))
+
 
 if __name__ == '__main__':
     import rosunit
@@ -99,11 +99,41 @@ TEST_F(MapTest, GetAllPointsWorks)
   EXPECT_EQ(0, map.getAllPoints().size());
 }
 
+TEST_F(MapTest, GeometryReadTogetherSharesItsMap)
+{
+  map.addPoint("another point", 1.0, 2.0);
+  auto points = map.getAllPoints();
+  ASSERT_EQ(2, points.size());
+  EXPECT_EQ(map, *points[0].parent_map);
+  EXPECT_EQ(points[0].parent_map, points[1].parent_map);
+}
+
 TEST_F(MapTest, DoubleAddPointFails)
 {
   EXPECT_ANY_THROW(map.addPoint("test point", 2.0, 3.0));
 }
 
+TEST_F(MapTest, FailedAddLeavesNothingBehind)
+{
+  auto num_entities = ltmc.getAllEntities().size();
+  EXPECT_ANY_THROW(map.addPoint("test point", 2.0, 3.0));
+  EXPECT_ANY_THROW(map.addRegion("test region", { { 0, 1 }, { 2, 3 } }));
+  EXPECT_EQ(num_entities, ltmc.getAllEntities().size());
+  EXPECT_EQ(4, map.getAttributes("has").size());
+}
+
+TEST_F(MapTest, AddedGeometryIsComplete)
+{
+  for (const Instance& geometry : vector<Instance>{ point, pose, region, door })
+  {
+    EXPECT_EQ(1, geometry.getAttributes("name").size());
+    EXPECT_EQ(1, ltmc.getEntitiesWithAttributeOfValue("has", geometry.entity_id).size());
+  }
+  EXPECT_TRUE(pose.hasConcept(ltmc.getConcept("pose")));
+  EXPECT_TRUE(region.hasConcept(ltmc.getConcept("region")));
+  EXPECT_TRUE(door.hasConcept(ltmc.getConcept("door")));
+}
+
 TEST_F(MapTest, PointEqualityWorks)
 {
   auto same_point = Point(point.entity_id, "test point", point.x, point.y, map, ltmc);
@@ -298,6 +328,129 @@ TEST_F(MapTest, RegionContainedPointsWorks)
   EXPECT_EQ(1, region.getContainedPoses().size());
 }
 
+TEST_F(MapTest, ContainmentFollowsGeometryChanges)
+{
+  auto room = map.addRegion("room", { { 10, 10 }, { 20, 10 }, { 20, 20 }, { 10, 20 } });
+  // The first query loads the map's geometry, so everything after checks that changes reach what was loaded
+  EXPECT_TRUE(room.getContainedPoints().empty());
+  EXPECT_TRUE(room.isPointContained(15, 15));
+  EXPECT_TRUE(room.isPointContained(10, 15));
+  EXPECT_FALSE(room.isPointContained(25, 15));
+
+  auto inside = map.addPoint("inside", 15, 15);
+  auto corner = map.addPoint("corner", 20, 20);
+  map.addPoint("outside", 25, 15);
+  map.addPose("facing", 12, 18, 0.5);
+  auto contained = room.getContainedPoints();
+  ASSERT_EQ(2, contained.size());
+  EXPECT_EQ(inside, contained[0]);
+  EXPECT_EQ(corner, contained[1]);
+  ASSERT_EQ(1, room.getContainedPoses().size());
+  EXPECT_EQ("facing", room.getContainedPoses()[0].getName());
+
+  auto hall = map.addRegion("hall", { { 15, 12 }, { 30, 12 }, { 30, 18 }, { 15, 18 } });
+  auto containing = inside.getContainingRegions();
+  ASSERT_EQ(2, containing.size());
+  EXPECT_EQ(room, containing[0]);
+  EXPECT_EQ(hall, containing[1]);
+
+  auto probe = map.addPoint("probe", 16, 15);
+  inside.deleteEntity();
+  EXPECT_EQ(2, room.getContainedPoints().size());
+  hall.deleteEntity();
+  ASSERT_EQ(1, probe.getContainingRegions().size());
+  EXPECT_EQ(room, probe.getContainingRegions()[0]);
+}
+
+TEST_F(MapTest, BatchContainmentMatchesSinglePoints)
+{
+  // An L shape, so that some points inside the bounding box are outside the region
+  auto l_shape = map.addRegion("l shape", { { 0, 0 }, { 4, 0 }, { 4, 1 }, { 1, 1 }, { 1, 3 }, { 0, 3 } });
+  // Not a multiple of any vector width, so the scalar tail runs too
+  std::vector<Region::Point2D> points = { { 0.5, 0.5 }, { 3, 0.5 }, { 0.5, 2.5 }, { 2, 2 },   { 4, 0.5 },
+                                          { 0, 0 },     { 1, 1 },   { 2.5, 1 },   { 5, 0.5 }, { -1, -1 },
+                                          { 100, 100 }, { 1.5, 1.5 }, { 0.5, 3 } };
+  std::vector<bool> expected = { true, true, true, false, true, true, true, true, false, false, false, false, true };
+  auto contained = l_shape.isPointContained(points);
+  EXPECT_EQ(expected, contained);
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    EXPECT_EQ(l_shape.isPointContained(points[i]), contained[i]);
+  }
+  EXPECT_TRUE(l_shape.isPointContained(std::vector<Region::Point2D>()).empty());
+}
+
+TEST_F(MapTest, ProximityQueriesWork)
+{
+  // The first query loads the map's geometry, so the rest also check that additions reach what was loaded
+  auto nearest = map.getNearestPoints(0, 0, 1);
+  ASSERT_EQ(1, nearest.size());
+  EXPECT_EQ(point, nearest[0]);
+
+  auto a = map.addPoint("a", 5, 0);
+  auto b = map.addPoint("b", 3, 0);
+  auto c = map.addPoint("c", 0, -3);
+  // Equally distant points come back in the order they were added
+  EXPECT_EQ(vector<Point>({ a, b }), map.getNearestPoints(4, 0, 2));
+  EXPECT_EQ(4, map.getNearestPoints(0, 0, 10).size());
+  EXPECT_TRUE(map.getNearestPoints(0, 0, 0).empty());
+  EXPECT_EQ(vector<Point>({ point, b, c }), map.getPointsWithinRadius(0, 0, 3));
+  EXPECT_TRUE(map.getPointsWithinRadius(10, 10, 1).empty());
+
+  auto far = map.addPose("far", 10, 10, 0);
+  ASSERT_EQ(1, map.getNearestPoses(9, 9, 1).size());
+  EXPECT_EQ(far, map.getNearestPoses(9, 9, 1)[0]);
+  EXPECT_EQ(vector<Pose>({ pose }), map.getPosesWithinRadius(0, 0, 1));
+
+  // Doors are measured to their closest point, not their ends
+  auto other = map.addDoor("other", 10, 0, 10, 4);
+  EXPECT_EQ(vector<Door>({ other, door }), map.getNearestDoors(9, 2, 2));
+  EXPECT_EQ(vector<Door>({ door }), map.getDoorsWithinRadius(2, 1, 1.5));
+
+  b.deleteEntity();
+  EXPECT_EQ(vector<Point>({ point, c }), map.getPointsWithinRadius(0, 0, 3));
+  other.deleteEntity();
+  EXPECT_EQ(vector<Door>({ door }), map.getNearestDoors(9, 2, 2));
+}
+
+TEST_F(MapTest, RegionGraphWorks)
+{
+  // Three rooms in a row and one off on its own, with doors on the walls between rooms
+  auto floor = ltmc.getMap("floor");
+  auto a = floor.addRegion("a", { { 0, 0 }, { 4, 0 }, { 4, 4 }, { 0, 4 } });
+  auto b = floor.addRegion("b", { { 4, 0 }, { 8, 0 }, { 8, 4 }, { 4, 4 } });
+  auto c = floor.addRegion("c", { { 8, 0 }, { 12, 0 }, { 12, 4 }, { 8, 4 } });
+  auto isolated = floor.addRegion("isolated", { { 20, 0 }, { 24, 0 }, { 24, 4 }, { 20, 4 } });
+  auto ab = floor.addDoor("ab", 4, 1, 4, 2);
+  auto bc = floor.addDoor("bc", 8, 1, 8, 2);
+
+  EXPECT_EQ(vector<Region>({ b }), floor.getAdjacentRegions(a));
+  EXPECT_EQ(vector<Region>({ a, c }), floor.getAdjacentRegions(b));
+  EXPECT_EQ(vector<Region>({ a, b, c }), floor.getReachableRegions(c));
+  EXPECT_EQ(vector<Region>({ isolated }), floor.getReachableRegions(isolated));
+  EXPECT_TRUE(floor.isRegionReachable(a, c));
+  EXPECT_TRUE(floor.isRegionReachable(isolated, isolated));
+  EXPECT_FALSE(floor.isRegionReachable(a, isolated));
+  EXPECT_EQ(vector<Region>({ a, b, c }), floor.getRegionPath(a, c));
+  EXPECT_EQ(vector<Door>({ ab, bc }), floor.getDoorPath(a, c));
+  EXPECT_EQ(vector<Region>({ c, b, a }), floor.getRegionPath(c, a));
+  EXPECT_EQ(vector<Region>({ a }), floor.getRegionPath(a, a));
+  EXPECT_TRUE(floor.getDoorPath(a, a).empty());
+  EXPECT_TRUE(floor.getRegionPath(a, isolated).empty());
+  // Regions of other maps aren't part of this map's graph
+  EXPECT_TRUE(floor.getReachableRegions(region).empty());
+  EXPECT_FALSE(floor.isRegionReachable(region, region));
+
+  // The graph follows changes to the map's doors and regions
+  auto corridor = floor.addDoor("corridor", 12, 2, 20, 2);
+  EXPECT_EQ(vector<Door>({ bc, corridor }), floor.getDoorPath(b, isolated));
+  bc.deleteEntity();
+  EXPECT_FALSE(floor.isRegionReachable(a, isolated));
+  EXPECT_TRUE(floor.isRegionReachable(c, isolated));
+  b.deleteEntity();
+  EXPECT_TRUE(floor.getAdjacentRegions(a).empty());
+}
+
 TEST_F(MapTest, DoorNameWorks)
 {
   EXPECT_EQ("test door", door.getName());